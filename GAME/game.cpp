@@ -15,15 +15,34 @@
 
 namespace coup {
 
+namespace {
+thread_local Game* boundGame = nullptr; ///< Game bound to the thread, see Game::Binding
+}
+
 /**
  * @brief Returns the singleton instance of the game.
- * Implements the Singleton pattern to ensure only one game instance exists.
+ * Implements the Singleton pattern to ensure only one game instance exists per thread.
  */
 Game& Game::getInstance() {
-    static Game instance;
+    if (boundGame) {
+        return *boundGame;
+    }
+    static thread_local Game instance;
     return instance;
 }
 
+std::unique_ptr<Game> Game::create() {
+    return std::unique_ptr<Game>(new Game()); // The constructor is private, so make_unique cannot reach it
+}
+
+Game::Binding::Binding(Game& game) : _previous(boundGame) {
+    boundGame = &game;
+}
+
+Game::Binding::~Binding() {
+    boundGame = _previous;
+}
+
 /**
  * @brief Destructor. Cleans up all dynamically allocated players.
  */
@@ -120,7 +139,9 @@ void Game::nextTurn() {
     // If the current player is a Merchant and has at least 3 coins, grant a bonus coin
     if (_players[_currentPlayerIndex]->getRole() == Role::Merchant && _players[_currentPlayerIndex]->getCoins() >= 3) {
         _players[_currentPlayerIndex]->setCoins(_players[_currentPlayerIndex]->getCoins() + 1);
-        std::cout << _players[_currentPlayerIndex]->getName() << " received an extra coin for being a Merchant." << std::endl;
+        if (_verbose) {
+            std::cout << _players[_currentPlayerIndex]->getName() << " received an extra coin for being a Merchant." << std::endl;
+        }
     }
 
     // Advance to the next active player in circular order
@@ -129,7 +150,9 @@ void Game::nextTurn() {
     } while (!_players[_currentPlayerIndex]->isActive());
 
     // Announce the next player's turn
-    turn();
+    if (_verbose) {
+        turn();
+    }
 }
 
 
@@ -188,6 +211,44 @@ std::string Game::winner() const {
     throw std::runtime_error("No active player found");
 }
 
+/**
+ * @brief Copies the state of the game and of all players into a snapshot.
+ */
+void Game::snapshot(GameSnapshot& out) const {
+    out.playerCount = static_cast<int>(_players.size());
+    for (size_t i = 0; i < _players.size(); ++i) {
+        out.players[i] = _players[i]->getState();
+        out.roles[i] = _players[i]->getRole();
+    }
+    out.currentPlayerIndex = _currentPlayerIndex;
+    out.gameActive = _gameActive;
+    out.numPlayers = _numPlayers;
+    out.lastStep = _lastStep;
+}
+
+/**
+ * @brief Restores a snapshot taken from this table.
+ * The roster is checked first, so a rejected snapshot leaves the game unchanged.
+ * @throws std::runtime_error if the snapshot was taken with different seats or roles.
+ */
+void Game::restore(const GameSnapshot& state) {
+    if (state.playerCount != static_cast<int>(_players.size())) {
+        throw std::runtime_error("Snapshot does not match the players of the game");
+    }
+    for (size_t i = 0; i < _players.size(); ++i) {
+        if (state.roles[i] != _players[i]->getRole()) {
+            throw std::runtime_error("Snapshot does not match the players of the game");
+        }
+    }
+    for (size_t i = 0; i < _players.size(); ++i) {
+        _players[i]->setState(state.players[i]);
+    }
+    _currentPlayerIndex = state.currentPlayerIndex;
+    _gameActive = state.gameActive;
+    _numPlayers = state.numPlayers;
+    _lastStep = state.lastStep;
+}
+
 /**
  * @brief Resets the game to initial state for testing purposes.
  * Clears all players and resets game state.
@@ -203,5 +264,6 @@ void coup::Game::reset() {
     _currentPlayerIndex = 0;
     _gameActive = false;
     _numPlayers = 0;
+    _lastStep = ActionType::Gather; // A bribe from a previous game must not carry over
 }
 }
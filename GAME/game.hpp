@@ -2,6 +2,7 @@
 #ifndef GAME_HPP
 #define GAME_HPP
 
+#include <memory>
 #include <string>
 #include <vector>
 #include "PLAYER/player.hpp"
@@ -21,6 +22,23 @@ namespace coup {
 
 class Player; // Forward declaration
 
+/**
+ * @struct GameSnapshot
+ * @brief Complete state of a game in progress, stored in a flat fixed-size record.
+ *
+ * The record holds no pointers, so copying it is a plain memory copy. It refers to the players
+ * by seat, so it can only be restored on a game with the same seats (see Game::restore()).
+ */
+struct GameSnapshot {
+    PlayerState players[6];  ///< State of every seat
+    Role roles[6];           ///< Role of every seat, to check the roster on restore
+    int playerCount;         ///< Number of seats
+    int currentPlayerIndex;  ///< Index of the player whose turn it is
+    bool gameActive;         ///< Whether the game was started
+    int numPlayers;          ///< Number of active players
+    ActionType lastStep;     ///< Last action performed in the game
+};
+
 /**
  * @class Game
  * @brief Main class for managing a Coup game session.
@@ -36,12 +54,14 @@ private:
     bool _gameActive;                    ///< Flag indicating if the game is currently active
     int _numPlayers;                     ///< Number of active players in the game
     ActionType _lastStep;                ///< Last action performed in the game
+    bool _verbose;                       ///< Whether turn announcements are printed to stdout
 
     /**
      * @brief Private constructor for Singleton pattern.
      * Initializes the game in its starting state, with no players and inactive.
      */
-    Game() : _players(), _currentPlayerIndex(0), _gameActive(false), _numPlayers(0) {
+    Game() : _players(), _currentPlayerIndex(0), _gameActive(false), _numPlayers(0),
+             _lastStep(ActionType::Gather), _verbose(true) {
         _players.reserve(6); // Reserve space for up to 6 players
     }
 
@@ -52,10 +72,49 @@ private:
 public:
     /**
      * @brief Returns the singleton instance of the game.
-     * @return Reference to the single Game instance.
+     * The instance is thread-local: every thread sees its own game, so simulation
+     * workers can each play independent games without sharing state. A Binding
+     * replaces it with another thread's game.
+     * @return Reference to the Game of the calling thread.
      */
     static Game& getInstance();
 
+    /**
+     * @brief Creates a game of its own, apart from the instances of the threads.
+     * Used to host many tables on one thread. Its players reach it through getInstance(),
+     * so it must be bound (see Binding) while they act.
+     * @return The new game, in its starting state.
+     */
+    static std::unique_ptr<Game> create();
+
+    /**
+     * @class Binding
+     * @brief Makes getInstance() return another thread's game on the calling thread.
+     *
+     * Players find their game through getInstance(), so a game set up on one thread can only be
+     * played on another one while it is bound there, e.g. by the GUI logic thread. Only one thread
+     * may use a game at a time; bindings can be nested and are undone in reverse order.
+     */
+    class Binding {
+    public:
+        /**
+         * @brief Binds a game to the calling thread.
+         * @param game The game getInstance() returns until the binding is destroyed.
+         */
+        explicit Binding(Game& game);
+
+        /**
+         * @brief Restores the game the thread used before.
+         */
+        ~Binding();
+
+        Binding(const Binding&) = delete;
+        Binding& operator=(const Binding&) = delete;
+
+    private:
+        Game* _previous;  ///< Game bound before, or nullptr
+    };
+
     /**
      * @brief Destructor. Cleans up all dynamically allocated players.
      */
@@ -129,6 +188,23 @@ public:
         _numPlayers = num;
     }
 
+    /**
+     * @brief Returns whether turn announcements are printed to stdout.
+     * @return true if the game prints its progress.
+     */
+    bool isVerbose() const {
+        return _verbose;
+    }
+
+    /**
+     * @brief Enables or disables printing of turn announcements.
+     * Simulations disable it, since console output dominates the cost of a turn.
+     * @param verbose The new value.
+     */
+    void setVerbose(bool verbose) {
+        _verbose = verbose;
+    }
+
     /**
      * @brief Returns a reference to the list of all players in the game.
      * @return Constant reference to the vector of players.
@@ -158,6 +234,30 @@ public:
      */
     Player* getCurrentPlayer() const { return _players[_currentPlayerIndex]; }
 
+    /**
+     * @brief Copies the state of the game and of all players into a snapshot.
+     * @param out Receives the state.
+     */
+    void snapshot(GameSnapshot& out) const;
+
+    /**
+     * @brief Returns a snapshot of the game.
+     * @return The state of the game and of all players.
+     */
+    GameSnapshot snapshot() const {
+        GameSnapshot out{};
+        snapshot(out);
+        return out;
+    }
+
+    /**
+     * @brief Restores a snapshot taken from this table.
+     * The players are updated in place, nothing is allocated or freed.
+     * @param state The snapshot.
+     * @throws std::runtime_error if the snapshot was taken with different seats or roles.
+     */
+    void restore(const GameSnapshot& state);
+
     /**
      * @brief Resets the game to initial state for testing purposes.
      * Clears all players and resets game state.
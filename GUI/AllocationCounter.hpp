@@ -0,0 +1,15 @@
+// idocohen963@gmail.com
+#pragma once
+
+#include <cstdint>
+
+namespace coup {
+
+/**
+ * @brief Returns the number of heap allocations made by the program so far, on all threads.
+ * Counted by the global operator new of AllocationCounter.cpp, which only the GUI program links.
+ * @return Number of calls to operator new.
+ */
+uint64_t allocationCount();
+
+} // namespace coup
@@ -0,0 +1,126 @@
+// idocohen963@gmail.com
+#include "AssetCache.hpp"
+#include <chrono>
+#include <iomanip>
+#include <stdexcept>
+
+namespace coup {
+
+namespace {
+
+/**
+ * @brief Milliseconds elapsed since a time point.
+ */
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+AssetCache::~AssetCache() {
+    if (_loader.joinable()) {
+        _loader.join();
+    }
+}
+
+void AssetCache::preload(const std::vector<std::string>& paths) {
+    if (_loader.joinable()) {
+        throw std::runtime_error("Assets are already being preloaded");
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (const std::string& path : paths) {
+            Entry& entry = _entries[path];
+            entry.pending = !entry.texture && !entry.image && !entry.failed;
+        }
+    }
+    _loader = std::thread([this, paths] {
+        for (const std::string& path : paths) {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (!_entries[path].pending) continue;
+            }
+            // Decoding only touches the image, so it runs without the lock
+            auto start = std::chrono::steady_clock::now();
+            auto image = std::make_unique<sf::Image>();
+            bool loaded = image->loadFromFile(path);
+            double elapsed = millisecondsSince(start);
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                Entry& entry = _entries[path];
+                entry.pending = false;
+                entry.background = true;
+                entry.decodeMs = elapsed;
+                if (loaded) {
+                    entry.image = std::move(image);
+                } else {
+                    entry.failed = true;
+                }
+            }
+            _decoded.notify_all();
+        }
+    });
+}
+
+std::shared_ptr<const sf::Texture> AssetCache::texture(const std::string& path) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    Entry& entry = _entries[path];
+    _decoded.wait(lock, [&entry] { return !entry.pending; });
+    if (entry.texture || entry.failed) {
+        return entry.texture;
+    }
+
+    if (!entry.image) {
+        auto start = std::chrono::steady_clock::now();
+        entry.image = std::make_unique<sf::Image>();
+        if (!entry.image->loadFromFile(path)) {
+            entry.image.reset();
+            entry.failed = true;
+        }
+        entry.decodeMs = millisecondsSince(start);
+        if (entry.failed) {
+            return nullptr;
+        }
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto texture = std::make_shared<sf::Texture>();
+    if (texture->loadFromImage(*entry.image)) {
+        texture->setSmooth(true);
+        entry.texture = texture;
+    } else {
+        entry.failed = true;
+    }
+    entry.image.reset(); // The pixels now live on the GPU
+    entry.uploadMs = millisecondsSince(start);
+    return entry.texture;
+}
+
+std::shared_ptr<const sf::Font> AssetCache::font(const std::string& path) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entry& entry = _entries[path];
+    if (!entry.font) {
+        auto start = std::chrono::steady_clock::now();
+        auto font = std::make_shared<sf::Font>();
+        if (!font->loadFromFile(path)) {
+            throw std::runtime_error("Fatal Error: Failed to load font '" + path + "'. Make sure it's in the execution directory.");
+        }
+        entry.font = font;
+        entry.decodeMs = millisecondsSince(start);
+    }
+    return entry.font;
+}
+
+void AssetCache::report(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    out << "Asset                          decode ms  upload ms\n";
+    for (const auto& item : _entries) {
+        const Entry& entry = item.second;
+        out << std::left << std::setw(30) << item.first << std::right << std::fixed << std::setprecision(2)
+            << std::setw(11) << entry.decodeMs << std::setw(11) << entry.uploadMs;
+        if (entry.failed) out << "  (missing)";
+        else if (entry.background) out << "  (background)";
+        out << "\n";
+    }
+}
+
+} // namespace coup
@@ -0,0 +1,91 @@
+// idocohen963@gmail.com
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace coup {
+
+/**
+ * @class AssetCache
+ * @brief Loads every texture and font of the GUI once and shares it between screens.
+ *
+ * Image files can be decoded ahead of time on a background thread (preload), while the
+ * welcome screen is shown. The GPU upload of a texture needs the window's GL context, so it
+ * happens on the GUI thread the first time the texture is requested. Files that fail to load
+ * are remembered too, so a missing background is not looked for again on every screen.
+ */
+class AssetCache {
+public:
+    /**
+     * @brief Constructor.
+     */
+    AssetCache() = default;
+
+    /**
+     * @brief Destructor. Waits for the background loader.
+     */
+    ~AssetCache();
+
+    AssetCache(const AssetCache&) = delete;
+    AssetCache& operator=(const AssetCache&) = delete;
+
+    /**
+     * @brief Starts decoding image files on a background thread.
+     * Can only be called once.
+     * @param paths The image files, in the order they will be needed.
+     */
+    void preload(const std::vector<std::string>& paths);
+
+    /**
+     * @brief Returns a texture, loading it on first use.
+     * Waits for the background loader if the file is being decoded there.
+     * @param path The image file.
+     * @return The shared texture, or nullptr if the file could not be loaded.
+     */
+    std::shared_ptr<const sf::Texture> texture(const std::string& path);
+
+    /**
+     * @brief Returns a font, loading it on first use.
+     * @param path The font file.
+     * @return The shared font.
+     * @throws std::runtime_error if the font file could not be loaded.
+     */
+    std::shared_ptr<const sf::Font> font(const std::string& path);
+
+    /**
+     * @brief Writes the decode and upload time of every asset.
+     * @param out The stream to write to.
+     */
+    void report(std::ostream& out) const;
+
+private:
+    /**
+     * @struct Entry
+     * @brief A texture or font and its loading state.
+     */
+    struct Entry {
+        std::unique_ptr<sf::Image> image;        ///< Decoded image waiting for upload
+        std::shared_ptr<sf::Texture> texture;    ///< Uploaded texture
+        std::shared_ptr<sf::Font> font;          ///< Loaded font
+        bool pending = false;                    ///< Queued on the background loader
+        bool failed = false;                     ///< The file could not be loaded
+        bool background = false;                 ///< Decoded by the background loader
+        double decodeMs = 0;                     ///< Time spent reading and decoding the file
+        double uploadMs = 0;                     ///< Time spent creating the texture
+    };
+
+    mutable std::mutex _mutex;               ///< Guards _entries
+    std::condition_variable _decoded;        ///< Signalled when the loader finishes a file
+    std::map<std::string, Entry> _entries;   ///< Assets by file path
+    std::thread _loader;                     ///< Background image decoder
+};
+
+} // namespace coup
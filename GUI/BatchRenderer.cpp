@@ -0,0 +1,94 @@
+// idocohen963@gmail.com
+#include "BatchRenderer.hpp"
+
+namespace coup {
+
+BatchRenderer::BatchRenderer(const sf::Font& font) : _cache(font), _rects(sf::Triangles) {
+}
+
+void BatchRenderer::clear() {
+    _rects.clear();
+    for (auto& item : _texts) {
+        item.second.clear();
+    }
+}
+
+void BatchRenderer::appendQuad(sf::VertexArray& array, const sf::FloatRect& rect, sf::Color color,
+                               const sf::FloatRect& texture) {
+    sf::Vector2f topLeft(rect.left, rect.top);
+    sf::Vector2f topRight(rect.left + rect.width, rect.top);
+    sf::Vector2f bottomLeft(rect.left, rect.top + rect.height);
+    sf::Vector2f bottomRight(rect.left + rect.width, rect.top + rect.height);
+    sf::Vector2f texTopLeft(texture.left, texture.top);
+    sf::Vector2f texTopRight(texture.left + texture.width, texture.top);
+    sf::Vector2f texBottomLeft(texture.left, texture.top + texture.height);
+    sf::Vector2f texBottomRight(texture.left + texture.width, texture.top + texture.height);
+
+    array.append(sf::Vertex(topLeft, color, texTopLeft));
+    array.append(sf::Vertex(topRight, color, texTopRight));
+    array.append(sf::Vertex(bottomLeft, color, texBottomLeft));
+    array.append(sf::Vertex(bottomLeft, color, texBottomLeft));
+    array.append(sf::Vertex(topRight, color, texTopRight));
+    array.append(sf::Vertex(bottomRight, color, texBottomRight));
+}
+
+void BatchRenderer::addRect(const sf::FloatRect& rect, sf::Color color) {
+    appendQuad(_rects, rect, color);
+}
+
+void BatchRenderer::addShape(const sf::RectangleShape& shape) {
+    sf::Vector2f position = shape.getPosition();
+    sf::Vector2f size = shape.getSize();
+    addRect(sf::FloatRect(position, size), shape.getFillColor());
+
+    // The outline grows outwards, as SFML draws it
+    float t = shape.getOutlineThickness();
+    if (t > 0.f && shape.getOutlineColor().a > 0) {
+        sf::Color color = shape.getOutlineColor();
+        addRect(sf::FloatRect(position.x - t, position.y - t, size.x + 2 * t, t), color);
+        addRect(sf::FloatRect(position.x - t, position.y + size.y, size.x + 2 * t, t), color);
+        addRect(sf::FloatRect(position.x - t, position.y, t, size.y), color);
+        addRect(sf::FloatRect(position.x + size.x, position.y, t, size.y), color);
+    }
+}
+
+void BatchRenderer::addText(const std::string& text, sf::Vector2f position, unsigned size, sf::Color color, bool bold) {
+    auto found = _texts.find(size);
+    if (found == _texts.end()) {
+        found = _texts.emplace(size, sf::VertexArray(sf::Triangles)).first;
+    }
+    sf::VertexArray& glyphs = found->second;
+    for (const sf::Vertex& vertex : _cache.get(text, size, bold).vertices) {
+        glyphs.append(sf::Vertex(vertex.position + position, color, vertex.texCoords));
+    }
+}
+
+float BatchRenderer::textWidth(const std::string& text, unsigned size, bool bold) {
+    return _cache.get(text, size, bold).width;
+}
+
+TextCache& BatchRenderer::textCache() {
+    return _cache;
+}
+
+std::size_t BatchRenderer::drawCalls() const {
+    std::size_t calls = _rects.getVertexCount() > 0 ? 1 : 0;
+    for (const auto& item : _texts) {
+        if (item.second.getVertexCount() > 0) ++calls;
+    }
+    return calls;
+}
+
+void BatchRenderer::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+    if (_rects.getVertexCount() > 0) {
+        target.draw(_rects, states);
+    }
+    for (const auto& item : _texts) {
+        if (item.second.getVertexCount() == 0) continue;
+        // Glyphs of every size live on their own page of the font texture
+        states.texture = &_cache.texture(item.first);
+        target.draw(item.second, states);
+    }
+}
+
+} // namespace coup
@@ -0,0 +1,95 @@
+// idocohen963@gmail.com
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <map>
+#include <string>
+#include "TextCache.hpp"
+
+namespace coup {
+
+/**
+ * @class BatchRenderer
+ * @brief Packs many rectangles and texts into a few vertex arrays.
+ *
+ * Every rectangle (fills, outlines and shadows) goes into one triangle list, drawn with a single
+ * call. Texts are copied from their cached layout (see TextCache) into one triangle list per
+ * character size, since the font keeps one glyph texture per size. A whole screen of panels and buttons is
+ * then drawn in one call plus one per text size, however many buttons it has.
+ *
+ * Rectangles are drawn before texts, so a text is never hidden by a rectangle added after it.
+ * clear() keeps the memory of the arrays, so rebuilding a screen of the same size allocates nothing,
+ * and a text already seen is only translated and colored, never laid out again.
+ */
+class BatchRenderer : public sf::Drawable {
+public:
+    /**
+     * @brief Constructor.
+     * @param font The font of all texts (must outlive the renderer).
+     */
+    explicit BatchRenderer(const sf::Font& font);
+
+    /**
+     * @brief Removes all rectangles and texts.
+     */
+    void clear();
+
+    /**
+     * @brief Adds a filled rectangle.
+     * @param rect The rectangle.
+     * @param color Fill color.
+     */
+    void addRect(const sf::FloatRect& rect, sf::Color color);
+
+    /**
+     * @brief Adds a rectangle shape: its fill, then its outline.
+     * Only the position, size, colors and outline thickness of the shape are used.
+     * @param shape The shape.
+     */
+    void addShape(const sf::RectangleShape& shape);
+
+    /**
+     * @brief Adds a text.
+     * @param text The text; '\n' starts a new line.
+     * @param position Top left corner, as for sf::Text.
+     * @param size Character size.
+     * @param color Text color.
+     * @param bold Whether to use bold glyphs.
+     */
+    void addText(const std::string& text, sf::Vector2f position, unsigned size, sf::Color color, bool bold = false);
+
+    /**
+     * @brief Measures the width of a one line text.
+     * @param text The text.
+     * @param size Character size.
+     * @param bold Whether to use bold glyphs.
+     * @return Width of the text in pixels.
+     */
+    float textWidth(const std::string& text, unsigned size, bool bold = false);
+
+    /**
+     * @brief Returns the layouts of the texts.
+     * @return The text cache.
+     */
+    TextCache& textCache();
+
+    /**
+     * @brief Returns the number of draw calls draw() issues.
+     * @return Draw calls per frame.
+     */
+    std::size_t drawCalls() const;
+
+protected:
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+private:
+    TextCache _cache;                        ///< Layouts of all texts added so far
+    sf::VertexArray _rects;                  ///< All rectangles
+    std::map<unsigned, sf::VertexArray> _texts;  ///< Glyphs by character size
+
+    static void appendQuad(sf::VertexArray& array, const sf::FloatRect& rect, sf::Color color,
+                           const sf::FloatRect& texture = sf::FloatRect());
+};
+
+} // namespace coup
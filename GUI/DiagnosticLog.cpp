@@ -0,0 +1,32 @@
+// idocohen963@gmail.com
+#include "DiagnosticLog.hpp"
+#include <iomanip>
+
+namespace coup {
+
+DiagnosticLog::DiagnosticLog() : _enabled(false), _start(std::chrono::steady_clock::now()), _entries(), _written(0) {
+}
+
+DiagnosticLog& DiagnosticLog::getInstance() {
+    static DiagnosticLog instance;
+    return instance;
+}
+
+void DiagnosticLog::dump(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint64_t first = _written > CAPACITY ? _written - CAPACITY : 0;
+    if (first > 0) {
+        out << "(" << first << " older messages dropped)\n";
+    }
+    for (uint64_t i = first; i < _written; ++i) {
+        const Entry& entry = _entries[i % CAPACITY];
+        out << std::fixed << std::setprecision(3) << std::setw(12) << entry.ms << " ms  " << entry.text << "\n";
+    }
+}
+
+uint64_t DiagnosticLog::written() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _written;
+}
+
+} // namespace coup
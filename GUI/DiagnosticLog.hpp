@@ -0,0 +1,100 @@
+// idocohen963@gmail.com
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <ostream>
+
+namespace coup {
+
+/**
+ * @class DiagnosticLog
+ * @brief Fixed-size ring of the most recent diagnostic messages of the GUI.
+ *
+ * Disabled by default: write() then returns after one relaxed atomic load, before formatting
+ * anything, so log calls can stay in the hot paths. When enabled, messages are formatted with
+ * printf-style formats into preallocated slots (long messages are truncated) and the oldest
+ * messages are overwritten. Any thread can write.
+ */
+class DiagnosticLog {
+public:
+    static const size_t CAPACITY = 256;     ///< Number of messages kept
+    static const size_t MESSAGE_SIZE = 120; ///< Maximum message length, including the terminator
+
+    /**
+     * @brief Returns the log of the GUI.
+     * @return The single log instance.
+     */
+    static DiagnosticLog& getInstance();
+
+    /**
+     * @brief Enables or disables recording.
+     * @param enabled The new value.
+     */
+    void setEnabled(bool enabled) { _enabled.store(enabled, std::memory_order_relaxed); }
+
+    /**
+     * @brief Returns whether messages are recorded.
+     * @return true if enabled.
+     */
+    bool isEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Records a message, if enabled.
+     * @param format printf-style format.
+     * @param args Arguments of the format (strings as const char*).
+     */
+    template <typename... Args>
+    void write(const char* format, Args... args) {
+        if (!isEnabled()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(_mutex);
+        Entry& entry = _entries[_written % CAPACITY];
+        entry.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+        formatInto(entry.text, format, args...);
+        ++_written;
+    }
+
+    /**
+     * @brief Writes the recorded messages, oldest first.
+     * @param out The stream to write to.
+     */
+    void dump(std::ostream& out) const;
+
+    /**
+     * @brief Returns the number of messages written since the start, including overwritten ones.
+     * @return Messages written.
+     */
+    uint64_t written() const;
+
+private:
+    /**
+     * @struct Entry
+     * @brief A recorded message.
+     */
+    struct Entry {
+        double ms;                 ///< Milliseconds since the log was created
+        char text[MESSAGE_SIZE];   ///< The message
+    };
+
+    std::atomic<bool> _enabled;
+    mutable std::mutex _mutex;
+    std::chrono::steady_clock::time_point _start;
+    Entry _entries[CAPACITY];
+    uint64_t _written;
+
+    DiagnosticLog();
+
+    static void formatInto(char* text, const char* format) { std::snprintf(text, MESSAGE_SIZE, "%s", format); }
+
+    template <typename... Args>
+    static void formatInto(char* text, const char* format, Args... args) {
+        std::snprintf(text, MESSAGE_SIZE, format, args...);
+    }
+};
+
+} // namespace coup
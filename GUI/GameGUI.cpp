@@ -1,46 +1,22 @@
 // idocohen963@gmail.com
 #include "GameGUI.hpp"
+#include "AllocationCounter.hpp"
+#include "GameLogic.hpp"
+#include "Labels.hpp"
+#include "PerfOverlay.hpp"
+#include "SpectatorGrid.hpp"
+#include "TimelineBar.hpp"
+#include "VisualStyle.hpp"
+#include <fstream>
 #include <iostream>
 #include <random>
-#include <map>
 #include <algorithm>
 #include <chrono> // For sf::Clock
+#include <thread>
 #include "PLAYER/PlayerFactory.hpp" 
 
 namespace coup {
 
-// === Visual Design Constants - DESIGN IMPROVEMENT ===
-// Modern color palette for enhanced UI
-namespace VisualStyle {
-    // Primary colors
-    const sf::Color PRIMARY_DARK = sf::Color(26, 32, 44);        // Dark blue-gray
-    const sf::Color PRIMARY_MEDIUM = sf::Color(45, 55, 72);      // Medium blue-gray
-    const sf::Color PRIMARY_LIGHT = sf::Color(74, 85, 104);      // Light blue-gray
-    
-    // Accent colors
-    const sf::Color ACCENT_BLUE = sf::Color(66, 153, 225);       // Modern blue
-    const sf::Color ACCENT_GREEN = sf::Color(72, 187, 120);      // Modern green
-    const sf::Color ACCENT_RED = sf::Color(245, 101, 101);       // Modern red
-    const sf::Color ACCENT_YELLOW = sf::Color(237, 203, 67);     // Modern yellow
-    const sf::Color ACCENT_PURPLE = sf::Color(159, 122, 234);    // Modern purple
-    
-    // Text colors
-    const sf::Color TEXT_PRIMARY = sf::Color(255, 255, 255);     // White
-    const sf::Color TEXT_SECONDARY = sf::Color(160, 174, 192);   // Light gray
-    const sf::Color TEXT_ACCENT = sf::Color(237, 203, 67);       // Yellow accent
-    
-    // Background gradients (simulated with solid colors)
-    const sf::Color BG_GRADIENT_TOP = sf::Color(45, 55, 72);
-    const sf::Color BG_GRADIENT_BOTTOM = sf::Color(26, 32, 44);
-    
-    // Button styles
-    const sf::Color BUTTON_PRIMARY = sf::Color(66, 153, 225);
-    const sf::Color BUTTON_SUCCESS = sf::Color(72, 187, 120);
-    const sf::Color BUTTON_DANGER = sf::Color(245, 101, 101);
-    const sf::Color BUTTON_WARNING = sf::Color(237, 203, 67);
-    const sf::Color BUTTON_HOVER = sf::Color(90, 170, 240);      // Lighter blue for hover effect
-}
-
 // Helper function to create rounded rectangle shape - DESIGN IMPROVEMENT
 sf::RectangleShape createRoundedButton(sf::Vector2f size, sf::Vector2f position, sf::Color fillColor) {
     sf::RectangleShape button(size);
@@ -53,7 +29,7 @@ sf::RectangleShape createRoundedButton(sf::Vector2f size, sf::Vector2f position,
 }
 
 // Helper function to create shadow effect - DESIGN IMPROVEMENT
-sf::RectangleShape createShadow(sf::Vector2f size, sf::Vector2f position, float offset = 4.f) {
+sf::RectangleShape createShadow(sf::Vector2f size, sf::Vector2f position, float offset) {
     sf::RectangleShape shadow(size);
     shadow.setPosition(position.x + offset, position.y + offset);
     shadow.setFillColor(sf::Color(0, 0, 0, 80)); // Semi-transparent black
@@ -62,52 +38,35 @@ sf::RectangleShape createShadow(sf::Vector2f size, sf::Vector2f position, float
 
 // === Conversion Helper Functions ===
 
-std::string GameGUI::roleToString(Role role) const {
-    static const std::map<Role, std::string> roleMap = {
-        {Role::Governor, "Governor"}, {Role::Spy, "Spy"},
-        {Role::Baron, "Baron"}, {Role::General, "General"},
-        {Role::Judge, "Judge"}, {Role::Merchant, "Merchant"}
-    };
-    auto it = roleMap.find(role);
-    return (it != roleMap.end()) ? it->second : "Unknown";
+const std::string& GameGUI::actionTypeToString(ActionType action) const {
+    return actionLabel(action);
 }
 
-std::string GameGUI::actionTypeToString(ActionType action) const {
-    static const std::map<ActionType, std::string> actionMap = {
-        {ActionType::Gather, "Gather"}, {ActionType::Tax, "Tax"},
-        {ActionType::Bribe, "Bribe"}, {ActionType::Arrest, "Arrest"},
-        {ActionType::Coup, "Coup"}, {ActionType::Sanction, "Sanction"},
-        {ActionType::Invest, "Invest"}, {ActionType::SpyOn, "Spy On"},
-        {ActionType::cancel, "Cancel"}
-    };
-    auto it = actionMap.find(action);
-    return (it != actionMap.end()) ? it->second : "Unknown";
-}
+// === GameGUI Class Implementation ===
 
-ActionType GameGUI::stringToActionType(const std::string& actionStr) const {
-    static const std::map<std::string, ActionType> actionMap = {
-        {"Gather", ActionType::Gather}, {"Tax", ActionType::Tax},
-        {"Bribe", ActionType::Bribe}, {"Arrest", ActionType::Arrest},
-        {"Coup", ActionType::Coup}, {"Sanction", ActionType::Sanction},
-        {"Invest", ActionType::Invest}, {"Spy On", ActionType::SpyOn},
-        {"Cancel", ActionType::cancel}
-    };
-    auto it = actionMap.find(actionStr);
-    if (it != actionMap.end()) {
-        return it->second;
-    }
-    // This should ideally not happen if UI buttons are generated correctly
-    throw std::runtime_error("Invalid action string provided: " + actionStr);
+GameGUI::GameGUI(Game& gameRef)
+    // DESIGN IMPROVEMENT: Larger window size for better layout and modern styling
+    : GameGUI(gameRef, std::make_unique<WindowSurface>(900, 700, "Coup Game - Modern Edition")) {
 }
 
-// === GameGUI Class Implementation ===
+GameGUI::GameGUI(Game& gameRef, std::unique_ptr<RenderSurface> renderSurface)
+    : surface(std::move(renderSurface)), window(*surface),
+      fontHandle(assets.font("assets/fonts/arial.ttf")), font(*fontHandle), game(gameRef),
+      rng(std::random_device{}()) {
+    // Decode the screen backgrounds while the welcome screen is shown
+    assets.preload({"background.jpg", "wood_background.jpg", "gametable.jpg"});
+}
 
-GameGUI::GameGUI(Game& gameRef) : window(sf::VideoMode(900, 700), "Coup Game - Modern Edition"), game(gameRef) {
-    // DESIGN IMPROVEMENT: Larger window size for better layout and modern styling
-    window.setFramerateLimit(60);
-    if (!font.loadFromFile("assets/fonts/arial.ttf")) {
-        throw std::runtime_error("Fatal Error: Failed to load font 'assets/fonts/arial.ttf'. Make sure it's in the execution directory.");
+bool GameGUI::loadBackground(const std::string& path, sf::Sprite& sprite) {
+    std::shared_ptr<const sf::Texture> texture = assets.texture(path);
+    if (!texture) {
+        return false;
     }
+    // The cache keeps the texture alive for the lifetime of the GUI, so the sprite can point to it
+    sprite.setTexture(*texture, true);
+    sprite.setScale(static_cast<float>(window.getSize().x) / texture->getSize().x,
+                    static_cast<float>(window.getSize().y) / texture->getSize().y);
+    return true;
 }
 
 void GameGUI::run() {
@@ -117,17 +76,13 @@ void GameGUI::run() {
 }
 
 void GameGUI::showWelcomeScreen() {
+    window.beginScreen("welcome");
     // DESIGN IMPROVEMENT: Modern gradient background instead of single color
-    sf::Texture bgTexture;
     sf::Sprite background;
     sf::RectangleShape colorBackground;
-    bool hasTexture = false;
+    bool hasTexture = loadBackground("background.jpg", background); // Decoded once by the asset cache
     
-    if (bgTexture.loadFromFile("background.jpg")) {
-        background.setTexture(bgTexture);
-        background.setScale(static_cast<float>(window.getSize().x) / bgTexture.getSize().x, static_cast<float>(window.getSize().y) / bgTexture.getSize().y);
-        hasTexture = true;
-    } else {
+    if (!hasTexture) {
         // DESIGN IMPROVEMENT: Modern gradient-like background
         colorBackground.setSize(sf::Vector2f(window.getSize().x, window.getSize().y));
         colorBackground.setFillColor(VisualStyle::PRIMARY_DARK); // Modern dark background
@@ -203,22 +158,18 @@ void GameGUI::showWelcomeScreen() {
 }
 
 void GameGUI::showPlayerInputScreen() {
+    window.beginScreen("players");
     std::vector<std::string> playerNames;
     std::string currentInput;
     std::string errorMessage;
     sf::Clock errorClock;
     
     // DESIGN IMPROVEMENT: Modern background styling
-    sf::Texture bgTexture;
     sf::Sprite background;
     sf::RectangleShape colorBackground;
-    bool hasTexture = false;
+    bool hasTexture = loadBackground("wood_background.jpg", background); // Decoded once by the asset cache
     
-    if (bgTexture.loadFromFile("wood_background.jpg")) {
-        background.setTexture(bgTexture);
-        background.setScale(static_cast<float>(window.getSize().x) / bgTexture.getSize().x, static_cast<float>(window.getSize().y) / bgTexture.getSize().y);
-        hasTexture = true;
-    } else {
+    if (!hasTexture) {
         // DESIGN IMPROVEMENT: Modern gradient background
         colorBackground.setSize(sf::Vector2f(window.getSize().x, window.getSize().y));
         colorBackground.setFillColor(VisualStyle::PRIMARY_MEDIUM);
@@ -366,25 +317,19 @@ void GameGUI::showPlayerInputScreen() {
 }
 
 void GameGUI::showRoleRevealScreen(const std::vector<std::string>& playerNames) {
+    window.beginScreen("roles");
     // DESIGN IMPROVEMENT: Modern background with enhanced styling
-    sf::Texture bgTexture;
     sf::Sprite background;
     sf::RectangleShape colorBackground;
-    bool hasTexture = false;
+    bool hasTexture = loadBackground("background.jpg", background); // Decoded once by the asset cache
     
-    if (bgTexture.loadFromFile("background.jpg")) {
-        background.setTexture(bgTexture);
-        background.setScale(window.getSize().x / (float)bgTexture.getSize().x, window.getSize().y / (float)bgTexture.getSize().y);
-        hasTexture = true;
-    } else {
+    if (!hasTexture) {
         // DESIGN IMPROVEMENT: Rich gradient-like background
         colorBackground.setSize(sf::Vector2f(window.getSize().x, window.getSize().y));
         colorBackground.setFillColor(VisualStyle::PRIMARY_DARK);
     }
 
     std::vector<std::string> roles = {"General", "Governor", "Judge", "Merchant", "Baron", "Spy"};
-    std::random_device rd;
-    std::mt19937 rng(rd());
     std::shuffle(roles.begin(), roles.end(), rng);
 
     for (size_t i = 0; i < playerNames.size(); ++i) {
@@ -416,6 +361,26 @@ void GameGUI::showRoleRevealScreen(const std::vector<std::string>& playerNames)
         revealText.setStyle(sf::Text::Bold);
         revealText.setPosition(revealButtonPos.x + (revealButtonSize.x - revealText.getLocalBounds().width) / 2.f, revealButtonPos.y + 20.f);
         
+        // DESIGN IMPROVEMENT: Role reveal with dramatic styling and card-like appearance
+        // Built once per player, shown after the click without being rebuilt every frame
+        sf::RectangleShape roleCard(sf::Vector2f(400, 150));
+        roleCard.setPosition((window.getSize().x - roleCard.getSize().x) / 2.f, 200.f);
+        roleCard.setFillColor(VisualStyle::PRIMARY_MEDIUM);
+        roleCard.setOutlineThickness(3.f);
+        roleCard.setOutlineColor(VisualStyle::ACCENT_YELLOW);
+
+        sf::RectangleShape roleCardShadow = createShadow(sf::Vector2f(400, 150), sf::Vector2f((window.getSize().x - 400) / 2.f, 200.f), 8.f);
+
+        sf::Text roleText("Your Role: " + assignedRole, font, 32);
+        roleText.setFillColor(VisualStyle::TEXT_ACCENT);
+        roleText.setStyle(sf::Text::Bold);
+        roleText.setPosition((window.getSize().x - roleText.getLocalBounds().width) / 2.f, 240.f);
+
+        // DESIGN IMPROVEMENT: Remember and strategize text
+        sf::Text strategyText("Remember your abilities and plan your strategy!", font, 16);
+        strategyText.setFillColor(VisualStyle::TEXT_SECONDARY);
+        strategyText.setPosition((window.getSize().x - strategyText.getLocalBounds().width) / 2.f, 300.f);
+
         sf::Clock revealTimer;
         bool waiting = false;
         
@@ -430,6 +395,8 @@ void GameGUI::showRoleRevealScreen(const std::vector<std::string>& playerNames)
                     sf::Vector2f mousePos(event.mouseButton.x, event.mouseButton.y);
                     if (revealButton.getGlobalBounds().contains(mousePos)) {
                         game.addPlayer(playerNames[i], assignedRole);
+                        playerText.setString(playerNames[i] + ", this is your role:");
+                        playerText.setPosition((window.getSize().x - playerText.getLocalBounds().width) / 2.f, 100.f);
                         waiting = true;
                         revealTimer.restart();
                     }
@@ -444,28 +411,6 @@ void GameGUI::showRoleRevealScreen(const std::vector<std::string>& playerNames)
             }
 
             if (waiting) {
-                // DESIGN IMPROVEMENT: Role reveal with dramatic styling and card-like appearance
-                sf::RectangleShape roleCard(sf::Vector2f(400, 150));
-                roleCard.setPosition((window.getSize().x - roleCard.getSize().x) / 2.f, 200.f);
-                roleCard.setFillColor(VisualStyle::PRIMARY_MEDIUM);
-                roleCard.setOutlineThickness(3.f);
-                roleCard.setOutlineColor(VisualStyle::ACCENT_YELLOW);
-                
-                sf::RectangleShape roleCardShadow = createShadow(sf::Vector2f(400, 150), sf::Vector2f((window.getSize().x - 400) / 2.f, 200.f), 8.f);
-                
-                sf::Text roleText("Your Role: " + assignedRole, font, 32);
-                roleText.setFillColor(VisualStyle::TEXT_ACCENT);
-                roleText.setStyle(sf::Text::Bold);
-                roleText.setPosition((window.getSize().x - roleText.getLocalBounds().width) / 2.f, 240.f);
-                
-                playerText.setString(playerNames[i] + ", this is your role:");
-                playerText.setPosition((window.getSize().x - playerText.getLocalBounds().width) / 2.f, 100.f);
-                
-                // DESIGN IMPROVEMENT: Remember and strategize text
-                sf::Text strategyText("Remember your abilities and plan your strategy!", font, 16);
-                strategyText.setFillColor(VisualStyle::TEXT_SECONDARY);
-                strategyText.setPosition((window.getSize().x - strategyText.getLocalBounds().width) / 2.f, 300.f);
-                
                 window.draw(roleCardShadow);
                 window.draw(roleCard);
                 window.draw(playerText);
@@ -489,307 +434,426 @@ void GameGUI::showRoleRevealScreen(const std::vector<std::string>& playerNames)
     game.startGame();
 }
 
+void GameGUI::captureTable(TableView& view) const {
+    Player* currentPlayer = game.getCurrentPlayer();
+    view.playerName = currentPlayer->getName();
+    view.role = currentPlayer->getRoleType();
+    view.coins = currentPlayer->getCoins();
+    view.sanctioned = currentPlayer->isSanctioned();
+
+    view.seats.clear();
+    for (const Player* p : game.getPlayers()) {
+        view.seats.push_back(SeatView{p->getName(), p->getCoins(), p->isActive()});
+    }
+    view.actions.clear();
+    for (ActionType action : currentPlayer->getAvailableActions()) {
+        if (action == ActionType::cancel) continue; // "cancel" is not a player-initiated action button
+        view.actions.push_back(ActionView{action});
+    }
+}
+
 void GameGUI::runGameScreen() {
-    // DESIGN IMPROVEMENT: Enhanced game screen background
-    sf::Texture bgTexture;
+    window.beginScreen("game");
+    // The modal backdrop draws locals of this function, so it must not outlive it
+    struct BackdropReset {
+        std::function<void()>& backdrop;
+        ~BackdropReset() { backdrop = nullptr; }
+    } backdropReset{drawBackdrop};
+
+    // DESIGN IMPROVEMENT: Enhanced game screen, built once and updated when the game changes
+    TableScene scene(font, window.getSize());
     sf::Sprite background;
-    sf::RectangleShape colorBackground;
-    bool hasTexture = false;
-    
-    if (bgTexture.loadFromFile("gametable.jpg")) {
-        background.setTexture(bgTexture);
-        background.setScale(static_cast<float>(window.getSize().x) / bgTexture.getSize().x, static_cast<float>(window.getSize().y) / bgTexture.getSize().y);
-        hasTexture = true;
-    } else {
-        // DESIGN IMPROVEMENT: Rich game table appearance
-        colorBackground.setSize(sf::Vector2f(window.getSize().x, window.getSize().y));
-        colorBackground.setFillColor(VisualStyle::PRIMARY_DARK);
+    if (loadBackground("gametable.jpg", background)) { // Decoded once by the asset cache
+        scene.setBackground(background);
     }
-    
+    PerfOverlay overlay(font); // Toggled with F3
+    drawBackdrop = [this, &scene, &overlay]() {
+        window.draw(scene);
+        window.draw(overlay);
+    };
+
+    // From here on only the logic thread touches the game; this thread renders its snapshots
+    GameLogic logic(game, [this](TableView& view) { captureTable(view); });
+    auto stopAndRecord = [this, &logic]() {
+        logic.stop();
+        writeRecording(logic.recording());
+    };
+    std::shared_ptr<const TableSnapshot> state;
+    uint64_t errorsShown = 0;
+    uint64_t reportsShown = 0;
+    uint64_t commandsTimed = 0;
+    uint64_t allocations = allocationCount();
+    bool waiting = true; // A command was sent and its result is not published yet
+    bool redraw = true;
+
     while (window.isOpen()) {
-        // Count active players directly
-        int activePlayers = 0;
-        for (const auto& p : game.getPlayers()) {
-            if (p->isActive()) {
-                activePlayers++;
-            }
-        }
-        
-        std::cout << "Debug: getNumPlayers()=" << game.getNumPlayers() << ", actual active players=" << activePlayers << std::endl;
-        
-        if (activePlayers <= 1) {
-            try {
-                showWinnerScreen(game.winner());
-            } catch (const std::runtime_error&) {
-                 showWinnerScreen("No one"); // In case of an empty game or other errors
+        std::shared_ptr<const TableSnapshot> latest = logic.snapshot();
+        if (latest && (!state || latest->version != state->version)) {
+            state = latest;
+            waiting = false;
+            redraw = scene.update(state->table) || redraw;
+            if (state->commands != commandsTimed) {
+                commandsTimed = state->commands;
+                overlay.addAction(state->commandMs);
             }
-            return;
-        }
 
-        Player* currentPlayer = game.getCurrentPlayer();
-        
-        // Check if current player is active, if not try to advance to next active player
-        if (!currentPlayer->isActive()) {
-            // Count active players first to see if game should end
-            int activePlayerCount = 0;
-            for (const auto& player : game.getPlayers()) {
-                if (player->isActive()) {
-                    activePlayerCount++;
-                }
+            if (state->reports != reportsShown) {
+                reportsShown = state->reports;
+                viewPlayerCoinsPopup(state->spiedName, state->spiedCoins);
+                redraw = true;
             }
-            
-            // If only one or no active players remain, the game is over
-            if (activePlayerCount <= 1) {
-                if (activePlayerCount == 1) {
-                    // Find the last active player and declare winner
-                    for (const auto& player : game.getPlayers()) {
-                        if (player->isActive()) {
-                            showWinnerScreen(player->getName());
-                            return;
-                        }
-                    }
+            if (state->errors != errorsShown) {
+                errorsShown = state->errors;
+                showErrorPopup(state->error);
+                redraw = true;
+            }
+            if (state->phase == TablePhase::GameOver) {
+                stopAndRecord();
+                if (!state->winner.empty()) {
+                    showWinnerScreen(state->winner);
                 }
-                showWinnerScreen("No one");
                 return;
             }
-            
-            // Safe to advance turn since there are enough active players
-            try {
-                game.nextTurn();
-                currentPlayer = game.getCurrentPlayer();
-            } catch (const std::runtime_error& e) {
-                std::cout << "Error advancing turn: " << e.what() << std::endl;
-                break;
+            if (state->phase == TablePhase::CancelPrompt && window.isOpen()) {
+                std::string answer = showCancelConfirmation(state->asked);
+                logic.post(GameCommand{GameCommand::Answer, ActionType::cancel, -1, answer == "yes"});
+                waiting = true;
+                redraw = true;
             }
         }
-        std::string roleStr = roleToString(currentPlayer->getRoleType());
 
-        // DESIGN IMPROVEMENT: Enhanced left panel with card-like player info
-        float leftMargin = 30.f;
-        float startY = 30.f;
-        
-        // Player info card background
-        sf::RectangleShape playerInfoCard(sf::Vector2f(350, 280));
-        playerInfoCard.setPosition(leftMargin, startY);
-        playerInfoCard.setFillColor(VisualStyle::PRIMARY_MEDIUM);
-        playerInfoCard.setOutlineThickness(2.f);
-        playerInfoCard.setOutlineColor(VisualStyle::ACCENT_BLUE);
-        
-        sf::RectangleShape playerInfoShadow = createShadow(sf::Vector2f(350, 280), sf::Vector2f(leftMargin, startY), 5.f);
-
-        // DESIGN IMPROVEMENT: Enhanced text styling with hierarchy
-        sf::Text turnText(currentPlayer->getName() + "'s Turn", font, 26);
-        turnText.setFillColor(VisualStyle::TEXT_ACCENT);
-        turnText.setStyle(sf::Text::Bold);
-        turnText.setPosition(leftMargin + 20.f, startY + 20.f);
-
-        sf::Text roleText("Role: " + roleStr, font, 20);
-        roleText.setFillColor(VisualStyle::TEXT_PRIMARY);
-        roleText.setPosition(leftMargin + 20.f, startY + 60.f);
-
-        sf::Text coinsText("Coins: " + std::to_string(currentPlayer->getCoins()), font, 20);
-        coinsText.setFillColor(VisualStyle::ACCENT_YELLOW);
-        coinsText.setStyle(sf::Text::Bold);
-        coinsText.setPosition(leftMargin + 20.f, startY + 90.f);
-
-        sf::Text statusText(std::string("Sanctioned: ") + (currentPlayer->isSanctioned() ? "Yes" : "No"), font, 18);
-        statusText.setFillColor(currentPlayer->isSanctioned() ? VisualStyle::ACCENT_RED : VisualStyle::ACCENT_GREEN);
-        statusText.setPosition(leftMargin + 20.f, startY + 120.f);
-
-        // DESIGN IMPROVEMENT: Active players list with better formatting
-        std::string alivePlayersStr = "Active Players:\n";
-        int playerCount = 0;
-        for (const auto& p : game.getPlayers()) {
-            if (p->isActive()) {
-                alivePlayersStr += "• " + p->getName() + " (" + std::to_string(p->getCoins()) + " coins)\n";
-                playerCount++;
+        redraw = overlay.refresh() || redraw;
+        if (redraw && window.isOpen()) {
+            auto frameStart = std::chrono::steady_clock::now();
+            window.clear(VisualStyle::PRIMARY_DARK);
+            window.draw(scene);
+            window.draw(overlay);
+            window.display();
+            redraw = false;
+
+            uint64_t allocated = allocationCount();
+            overlay.addFrame(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count(),
+                             scene.drawCalls(), allocated - allocations);
+            allocations = allocated;
+        }
+
+        bool handled = false;
+        sf::Event event;
+        while (window.pollEvent(event)) {
+            handled = true;
+            if (event.type == sf::Event::Closed) {
+                window.close();
+                stopAndRecord();
+                return;
+            }
+            if (event.type == sf::Event::Resized || event.type == sf::Event::GainedFocus) {
+                redraw = true; // The window contents may have been lost
+            }
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3) {
+                overlay.setVisible(!overlay.isVisible());
+                redraw = true;
+            }
+            if (event.type != sf::Event::MouseButtonPressed || event.mouseButton.button != sf::Mouse::Left ||
+                waiting || !state || state->phase != TablePhase::Turn) {
+                continue;
+            }
+
+            sf::Vector2f mousePos(event.mouseButton.x, event.mouseButton.y);
+            ActionType action;
+            if (!scene.actionAt(mousePos, action)) {
+                continue;
             }
+            redraw = true; // Popups are drawn over the table
+
+            int target = -1;
+            if (action == ActionType::Coup || action == ActionType::Arrest || action == ActionType::Sanction || action == ActionType::SpyOn) {
+                std::string targetName = askForTargetPlayerName();
+                if (targetName.empty()) continue; // User cancelled target selection
+
+                const std::vector<SeatView>& seats = state->table.seats;
+                for (size_t seat = 0; seat < seats.size(); ++seat) {
+                    if (seats[seat].name == targetName) {
+                        target = static_cast<int>(seat);
+                        break;
+                    }
+                }
+                if (target < 0) {
+                    showErrorPopup("Player '" + targetName + "' not found.");
+                    continue;
+                }
+            }
+            waiting = logic.post(GameCommand{GameCommand::Act, action, target, false});
         }
-        sf::Text alivePlayersText(alivePlayersStr, font, 16);
-        alivePlayersText.setFillColor(VisualStyle::TEXT_SECONDARY);
-        alivePlayersText.setPosition(leftMargin + 20.f, startY + 160.f);
-        
-        // DESIGN IMPROVEMENT: Enhanced action buttons panel
-        std::vector<ActionType> availableActions = currentPlayer->getAvailableActions();
-        std::vector<sf::RectangleShape> actionButtons;
-        std::vector<sf::RectangleShape> actionShadows;
-        std::vector<sf::Text> actionTexts;
-        
-        float rightMargin = window.getSize().x - 280.f;
-        float buttonHeight = 50.f;
-        float buttonSpacing = 15.f;
-        float actionStartY = startY + 20.f;
-
-        // Action panel background
-        sf::RectangleShape actionPanel(sf::Vector2f(250, static_cast<float>(availableActions.size() * (buttonHeight + buttonSpacing) + 40)));
-        actionPanel.setPosition(rightMargin, startY);
-        actionPanel.setFillColor(VisualStyle::PRIMARY_MEDIUM);
-        actionPanel.setOutlineThickness(2.f);
-        actionPanel.setOutlineColor(VisualStyle::ACCENT_PURPLE);
-        
-        sf::RectangleShape actionPanelShadow = createShadow(actionPanel.getSize(), actionPanel.getPosition(), 5.f);
 
-        sf::Text actionTitle("Available Actions", font, 18);
-        actionTitle.setFillColor(VisualStyle::TEXT_ACCENT);
-        actionTitle.setStyle(sf::Text::Bold);
-        actionTitle.setPosition(rightMargin + 10.f, startY + 10.f);
+        if (!handled && !redraw) {
+            // Nothing to do until the next event or snapshot; the engine keeps working meanwhile
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+    stopAndRecord(); // The window was closed from a popup
+}
 
-        size_t button_idx = 0;
-        for (ActionType action : availableActions) {
-            if (action == ActionType::cancel) continue; // "cancel" is not a player-initiated action button
-            
-            sf::Vector2f buttonSize(220, buttonHeight);
-            sf::Vector2f buttonPos(rightMargin + 15.f, actionStartY + 40.f + button_idx * (buttonHeight + buttonSpacing));
-            
-            // DESIGN IMPROVEMENT: Color-coded action buttons
-            sf::Color buttonColor = VisualStyle::BUTTON_PRIMARY;
-            if (action == ActionType::Coup) buttonColor = VisualStyle::BUTTON_DANGER;
-            else if (action == ActionType::Gather || action == ActionType::Tax) buttonColor = VisualStyle::BUTTON_SUCCESS;
-            else if (action == ActionType::Bribe) buttonColor = VisualStyle::BUTTON_WARNING;
-            
-            sf::RectangleShape buttonShadow = createShadow(buttonSize, buttonPos, 3.f);
-            sf::RectangleShape button = createRoundedButton(buttonSize, buttonPos, buttonColor);
-            
-            actionShadows.push_back(buttonShadow);
-            actionButtons.push_back(button);
-
-            std::string actionStr = actionTypeToString(action);
-            sf::Text text(actionStr, font, 18);
-            text.setFillColor(VisualStyle::TEXT_PRIMARY);
-            text.setStyle(sf::Text::Bold);
-            text.setPosition(buttonPos.x + (buttonSize.x - text.getLocalBounds().width) / 2.f, buttonPos.y + 14.f);
-            actionTexts.push_back(text);
-            button_idx++;
+void GameGUI::writeRecording(const GameRecording& recording) const {
+    if (recordPath.empty()) {
+        return;
+    }
+    try {
+        std::ofstream out(recordPath);
+        if (!out) {
+            throw std::runtime_error("cannot open '" + recordPath + "'");
         }
+        saveRecording(recording, out);
+    } catch (const std::runtime_error& e) {
+        std::cerr << "Failed to save the recording: " << e.what() << std::endl;
+    }
+}
 
-        bool turnEnded = false;
-        while (window.isOpen() && !turnEnded) {
-            sf::Event event;
-            while (window.pollEvent(event)) {
-                if (event.type == sf::Event::Closed) {
-                    window.close();
-                    return;
-                }
-                if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
-                    sf::Vector2f mousePos(event.mouseButton.x, event.mouseButton.y);
-                    for (size_t i = 0; i < actionButtons.size(); ++i) {
-                        if (actionButtons[i].getGlobalBounds().contains(mousePos)) {
-                            ActionType action = stringToActionType(actionTexts[i].getString());
-                            Player* targetPlayer = nullptr;
-
-                            try {
-                                if (action == ActionType::Coup || action == ActionType::Arrest || action == ActionType::Sanction || action == ActionType::SpyOn) {
-                                    std::string targetName = askForTargetPlayerName();
-                                    if (targetName.empty()) continue; // User cancelled target selection
-                                    
-                                    bool found = false;
-                                    for (Player* p : game.getPlayers()) {
-                                        if (p->getName() == targetName) {
-                                            targetPlayer = p;
-                                            found = true;
-                                            break;
-                                        }
-                                    }
-                                    if (!found) {
-                                        showErrorPopup("Player '" + targetName + "' not found.");
-                                        continue;
-                                    }
-                                }
-
-                                ActionType executedAction = action; // Store the action before potential modification
-
-                                switch (action) {
-                                    case ActionType::Gather: currentPlayer->gather(); break;
-                                    case ActionType::Tax: currentPlayer->tax(); break;
-                                    case ActionType::Bribe: currentPlayer->bribe(); break;
-                                    case ActionType::Invest: currentPlayer->invest(); break;
-                                    case ActionType::Coup: currentPlayer->coup(*targetPlayer); break;
-                                    case ActionType::Arrest: currentPlayer->arrest(*targetPlayer); break;
-                                    case ActionType::Sanction: currentPlayer->sanction(*targetPlayer); break;
-                                    case ActionType::SpyOn: 
-                                        currentPlayer->spyOn(*targetPlayer);
-                                        viewPlayerCoinsPopup(targetPlayer->getName());
-                                        break;
-                                    default: break;
-                                }
-
-                                turnEnded = true;
-
-                                // Check for cancellation possibilities after the action
-                                for (Player* p : game.getPlayers()) {
-                                    // A player can cancel if they are active, not the current player, and their role allows it.
-                                    if (p->isActive() && p != currentPlayer && p->canCancel(executedAction)) {
-                                        std::string answer = showCancelConfirmation(p->getName());
-                                        if (answer == "yes") {
-                                            try {
-                                                // The target of the cancel action depends on the original action
-                                                Player& cancelTarget = (executedAction == ActionType::Coup) ? *targetPlayer : *currentPlayer;
-                                                p->cancel(cancelTarget);
-                                            } catch (const std::runtime_error& cancel_e) {
-                                                showErrorPopup(cancel_e.what());
-                                            }
-                                            break; // Only one player can cancel
-                                        }
-                                    }
-                                }
-
-                                // Note: All actions advance turn automatically, so we don't need to call nextTurn() here
-
-                            } catch (const std::runtime_error& e) {
-                                showErrorPopup(e.what());
-                                // Turn does not end on error, allowing player to choose another action
-                            }
+void GameGUI::runReplay(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Cannot open recording '" + path + "'");
+    }
+    GameRecording recording = loadRecording(in);
+    window.beginScreen("replay");
+
+    // The players of the replayed game find it through getInstance(), as in runGameScreen
+    Game::Binding binding(game);
+    ReplayTimeline timeline(recording);
+    TableScene scene(font, window.getSize());
+    sf::Sprite background;
+    if (loadBackground("gametable.jpg", background)) {
+        scene.setBackground(background);
+    }
+    TimelineBar bar(font, window.getSize());
+    PerfOverlay overlay(font); // Toggled with F3
+
+    static const float SPEEDS[] = {0.5f, 1.f, 2.f, 4.f, 8.f, 16.f}; // Moves per second
+    const size_t speedCount = sizeof(SPEEDS) / sizeof(SPEEDS[0]);
+    size_t speed = 1;
+    bool playing = false;
+    bool dragging = false;
+    size_t wanted = 0;           // Position asked for by the controls
+    float playedSeconds = 0.f;   // Play time not yet turned into moves
+    auto lastTick = std::chrono::steady_clock::now();
+    TableView view;
+    std::string caption;
+    uint64_t allocations = allocationCount();
+    bool redraw = true;
+    bool moved = true;
+
+    while (window.isOpen()) {
+        bool handled = false;
+        sf::Event event;
+        while (window.pollEvent(event)) {
+            handled = true;
+            if (event.type == sf::Event::Closed ||
+                (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape)) {
+                window.close();
+                return;
+            }
+            if (event.type == sf::Event::Resized || event.type == sf::Event::GainedFocus) {
+                redraw = true;
+            }
+            if (event.type == sf::Event::KeyPressed) {
+                switch (event.key.code) {
+                    case sf::Keyboard::Space:
+                        playing = !playing;
+                        if (playing && timeline.position() == timeline.length()) {
+                            wanted = 0; // Play again from the start
                         }
-                    }
+                        playedSeconds = 0.f;
+                        break;
+                    case sf::Keyboard::Left: playing = false; wanted = wanted > 0 ? wanted - 1 : 0; break;
+                    case sf::Keyboard::Right: playing = false; wanted = std::min(wanted + 1, timeline.length()); break;
+                    case sf::Keyboard::Up: speed = std::min(speed + 1, speedCount - 1); break;
+                    case sf::Keyboard::Down: speed = speed > 0 ? speed - 1 : 0; break;
+                    case sf::Keyboard::Home: wanted = 0; break;
+                    case sf::Keyboard::End: wanted = timeline.length(); break;
+                    case sf::Keyboard::F3: overlay.setVisible(!overlay.isVisible()); break;
+                    default: break;
                 }
+                redraw = true;
             }
+            if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+                dragging = bar.positionAt(sf::Vector2f(event.mouseButton.x, event.mouseButton.y), false, wanted);
+            } else if (event.type == sf::Event::MouseMoved && dragging) {
+                bar.positionAt(sf::Vector2f(event.mouseMove.x, event.mouseMove.y), true, wanted);
+            } else if (event.type == sf::Event::MouseButtonReleased) {
+                dragging = false;
+            }
+        }
 
-            // DESIGN IMPROVEMENT: Enhanced drawing with proper layering and modern styling
-            window.clear(VisualStyle::PRIMARY_DARK);
-            if (hasTexture) {
-                window.draw(background);
+        auto now = std::chrono::steady_clock::now();
+        if (playing && !dragging) {
+            playedSeconds += std::chrono::duration<float>(now - lastTick).count();
+            while (playedSeconds >= 1.f / SPEEDS[speed] && wanted < timeline.length()) {
+                playedSeconds -= 1.f / SPEEDS[speed];
+                ++wanted;
+            }
+            if (wanted == timeline.length()) {
+                playing = false;
+            }
+        }
+        lastTick = now;
+
+        if (wanted != timeline.position() || moved) {
+            // A seek restores the closest checkpoint, so it costs a few moves at most
+            auto seekStart = std::chrono::steady_clock::now();
+            timeline.seek(wanted);
+            overlay.addAction(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - seekStart).count());
+            captureTable(view);
+            view.actions.clear(); // Nothing can be played in a replay
+            redraw = scene.update(view) || redraw;
+
+            size_t position = timeline.position();
+            const GameRecording& recorded = timeline.recording();
+            if (position == 0) {
+                caption = "Start of the game";
+            } else if (position == timeline.length() && recorded.record.winner >= 0) {
+                caption = "Winner: " + recorded.names[recorded.record.winner];
             } else {
-                window.draw(colorBackground);
+                const ReplayMove& last = recorded.record.moves[position - 1];
+                caption = recorded.names[timeline.actor(position - 1)] + ": " + actionTypeToString(last.action);
+                if (last.target >= 0) {
+                    caption += " on " + recorded.names[last.target];
+                }
+                if (last.canceller >= 0) {
+                    caption += " (cancelled by " + recorded.names[last.canceller] + ")";
+                }
             }
-            
-            // Draw shadows first
-            window.draw(playerInfoShadow);
-            window.draw(actionPanelShadow);
-            for (const auto& shadow : actionShadows) {
-                window.draw(shadow);
+            moved = false;
+        }
+        redraw = bar.update(timeline.position(), timeline.length(), playing, SPEEDS[speed], caption) || redraw;
+        redraw = overlay.refresh() || redraw;
+
+        if (redraw) {
+            auto frameStart = std::chrono::steady_clock::now();
+            window.clear(VisualStyle::PRIMARY_DARK);
+            window.draw(scene);
+            window.draw(bar);
+            window.draw(overlay);
+            window.display();
+            redraw = false;
+
+            uint64_t allocated = allocationCount();
+            overlay.addFrame(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count(),
+                             scene.drawCalls() + bar.drawCalls(), allocated - allocations);
+            allocations = allocated;
+        } else if (!handled && !playing) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        } else if (!handled) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+void GameGUI::runSpectator(size_t tables) {
+    window.beginScreen("spectator");
+    // The bots play on their own threads; a table moves every 400 ms and its tile is refreshed at most every 250 ms
+    LiveTables live(tables, 0, std::chrono::milliseconds(400), rng());
+    SpectatorGrid grid(font, window.getSize(), tables, std::chrono::milliseconds(250));
+    PerfOverlay overlay(font); // Toggled with F3
+    uint64_t allocations = allocationCount();
+    bool redraw = true;
+
+    while (window.isOpen()) {
+        bool handled = false;
+        sf::Event event;
+        while (window.pollEvent(event)) {
+            handled = true;
+            if (event.type == sf::Event::Closed ||
+                (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape)) {
+                window.close();
+                return;
             }
-            
-            // Draw main elements
-            window.draw(playerInfoCard);
-            window.draw(actionPanel);
-            
-            // Draw text content
-            window.draw(turnText);
-            window.draw(roleText);
-            window.draw(coinsText);
-            window.draw(statusText);
-            window.draw(alivePlayersText);
-            window.draw(actionTitle);
-
-            // Draw action buttons and their text
-            for (size_t i = 0; i < actionButtons.size(); ++i) {
-                window.draw(actionButtons[i]);
-                window.draw(actionTexts[i]);
+            if (event.type == sf::Event::Resized || event.type == sf::Event::GainedFocus) {
+                redraw = true;
             }
-            
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3) {
+                overlay.setVisible(!overlay.isVisible());
+                redraw = true;
+            }
+        }
+
+        auto frameStart = std::chrono::steady_clock::now();
+        redraw = grid.update(live) > 0 || redraw;
+        redraw = overlay.refresh() || redraw;
+        if (redraw) {
+            window.clear(VisualStyle::PRIMARY_DARK);
+            window.draw(grid);
+            window.draw(overlay);
             window.display();
+            redraw = false;
+
+            uint64_t allocated = allocationCount();
+            overlay.addFrame(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count(),
+                             grid.drawCalls(), allocated - allocations);
+            allocations = allocated;
+        } else if (!handled) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+}
+
+bool GameGUI::runModal(sf::Vector2f panelSize, const std::function<bool(const sf::Event&, sf::Vector2f)>& onEvent,
+                       const std::function<void(const sf::RenderStates&)>& drawContent) {
+    // The panel is centered in the main window, its content is laid out in panel coordinates
+    sf::Vector2f origin((window.getSize().x - panelSize.x) / 2.f, (window.getSize().y - panelSize.y) / 2.f);
+    sf::RenderStates panelStates;
+    panelStates.transform.translate(origin);
+
+    // Dimmed backdrop, so the screen behind stays visible but clearly inactive
+    sf::RectangleShape dimmer(sf::Vector2f(window.getSize().x, window.getSize().y));
+    dimmer.setFillColor(sf::Color(0, 0, 0, 150));
+    sf::RectangleShape panelShadow = createShadow(panelSize, origin, 8.f);
+
+    bool redraw = true; // The first frame puts the panel up
+    while (window.isOpen()) {
+        sf::Event event;
+        while (window.pollEvent(event)) {
+            if (event.type == sf::Event::Closed) {
+                window.close();
+                return false; // Exit application
+            }
+            // Any event may change the panel (typed text, a resize or a focus change losing the contents)
+            redraw = true;
+            sf::Vector2f mouse;
+            if (event.type == sf::Event::MouseButtonPressed) {
+                mouse = sf::Vector2f(event.mouseButton.x - origin.x, event.mouseButton.y - origin.y);
+            }
+            if (onEvent(event, mouse)) {
+                return true;
+            }
+        }
+
+        if (!redraw) {
+            // The popup only changes on input; the table behind it is not rendered again meanwhile
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            continue;
         }
+        window.clear(VisualStyle::PRIMARY_DARK);
+        if (drawBackdrop) {
+            drawBackdrop();
+        }
+        window.draw(dimmer);
+        window.draw(panelShadow);
+        drawContent(panelStates);
+        window.display();
+        redraw = false;
     }
+    return false;
 }
 
 std::string GameGUI::askForTargetPlayerName() {
-    // DESIGN IMPROVEMENT: Modern modal window with enhanced styling
-    sf::RenderWindow inputWindow(sf::VideoMode(450, 250), "Select Target Player", sf::Style::Titlebar | sf::Style::Close);
-    
+    // DESIGN IMPROVEMENT: Modern modal overlay with enhanced styling
+    sf::Vector2f panelSize(450, 250);
+
     // Background with modern colors
-    sf::RectangleShape modalBackground(sf::Vector2f(450, 250));
+    sf::RectangleShape modalBackground(panelSize);
     modalBackground.setFillColor(VisualStyle::PRIMARY_MEDIUM);
-    
+    modalBackground.setOutlineThickness(2.f);
+    modalBackground.setOutlineColor(VisualStyle::ACCENT_BLUE);
+
     // DESIGN IMPROVEMENT: Enhanced prompt styling
     sf::Text prompt("Enter target player name:", font, 22);
     prompt.setFillColor(VisualStyle::TEXT_PRIMARY);
@@ -826,64 +890,54 @@ std::string GameGUI::askForTargetPlayerName() {
     instructionText.setFillColor(VisualStyle::TEXT_SECONDARY);
     instructionText.setPosition(30, 140);
 
-    while (inputWindow.isOpen()) {
-        sf::Event event;
-        while (inputWindow.pollEvent(event)) {
-            if (event.type == sf::Event::Closed) {
-                inputWindow.close();
-                return ""; // Window closed by user
+    std::string result; // Stays empty when the selection is cancelled
+    runModal(panelSize, [&](const sf::Event& event, sf::Vector2f mouse) {
+        if (event.type == sf::Event::TextEntered) {
+            if (event.text.unicode == '\b' && !inputText.empty()) { // Backspace
+                inputText.pop_back();
+            } else if (event.text.unicode == '\r' || event.text.unicode == '\n') { // Enter
+                result = inputText;
+                return true;
+            } else if (event.text.unicode >= 32 && event.text.unicode < 128) {
+                inputText += static_cast<char>(event.text.unicode);
             }
-            if (event.type == sf::Event::TextEntered) {
-                if (event.text.unicode == '\b' && !inputText.empty()) { // Backspace
-                    inputText.pop_back();
-                } else if (event.text.unicode == '\r' || event.text.unicode == '\n') { // Enter
-                    inputWindow.close();
-                    return inputText;
-                } else if (event.text.unicode >= 32 && event.text.unicode < 128) {
-                    inputText += static_cast<char>(event.text.unicode);
-                }
-                inputDisplay.setString("> " + inputText);
+            inputDisplay.setString("> " + inputText);
+        }
+        if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape) {
+            return true;
+        }
+        if (event.type == sf::Event::MouseButtonPressed) {
+            if (cancelButton.getGlobalBounds().contains(mouse)) {
+                return true;
             }
-            if (event.type == sf::Event::MouseButtonPressed) {
-                sf::Vector2i mousePos = sf::Mouse::getPosition(inputWindow);
-                if (cancelButton.getGlobalBounds().contains(static_cast<float>(mousePos.x), static_cast<float>(mousePos.y))) {
-                    inputWindow.close();
-                    return "";
-                }
-                if (confirmButton.getGlobalBounds().contains(static_cast<float>(mousePos.x), static_cast<float>(mousePos.y)) && !inputText.empty()) {
-                    inputWindow.close();
-                    return inputText;
-                }
+            if (confirmButton.getGlobalBounds().contains(mouse) && !inputText.empty()) {
+                result = inputText;
+                return true;
             }
         }
-        
-        inputWindow.clear(VisualStyle::PRIMARY_DARK);
-        inputWindow.draw(modalBackground);
-        inputWindow.draw(prompt);
-        inputWindow.draw(inputBox);
-        inputWindow.draw(inputDisplay);
-        inputWindow.draw(instructionText);
-        inputWindow.draw(cancelButton);
-        inputWindow.draw(confirmButton);
-        inputWindow.draw(cancelText);
-        inputWindow.draw(confirmText);
-        inputWindow.display();
-    }
-    return inputText;
+        return false;
+    }, [&](const sf::RenderStates& states) {
+        window.draw(modalBackground, states);
+        window.draw(prompt, states);
+        window.draw(inputBox, states);
+        window.draw(inputDisplay, states);
+        window.draw(instructionText, states);
+        window.draw(cancelButton, states);
+        window.draw(confirmButton, states);
+        window.draw(cancelText, states);
+        window.draw(confirmText, states);
+    });
+    return result;
 }
 
 void GameGUI::showWinnerScreen(const std::string& winnerName) {
+    window.beginScreen("winner");
     // DESIGN IMPROVEMENT: Dramatic winner screen with enhanced styling
-    sf::Texture bgTexture;
     sf::Sprite background;
     sf::RectangleShape colorBackground;
-    bool hasTexture = false;
+    bool hasTexture = loadBackground("background.jpg", background); // Decoded once by the asset cache
     
-    if (bgTexture.loadFromFile("background.jpg")) {
-        background.setTexture(bgTexture);
-        background.setScale(window.getSize().x / (float)bgTexture.getSize().x, window.getSize().y / (float)bgTexture.getSize().y);
-        hasTexture = true;
-    } else {
+    if (!hasTexture) {
         // DESIGN IMPROVEMENT: Celebration gradient background
         colorBackground.setSize(sf::Vector2f(window.getSize().x, window.getSize().y));
         colorBackground.setFillColor(VisualStyle::PRIMARY_DARK);
@@ -992,28 +1046,21 @@ void GameGUI::showWinnerScreen(const std::string& winnerName) {
     }
 }
 
-void GameGUI::viewPlayerCoinsPopup(const std::string& targetName) {
-    Player* target = nullptr;
-    for(Player* p : game.getPlayers()) {
-        if (p->getName() == targetName) {
-            target = p;
-            break;
-        }
-    }
-    if (!target) return; // Should not happen if logic is correct
-
-    // DESIGN IMPROVEMENT: Enhanced spy report window with modern styling
-    sf::RenderWindow popupWindow(sf::VideoMode(450, 280), "🕵️ Spy Report", sf::Style::Titlebar | sf::Style::Close);
+void GameGUI::viewPlayerCoinsPopup(const std::string& targetName, int coins) {
+    // DESIGN IMPROVEMENT: Enhanced spy report overlay with modern styling
+    sf::Vector2f panelSize(450, 280);
     
     // Background
-    sf::RectangleShape modalBackground(sf::Vector2f(450, 280));
+    sf::RectangleShape modalBackground(panelSize);
     modalBackground.setFillColor(VisualStyle::PRIMARY_MEDIUM);
+    modalBackground.setOutlineThickness(2.f);
+    modalBackground.setOutlineColor(VisualStyle::ACCENT_PURPLE);
     
     // DESIGN IMPROVEMENT: Spy-themed header
     sf::Text headerText("SPY INTELLIGENCE REPORT", font, 20);
     headerText.setFillColor(VisualStyle::ACCENT_PURPLE);
     headerText.setStyle(sf::Text::Bold);
-    headerText.setPosition((popupWindow.getSize().x - headerText.getLocalBounds().width) / 2.f, 30.f);
+    headerText.setPosition((panelSize.x - headerText.getLocalBounds().width) / 2.f, 30.f);
     
     // DESIGN IMPROVEMENT: Target info card
     sf::RectangleShape infoCard(sf::Vector2f(380, 100));
@@ -1035,14 +1082,14 @@ void GameGUI::viewPlayerCoinsPopup(const std::string& targetName) {
     coinsLabel.setFillColor(VisualStyle::TEXT_SECONDARY);
     coinsLabel.setPosition(50, 155);
     
-    sf::Text infoText(std::to_string(target->getCoins()) + " coins", font, 24);
+    sf::Text infoText(std::to_string(coins) + " coins", font, 24);
     infoText.setFillColor(VisualStyle::ACCENT_YELLOW);
     infoText.setStyle(sf::Text::Bold);
     infoText.setPosition(200, 155);
 
     // DESIGN IMPROVEMENT: Modern OK button
     sf::Vector2f okButtonSize(120, 40);
-    sf::Vector2f okButtonPos((popupWindow.getSize().x - okButtonSize.x) / 2.f, 210.f);
+    sf::Vector2f okButtonPos((panelSize.x - okButtonSize.x) / 2.f, 210.f);
     
     sf::RectangleShape okButtonShadow = createShadow(okButtonSize, okButtonPos, 3.f);
     sf::RectangleShape okButton = createRoundedButton(okButtonSize, okButtonPos, VisualStyle::BUTTON_SUCCESS);
@@ -1052,64 +1099,55 @@ void GameGUI::viewPlayerCoinsPopup(const std::string& targetName) {
     okText.setStyle(sf::Text::Bold);
     okText.setPosition(okButtonPos.x + (okButtonSize.x - okText.getLocalBounds().width) / 2.f, okButtonPos.y + 10.f);
 
-    while (popupWindow.isOpen()) {
-        sf::Event event;
-        while (popupWindow.pollEvent(event)) {
-            if (event.type == sf::Event::Closed) popupWindow.close();
-            if (event.type == sf::Event::MouseButtonPressed) {
-                sf::Vector2i mouse = sf::Mouse::getPosition(popupWindow);
-                if (okButton.getGlobalBounds().contains(static_cast<float>(mouse.x), static_cast<float>(mouse.y))) {
-                    popupWindow.close();
-                }
-            }
-            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape) {
-                popupWindow.close();
-            }
+    runModal(panelSize, [&](const sf::Event& event, sf::Vector2f mouse) {
+        if (event.type == sf::Event::MouseButtonPressed && okButton.getGlobalBounds().contains(mouse)) {
+            return true;
         }
-
-        popupWindow.clear(VisualStyle::PRIMARY_DARK);
-        popupWindow.draw(modalBackground);
-        popupWindow.draw(headerText);
-        popupWindow.draw(infoCard);
-        popupWindow.draw(targetLabel);
-        popupWindow.draw(targetText);
-        popupWindow.draw(coinsLabel);
-        popupWindow.draw(infoText);
-        popupWindow.draw(okButtonShadow);
-        popupWindow.draw(okButton);
-        popupWindow.draw(okText);
-        popupWindow.display();
-    }
+        return event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape;
+    }, [&](const sf::RenderStates& states) {
+        window.draw(modalBackground, states);
+        window.draw(headerText, states);
+        window.draw(infoCard, states);
+        window.draw(targetLabel, states);
+        window.draw(targetText, states);
+        window.draw(coinsLabel, states);
+        window.draw(infoText, states);
+        window.draw(okButtonShadow, states);
+        window.draw(okButton, states);
+        window.draw(okText, states);
+    });
 }
 
 std::string GameGUI::showCancelConfirmation(const std::string& playerName) {
     // DESIGN IMPROVEMENT: Enhanced cancel confirmation with dramatic styling
-    sf::RenderWindow popupWindow(sf::VideoMode(500, 300), "🚫 Cancel Action?", sf::Style::Titlebar);
+    sf::Vector2f panelSize(500, 300);
 
     // Background
-    sf::RectangleShape modalBackground(sf::Vector2f(500, 300));
+    sf::RectangleShape modalBackground(panelSize);
     modalBackground.setFillColor(VisualStyle::PRIMARY_MEDIUM);
+    modalBackground.setOutlineThickness(2.f);
+    modalBackground.setOutlineColor(VisualStyle::ACCENT_RED);
     
     // DESIGN IMPROVEMENT: Attention-grabbing header
     sf::Text headerText("ACTION CANCELLATION", font, 18);
     headerText.setFillColor(VisualStyle::ACCENT_RED);
     headerText.setStyle(sf::Text::Bold);
-    headerText.setPosition((popupWindow.getSize().x - headerText.getLocalBounds().width) / 2.f, 30.f);
+    headerText.setPosition((panelSize.x - headerText.getLocalBounds().width) / 2.f, 30.f);
 
     // DESIGN IMPROVEMENT: Player name with emphasis
     sf::Text playerText(playerName, font, 28);
     playerText.setFillColor(VisualStyle::TEXT_ACCENT);
     playerText.setStyle(sf::Text::Bold);
-    playerText.setPosition((popupWindow.getSize().x - playerText.getLocalBounds().width) / 2.f, 70.f);
+    playerText.setPosition((panelSize.x - playerText.getLocalBounds().width) / 2.f, 70.f);
     
     sf::Text questionText("Do you want to cancel the current action?", font, 20);
     questionText.setFillColor(VisualStyle::TEXT_PRIMARY);
-    questionText.setPosition((popupWindow.getSize().x - questionText.getLocalBounds().width) / 2.f, 110.f);
+    questionText.setPosition((panelSize.x - questionText.getLocalBounds().width) / 2.f, 110.f);
     
     // DESIGN IMPROVEMENT: Warning message
     sf::Text warningText("⚠️ This decision is final and cannot be undone", font, 16);
     warningText.setFillColor(VisualStyle::TEXT_SECONDARY);
-    warningText.setPosition((popupWindow.getSize().x - warningText.getLocalBounds().width) / 2.f, 150.f);
+    warningText.setPosition((panelSize.x - warningText.getLocalBounds().width) / 2.f, 150.f);
 
     // DESIGN IMPROVEMENT: Enhanced Yes/No buttons with proper styling
     sf::Vector2f buttonSize(140, 50);
@@ -1132,72 +1170,63 @@ std::string GameGUI::showCancelConfirmation(const std::string& playerName) {
     noText.setStyle(sf::Text::Bold);
     noText.setPosition(noButtonPos.x + (buttonSize.x - noText.getLocalBounds().width) / 2.f, noButtonPos.y + 16.f);
 
-    while (popupWindow.isOpen()) {
-        sf::Event event;
-        while (popupWindow.pollEvent(event)) {
-            if (event.type == sf::Event::Closed) {
-                popupWindow.close();
-                return "no";
+    std::string answer = "no"; // Closing the window counts as a refusal
+    runModal(panelSize, [&](const sf::Event& event, sf::Vector2f mouse) {
+        if (event.type == sf::Event::MouseButtonPressed) {
+            if (yesButton.getGlobalBounds().contains(mouse)) {
+                answer = "yes";
+                return true;
             }
-            if (event.type == sf::Event::MouseButtonPressed) {
-                sf::Vector2i mousePos = sf::Mouse::getPosition(popupWindow);
-                if (yesButton.getGlobalBounds().contains(static_cast<float>(mousePos.x), static_cast<float>(mousePos.y))) {
-                    popupWindow.close();
-                    return "yes";
-                }
-                if (noButton.getGlobalBounds().contains(static_cast<float>(mousePos.x), static_cast<float>(mousePos.y))) {
-                    popupWindow.close();
-                    return "no";
-                }
+            if (noButton.getGlobalBounds().contains(mouse)) {
+                return true;
             }
-            // DESIGN IMPROVEMENT: Keyboard shortcuts
-            if (event.type == sf::Event::KeyPressed) {
-                if (event.key.code == sf::Keyboard::Y) {
-                    popupWindow.close();
-                    return "yes";
-                }
-                if (event.key.code == sf::Keyboard::N || event.key.code == sf::Keyboard::Escape) {
-                    popupWindow.close();
-                    return "no";
-                }
+        }
+        // DESIGN IMPROVEMENT: Keyboard shortcuts
+        if (event.type == sf::Event::KeyPressed) {
+            if (event.key.code == sf::Keyboard::Y) {
+                answer = "yes";
+                return true;
+            }
+            if (event.key.code == sf::Keyboard::N || event.key.code == sf::Keyboard::Escape) {
+                return true;
             }
         }
-
-        popupWindow.clear(VisualStyle::PRIMARY_DARK);
-        popupWindow.draw(modalBackground);
-        popupWindow.draw(headerText);
-        popupWindow.draw(playerText);
-        popupWindow.draw(questionText);
-        popupWindow.draw(warningText);
+        return false;
+    }, [&](const sf::RenderStates& states) {
+        window.draw(modalBackground, states);
+        window.draw(headerText, states);
+        window.draw(playerText, states);
+        window.draw(questionText, states);
+        window.draw(warningText, states);
         
         // Draw shadows first
-        popupWindow.draw(yesButtonShadow);
-        popupWindow.draw(noButtonShadow);
+        window.draw(yesButtonShadow, states);
+        window.draw(noButtonShadow, states);
         
         // Draw buttons and text
-        popupWindow.draw(yesButton);
-        popupWindow.draw(noButton);
-        popupWindow.draw(yesText);
-        popupWindow.draw(noText);
-        
-        popupWindow.display();
-    }
-    return "no";
+        window.draw(yesButton, states);
+        window.draw(noButton, states);
+        window.draw(yesText, states);
+        window.draw(noText, states);
+    });
+    return answer;
 }
 
 void GameGUI::showErrorPopup(const std::string& errorMessage) {
-    // DESIGN IMPROVEMENT: Enhanced error popup with modern styling
-    sf::RenderWindow popupWindow(sf::VideoMode(550, 250), "⚠️ Error", sf::Style::Titlebar | sf::Style::Close);
+    // DESIGN IMPROVEMENT: Enhanced error overlay with modern styling
+    sf::Vector2f panelSize(550, 250);
 
     // Background
-    sf::RectangleShape modalBackground(sf::Vector2f(550, 250));
+    sf::RectangleShape modalBackground(panelSize);
     modalBackground.setFillColor(VisualStyle::PRIMARY_MEDIUM);
+    modalBackground.setOutlineThickness(2.f);
+    modalBackground.setOutlineColor(VisualStyle::ACCENT_RED);
     
     // DESIGN IMPROVEMENT: Error header with warning styling
     sf::Text headerText("ERROR OCCURRED", font, 20);
     headerText.setFillColor(VisualStyle::ACCENT_RED);
     headerText.setStyle(sf::Text::Bold);
-    headerText.setPosition((popupWindow.getSize().x - headerText.getLocalBounds().width) / 2.f, 30.f);
+    headerText.setPosition((panelSize.x - headerText.getLocalBounds().width) / 2.f, 30.f);
     
     // DESIGN IMPROVEMENT: Error message card
     sf::RectangleShape errorCard(sf::Vector2f(480, 80));
@@ -1223,7 +1252,7 @@ void GameGUI::showErrorPopup(const std::string& errorMessage) {
 
     // DESIGN IMPROVEMENT: Modern OK button
     sf::Vector2f okButtonSize(140, 40);
-    sf::Vector2f okButtonPos((popupWindow.getSize().x - okButtonSize.x) / 2.f, 180.f);
+    sf::Vector2f okButtonPos((panelSize.x - okButtonSize.x) / 2.f, 180.f);
     
     sf::RectangleShape okButtonShadow = createShadow(okButtonSize, okButtonPos, 3.f);
     sf::RectangleShape okButton = createRoundedButton(okButtonSize, okButtonPos, VisualStyle::BUTTON_DANGER);
@@ -1233,34 +1262,22 @@ void GameGUI::showErrorPopup(const std::string& errorMessage) {
     okText.setStyle(sf::Text::Bold);
     okText.setPosition(okButtonPos.x + (okButtonSize.x - okText.getLocalBounds().width) / 2.f, okButtonPos.y + 11.f);
 
-    while (popupWindow.isOpen()) {
-        sf::Event event;
-        while (popupWindow.pollEvent(event)) {
-            if (event.type == sf::Event::Closed || (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape)) {
-                popupWindow.close();
-            }
-            if (event.type == sf::Event::MouseButtonPressed) {
-                sf::Vector2i mousePos = sf::Mouse::getPosition(popupWindow);
-                if (okButton.getGlobalBounds().contains(static_cast<float>(mousePos.x), static_cast<float>(mousePos.y))) {
-                    popupWindow.close();
-                }
-            }
-            // DESIGN IMPROVEMENT: Allow Enter key to close
-            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Enter) {
-                popupWindow.close();
-            }
+    runModal(panelSize, [&](const sf::Event& event, sf::Vector2f mouse) {
+        if (event.type == sf::Event::MouseButtonPressed && okButton.getGlobalBounds().contains(mouse)) {
+            return true;
         }
-        
-        popupWindow.clear(VisualStyle::PRIMARY_DARK);
-        popupWindow.draw(modalBackground);
-        popupWindow.draw(headerText);
-        popupWindow.draw(errorCard);
-        popupWindow.draw(message);
-        popupWindow.draw(okButtonShadow);
-        popupWindow.draw(okButton);
-        popupWindow.draw(okText);
-        popupWindow.display();
-    }
+        // DESIGN IMPROVEMENT: Allow Enter or Escape key to close
+        return event.type == sf::Event::KeyPressed &&
+               (event.key.code == sf::Keyboard::Escape || event.key.code == sf::Keyboard::Enter);
+    }, [&](const sf::RenderStates& states) {
+        window.draw(modalBackground, states);
+        window.draw(headerText, states);
+        window.draw(errorCard, states);
+        window.draw(message, states);
+        window.draw(okButtonShadow, states);
+        window.draw(okButton, states);
+        window.draw(okText, states);
+    });
 }
 
-} // namespace coup
\ No newline at end of file
+} // namespace coup
@@ -2,8 +2,15 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
+#include <functional>
+#include <memory>
+#include <random>
 #include <vector>
 #include <string>
+#include "AssetCache.hpp"
+#include "RenderSurface.hpp"
+#include "TableScene.hpp"
+#include "SIM/timeline.hpp"
 #include "GAME/game.hpp"       // ודא שהנתיב ל-game.hpp נכון
 #include "PLAYER/player.hpp" // ודא שהנתיב ל-player.hpp נכון
 
@@ -26,21 +33,68 @@ public:
      */
     GameGUI(Game& game);
 
+    /**
+     * @brief GameGUI constructor drawing on a given surface, e.g. offscreen for automated tests.
+     * @param game The game to play.
+     * @param surface Where the screens are drawn and the input comes from.
+     */
+    GameGUI(Game& game, std::unique_ptr<RenderSurface> surface);
+
     /**
      * @brief Runs the main GUI loop.
      * Starts with the welcome screen, proceeds to player input, and then runs the game screen.
      */
     void run();
 
+    /**
+     * @brief Shows a dashboard of live bot-vs-bot games until the window is closed or Escape is pressed.
+     * The game given to the constructor is not used.
+     * @param tables Number of tables shown.
+     */
+    void runSpectator(size_t tables);
+
+    /**
+     * @brief Shows a recorded game with a timeline: seek to any move, play and pause at several speeds.
+     * The game given to the constructor is used to replay the recording.
+     * @param path The recording (see setRecordPath()).
+     * @throws std::runtime_error if the file cannot be read or is not a valid recording.
+     */
+    void runReplay(const std::string& path);
+
+    /**
+     * @brief Records the next game played with run() to a file, for runReplay().
+     * The file is written when the game ends or the window is closed.
+     * @param path The file, or empty not to record.
+     */
+    void setRecordPath(const std::string& path) { recordPath = path; }
+
     /**
      * @brief Default destructor.
      */
     ~GameGUI() = default;
 
+    /**
+     * @brief Returns the asset cache, e.g. to report load times.
+     * @return The cache holding all textures and fonts of the GUI.
+     */
+    const AssetCache& getAssets() const { return assets; }
+
+    /**
+     * @brief Seeds the role shuffle, so scripted runs draw the same screens every time.
+     * @param seed The seed.
+     */
+    void setSeed(unsigned seed) { rng.seed(seed); }
+
 private:
-    sf::RenderWindow window; // The main SFML window
-    sf::Font font;           // The font used for all text rendering
-    Game& game;              // Reference to the game instance
+    std::unique_ptr<RenderSurface> surface;    // The window, or an offscreen surface
+    RenderSurface& window;                     // The surface all screens draw on
+    AssetCache assets;                         // Textures and fonts, loaded once
+    std::shared_ptr<const sf::Font> fontHandle; // Keeps the shared font alive
+    const sf::Font& font;                      // The font used for all text rendering
+    Game& game;                                // Reference to the game instance
+    std::function<void()> drawBackdrop;        // Draws the screen behind a modal overlay, if any
+    std::mt19937 rng;                          // Shuffles the roles
+    std::string recordPath;                    // Where the game is recorded, empty if not
 
     // === Private Helper Functions ===
 
@@ -51,16 +105,25 @@ private:
     void runGameScreen();
     void showWinnerScreen(const std::string& winnerName);
 
-    // User interaction popups
+    // User interaction popups, shown as modal overlays inside the main window
+    bool runModal(sf::Vector2f panelSize, const std::function<bool(const sf::Event&, sf::Vector2f)>& onEvent,
+                  const std::function<void(const sf::RenderStates&)>& drawContent);
     std::string askForTargetPlayerName();
     std::string showCancelConfirmation(const std::string& playerName);
     void showErrorPopup(const std::string& errorMessage);
-    void viewPlayerCoinsPopup(const std::string& targetName);
+    void viewPlayerCoinsPopup(const std::string& targetName, int coins);
+
+    // Fills the view of the game screen from the current state of the game
+    void captureTable(TableView& view) const;
+
+    // Saves a recording to recordPath, if set; failures are reported but do not stop the GUI
+    void writeRecording(const GameRecording& recording) const;
+
+    // Sets a cached background texture on a sprite scaled to the window, false if the file is missing
+    bool loadBackground(const std::string& path, sf::Sprite& sprite);
 
     // Utility and conversion functions
-    std::string roleToString(Role role) const;
-    std::string actionTypeToString(ActionType action) const;
-    ActionType stringToActionType(const std::string& actionStr) const;
+    const std::string& actionTypeToString(ActionType action) const;
 };
 
 } // namespace coup
\ No newline at end of file
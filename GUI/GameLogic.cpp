@@ -0,0 +1,167 @@
+// idocohen963@gmail.com
+#include "GameLogic.hpp"
+#include "DiagnosticLog.hpp"
+#include <chrono>
+#include <stdexcept>
+
+namespace coup {
+
+GameLogic::GameLogic(Game& game, std::function<void(TableView&)> capture)
+    : _game(game), _capture(std::move(capture)), _flow(game) {
+    _thread = std::thread(&GameLogic::run, this);
+}
+
+GameLogic::~GameLogic() {
+    stop();
+}
+
+void GameLogic::stop() {
+    if (!_thread.joinable()) {
+        return;
+    }
+    GameCommand command{GameCommand::Stop, ActionType::Gather, -1, false};
+    while (!post(command)) {
+        std::this_thread::yield(); // The queue drains quickly, the logic thread never blocks on the GUI
+    }
+    _thread.join();
+}
+
+bool GameLogic::post(const GameCommand& command) {
+    if (!_commands.push(command)) {
+        return false;
+    }
+    // Taking the lock orders the push before the check of a logic thread going to sleep
+    { std::lock_guard<std::mutex> lock(_wakeMutex); }
+    _wake.notify_one();
+    return true;
+}
+
+std::shared_ptr<const TableSnapshot> GameLogic::snapshot() const {
+    return std::atomic_load(&_published);
+}
+
+void GameLogic::run() {
+    Game::Binding binding(_game); // Player actions reach the game through getInstance()
+    _recording.record.gameId = 0;
+    _recording.record.winner = -1;
+    for (const Player* p : _game.getPlayers()) {
+        _recording.names.push_back(p->getName());
+        _recording.record.lineup.push_back(p->getRole());
+    }
+    _flow.start();
+    follow();
+    publish();
+
+    GameCommand command;
+    while (true) {
+        if (!_commands.pop(command)) {
+            std::unique_lock<std::mutex> lock(_wakeMutex);
+            _wake.wait(lock, [this] { return !_commands.empty(); });
+            continue;
+        }
+        if (command.type == GameCommand::Stop) {
+            return;
+        }
+        auto start = std::chrono::steady_clock::now();
+        if (command.type == GameCommand::Act) {
+            act(command);
+        } else {
+            answer(command.cancel);
+        }
+        ++_state.commands;
+        _state.commandMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        publish();
+    }
+}
+
+void GameLogic::publish() {
+    if (_state.phase != TablePhase::GameOver) {
+        _capture(_state.table);
+    }
+    ++_state.version;
+    std::atomic_store(&_published, std::shared_ptr<const TableSnapshot>(std::make_shared<TableSnapshot>(_state)));
+}
+
+/**
+ * @brief Updates the next snapshot with where the turn is suspended.
+ */
+void GameLogic::follow() {
+    const std::vector<Player*>& players = _game.getPlayers();
+    DiagnosticLog& log = DiagnosticLog::getInstance();
+    switch (_flow.awaiting()) {
+        case TurnFlow::Await::Action:
+            _state.phase = TablePhase::Turn;
+            _state.asked.clear();
+            if (log.isEnabled()) { // The player name is only copied when it is logged
+                log.write("Turn of %s, %d active players", _game.getCurrentPlayer()->getName().c_str(),
+                          Simulator::countActive(_game));
+            }
+            break;
+        case TurnFlow::Await::Cancel:
+            _state.phase = TablePhase::CancelPrompt;
+            _state.asked = players[_flow.asked()]->getName();
+            break;
+        case TurnFlow::Await::Nothing:
+            _state.phase = TablePhase::GameOver;
+            _state.asked.clear();
+            _state.winner = _flow.winner() >= 0 ? players[_flow.winner()]->getName() : std::string();
+            _recording.record.winner = _flow.winner();
+            break;
+    }
+}
+
+void GameLogic::act(const GameCommand& command) {
+    if (_flow.awaiting() != TurnFlow::Await::Action) {
+        return; // A late click, the game moved on
+    }
+    const std::vector<Player*>& players = _game.getPlayers();
+    Player* currentPlayer = _game.getCurrentPlayer();
+    try {
+        _flow.act(Move{command.action, command.target});
+    } catch (const std::runtime_error& e) {
+        reject(e.what()); // The turn does not end on error, the player can choose another action
+        return;
+    }
+    const Move& move = _flow.announced();
+    if (move.action == ActionType::SpyOn) {
+        ++_state.reports;
+        _state.spiedName = players[move.target]->getName();
+        _state.spiedCoins = players[move.target]->getCoins();
+    }
+    _recording.record.moves.push_back(ReplayMove{move.action, move.target, -1});
+
+    DiagnosticLog& log = DiagnosticLog::getInstance();
+    if (log.isEnabled()) {
+        log.write("%s played action %d on seat %d", currentPlayer->getName().c_str(),
+                  static_cast<int>(move.action), move.target);
+    }
+    follow();
+}
+
+void GameLogic::answer(bool cancel) {
+    if (_flow.awaiting() != TurnFlow::Await::Cancel) {
+        return;
+    }
+    try {
+        if (_flow.answer(cancel)) {
+            _recording.record.moves.back().canceller = _flow.canceller();
+            DiagnosticLog& log = DiagnosticLog::getInstance();
+            if (log.isEnabled()) {
+                const std::vector<Player*>& players = _game.getPlayers();
+                log.write("%s cancelled the action of %s", players[_flow.canceller()]->getName().c_str(),
+                          players[_flow.actor()]->getName().c_str());
+            }
+        }
+    } catch (const std::runtime_error& e) {
+        reject(e.what()); // The window moved on to the next player able to cancel
+    }
+    follow();
+}
+
+void GameLogic::reject(const std::string& error) {
+    DiagnosticLog::getInstance().write("Command rejected: %s", error.c_str());
+    ++_state.errors;
+    _state.error = error;
+}
+
+} // namespace coup
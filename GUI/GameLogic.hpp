@@ -0,0 +1,141 @@
+// idocohen963@gmail.com
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "SpscQueue.hpp"
+#include "TableScene.hpp"
+#include "GAME/game.hpp"
+#include "SIM/timeline.hpp"
+#include "SIM/turnflow.hpp"
+
+namespace coup {
+
+/**
+ * @struct GameCommand
+ * @brief A request of the GUI to the logic thread.
+ */
+struct GameCommand {
+    enum Type {
+        Act,     ///< The current player performs an action
+        Answer,  ///< The player asked about a cancel answers
+        Stop     ///< The logic thread exits
+    };
+    Type type;
+    ActionType action;  ///< Act: the action
+    int target;         ///< Act: seat of the target, or -1
+    bool cancel;        ///< Answer: whether the asked player cancels
+};
+
+/**
+ * @enum TablePhase
+ * @brief What the logic thread is waiting for.
+ */
+enum class TablePhase {
+    Turn,          ///< An action of the current player
+    CancelPrompt,  ///< The answer of the player asked about a cancel
+    GameOver       ///< Nothing, the game ended
+};
+
+/**
+ * @struct TableSnapshot
+ * @brief Immutable state of the game published by the logic thread.
+ * Events the GUI must show once carry a counter, which changes when a new one happens.
+ */
+struct TableSnapshot {
+    uint64_t version = 0;          ///< Increases with every published snapshot
+    TablePhase phase = TablePhase::Turn;
+    TableView table;               ///< What the game screen shows
+    std::string asked;             ///< CancelPrompt: the player asked whether to cancel
+    uint64_t errors = 0;           ///< Number of rejected commands so far
+    std::string error;             ///< Why the last command was rejected
+    uint64_t reports = 0;          ///< Number of spy reports so far
+    std::string spiedName;         ///< Player seen by the last spy report
+    int spiedCoins = 0;            ///< Coins seen by the last spy report
+    std::string winner;            ///< GameOver: the winner, empty if the game could not go on
+    uint64_t commands = 0;         ///< Number of commands processed
+    double commandMs = 0;          ///< Engine time of the last command
+};
+
+/**
+ * @class GameLogic
+ * @brief Runs a game on its own thread, so engine work never blocks rendering.
+ *
+ * The game is only touched by the logic thread, which binds it (see Game::Binding) for the
+ * player actions. The GUI thread sends commands through a lock-free queue and reads the state
+ * through immutable snapshots: every change is published as a new snapshot with an atomic
+ * pointer swap, so the GUI never waits for the logic thread and never sees a half-applied move.
+ * Every applied action and cancel is recorded, so the game can be replayed (see ReplayTimeline).
+ * The turns are played through a TurnFlow, the same one the server tables use, so the cancel
+ * window follows the same rules on screen and over the network.
+ */
+class GameLogic {
+public:
+    /**
+     * @brief Constructor. Starts the logic thread, which publishes the first snapshot.
+     * @param game The game, already started. Not to be used by other threads until destruction.
+     * @param capture Fills the table view from the game; called on the logic thread.
+     */
+    GameLogic(Game& game, std::function<void(TableView&)> capture);
+
+    /**
+     * @brief Destructor. Stops and joins the logic thread.
+     */
+    ~GameLogic();
+
+    /**
+     * @brief Stops and joins the logic thread. GUI thread only; does nothing the second time.
+     */
+    void stop();
+
+    /**
+     * @brief Returns the recording of the game so far.
+     * Only valid once stop() returned, the logic thread writes it while it runs.
+     * @return The seats and every applied move.
+     */
+    const GameRecording& recording() const { return _recording; }
+
+    GameLogic(const GameLogic&) = delete;
+    GameLogic& operator=(const GameLogic&) = delete;
+
+    /**
+     * @brief Sends a command to the logic thread. GUI thread only.
+     * @param command The command.
+     * @return false if too many commands are pending.
+     */
+    bool post(const GameCommand& command);
+
+    /**
+     * @brief Returns the latest published state. Never blocks.
+     * @return The snapshot, or nullptr before the first one is published.
+     */
+    std::shared_ptr<const TableSnapshot> snapshot() const;
+
+private:
+    Game& _game;
+    std::function<void(TableView&)> _capture;
+    SpscQueue<GameCommand, 64> _commands;
+    std::mutex _wakeMutex;                          ///< Only used to sleep while the queue is empty
+    std::condition_variable _wake;
+    std::shared_ptr<const TableSnapshot> _published;  ///< Accessed with std::atomic_load/atomic_store
+
+    // Logic thread state
+    TableSnapshot _state;        ///< Next snapshot to publish
+    TurnFlow _flow;              ///< The turn, suspended between commands
+    GameRecording _recording;    ///< The seats and the applied moves
+    std::thread _thread;
+
+    void run();
+    void publish();
+    void follow();
+    void act(const GameCommand& command);
+    void answer(bool cancel);
+    void reject(const std::string& error);
+};
+
+} // namespace coup
@@ -0,0 +1,25 @@
+// idocohen963@gmail.com
+#include "Labels.hpp"
+#include <cstddef>
+
+namespace coup {
+
+namespace {
+const std::string UNKNOWN = "Unknown";
+
+// Indexed by the enum values, in declaration order
+const std::string ROLE_LABELS[] = {"Spy", "Merchant", "General", "Governor", "Judge", "Baron"};
+const std::string ACTION_LABELS[] = {"Gather", "Tax", "Bribe", "Arrest", "Coup", "Sanction", "Invest", "Spy On", "Cancel"};
+}
+
+const std::string& roleLabel(Role role) {
+    std::size_t index = static_cast<std::size_t>(role);
+    return index < sizeof(ROLE_LABELS) / sizeof(ROLE_LABELS[0]) ? ROLE_LABELS[index] : UNKNOWN;
+}
+
+const std::string& actionLabel(ActionType action) {
+    std::size_t index = static_cast<std::size_t>(action);
+    return index < sizeof(ACTION_LABELS) / sizeof(ACTION_LABELS[0]) ? ACTION_LABELS[index] : UNKNOWN;
+}
+
+} // namespace coup
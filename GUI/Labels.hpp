@@ -0,0 +1,25 @@
+// idocohen963@gmail.com
+#pragma once
+
+#include <string>
+#include "PLAYER/player.hpp"
+
+namespace coup {
+
+/**
+ * @brief Returns the display name of a role.
+ * The names are built once; the returned reference stays valid for the whole program.
+ * @param role The role.
+ * @return The name, or "Unknown".
+ */
+const std::string& roleLabel(Role role);
+
+/**
+ * @brief Returns the display name of an action, as written on its button.
+ * The names are built once; the returned reference stays valid for the whole program.
+ * @param action The action.
+ * @return The name, or "Unknown".
+ */
+const std::string& actionLabel(ActionType action);
+
+} // namespace coup
@@ -0,0 +1,168 @@
+// idocohen963@gmail.com
+#include "OffscreenSurface.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace coup {
+
+namespace {
+
+/**
+ * @brief Nearest-rank percentile of sorted values.
+ */
+double percentile(const std::vector<double>& sorted, double fraction) {
+    size_t rank = static_cast<size_t>(fraction * sorted.size() + 0.5);
+    return sorted[std::min(sorted.size() - 1, rank == 0 ? 0 : rank - 1)];
+}
+
+/**
+ * @brief Maps a key name of a script to the key.
+ */
+sf::Keyboard::Key keyByName(const std::string& name) {
+    static const std::map<std::string, sf::Keyboard::Key> keys = {
+        {"Enter", sf::Keyboard::Enter}, {"Escape", sf::Keyboard::Escape},
+        {"Backspace", sf::Keyboard::Backspace}, {"Tab", sf::Keyboard::Tab}, {"Space", sf::Keyboard::Space},
+        {"F1", sf::Keyboard::F1}, {"F2", sf::Keyboard::F2}, {"F3", sf::Keyboard::F3}, {"F4", sf::Keyboard::F4},
+        {"F5", sf::Keyboard::F5}, {"F6", sf::Keyboard::F6}, {"F7", sf::Keyboard::F7}, {"F8", sf::Keyboard::F8},
+        {"F9", sf::Keyboard::F9}, {"F10", sf::Keyboard::F10}, {"F11", sf::Keyboard::F11}, {"F12", sf::Keyboard::F12}};
+    auto it = keys.find(name);
+    if (it == keys.end()) {
+        throw std::runtime_error("Unknown key '" + name + "'");
+    }
+    return it->second;
+}
+
+}
+
+OffscreenSurface::OffscreenSurface(unsigned width, unsigned height)
+    : _open(true), _passEnded(false), _resumeAt(Clock::now()), _screen("startup"), _frameStart(Clock::now()),
+      _frameCount(0), _dumped(0), _undumpedFrame(false) {
+    if (!_texture.create(width, height)) {
+        throw std::runtime_error("Failed to create an offscreen render texture");
+    }
+}
+
+void OffscreenSurface::loadScript(std::istream& in) {
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        std::istringstream words(line.substr(0, line.find('#')));
+        std::string command;
+        if (!(words >> command)) continue; // Blank line or comment
+
+        Step step{sf::Event(), 0};
+        bool valid = true;
+        if (command == "click") {
+            step.event.type = sf::Event::MouseButtonPressed;
+            step.event.mouseButton.button = sf::Mouse::Left;
+            valid = static_cast<bool>(words >> step.event.mouseButton.x >> step.event.mouseButton.y);
+        } else if (command == "key") {
+            std::string name;
+            valid = static_cast<bool>(words >> name);
+            step.event.type = sf::Event::KeyPressed;
+            step.event.key.code = valid ? keyByName(name) : sf::Keyboard::Unknown;
+        } else if (command == "text") {
+            std::string text;
+            std::getline(words >> std::ws, text);
+            for (char c : text) {
+                step.event.type = sf::Event::TextEntered;
+                step.event.text.unicode = static_cast<unsigned char>(c);
+                _script.push_back(step);
+            }
+            continue;
+        } else if (command == "enter") {
+            step.event.type = sf::Event::TextEntered;
+            step.event.text.unicode = '\r';
+        } else if (command == "wait") {
+            valid = static_cast<bool>(words >> step.waitMs) && step.waitMs > 0;
+        } else if (command == "close") {
+            step.event.type = sf::Event::Closed;
+        } else {
+            throw std::runtime_error("Unknown script command '" + command + "' on line " + std::to_string(lineNumber));
+        }
+        if (!valid) {
+            throw std::runtime_error("Malformed script command on line " + std::to_string(lineNumber));
+        }
+        _script.push_back(step);
+    }
+}
+
+void OffscreenSurface::close() {
+    if (_open && _undumpedFrame) {
+        dumpFrame(); // The last frame shown
+    }
+    _open = false;
+}
+
+bool OffscreenSurface::pollEvent(sf::Event& event) {
+    if (!_open) {
+        return false;
+    }
+    // One event per pass of the event loop, so the screen draws a frame between two inputs
+    if (_passEnded) {
+        _passEnded = false;
+        return false;
+    }
+    if (Clock::now() < _resumeAt) {
+        return false;
+    }
+    if (!_script.empty() && _script.front().waitMs > 0) {
+        _resumeAt = Clock::now() + std::chrono::milliseconds(_script.front().waitMs);
+        _script.pop_front();
+        return false;
+    }
+
+    if (_undumpedFrame) {
+        dumpFrame(); // What the user sees when acting
+    }
+    if (_script.empty()) {
+        event = sf::Event();
+        event.type = sf::Event::Closed;
+    } else {
+        event = _script.front().event;
+        _script.pop_front();
+    }
+    _passEnded = true;
+    return true;
+}
+
+void OffscreenSurface::clear(const sf::Color& color) {
+    _frameStart = Clock::now();
+    _texture.clear(color);
+}
+
+void OffscreenSurface::display() {
+    _texture.display();
+    _frameMs[_screen].push_back(std::chrono::duration<double, std::milli>(Clock::now() - _frameStart).count());
+    ++_frameCount;
+    _undumpedFrame = true;
+}
+
+void OffscreenSurface::dumpFrame() {
+    _undumpedFrame = false;
+    if (_dumpDirectory.empty()) {
+        return;
+    }
+    std::ostringstream path;
+    path << _dumpDirectory << "/frame_" << std::setw(4) << std::setfill('0') << _dumped++ << "_" << _screen << ".png";
+    if (!_texture.getTexture().copyToImage().saveToFile(path.str())) {
+        throw std::runtime_error("Failed to write frame '" + path.str() + "'");
+    }
+}
+
+void OffscreenSurface::report(std::ostream& out) const {
+    out << "Screen              frames    p50 ms    p90 ms    p99 ms    max ms\n";
+    for (const auto& item : _frameMs) {
+        std::vector<double> sorted = item.second;
+        std::sort(sorted.begin(), sorted.end());
+        out << std::left << std::setw(16) << item.first << std::right << std::setw(10) << sorted.size()
+            << std::fixed << std::setprecision(3) << std::setw(10) << percentile(sorted, 0.50)
+            << std::setw(10) << percentile(sorted, 0.90) << std::setw(10) << percentile(sorted, 0.99)
+            << std::setw(10) << sorted.back() << "\n";
+    }
+}
+
+} // namespace coup
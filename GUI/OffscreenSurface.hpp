@@ -0,0 +1,107 @@
+// idocohen963@gmail.com
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "RenderSurface.hpp"
+
+namespace coup {
+
+/**
+ * @class OffscreenSurface
+ * @brief Renders the GUI into a texture and feeds it scripted input, for tests without a display.
+ *
+ * The script is a text file with one command per line ('#' starts a comment):
+ *   click X Y    left mouse button pressed at window coordinates X, Y
+ *   key NAME     key pressed: Enter, Escape, Backspace, Tab, Space or F1 to F12
+ *   text WORDS   the characters of the rest of the line, typed one by one
+ *   enter        the Enter character, as typed in a text field
+ *   wait MS      no input for MS milliseconds (e.g. while a timed animation runs)
+ *   close        the window close button
+ * Screens get one event per pass of their event loop, as if the user acted between frames.
+ * When the script runs out the surface reports a close event, so the GUI always exits.
+ *
+ * The render time of every frame (from clear() to display()) is recorded per screen. With a dump
+ * directory, the frame on screen when each scripted event is delivered is saved as a PNG file,
+ * which gives the same files for the same script and seed.
+ */
+class OffscreenSurface : public RenderSurface {
+public:
+    /**
+     * @brief Constructor.
+     * @param width Width in pixels.
+     * @param height Height in pixels.
+     * @throws std::runtime_error if the render texture could not be created.
+     */
+    OffscreenSurface(unsigned width, unsigned height);
+
+    /**
+     * @brief Appends the commands of a script.
+     * @param in The script.
+     * @throws std::runtime_error on an unknown command or a malformed argument.
+     */
+    void loadScript(std::istream& in);
+
+    /**
+     * @brief Saves frames as PNG files in a directory (which must exist).
+     * @param directory The directory.
+     */
+    void setFrameDump(const std::string& directory) { _dumpDirectory = directory; }
+
+    /**
+     * @brief Returns the number of frames rendered.
+     * @return Frames displayed so far.
+     */
+    std::size_t frames() const { return _frameCount; }
+
+    /**
+     * @brief Writes the frame time percentiles of every screen.
+     * @param out The stream to write to.
+     */
+    void report(std::ostream& out) const;
+
+    sf::RenderTarget& target() override { return _texture; }
+    const sf::RenderTarget& target() const override { return _texture; }
+    bool isOpen() const override { return _open; }
+    void close() override;
+    bool pollEvent(sf::Event& event) override;
+    void clear(const sf::Color& color) override;
+    void display() override;
+    void beginScreen(const std::string& name) override { _screen = name; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @struct Step
+     * @brief A scripted event, or a pause when waitMs is positive.
+     */
+    struct Step {
+        sf::Event event;
+        int waitMs;
+    };
+
+    sf::RenderTexture _texture;
+    bool _open;
+    std::deque<Step> _script;
+    bool _passEnded;                  ///< An event was delivered in the current pass of the event loop
+    Clock::time_point _resumeAt;      ///< End of the current wait
+    std::string _screen;
+    Clock::time_point _frameStart;
+    std::map<std::string, std::vector<double>> _frameMs;  ///< Render time of every frame, by screen
+    std::size_t _frameCount;
+    std::string _dumpDirectory;
+    std::size_t _dumped;              ///< Number of dumped frames
+    bool _undumpedFrame;              ///< A frame was displayed since the last dump
+
+    void dumpFrame();
+};
+
+} // namespace coup
@@ -0,0 +1,71 @@
+// idocohen963@gmail.com
+#include "PerfOverlay.hpp"
+#include "VisualStyle.hpp"
+#include <cstdio>
+
+namespace coup {
+
+namespace {
+const std::chrono::milliseconds REFRESH_PERIOD(250);
+}
+
+PerfOverlay::PerfOverlay(const sf::Font& font)
+    : _visible(false), _panel(sf::Vector2f(300, 96)), _text("", font, 14), _frames(0), _frameMs(0),
+      _drawCalls(0), _allocations(0), _actions(0), _actionMs(0), _lastActionMs(0) {
+    _panel.setPosition(10.f, 10.f);
+    _panel.setFillColor(sf::Color(0, 0, 0, 170));
+    _text.setFillColor(VisualStyle::TEXT_PRIMARY);
+    _text.setPosition(20.f, 16.f);
+}
+
+void PerfOverlay::setVisible(bool visible) {
+    _visible = visible;
+    _lastRefresh = std::chrono::steady_clock::time_point(); // Refresh on the next frame
+}
+
+void PerfOverlay::addFrame(double frameMs, size_t drawCalls, uint64_t allocations) {
+    ++_frames;
+    _frameMs += frameMs;
+    _drawCalls += drawCalls + this->drawCalls();
+    _allocations += allocations;
+}
+
+void PerfOverlay::addAction(double actionMs) {
+    ++_actions;
+    _actionMs += actionMs;
+    _lastActionMs = actionMs;
+}
+
+bool PerfOverlay::refresh() {
+    auto now = std::chrono::steady_clock::now();
+    if (!_visible || now - _lastRefresh < REFRESH_PERIOD) {
+        return false;
+    }
+    _lastRefresh = now;
+
+    char text[256];
+    double frames = _frames > 0 ? static_cast<double>(_frames) : 1.0;
+    std::snprintf(text, sizeof(text),
+                  "Frame time:   %.3f ms\nDraw calls:   %.1f per frame\nAllocations:  %.1f per frame\n"
+                  "Engine:       %.3f ms per action (last %.3f)",
+                  _frameMs / frames, _drawCalls / frames, _allocations / frames,
+                  _actions > 0 ? _actionMs / _actions : 0.0, _lastActionMs);
+    _text.setString(text);
+
+    _frames = 0;
+    _frameMs = 0;
+    _drawCalls = 0;
+    _allocations = 0;
+    _actions = 0;
+    _actionMs = 0;
+    return true;
+}
+
+void PerfOverlay::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+    if (_visible) {
+        target.draw(_panel, states);
+        target.draw(_text, states);
+    }
+}
+
+} // namespace coup
@@ -0,0 +1,84 @@
+// idocohen963@gmail.com
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace coup {
+
+/**
+ * @class PerfOverlay
+ * @brief In-window performance figures of the game screen.
+ *
+ * Shows the render time of a frame, the draw calls of a frame, the heap allocations between two
+ * frames and the engine time of an action, averaged over the frames since the last refresh. The
+ * text is rebuilt at most four times a second, so the overlay itself barely shows in the figures.
+ */
+class PerfOverlay : public sf::Drawable {
+public:
+    /**
+     * @brief Constructor. The overlay starts hidden.
+     * @param font The font of the text (must outlive the overlay).
+     */
+    explicit PerfOverlay(const sf::Font& font);
+
+    /**
+     * @brief Shows or hides the overlay.
+     * @param visible The new value.
+     */
+    void setVisible(bool visible);
+
+    /**
+     * @brief Returns whether the overlay is shown.
+     * @return true if shown.
+     */
+    bool isVisible() const { return _visible; }
+
+    /**
+     * @brief Records a rendered frame.
+     * @param frameMs Time from clear() to display().
+     * @param drawCalls Draw calls of the frame, without the overlay's own.
+     * @param allocations Heap allocations since the previous frame.
+     */
+    void addFrame(double frameMs, size_t drawCalls, uint64_t allocations);
+
+    /**
+     * @brief Records the engine time of an action.
+     * @param actionMs Time the logic thread spent on the action.
+     */
+    void addAction(double actionMs);
+
+    /**
+     * @brief Rebuilds the text if it is shown and due for a refresh.
+     * @return true if the text changed and the frame should be redrawn.
+     */
+    bool refresh();
+
+    /**
+     * @brief Returns the draw calls of the overlay itself.
+     * @return Draw calls per frame.
+     */
+    size_t drawCalls() const { return _visible ? 2 : 0; }
+
+protected:
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+private:
+    bool _visible;
+    sf::RectangleShape _panel;
+    sf::Text _text;
+    std::chrono::steady_clock::time_point _lastRefresh;
+
+    // Totals since the last refresh
+    size_t _frames;
+    double _frameMs;
+    size_t _drawCalls;
+    uint64_t _allocations;
+    size_t _actions;
+    double _actionMs;
+    double _lastActionMs;
+};
+
+} // namespace coup
@@ -0,0 +1,11 @@
+// idocohen963@gmail.com
+#include "RenderSurface.hpp"
+
+namespace coup {
+
+WindowSurface::WindowSurface(unsigned width, unsigned height, const std::string& title)
+    : _window(sf::VideoMode(width, height), title) {
+    _window.setFramerateLimit(60);
+}
+
+} // namespace coup
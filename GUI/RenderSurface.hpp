@@ -0,0 +1,94 @@
+// idocohen963@gmail.com
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <string>
+
+namespace coup {
+
+/**
+ * @class RenderSurface
+ * @brief Where the GUI draws its screens and gets its input from.
+ *
+ * It mirrors the parts of sf::RenderWindow the screens use, so the same screen code can run in a
+ * window (WindowSurface) or offscreen with scripted input (OffscreenSurface).
+ */
+class RenderSurface {
+public:
+    virtual ~RenderSurface() = default;
+
+    /**
+     * @brief Returns the render target of the surface.
+     * @return The target the screens draw into.
+     */
+    virtual sf::RenderTarget& target() = 0;
+    virtual const sf::RenderTarget& target() const = 0;
+
+    /**
+     * @brief Returns whether the surface still accepts frames.
+     * @return false once closed.
+     */
+    virtual bool isOpen() const = 0;
+
+    /**
+     * @brief Closes the surface.
+     */
+    virtual void close() = 0;
+
+    /**
+     * @brief Pops the next pending input event.
+     * @param event Receives the event.
+     * @return false if no event is pending.
+     */
+    virtual bool pollEvent(sf::Event& event) = 0;
+
+    /**
+     * @brief Starts a new frame by clearing the target.
+     * @param color The background color.
+     */
+    virtual void clear(const sf::Color& color) { target().clear(color); }
+
+    /**
+     * @brief Shows the frame drawn since clear().
+     */
+    virtual void display() = 0;
+
+    /**
+     * @brief Tells the surface which screen the next frames belong to, e.g. for per screen timings.
+     * @param name Name of the screen.
+     */
+    virtual void beginScreen(const std::string& name) { (void)name; }
+
+    void draw(const sf::Drawable& drawable, const sf::RenderStates& states = sf::RenderStates::Default) {
+        target().draw(drawable, states);
+    }
+
+    sf::Vector2u getSize() const { return target().getSize(); }
+};
+
+/**
+ * @class WindowSurface
+ * @brief A desktop window, limited to 60 frames per second.
+ */
+class WindowSurface : public RenderSurface {
+public:
+    /**
+     * @brief Constructor. Opens the window.
+     * @param width Width in pixels.
+     * @param height Height in pixels.
+     * @param title Window title.
+     */
+    WindowSurface(unsigned width, unsigned height, const std::string& title);
+
+    sf::RenderTarget& target() override { return _window; }
+    const sf::RenderTarget& target() const override { return _window; }
+    bool isOpen() const override { return _window.isOpen(); }
+    void close() override { _window.close(); }
+    bool pollEvent(sf::Event& event) override { return _window.pollEvent(event); }
+    void display() override { _window.display(); }
+
+private:
+    sf::RenderWindow _window;
+};
+
+} // namespace coup
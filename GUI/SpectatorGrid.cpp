@@ -0,0 +1,129 @@
+// idocohen963@gmail.com
+#include "SpectatorGrid.hpp"
+#include "Labels.hpp"
+#include "VisualStyle.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace coup {
+
+namespace {
+const float TILE_GAP = 4.f;
+const float TILE_PADDING = 6.f;
+const int TILE_LINES = MAX_PLAYERS + 2;  ///< Header, one line per seat, last action
+}
+
+SpectatorGrid::SpectatorGrid(const sf::Font& font, sf::Vector2u size, std::size_t tiles,
+                             std::chrono::milliseconds refreshPeriod)
+    : _batch(font), _refreshPeriod(refreshPeriod), _versions(tiles, 0),
+      _painted(tiles, std::chrono::steady_clock::time_point()) {
+    if (!_canvas.create(size.x, size.y)) {
+        throw std::runtime_error("Failed to create the spectator canvas");
+    }
+    _canvas.clear(VisualStyle::PRIMARY_DARK);
+    _canvas.display();
+    _sprite.setTexture(_canvas.getTexture(), true);
+
+    // Columns are chosen so that the tiles come out about as wide as the window's aspect ratio
+    float aspect = static_cast<float>(size.x) / static_cast<float>(size.y);
+    _columns = std::max(1u, static_cast<unsigned>(std::ceil(std::sqrt(tiles * aspect))));
+    unsigned rows = static_cast<unsigned>((tiles + _columns - 1) / _columns);
+    _tileSize = sf::Vector2f(static_cast<float>(size.x) / _columns, static_cast<float>(size.y) / std::max(1u, rows));
+
+    float lineHeight = (_tileSize.y - TILE_GAP - 2 * TILE_PADDING) / TILE_LINES;
+    _textSize = static_cast<unsigned>(std::max(8.f, std::min(16.f, lineHeight * 0.8f)));
+    _batch.textCache().prebuild(_textSize, false);
+    _batch.textCache().prebuild(_textSize, true);
+}
+
+std::size_t SpectatorGrid::update(const LiveTables& tables) {
+    auto now = std::chrono::steady_clock::now();
+    std::size_t count = std::min(tables.size(), _versions.size());
+    std::size_t painted = 0;
+    _batch.clear();
+    for (std::size_t i = 0; i < count; ++i) {
+        // The version is read without a lock; unchanged tables cost nothing more
+        if (tables.version(i) == _versions[i] || now - _painted[i] < _refreshPeriod) {
+            continue;
+        }
+        _versions[i] = tables.read(i, _state);
+        _painted[i] = now;
+        paintTile(i);
+        ++painted;
+    }
+    if (painted > 0) {
+        // Each tile covers its whole cell, so the tiles not repainted are left as they are
+        _canvas.draw(_batch);
+        _canvas.display();
+    }
+    return painted;
+}
+
+void SpectatorGrid::paintTile(std::size_t index) {
+    sf::Vector2f origin((index % _columns) * _tileSize.x, (index / _columns) * _tileSize.y);
+    sf::Vector2f size(_tileSize.x - TILE_GAP, _tileSize.y - TILE_GAP);
+    _batch.addRect(sf::FloatRect(origin, _tileSize), VisualStyle::PRIMARY_DARK);
+    _batch.addRect(sf::FloatRect(origin, size),
+                   _state.finished ? VisualStyle::ACCENT_GREEN : VisualStyle::ACCENT_BLUE);
+    _batch.addRect(sf::FloatRect(origin.x + 1.f, origin.y + 1.f, size.x - 2.f, size.y - 2.f), VisualStyle::PRIMARY_MEDIUM);
+
+    float x = origin.x + TILE_PADDING;
+    float y = origin.y + TILE_PADDING;
+    float lineHeight = (size.y - 2 * TILE_PADDING) / TILE_LINES;
+    char number[48];
+
+    std::snprintf(number, sizeof(number), "Table %zu  game %llu  move %d", index + 1,
+                  static_cast<unsigned long long>(_state.gamesPlayed + (_state.finished ? 0 : 1)), _state.actions);
+    _line.assign(number);
+    _batch.addText(_line, sf::Vector2f(x, y), _textSize, VisualStyle::TEXT_ACCENT, true);
+
+    for (int seat = 0; seat < _state.playerCount; ++seat) {
+        y += lineHeight;
+        std::snprintf(number, sizeof(number), "P%d ", seat);
+        _line.assign(number).append(roleLabel(_state.roles[seat]));
+        sf::Color color = VisualStyle::TEXT_PRIMARY;
+        if (!_state.active[seat]) {
+            _line.append("  out");
+            color = VisualStyle::TEXT_SECONDARY;
+        } else {
+            std::snprintf(number, sizeof(number), "  %d", _state.coins[seat]);
+            _line.append(number);
+            if (_state.finished ? seat == _state.winner : seat == _state.current) {
+                color = VisualStyle::ACCENT_YELLOW;
+            }
+        }
+        _batch.addText(_line, sf::Vector2f(x, y), _textSize, color, seat == _state.current && !_state.finished);
+    }
+
+    y = origin.y + TILE_PADDING + (TILE_LINES - 1) * lineHeight;
+    if (_state.finished) {
+        if (_state.winner >= 0) {
+            std::snprintf(number, sizeof(number), "Winner: P%d ", _state.winner);
+            _line.assign(number).append(roleLabel(_state.roles[_state.winner]));
+        } else {
+            _line.assign("Draw");
+        }
+    } else if (_state.lastActor >= 0) {
+        std::snprintf(number, sizeof(number), "P%d ", _state.lastActor);
+        _line.assign(number).append(actionLabel(_state.lastAction));
+        if (_state.lastTarget >= 0) {
+            std::snprintf(number, sizeof(number), " P%d", _state.lastTarget);
+            _line.append(number);
+        }
+        if (_state.lastCancelled) {
+            _line.append(" (cancelled)");
+        }
+    } else {
+        _line.clear();
+    }
+    _batch.addText(_line, sf::Vector2f(x, y), _textSize,
+                   _state.finished ? VisualStyle::ACCENT_GREEN : VisualStyle::TEXT_SECONDARY);
+}
+
+void SpectatorGrid::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+    target.draw(_sprite, states);
+}
+
+} // namespace coup
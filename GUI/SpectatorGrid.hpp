@@ -0,0 +1,68 @@
+// idocohen963@gmail.com
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "BatchRenderer.hpp"
+#include "SIM/spectator.hpp"
+
+namespace coup {
+
+/**
+ * @class SpectatorGrid
+ * @brief Dashboard of live tables, one tile per table.
+ *
+ * The tiles are painted into an offscreen canvas that is kept between frames, so a frame only
+ * costs drawing the canvas once. update() repaints the tiles whose table moved since they were
+ * last painted, at most once per refresh period per tile, all of them batched into one vertex
+ * array: the work of an update follows the number of changed tiles, not the size of the grid.
+ */
+class SpectatorGrid : public sf::Drawable {
+public:
+    /**
+     * @brief Constructor. Lays the tiles out in a grid filling the window.
+     * @param font The font of all texts (must outlive the grid).
+     * @param size Size of the window.
+     * @param tiles Number of tiles.
+     * @param refreshPeriod Minimum time between two repaints of a tile.
+     * @throws std::runtime_error if the canvas cannot be created.
+     */
+    SpectatorGrid(const sf::Font& font, sf::Vector2u size, std::size_t tiles, std::chrono::milliseconds refreshPeriod);
+
+    /**
+     * @brief Repaints the tiles of the tables that moved and are due for a refresh.
+     * @param tables The live tables; table i is shown on tile i.
+     * @return Number of tiles repainted; 0 means the canvas did not change.
+     */
+    std::size_t update(const LiveTables& tables);
+
+    /**
+     * @brief Returns the number of draw calls of a frame of the grid.
+     * @return Draw calls per frame.
+     */
+    std::size_t drawCalls() const { return 1; }
+
+protected:
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+private:
+    sf::RenderTexture _canvas;        ///< All tiles, as last painted
+    sf::Sprite _sprite;               ///< Draws the canvas
+    BatchRenderer _batch;             ///< Geometry of the tiles being repainted
+    unsigned _columns;
+    sf::Vector2f _tileSize;
+    unsigned _textSize;
+    std::chrono::milliseconds _refreshPeriod;
+    std::vector<uint64_t> _versions;  ///< Version of the table state each tile shows
+    std::vector<std::chrono::steady_clock::time_point> _painted;  ///< Last repaint of each tile
+    LiveTableState _state;            ///< Reused copy of a table state
+    std::string _line;                ///< Reused buffer of the tile texts
+
+    void paintTile(std::size_t index);
+};
+
+} // namespace coup
@@ -0,0 +1,74 @@
+// idocohen963@gmail.com
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace coup {
+
+/**
+ * @class SpscQueue
+ * @brief Bounded lock-free queue between exactly one producer thread and one consumer thread.
+ *
+ * The items live in a fixed ring, so pushing and popping never allocate or lock. The producer only
+ * writes the tail and the consumer only writes the head; each publishes its index with release
+ * ordering after touching the item, which is enough for the other side to see the item.
+ *
+ * @tparam T Item type, copied in and out.
+ * @tparam Capacity Maximum number of queued items, a power of two.
+ */
+template <typename T, std::size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscQueue() : _head(0), _tail(0) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /**
+     * @brief Adds an item. Producer thread only.
+     * @param item The item.
+     * @return false if the queue is full.
+     */
+    bool push(const T& item) {
+        std::size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        _items[tail & (Capacity - 1)] = item;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest item. Consumer thread only.
+     * @param item Receives the item.
+     * @return false if the queue is empty.
+     */
+    bool pop(T& item) {
+        std::size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = _items[head & (Capacity - 1)];
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Returns whether the queue is empty. Exact on the consumer thread only.
+     * @return true if there is nothing to pop.
+     */
+    bool empty() const {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(64) std::atomic<std::size_t> _head;  ///< Next item to pop, written by the consumer
+    alignas(64) std::atomic<std::size_t> _tail;  ///< Next free slot, written by the producer
+    T _items[Capacity];
+};
+
+} // namespace coup
@@ -0,0 +1,157 @@
+// idocohen963@gmail.com
+#include "TableScene.hpp"
+#include "Labels.hpp"
+#include "VisualStyle.hpp"
+#include <cstdio>
+
+namespace coup {
+
+namespace {
+
+const float LEFT_MARGIN = 30.f;
+const float START_Y = 30.f;
+const float BUTTON_HEIGHT = 50.f;
+const float BUTTON_SPACING = 15.f;
+
+/// Character sizes of the screen texts, with whether they are bold
+const std::pair<unsigned, bool> TEXT_STYLES[] = {{26, true}, {20, false}, {20, true}, {18, false}, {18, true}, {16, false}};
+
+/**
+ * @brief Color of an action button, by what the action does.
+ */
+sf::Color buttonColor(ActionType action) {
+    if (action == ActionType::Coup) return VisualStyle::BUTTON_DANGER;
+    if (action == ActionType::Gather || action == ActionType::Tax) return VisualStyle::BUTTON_SUCCESS;
+    if (action == ActionType::Bribe) return VisualStyle::BUTTON_WARNING;
+    return VisualStyle::BUTTON_PRIMARY;
+}
+
+}
+
+TableScene::TableScene(const sf::Font& font, sf::Vector2u size)
+    : _size(size), _empty(true), _hasTexture(false), _batch(font) {
+    _colorBackground.setSize(sf::Vector2f(size.x, size.y));
+    _colorBackground.setFillColor(VisualStyle::PRIMARY_DARK);
+    for (const auto& style : TEXT_STYLES) {
+        _batch.textCache().prebuild(style.first, style.second);
+    }
+}
+
+void TableScene::setBackground(const sf::Sprite& sprite) {
+    _background = sprite;
+    _hasTexture = true;
+}
+
+bool TableScene::update(const TableView& view) {
+    if (!_empty && view == _shown) {
+        return false;
+    }
+    _shown = view;
+    _empty = false;
+    rebuild();
+    return true;
+}
+
+std::size_t TableScene::drawCalls() const {
+    return 1 + _batch.drawCalls(); // The background is drawn on its own
+}
+
+sf::FloatRect TableScene::buttonRect(std::size_t index) const {
+    float rightMargin = _size.x - 280.f;
+    float actionStartY = START_Y + 20.f;
+    return sf::FloatRect(rightMargin + 15.f, actionStartY + 40.f + index * (BUTTON_HEIGHT + BUTTON_SPACING),
+                         220.f, BUTTON_HEIGHT);
+}
+
+void TableScene::rebuild() {
+    _batch.clear();
+    float rightMargin = _size.x - 280.f;
+
+    // Shadows first, then panels, then their content
+    sf::Vector2f cardSize(350, 280);
+    sf::Vector2f cardPos(LEFT_MARGIN, START_Y);
+    sf::Vector2f panelSize(250, _shown.actions.size() * (BUTTON_HEIGHT + BUTTON_SPACING) + 40);
+    sf::Vector2f panelPos(rightMargin, START_Y);
+    _batch.addShape(createShadow(cardSize, cardPos, 5.f));
+    _batch.addShape(createShadow(panelSize, panelPos, 5.f));
+    for (std::size_t i = 0; i < _shown.actions.size(); ++i) {
+        sf::FloatRect rect = buttonRect(i);
+        _batch.addShape(createShadow(sf::Vector2f(rect.width, rect.height), sf::Vector2f(rect.left, rect.top), 3.f));
+    }
+
+    // Player info card
+    sf::RectangleShape card(cardSize);
+    card.setPosition(cardPos);
+    card.setFillColor(VisualStyle::PRIMARY_MEDIUM);
+    card.setOutlineThickness(2.f);
+    card.setOutlineColor(VisualStyle::ACCENT_BLUE);
+    _batch.addShape(card);
+
+    // Texts are composed in a reused buffer; the labels themselves are constants
+    _line.assign(_shown.playerName).append("'s Turn");
+    _batch.addText(_line, sf::Vector2f(LEFT_MARGIN + 20.f, START_Y + 20.f), 26, VisualStyle::TEXT_ACCENT, true);
+    _line.assign("Role: ").append(roleLabel(_shown.role));
+    _batch.addText(_line, sf::Vector2f(LEFT_MARGIN + 20.f, START_Y + 60.f), 20, VisualStyle::TEXT_PRIMARY);
+    char number[16];
+    std::snprintf(number, sizeof(number), "%d", _shown.coins);
+    _line.assign("Coins: ").append(number);
+    _batch.addText(_line, sf::Vector2f(LEFT_MARGIN + 20.f, START_Y + 90.f), 20, VisualStyle::ACCENT_YELLOW, true);
+    _batch.addText(_shown.sanctioned ? "Sanctioned: Yes" : "Sanctioned: No",
+                   sf::Vector2f(LEFT_MARGIN + 20.f, START_Y + 120.f), 18,
+                   _shown.sanctioned ? VisualStyle::ACCENT_RED : VisualStyle::ACCENT_GREEN);
+
+    // One text per seat, so a change of coins only lays out the line of that player
+    float lineY = START_Y + 160.f;
+    float lineSpacing = _batch.textCache().lineSpacing(16);
+    _batch.addText("Active Players:", sf::Vector2f(LEFT_MARGIN + 20.f, lineY), 16, VisualStyle::TEXT_SECONDARY);
+    for (const SeatView& seat : _shown.seats) {
+        if (seat.active) {
+            lineY += lineSpacing;
+            std::snprintf(number, sizeof(number), "%d", seat.coins);
+            _line.assign("• ").append(seat.name).append(" (").append(number).append(" coins)");
+            _batch.addText(_line, sf::Vector2f(LEFT_MARGIN + 20.f, lineY), 16, VisualStyle::TEXT_SECONDARY);
+        }
+    }
+
+    // Action panel; its height follows the number of actions
+    sf::RectangleShape panel(panelSize);
+    panel.setPosition(panelPos);
+    panel.setFillColor(VisualStyle::PRIMARY_MEDIUM);
+    panel.setOutlineThickness(2.f);
+    panel.setOutlineColor(VisualStyle::ACCENT_PURPLE);
+    _batch.addShape(panel);
+    _batch.addText("Available Actions", sf::Vector2f(rightMargin + 10.f, START_Y + 10.f), 18,
+                   VisualStyle::TEXT_ACCENT, true);
+
+    for (std::size_t i = 0; i < _shown.actions.size(); ++i) {
+        sf::FloatRect rect = buttonRect(i);
+        const ActionView& action = _shown.actions[i];
+        _batch.addShape(createRoundedButton(sf::Vector2f(rect.width, rect.height), sf::Vector2f(rect.left, rect.top),
+                                            buttonColor(action.action)));
+        const std::string& label = actionLabel(action.action);
+        float labelWidth = _batch.textWidth(label, 18, true);
+        _batch.addText(label, sf::Vector2f(rect.left + (rect.width - labelWidth) / 2.f, rect.top + 14.f), 18,
+                       VisualStyle::TEXT_PRIMARY, true);
+    }
+}
+
+bool TableScene::actionAt(sf::Vector2f point, ActionType& action) const {
+    for (std::size_t i = 0; i < _shown.actions.size(); ++i) {
+        if (buttonRect(i).contains(point)) {
+            action = _shown.actions[i].action;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TableScene::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+    if (_hasTexture) {
+        target.draw(_background, states);
+    } else {
+        target.draw(_colorBackground, states);
+    }
+    target.draw(_batch, states);
+}
+
+} // namespace coup
@@ -0,0 +1,125 @@
+// idocohen963@gmail.com
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "BatchRenderer.hpp"
+#include "GAME/game.hpp"
+
+namespace coup {
+
+/**
+ * @struct SeatView
+ * @brief What the game screen shows about one player.
+ */
+struct SeatView {
+    std::string name;  ///< Player name
+    int coins;         ///< Coins of the player
+    bool active;       ///< Whether the player is still in the game
+
+    bool operator==(const SeatView& other) const {
+        return name == other.name && coins == other.coins && active == other.active;
+    }
+    bool operator!=(const SeatView& other) const { return !(*this == other); }
+};
+
+/**
+ * @struct ActionView
+ * @brief An action button of the game screen.
+ */
+struct ActionView {
+    ActionType action;  ///< The action performed by the button, labelled by actionLabel()
+
+    bool operator==(const ActionView& other) const { return action == other.action; }
+    bool operator!=(const ActionView& other) const { return !(*this == other); }
+};
+
+/**
+ * @struct TableView
+ * @brief The state of the game as shown on the game screen.
+ * Captured from the Game once per change, never per frame.
+ */
+struct TableView {
+    std::string playerName;           ///< Name of the current player
+    Role role = Role::Spy;            ///< Role of the current player
+    int coins = 0;                    ///< Coins of the current player
+    bool sanctioned = false;          ///< Whether the current player is sanctioned
+    std::vector<SeatView> seats;      ///< All players, in seat order
+    std::vector<ActionView> actions;  ///< Actions the current player can start
+
+    bool operator==(const TableView& other) const {
+        return playerName == other.playerName && role == other.role && coins == other.coins &&
+               sanctioned == other.sanctioned && seats == other.seats && actions == other.actions;
+    }
+    bool operator!=(const TableView& other) const { return !(*this == other); }
+};
+
+/**
+ * @class TableScene
+ * @brief Retained widgets of the game screen.
+ *
+ * The info card, the players list and the action panel are laid out once per view. update()
+ * compares the new view with the one currently shown and only rebuilds the geometry when it
+ * changed, so the caller knows when a redraw is actually needed and drawing allocates nothing.
+ * All panels, shadows and buttons are batched into one vertex array and the texts into one per
+ * character size, so a frame costs a handful of draw calls whatever the number of buttons.
+ * Labels come from the constant tables of Labels.hpp and the players list is one text per seat,
+ * so a rebuild finds nearly every text in the layout cache of the batch.
+ */
+class TableScene : public sf::Drawable {
+public:
+    /**
+     * @brief Constructor. Lays out the static parts of the screen and loads the glyphs of every
+     * size it uses into the font atlas.
+     * @param font The font of all texts (must outlive the scene).
+     * @param size Size of the window.
+     */
+    TableScene(const sf::Font& font, sf::Vector2u size);
+
+    /**
+     * @brief Sets the background picture. Without one, a plain color is drawn.
+     * @param sprite Sprite already scaled to the window.
+     */
+    void setBackground(const sf::Sprite& sprite);
+
+    /**
+     * @brief Shows a new state of the game.
+     * @param view The state to show.
+     * @return true if anything on screen changed.
+     */
+    bool update(const TableView& view);
+
+    /**
+     * @brief Finds the action button under a point.
+     * @param point Point in window coordinates.
+     * @param action Receives the action of the button.
+     * @return true if a button was hit.
+     */
+    bool actionAt(sf::Vector2f point, ActionType& action) const;
+
+    /**
+     * @brief Returns the number of draw calls of a frame of the scene.
+     * @return Draw calls per frame.
+     */
+    std::size_t drawCalls() const;
+
+protected:
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+private:
+    sf::Vector2u _size;
+    TableView _shown;                  ///< The view the geometry currently shows
+    bool _empty;                       ///< No view was shown yet
+    bool _hasTexture;
+    sf::Sprite _background;
+    sf::RectangleShape _colorBackground;
+    std::string _line;                 ///< Reused buffer of the texts built from the view
+    BatchRenderer _batch;              ///< Geometry of everything but the background
+
+    void rebuild();
+    sf::FloatRect buttonRect(std::size_t index) const;
+};
+
+} // namespace coup
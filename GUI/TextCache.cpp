@@ -0,0 +1,115 @@
+// idocohen963@gmail.com
+#include "TextCache.hpp"
+#include <algorithm>
+
+namespace coup {
+
+namespace {
+
+void appendGlyph(std::vector<sf::Vertex>& vertices, const sf::Glyph& glyph, float x, float y) {
+    float left = x + glyph.bounds.left;
+    float top = y + glyph.bounds.top;
+    float right = left + glyph.bounds.width;
+    float bottom = top + glyph.bounds.height;
+    float u1 = static_cast<float>(glyph.textureRect.left);
+    float v1 = static_cast<float>(glyph.textureRect.top);
+    float u2 = static_cast<float>(glyph.textureRect.left + glyph.textureRect.width);
+    float v2 = static_cast<float>(glyph.textureRect.top + glyph.textureRect.height);
+
+    vertices.push_back(sf::Vertex(sf::Vector2f(left, top), sf::Color::White, sf::Vector2f(u1, v1)));
+    vertices.push_back(sf::Vertex(sf::Vector2f(right, top), sf::Color::White, sf::Vector2f(u2, v1)));
+    vertices.push_back(sf::Vertex(sf::Vector2f(left, bottom), sf::Color::White, sf::Vector2f(u1, v2)));
+    vertices.push_back(sf::Vertex(sf::Vector2f(left, bottom), sf::Color::White, sf::Vector2f(u1, v2)));
+    vertices.push_back(sf::Vertex(sf::Vector2f(right, top), sf::Color::White, sf::Vector2f(u2, v1)));
+    vertices.push_back(sf::Vertex(sf::Vector2f(right, bottom), sf::Color::White, sf::Vector2f(u2, v2)));
+}
+
+}
+
+TextCache::TextCache(const sf::Font& font) : _font(font), _hits(0), _misses(0) {
+}
+
+void TextCache::prebuild(unsigned size, bool bold) {
+    for (sf::Uint32 c = 32; c < 127; ++c) {
+        _font.getGlyph(c, size, bold);
+    }
+    _font.getGlyph(0x2022, size, bold); // The bullet of the players list
+}
+
+const TextLayout& TextCache::get(const std::string& text, unsigned size, bool bold) {
+    std::unordered_map<std::string, TextLayout>& layouts = _layouts[std::make_pair(size, bold)];
+    auto found = layouts.find(text);
+    if (found != layouts.end()) {
+        ++_hits;
+        return found->second;
+    }
+    ++_misses;
+    if (layouts.size() >= MAX_LAYOUTS) {
+        layouts.clear();
+    }
+    TextLayout& result = layouts[text];
+    layout(text, size, bold, result);
+    return result;
+}
+
+void TextCache::layout(const std::string& string, unsigned size, bool bold, TextLayout& result) const {
+    // Same rules as sf::Text: kerning, whitespace advances and line spacing, pen on the baseline.
+    // The sources are UTF-8, so the bullet of the players list is one glyph.
+    sf::String text = sf::String::fromUtf8(string.begin(), string.end());
+    float whitespaceWidth = _font.getGlyph(L' ', size, bold).advance;
+    float spacing = _font.getLineSpacing(size);
+    float x = 0.f;
+    float y = static_cast<float>(size);
+    float minX = static_cast<float>(size);
+    float maxX = 0.f;
+    sf::Uint32 previous = 0;
+
+    for (std::size_t i = 0; i < text.getSize(); ++i) {
+        sf::Uint32 current = text[i];
+        if (current == L'\r') continue;
+        x += _font.getKerning(previous, current, size);
+        previous = current;
+
+        if (current == L' ' || current == L'\t' || current == L'\n') {
+            minX = std::min(minX, x);
+            maxX = std::max(maxX, x);
+            if (current == L' ') {
+                x += whitespaceWidth;
+            } else if (current == L'\t') {
+                x += whitespaceWidth * 4;
+            } else {
+                y += spacing;
+                x = 0;
+            }
+            maxX = std::max(maxX, x);
+            continue;
+        }
+
+        const sf::Glyph& glyph = _font.getGlyph(current, size, bold);
+        appendGlyph(result.vertices, glyph, x, y);
+        minX = std::min(minX, x + glyph.bounds.left);
+        maxX = std::max(maxX, x + glyph.bounds.left + glyph.bounds.width);
+        x += glyph.advance;
+    }
+    if (minX > maxX) minX = maxX = 0.f; // Empty text
+    result.left = minX;
+    result.width = maxX - minX;
+}
+
+float TextCache::lineSpacing(unsigned size) const {
+    return _font.getLineSpacing(size);
+}
+
+const sf::Texture& TextCache::texture(unsigned size) const {
+    return _font.getTexture(size);
+}
+
+std::size_t TextCache::hits() const {
+    return _hits;
+}
+
+std::size_t TextCache::misses() const {
+    return _misses;
+}
+
+} // namespace coup
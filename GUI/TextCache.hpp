@@ -0,0 +1,98 @@
+// idocohen963@gmail.com
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace coup {
+
+/**
+ * @struct TextLayout
+ * @brief A text laid out into glyph quads, relative to its top left corner.
+ */
+struct TextLayout {
+    std::vector<sf::Vertex> vertices;  ///< Two triangles per visible glyph, texture coordinates in the font page
+    float left = 0.f;                  ///< Left of the first glyph
+    float width = 0.f;                 ///< Horizontal extent of the glyphs
+};
+
+/**
+ * @class TextCache
+ * @brief Keeps the layout of every text drawn, keyed by (string, size, style).
+ *
+ * A text is laid out the first time it is asked for; afterwards the same label only costs a hash
+ * lookup, and the lookup takes the string by reference, so it builds nothing. The glyphs live in
+ * the pages of the font texture (one per character size), which prebuild() fills in advance with
+ * all printable characters, so the atlas does not grow while a game is played and the cached
+ * texture coordinates stay valid.
+ *
+ * The texts of a game are few (labels, names and coin counts), but names and coins combine, so
+ * each (size, style) keeps at most MAX_LAYOUTS texts and is emptied when it is full.
+ */
+class TextCache {
+public:
+    static const std::size_t MAX_LAYOUTS = 1024;  ///< Cached texts per character size and style
+
+    /**
+     * @brief Constructor.
+     * @param font The font of all texts (must outlive the cache).
+     */
+    explicit TextCache(const sf::Font& font);
+
+    /**
+     * @brief Loads the printable ASCII characters into the font page of a size.
+     * @param size Character size.
+     * @param bold Whether to load the bold glyphs.
+     */
+    void prebuild(unsigned size, bool bold);
+
+    /**
+     * @brief Returns the layout of a text, laying it out on first use.
+     * @param text The text; '\n' starts a new line.
+     * @param size Character size.
+     * @param bold Whether to use bold glyphs.
+     * @return The layout, valid until the next call.
+     */
+    const TextLayout& get(const std::string& text, unsigned size, bool bold);
+
+    /**
+     * @brief Returns the distance between two lines of text.
+     * @param size Character size.
+     * @return Line spacing in pixels.
+     */
+    float lineSpacing(unsigned size) const;
+
+    /**
+     * @brief Returns the font page holding the glyphs of a size.
+     * @param size Character size.
+     * @return The texture.
+     */
+    const sf::Texture& texture(unsigned size) const;
+
+    /**
+     * @brief Returns the number of texts found in the cache.
+     * @return Cache hits so far.
+     */
+    std::size_t hits() const;
+
+    /**
+     * @brief Returns the number of texts laid out.
+     * @return Cache misses so far.
+     */
+    std::size_t misses() const;
+
+private:
+    const sf::Font& _font;
+    std::map<std::pair<unsigned, bool>, std::unordered_map<std::string, TextLayout>> _layouts;
+    std::size_t _hits;
+    std::size_t _misses;
+
+    void layout(const std::string& text, unsigned size, bool bold, TextLayout& result) const;
+};
+
+} // namespace coup
@@ -0,0 +1,84 @@
+// idocohen963@gmail.com
+#include "TimelineBar.hpp"
+#include "VisualStyle.hpp"
+#include <algorithm>
+#include <cstdio>
+
+namespace coup {
+
+TimelineBar::TimelineBar(const sf::Font& font, sf::Vector2u size)
+    : _panel(20.f, size.y - 100.f, size.x - 40.f, 84.f),
+      _track(40.f, size.y - 58.f, size.x - 80.f, 10.f),
+      _position(0), _length(0), _playing(false), _speed(0.f), _empty(true), _batch(font) {
+    _batch.textCache().prebuild(16, true);
+    _batch.textCache().prebuild(16, false);
+    _batch.textCache().prebuild(13, false);
+}
+
+bool TimelineBar::update(std::size_t position, std::size_t length, bool playing, float speed, const std::string& caption) {
+    if (!_empty && position == _position && length == _length && playing == _playing && speed == _speed &&
+        caption == _caption) {
+        return false;
+    }
+    _position = position;
+    _length = length;
+    _playing = playing;
+    _speed = speed;
+    _caption = caption;
+    _empty = false;
+    rebuild();
+    return true;
+}
+
+bool TimelineBar::positionAt(sf::Vector2f point, bool dragging, std::size_t& position) const {
+    // The slider is easier to grab with some room around the track
+    sf::FloatRect grab(_track.left - 10.f, _track.top - 12.f, _track.width + 20.f, _track.height + 24.f);
+    if (!dragging && !grab.contains(point)) {
+        return false;
+    }
+    float ratio = std::min(1.f, std::max(0.f, (point.x - _track.left) / _track.width));
+    position = static_cast<std::size_t>(ratio * _length + 0.5f);
+    return true;
+}
+
+void TimelineBar::rebuild() {
+    _batch.clear();
+    sf::RectangleShape panel(sf::Vector2f(_panel.width, _panel.height));
+    panel.setPosition(_panel.left, _panel.top);
+    panel.setFillColor(VisualStyle::PRIMARY_MEDIUM);
+    panel.setOutlineThickness(2.f);
+    panel.setOutlineColor(VisualStyle::ACCENT_PURPLE);
+    _batch.addShape(createShadow(panel.getSize(), panel.getPosition(), 5.f));
+    _batch.addShape(panel);
+
+    float ratio = _length > 0 ? static_cast<float>(_position) / _length : 0.f;
+    _batch.addRect(_track, VisualStyle::PRIMARY_DARK);
+    _batch.addRect(sf::FloatRect(_track.left, _track.top, _track.width * ratio, _track.height), VisualStyle::ACCENT_BLUE);
+    _batch.addRect(sf::FloatRect(_track.left + _track.width * ratio - 6.f, _track.top - 7.f, 12.f, _track.height + 14.f),
+                   VisualStyle::ACCENT_YELLOW);
+
+    char text[64];
+    std::snprintf(text, sizeof(text), "Move %zu / %zu", _position, _length);
+    _line.assign(text);
+    _batch.addText(_line, sf::Vector2f(_track.left, _panel.top + 10.f), 16, VisualStyle::TEXT_ACCENT, true);
+    _batch.addText(_caption, sf::Vector2f(_track.left + 150.f, _panel.top + 10.f), 16, VisualStyle::TEXT_PRIMARY);
+
+    if (_playing) {
+        std::snprintf(text, sizeof(text), "Playing %g moves/s", _speed);
+    } else {
+        std::snprintf(text, sizeof(text), "Paused (%g moves/s)", _speed);
+    }
+    _line.assign(text);
+    float width = _batch.textWidth(_line, 16, true);
+    _batch.addText(_line, sf::Vector2f(_track.left + _track.width - width, _panel.top + 10.f), 16,
+                   _playing ? VisualStyle::ACCENT_GREEN : VisualStyle::TEXT_SECONDARY, true);
+
+    _batch.addText("Space: play/pause   Left/Right: step   Up/Down: speed   Home/End: jump   Esc: quit",
+                   sf::Vector2f(_track.left, _track.top + _track.height + 10.f), 13, VisualStyle::TEXT_SECONDARY);
+}
+
+void TimelineBar::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+    target.draw(_batch, states);
+}
+
+} // namespace coup
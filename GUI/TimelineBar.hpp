@@ -0,0 +1,71 @@
+// idocohen963@gmail.com
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <string>
+#include "BatchRenderer.hpp"
+
+namespace coup {
+
+/**
+ * @class TimelineBar
+ * @brief Playback controls of the replay screen: position, slider and speed.
+ *
+ * The bar sits at the bottom of the window. Like TableScene, it only rebuilds its geometry when
+ * what it shows changed, and everything is batched into one BatchRenderer.
+ */
+class TimelineBar : public sf::Drawable {
+public:
+    /**
+     * @brief Constructor.
+     * @param font The font of all texts (must outlive the bar).
+     * @param size Size of the window.
+     */
+    TimelineBar(const sf::Font& font, sf::Vector2u size);
+
+    /**
+     * @brief Shows a new playback state.
+     * @param position Moves applied.
+     * @param length Moves of the game.
+     * @param playing Whether the replay is playing.
+     * @param speed Moves per second while playing.
+     * @param caption Description of the last move.
+     * @return true if anything on screen changed.
+     */
+    bool update(std::size_t position, std::size_t length, bool playing, float speed, const std::string& caption);
+
+    /**
+     * @brief Converts a point to a position of the timeline.
+     * @param point Point in window coordinates.
+     * @param dragging Whether the slider is being dragged; points outside the slider then count too.
+     * @param position Receives the position under the point.
+     * @return true if the point is on the slider, or dragging.
+     */
+    bool positionAt(sf::Vector2f point, bool dragging, std::size_t& position) const;
+
+    /**
+     * @brief Returns the number of draw calls of a frame of the bar.
+     * @return Draw calls per frame.
+     */
+    std::size_t drawCalls() const { return _batch.drawCalls(); }
+
+protected:
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+private:
+    sf::FloatRect _panel;
+    sf::FloatRect _track;
+    std::size_t _position;
+    std::size_t _length;
+    bool _playing;
+    float _speed;
+    std::string _caption;
+    bool _empty;               ///< Nothing was shown yet
+    std::string _line;         ///< Reused buffer of the texts
+    BatchRenderer _batch;
+
+    void rebuild();
+};
+
+} // namespace coup
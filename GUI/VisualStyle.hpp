@@ -0,0 +1,46 @@
+// idocohen963@gmail.com
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+namespace coup {
+
+// === Visual Design Constants - DESIGN IMPROVEMENT ===
+// Modern color palette for enhanced UI
+namespace VisualStyle {
+    // Primary colors
+    const sf::Color PRIMARY_DARK = sf::Color(26, 32, 44);        // Dark blue-gray
+    const sf::Color PRIMARY_MEDIUM = sf::Color(45, 55, 72);      // Medium blue-gray
+    const sf::Color PRIMARY_LIGHT = sf::Color(74, 85, 104);      // Light blue-gray
+    
+    // Accent colors
+    const sf::Color ACCENT_BLUE = sf::Color(66, 153, 225);       // Modern blue
+    const sf::Color ACCENT_GREEN = sf::Color(72, 187, 120);      // Modern green
+    const sf::Color ACCENT_RED = sf::Color(245, 101, 101);       // Modern red
+    const sf::Color ACCENT_YELLOW = sf::Color(237, 203, 67);     // Modern yellow
+    const sf::Color ACCENT_PURPLE = sf::Color(159, 122, 234);    // Modern purple
+    
+    // Text colors
+    const sf::Color TEXT_PRIMARY = sf::Color(255, 255, 255);     // White
+    const sf::Color TEXT_SECONDARY = sf::Color(160, 174, 192);   // Light gray
+    const sf::Color TEXT_ACCENT = sf::Color(237, 203, 67);       // Yellow accent
+    
+    // Background gradients (simulated with solid colors)
+    const sf::Color BG_GRADIENT_TOP = sf::Color(45, 55, 72);
+    const sf::Color BG_GRADIENT_BOTTOM = sf::Color(26, 32, 44);
+    
+    // Button styles
+    const sf::Color BUTTON_PRIMARY = sf::Color(66, 153, 225);
+    const sf::Color BUTTON_SUCCESS = sf::Color(72, 187, 120);
+    const sf::Color BUTTON_DANGER = sf::Color(245, 101, 101);
+    const sf::Color BUTTON_WARNING = sf::Color(237, 203, 67);
+    const sf::Color BUTTON_HOVER = sf::Color(90, 170, 240);      // Lighter blue for hover effect
+}
+
+// Helper function to create rounded rectangle shape - DESIGN IMPROVEMENT
+sf::RectangleShape createRoundedButton(sf::Vector2f size, sf::Vector2f position, sf::Color fillColor);
+
+// Helper function to create shadow effect - DESIGN IMPROVEMENT
+sf::RectangleShape createShadow(sf::Vector2f size, sf::Vector2f position, float offset = 4.f);
+
+} // namespace coup
@@ -1,17 +1,96 @@
 // idocohen963@gmail.com
 #include "GameGUI.hpp"
+#include "DiagnosticLog.hpp"
+#include "OffscreenSurface.hpp"
 #include "GAME/game.hpp"
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
 
-int main() {
+/**
+ * Usage: gui_exec [--log] [--record <file> | --replay <file> | --spectate <tables>] [--headless <script> [--frames <directory>] [--seed <n>]]
+ *
+ * Without options the GUI opens in a window. With --headless it renders offscreen, driven by the
+ * input script (see OffscreenSurface), optionally saving frames, and prints frame time percentiles.
+ * With --record the game is saved to a file, which --replay shows with a timeline instead of a game.
+ * With --spectate a dashboard of live bot games is shown instead of a game.
+ * With --log the diagnostic log is recorded and printed to stderr at exit.
+ */
+int main(int argc, char* argv[]) {
     try {
+        std::string script;
+        std::string frames;
+        unsigned seed = 1;
+        size_t tables = 0;
+        std::string record;
+        std::string replay;
+        for (int i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--log") == 0) {
+                coup::DiagnosticLog::getInstance().setEnabled(true);
+            } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+                record = argv[++i];
+            } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+                replay = argv[++i];
+            } else if (std::strcmp(argv[i], "--spectate") == 0 && i + 1 < argc) {
+                tables = std::stoul(argv[++i]);
+            } else if (std::strcmp(argv[i], "--headless") == 0 && i + 1 < argc) {
+                script = argv[++i];
+            } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+                frames = argv[++i];
+            } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+                seed = static_cast<unsigned>(std::stoul(argv[++i]));
+            } else {
+                std::cerr << "Usage: " << argv[0] << " [--log] [--record <file> | --replay <file> | --spectate <tables>] [--headless <script> [--frames <directory>] [--seed <n>]]" << std::endl;
+                return 1;
+            }
+        }
+
         coup::Game& game = coup::Game::getInstance();
-        coup::GameGUI gui(game);
-        gui.run();
+        if (script.empty()) {
+            coup::GameGUI gui(game);
+            gui.setRecordPath(record);
+            if (!replay.empty()) {
+                gui.runReplay(replay);
+            } else if (tables > 0) {
+                gui.runSpectator(tables);
+            } else {
+                gui.run();
+            }
+            gui.getAssets().report(std::cout);
+            coup::DiagnosticLog::getInstance().dump(std::cerr);
+            return 0;
+        }
+
+        std::ifstream in(script);
+        if (!in) {
+            throw std::runtime_error("Cannot open script '" + script + "'");
+        }
+        auto surface = std::make_unique<coup::OffscreenSurface>(900, 700);
+        surface->loadScript(in);
+        surface->setFrameDump(frames);
+        coup::OffscreenSurface& offscreen = *surface;
+
+        coup::GameGUI gui(game, std::move(surface));
+        gui.setSeed(seed);
+        gui.setRecordPath(record);
+        if (!replay.empty()) {
+            gui.runReplay(replay);
+        } else if (tables > 0) {
+            gui.runSpectator(tables);
+        } else {
+            gui.run();
+        }
+        std::cout << offscreen.frames() << " frames rendered offscreen\n";
+        offscreen.report(std::cout);
+        gui.getAssets().report(std::cout);
+        coup::DiagnosticLog::getInstance().dump(std::cerr);
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
     }
-    
+
     return 0;
 }
@@ -52,6 +52,22 @@ enum class ActionType {
     cancel      ///< Cancel - unique action for Judge (bribe), Governor (tax), and General (coup)
 };
 
+/**
+ * @struct PlayerState
+ * @brief Mutable state of a player, as a plain copyable record.
+ *
+ * Name and role never change during a game, so they are not part of the state.
+ * Used by Game::snapshot() and Game::restore().
+ */
+struct PlayerState {
+    int coins;          ///< Number of coins
+    bool active;        ///< Whether the player is still in the game
+    bool sanctioned;    ///< Whether the player is under sanction
+    bool lastArrested;  ///< Whether the player was arrested in the previous turn
+    bool canArrest;     ///< Whether the player is allowed to arrest in this turn
+    bool isBribed;      ///< Whether the player performed a bribe in the last turn
+};
+
 /**
  * @class Player
  * @brief Base class representing a player in the game.
@@ -244,6 +260,27 @@ class Player{
          * @return The player's role (of type Role)
          */
         Role getRole() const { return role; }
+
+        /**
+         * @brief Returns the mutable state of the player
+         * @return Coins and flags of the player
+         */
+        PlayerState getState() const {
+            return PlayerState{playerCoins, active, sanctioned, lastArrested, canArrest, isBribed};
+        }
+
+        /**
+         * @brief Overwrites the mutable state of the player
+         * @param state Coins and flags to set
+         */
+        void setState(const PlayerState& state) {
+            playerCoins = state.coins;
+            active = state.active;
+            sanctioned = state.sanctioned;
+            lastArrested = state.lastArrested;
+            canArrest = state.canArrest;
+            isBribed = state.isBribed;
+        }
         ///@}
         
         /**
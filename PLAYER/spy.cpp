@@ -51,7 +51,9 @@ namespace coup {
         target.checkActive();   // Check that the target player is active
         
         // 1. View coins (information gathering)
-        std::cout << target.getName() << " has " << target.getCoins() << " coins.\n";
+        if (Game::getInstance().isVerbose()) {
+            std::cout << target.getName() << " has " << target.getCoins() << " coins.\n";
+        }
         
         // 2. Prevent arrest ability for the next turn
         if (target.isCanArrest()) {
@@ -0,0 +1,759 @@
+// idocohen963@gmail.com
+#include "protocol.hpp"
+#include "server.hpp"
+#include "timerwheel.hpp"
+#include "SIM/simulator.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * @file loadgen_main.cpp
+ * @brief Load generator of the game server.
+ *
+ * Usage: coup_loadgen [--host <ip>] [--port <port>] [--unix <path>] [--tables N] [--players N]
+ *                     [--rate N] [--seconds N] [--connections N] [--seed N] [--spectators N]
+ *                     [--scaling N | --bandwidth | --timers N]
+ * Opens the connections, creates the tables and seats random lineups, then sends actions at the
+ * target rate (requests per second) for the given time and reports the latency percentiles of the
+ * actions (time from sending a request to receiving its reply). A rate of 0 sends as fast as the
+ * tables take, every table always waiting for one reply. With --spectators N, N other
+ * connections subscribe to every table and follow its states, which the report counts in bytes
+ * of state pushes per action.
+ *
+ * With --scaling N the generator starts its own server with 1, 2, 4, ... N shards instead,
+ * loads each with one generator thread per shard (each with the given connections and its share
+ * of the tables and of the rate) and reports the throughput of every shard count, then the
+ * metrics of the shards of the last run. Generators and shards share the cores, so the scaling
+ * needs twice as many cores as shards to show.
+ *
+ * With --bandwidth the generator starts its own server twice, sending full States then Deltas
+ * to the subscribers, and compares the bytes of state pushes per action.
+ *
+ * With --timers N the generator measures the timer wheel of the server alone instead: it schedules
+ * N concurrent timers a minute of 1 ms ticks apart at most, cancels and reschedules half of them
+ * (as players acting before their deadline), then turns the wheel tick by tick until all expired,
+ * and reports the time of every operation and whether each timer expired at its own tick.
+ *
+ * The load is open loop: requests are due at a fixed rate whatever the server latency. A table
+ * only has one action in flight, since the next one depends on the state the previous one led
+ * to; a request due while every table waits for a reply is skipped and reported, and more
+ * tables are needed to reach the rate. The bots play Gather and Tax, coup once they can, and never
+ * cancel. A finished table is replaced by a new one.
+ */
+
+using namespace coup;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+/**
+ * @brief A connection to the server and its buffers.
+ */
+struct Client {
+    int fd = -1;
+    std::string input;
+    std::string output;
+    std::unordered_map<uint32_t, TableState> watched;  ///< Tables of other connections it spectates
+};
+
+/**
+ * @brief A table played by the load generator.
+ */
+struct Slot {
+    size_t client = 0;
+    uint32_t table = 0;   ///< Server id, 0 while being created
+    TableState state;
+    bool busy = false;    ///< An action is waiting for its reply
+};
+
+/**
+ * @brief What a request in flight was sent for.
+ */
+struct Pending {
+    enum Purpose : uint8_t { Create, Setup, Action };
+    size_t slot;
+    Purpose purpose;
+    Clock::time_point sent;
+};
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 7777;
+    std::string unixPath;
+    size_t tables = 1000;
+    int players = 4;
+    double rate = 20000;
+    double seconds = 10;
+    size_t connections = 4;
+    uint64_t seed = 1;
+    size_t spectators = 0;  ///< Other connections subscribed to every table
+};
+
+int connectTo(const Options& options) {
+    int fd;
+    if (!options.unixPath.empty()) {
+        sockaddr_un address{};
+        if (options.unixPath.size() >= sizeof(address.sun_path)) {
+            throw std::runtime_error("Unix socket path too long");
+        }
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, options.unixPath.c_str(), options.unixPath.size() + 1);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+            throw std::runtime_error("Cannot connect to " + options.unixPath + ": " + std::strerror(errno));
+        }
+    } else {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(options.port));
+        if (inet_pton(AF_INET, options.host.c_str(), &address.sin_addr) != 1) {
+            throw std::runtime_error("Invalid host address " + options.host);
+        }
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+            throw std::runtime_error("Cannot connect to " + options.host + ":" + std::to_string(options.port) +
+                                     ": " + std::strerror(errno));
+        }
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+    if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) < 0) {
+        throw std::runtime_error("fcntl failed");
+    }
+    return fd;
+}
+
+/**
+ * @brief What a load generator measured.
+ */
+struct LoadResult {
+    uint64_t sent = 0;       ///< Actions sent in the measured time
+    uint64_t answered = 0;   ///< Actions answered in the measured time
+    uint64_t errors = 0;     ///< Requests refused by the server
+    uint64_t skipped = 0;    ///< Actions due while every table waited for a reply
+    uint64_t games = 0;      ///< Games finished
+    uint64_t stateBytes = 0; ///< Bytes of States and Deltas received in the measured time
+    double seconds = 0;      ///< Measured time
+    std::vector<double> latencies;  ///< Microseconds of every answered action
+
+    /**
+     * @brief Adds the counts of another generator; the runs overlap, so the time is the longest.
+     */
+    void merge(const LoadResult& other) {
+        sent += other.sent;
+        answered += other.answered;
+        errors += other.errors;
+        skipped += other.skipped;
+        games += other.games;
+        stateBytes += other.stateBytes;
+        seconds = std::max(seconds, other.seconds);
+        latencies.insert(latencies.end(), other.latencies.begin(), other.latencies.end());
+    }
+
+    /**
+     * @brief Returns a latency percentile; sorts the latencies on first use.
+     */
+    double percentile(double fraction) {
+        if (latencies.empty()) {
+            return 0.0;
+        }
+        if (!std::is_sorted(latencies.begin(), latencies.end())) {
+            std::sort(latencies.begin(), latencies.end());
+        }
+        return latencies[std::min(latencies.size() - 1, static_cast<size_t>(fraction * latencies.size()))];
+    }
+};
+
+/**
+ * @brief Picks the next request of a table: the answer of a cancel window, or the action of the turn.
+ * @return false if the table waits for nothing the bots can send.
+ */
+bool chooseRequest(const TableState& state, Rng& rng, Request& request) {
+    if (state.phase == ServerPhase::CancelWindow) {
+        request.type = MessageType::Answer;
+        request.seat = state.asked;
+        request.cancel = false;
+        return true;
+    }
+    if (state.phase != ServerPhase::Turn) {
+        return false;
+    }
+    int self = state.current;
+    request.type = MessageType::Act;
+    request.seat = self;
+    request.target = -1;
+    int coins = state.coins[self];
+    if (coins >= 7 && (coins >= 10 || rng() % 2 == 0)) {
+        for (int i = 1; i < state.playerCount; ++i) {
+            int other = (self + i) % state.playerCount;
+            if (state.active[other]) {
+                request.action = ActionType::Coup;
+                request.target = other;
+                return true;
+            }
+        }
+    }
+    request.action = (rng() % 2 == 0) ? ActionType::Gather : ActionType::Tax;
+    return true;
+}
+
+class LoadGenerator {
+public:
+    explicit LoadGenerator(const Options& options)
+        : _options(options), _rng(options.seed), _slots(options.tables), _seq(0), _cursor(0), _measuring(false) {
+        _epoll = epoll_create1(0);
+        if (_epoll < 0) {
+            throw std::runtime_error("epoll_create1 failed");
+        }
+        _clients.resize(std::max<size_t>(1, options.connections));
+        if (options.spectators >= _clients.size()) {
+            throw std::runtime_error("Spectators need more connections than spectators per table");
+        }
+        for (size_t c = 0; c < _clients.size(); ++c) {
+            _clients[c].fd = connectTo(options);
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.u64 = c;
+            epoll_ctl(_epoll, EPOLL_CTL_ADD, _clients[c].fd, &event);
+        }
+    }
+
+    ~LoadGenerator() {
+        for (Client& client : _clients) {
+            close(client.fd);
+        }
+        close(_epoll);
+    }
+
+    LoadResult run() {
+        for (size_t s = 0; s < _slots.size(); ++s) {
+            _slots[s].client = s % _clients.size();
+            create(s);
+        }
+        // Setup: wait until every table plays
+        Clock::time_point deadline = Clock::now() + std::chrono::seconds(30);
+        while (std::any_of(_slots.begin(), _slots.end(), [](const Slot& slot) { return !playing(slot); })) {
+            if (Clock::now() > deadline) {
+                throw std::runtime_error("The tables were not set up within 30 seconds");
+            }
+            poll(1);
+        }
+
+        _measuring = true;
+        Clock::time_point start = Clock::now();
+        Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(
+                                            std::chrono::duration<double>(_options.seconds));
+        uint64_t issued = 0;
+        Request request;
+        while (Clock::now() < end) {
+            uint64_t due = UINT64_MAX; // Closed loop: every table that can play does
+            if (_options.rate > 0) {
+                due = static_cast<uint64_t>(std::chrono::duration<double>(Clock::now() - start).count() * _options.rate);
+            }
+            while (issued < due) {
+                size_t slot = nextPlayable();
+                if (slot == _slots.size()) {
+                    if (_options.rate > 0) {
+                        _result.skipped += due - issued; // Every table waits for a reply
+                        issued = due;
+                    }
+                    break;
+                }
+                chooseRequest(_slots[slot].state, _rng, request);
+                request.table = _slots[slot].table;
+                _slots[slot].busy = true;
+                sendRequest(slot, request, Pending::Action);
+                ++issued;
+            }
+            poll(1); // Returns as soon as replies arrive; sleeping leaves the cores to the server
+        }
+        _result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        _result.sent = issued - _result.skipped;
+        _measuring = false;
+        Clock::time_point drain = Clock::now() + std::chrono::seconds(2);
+        while (!_pending.empty() && Clock::now() < drain) {
+            poll(1);
+        }
+        return std::move(_result);
+    }
+
+private:
+    Options _options;
+    Rng _rng;
+    int _epoll;
+    std::vector<Client> _clients;
+    std::vector<Slot> _slots;
+    std::unordered_map<uint32_t, size_t> _tableSlots;  ///< Server table id -> slot
+    std::unordered_map<uint32_t, Pending> _pending;    ///< By seq
+    uint32_t _seq;
+    size_t _cursor;
+    bool _measuring;
+    LoadResult _result;
+    TableState _state;   ///< Decoding buffers
+    StateDelta _delta;
+
+    static bool playing(const Slot& slot) {
+        return slot.table != 0 && (slot.state.phase == ServerPhase::Turn || slot.state.phase == ServerPhase::CancelWindow);
+    }
+
+    /**
+     * @brief Finds the next table that can take an action, round robin.
+     * @return The slot, or the number of slots if every table is busy.
+     */
+    size_t nextPlayable() {
+        for (size_t n = 0; n < _slots.size(); ++n) {
+            size_t slot = _cursor;
+            _cursor = (_cursor + 1) % _slots.size();
+            if (!_slots[slot].busy && playing(_slots[slot])) {
+                return slot;
+            }
+        }
+        return _slots.size();
+    }
+
+    void sendRequest(size_t slot, Request& request, Pending::Purpose purpose, size_t client) {
+        request.seq = ++_seq;
+        encodeRequest(request, _clients[client].output);
+        _pending[request.seq] = Pending{slot, purpose, Clock::now()};
+    }
+
+    void sendRequest(size_t slot, Request& request, Pending::Purpose purpose) {
+        request.seq = ++_seq;
+        encodeRequest(request, _clients[_slots[slot].client].output);
+        _pending[request.seq] = Pending{slot, purpose, Clock::now()};
+    }
+
+    void create(size_t slot) {
+        _slots[slot].table = 0;
+        _slots[slot].state = TableState();
+        Request request;
+        request.type = MessageType::CreateTable;
+        sendRequest(slot, request, Pending::Create);
+    }
+
+    /**
+     * @brief Seats a random lineup on a created table, subscribes to it (from the spectators too)
+     * and starts it, in one burst.
+     */
+    void setup(size_t slot, uint32_t table) {
+        _slots[slot].table = table;
+        _tableSlots[table] = slot;
+        Request request;
+        request.table = table;
+        request.type = MessageType::AddPlayer;
+        for (int i = 0; i < _options.players; ++i) {
+            request.role = static_cast<Role>(_rng() % ROLE_COUNT);
+            request.name = "bot" + std::to_string(i);
+            sendRequest(slot, request, Pending::Setup);
+        }
+        request.type = MessageType::Subscribe;
+        sendRequest(slot, request, Pending::Setup);
+        for (size_t k = 1; k <= _options.spectators; ++k) {
+            sendRequest(slot, request, Pending::Setup, (_slots[slot].client + k) % _clients.size());
+        }
+        request.type = MessageType::StartGame;
+        sendRequest(slot, request, Pending::Setup);
+    }
+
+    /**
+     * @brief Writes the queued requests, then handles what arrived within the timeout.
+     */
+    void poll(int timeoutMs) {
+        for (Client& client : _clients) {
+            while (!client.output.empty()) {
+                ssize_t written = send(client.fd, client.output.data(), client.output.size(), MSG_NOSIGNAL);
+                if (written > 0) {
+                    client.output.erase(0, static_cast<size_t>(written));
+                } else if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                    break;
+                } else if (written < 0 && errno != EINTR) {
+                    throw std::runtime_error("The server closed the connection");
+                }
+            }
+        }
+        epoll_event events[16];
+        int count = epoll_wait(_epoll, events, 16, timeoutMs);
+        for (int i = 0; i < count; ++i) {
+            receive(events[i].data.u64);
+        }
+    }
+
+    void receive(size_t c) {
+        Client& client = _clients[c];
+        char buffer[65536];
+        while (true) {
+            ssize_t received = read(client.fd, buffer, sizeof(buffer));
+            if (received > 0) {
+                client.input.append(buffer, static_cast<size_t>(received));
+            } else if (received == 0) {
+                throw std::runtime_error("The server closed the connection");
+            } else if (errno != EINTR) {
+                break;
+            }
+        }
+        size_t used = 0;
+        const char* body;
+        size_t size;
+        size_t frame;
+        while ((frame = nextFrame(client.input.data() + used, client.input.size() - used, body, size)) > 0) {
+            MessageType type = frameType(body);
+            if (type == MessageType::State || type == MessageType::Delta) {
+                if (_measuring) {
+                    _result.stateBytes += frame;
+                }
+                onState(c, body, size);
+            } else {
+                onReply(body, size);
+            }
+            used += frame;
+        }
+        client.input.erase(0, used);
+    }
+
+    /**
+     * @brief Keeps a table up to date: the state its player sees, or the copy of a spectator.
+     * A spectator may still follow a table its player already replaced, after a short game.
+     */
+    void onState(size_t c, const char* body, size_t size) {
+        std::unordered_map<uint32_t, TableState>& watched = _clients[c].watched;
+        std::unordered_map<uint32_t, size_t>::iterator found;
+        if (frameType(body) == MessageType::State) {
+            decodeState(body, size, _state);
+            auto spectated = watched.find(_state.table);
+            if (spectated != watched.end()) {
+                spectated->second = _state;
+                if (_state.phase == ServerPhase::GameOver) {
+                    watched.erase(spectated);
+                }
+                return;
+            }
+            found = _tableSlots.find(_state.table);
+            if (found == _tableSlots.end()) {
+                return;
+            }
+            if (_slots[found->second].client != c) {
+                watched[_state.table] = _state;
+                return;
+            }
+            _slots[found->second].state = _state;
+        } else {
+            decodeDelta(body, size, _delta);
+            auto spectated = watched.find(_delta.table);
+            if (spectated != watched.end()) {
+                applyDelta(_delta, spectated->second);
+                if (spectated->second.phase == ServerPhase::GameOver) {
+                    watched.erase(spectated);
+                }
+                return;
+            }
+            found = _tableSlots.find(_delta.table);
+            if (found == _tableSlots.end()) {
+                return;
+            }
+            applyDelta(_delta, _slots[found->second].state);
+        }
+        size_t slot = found->second;
+        if (_slots[slot].state.phase == ServerPhase::GameOver) {
+            ++_result.games;
+            _tableSlots.erase(found);
+            create(slot); // Its last reply may still be on the way, the slot stays busy until then
+        }
+    }
+
+    void onReply(const char* body, size_t size) {
+        Reply reply;
+        decodeReply(body, size, reply);
+        auto found = _pending.find(reply.seq);
+        if (found == _pending.end()) {
+            throw std::runtime_error("Reply to an unknown request");
+        }
+        Pending pending = found->second;
+        _pending.erase(found);
+        if (pending.purpose == Pending::Create) {
+            if (reply.type != MessageType::Created) {
+                throw std::runtime_error("Cannot create a table: " + reply.error);
+            }
+            setup(pending.slot, reply.table);
+            return;
+        }
+        if (reply.type == MessageType::Error) {
+            ++_result.errors;
+        }
+        if (pending.purpose == Pending::Action) {
+            _slots[pending.slot].busy = false;
+            if (_measuring) {
+                ++_result.answered;
+                _result.latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - pending.sent).count());
+            }
+        }
+    }
+};
+
+/**
+ * @brief Prints what a run measured.
+ */
+void report(const Options& options, LoadResult& result) {
+    std::cout << std::fixed << std::setprecision(0) << options.tables << " tables of " << options.players
+              << " players on " << options.connections << " connections, target ";
+    if (options.rate > 0) {
+        std::cout << options.rate << " requests/s\n";
+    } else {
+        std::cout << "as many requests as the tables take\n";
+    }
+    std::cout << "sent " << result.sent << " actions in " << std::setprecision(2) << result.seconds << "s ("
+              << std::setprecision(0) << result.sent / result.seconds << " requests/s), " << result.answered
+              << " answered, " << result.errors << " errors, " << result.skipped << " skipped (every table busy), "
+              << result.games << " games finished\n"
+              << std::setprecision(1) << "state pushes: " << result.stateBytes / std::max<double>(1, result.answered)
+              << " bytes per action (" << options.spectators << " spectators per table)\n"
+              << "latency us: p50 " << result.percentile(0.50) << ", p90 "
+              << result.percentile(0.90) << ", p99 " << result.percentile(0.99) << ", max "
+              << result.percentile(1.0) << std::endl;
+}
+
+/**
+ * @brief Runs generators on their own threads, each with its share of the tables and of the rate.
+ * @throws std::runtime_error if a generator failed.
+ */
+LoadResult runGenerators(const Options& options, unsigned count) {
+    std::vector<LoadResult> results(count);
+    std::vector<std::exception_ptr> failures(count);
+    std::vector<std::thread> threads;
+    for (unsigned g = 0; g < count; ++g) {
+        threads.emplace_back([&options, &results, &failures, count, g] {
+            Options share = options;
+            share.tables = std::max<size_t>(1, options.tables / count);
+            share.rate = options.rate / count;
+            share.seed = options.seed + g;
+            try {
+                LoadGenerator generator(share);
+                results[g] = generator.run();
+            } catch (...) {
+                failures[g] = std::current_exception();
+            }
+        });
+    }
+    LoadResult total;
+    for (unsigned g = 0; g < count; ++g) {
+        threads[g].join();
+    }
+    for (unsigned g = 0; g < count; ++g) {
+        if (failures[g]) {
+            std::rethrow_exception(failures[g]);
+        }
+        total.merge(results[g]);
+    }
+    return total;
+}
+
+/**
+ * @brief Serves an in-process server with 1, 2, 4, ... shards up to the given count, loads it
+ * with one generator thread per shard and prints the throughput and the metrics of the shards.
+ */
+void runScaling(Options options, unsigned maxShards) {
+    options.unixPath = "/tmp/coup_loadgen_" + std::to_string(getpid()) + ".sock";
+    std::vector<unsigned> counts;
+    for (unsigned k = 1; k < maxShards; k *= 2) {
+        counts.push_back(k);
+    }
+    counts.push_back(maxShards);
+    double baseline = 0;
+    std::cout << "shards  requests/s  speedup  p50 us  p99 us  forwarded  migrations" << std::endl;
+    std::vector<std::vector<ShardMetrics>> details;
+    for (unsigned k : counts) {
+        GameServer server(k);
+        server.listenUnix(options.unixPath);
+        std::thread loop([&server] { server.run(); });
+        LoadResult result;
+        try {
+            result = runGenerators(options, k);
+        } catch (...) {
+            server.stop();
+            loop.join();
+            throw;
+        }
+        server.stop();
+        loop.join();
+        uint64_t forwarded = 0;
+        uint64_t migrations = 0;
+        details.push_back(server.metrics());
+        for (const ShardMetrics& m : details.back()) {
+            forwarded += m.forwarded;
+            migrations += m.migratedOut;
+        }
+        double throughput = result.answered / result.seconds;
+        if (k == 1) {
+            baseline = throughput;
+        }
+        std::cout << std::setw(6) << k << std::fixed << std::setprecision(0) << std::setw(12) << throughput
+                  << std::setprecision(2) << std::setw(9) << throughput / baseline << std::setprecision(1)
+                  << std::setw(8) << result.percentile(0.50) << std::setw(8) << result.percentile(0.99)
+                  << std::setw(11) << forwarded << std::setw(12) << migrations << std::endl;
+    }
+    std::cout << "\nShards of the last run:\n";
+    printShardMetrics(details.back(), std::cout);
+}
+
+/**
+ * @brief Loads an in-process server sending full States, then one sending Deltas, and prints the
+ * bytes of state pushes each needed per action.
+ */
+void runBandwidth(Options options) {
+    options.unixPath = "/tmp/coup_loadgen_" + std::to_string(getpid()) + ".sock";
+    double perAction[2] = {};
+    for (int deltas = 0; deltas < 2; ++deltas) {
+        GameServer server;
+        server.setStateDeltas(deltas == 1);
+        server.listenUnix(options.unixPath);
+        std::thread loop([&server] { server.run(); });
+        LoadResult result;
+        try {
+            result = LoadGenerator(options).run();
+        } catch (...) {
+            server.stop();
+            loop.join();
+            throw;
+        }
+        server.stop();
+        loop.join();
+        perAction[deltas] = result.stateBytes / std::max<double>(1, result.answered);
+        std::cout << (deltas ? "deltas:      " : "full states: ") << std::fixed << std::setprecision(1)
+                  << perAction[deltas] << " bytes of state per action, " << std::setprecision(0)
+                  << result.answered / result.seconds << " requests/s, " << result.errors << " errors" << std::endl;
+    }
+    std::cout << std::setprecision(1) << "deltas send " << perAction[0] / std::max(1e-9, perAction[1])
+              << " times fewer bytes (" << options.players << " players, " << options.spectators
+              << " spectators per table)" << std::endl;
+}
+
+/**
+ * @brief Schedules, reschedules and expires count concurrent timers, and prints the cost of each
+ * operation.
+ */
+void runTimers(size_t count, uint64_t seed) {
+    const uint64_t span = 60000;
+    Rng rng(seed);
+    TimerWheel wheel;
+    std::vector<TimerWheel::Handle> handles(count);
+    std::vector<uint64_t> due(count);
+    auto nsPer = [](Clock::time_point start, size_t operations) {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / std::max<size_t>(1, operations);
+    };
+
+    Clock::time_point start = Clock::now();
+    for (size_t t = 0; t < count; ++t) {
+        due[t] = 1 + rng() % span;
+        handles[t] = wheel.schedule(due[t], t);
+    }
+    double scheduleNs = nsPer(start, count);
+
+    start = Clock::now();
+    for (size_t t = 0; t < count; t += 2) {
+        wheel.cancel(handles[t]);
+        due[t] = 1 + rng() % span;
+        handles[t] = wheel.schedule(due[t], t);
+    }
+    double rescheduleNs = nsPer(start, count / 2);
+
+    std::vector<uint64_t> expired;
+    size_t fired = 0;
+    size_t misplaced = 0;
+    start = Clock::now();
+    for (uint64_t tick = 1; tick <= span; ++tick) {
+        wheel.advance(tick, expired);
+        for (uint64_t t : expired) {
+            misplaced += due[t] != tick;
+        }
+        fired += expired.size();
+        expired.clear();
+    }
+    double advanceNs = nsPer(start, span);
+
+    std::cout << std::fixed << std::setprecision(1) << count << " concurrent timers over " << span << " ticks\n"
+              << "schedule:            " << scheduleNs << " ns per timer\n"
+              << "cancel + reschedule: " << rescheduleNs << " ns per timer\n"
+              << "advance:             " << advanceNs << " ns per tick, "
+              << advanceNs * span / std::max<size_t>(1, fired) << " ns per expired timer\n"
+              << fired << " expired, " << misplaced << " at the wrong tick, " << wheel.size() << " left" << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    unsigned scaling = 0;
+    bool bandwidth = false;
+    size_t timers = 0;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--host") == 0 && hasValue) {
+            options.host = argv[++i];
+        } else if (std::strcmp(argv[i], "--port") == 0 && hasValue) {
+            options.port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--unix") == 0 && hasValue) {
+            options.unixPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--tables") == 0 && hasValue) {
+            options.tables = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--players") == 0 && hasValue) {
+            options.players = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--rate") == 0 && hasValue) {
+            options.rate = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--seconds") == 0 && hasValue) {
+            options.seconds = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--connections") == 0 && hasValue) {
+            options.connections = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--scaling") == 0 && hasValue) {
+            scaling = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--spectators") == 0 && hasValue) {
+            options.spectators = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--bandwidth") == 0) {
+            bandwidth = true;
+        } else if (std::strcmp(argv[i], "--timers") == 0 && hasValue) {
+            timers = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+    if (options.tables == 0 || options.players < 2 || options.players > MAX_PLAYERS) {
+        std::cerr << "Need at least one table and 2-6 players" << std::endl;
+        return 1;
+    }
+
+    try {
+        if (timers > 0) {
+            runTimers(timers, options.seed);
+        } else if (scaling > 0) {
+            runScaling(options, scaling);
+        } else if (bandwidth) {
+            runBandwidth(options);
+        } else {
+            LoadResult result = LoadGenerator(options).run();
+            report(options, result);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,389 @@
+// idocohen963@gmail.com
+#include "protocol.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include "SIM/encoding.hpp"
+#include "SIM/simulator.hpp"
+
+namespace coup {
+
+namespace {
+
+/**
+ * @brief Reserves the size field of a frame and writes the type.
+ * @return Position of the size field, filled by endFrame().
+ */
+size_t beginFrame(std::string& out, MessageType type) {
+    size_t start = out.size();
+    out.append(2, '\0');
+    out.push_back(static_cast<char>(type));
+    return start;
+}
+
+/**
+ * @brief Fills the size field of a frame once its body is written.
+ */
+void endFrame(std::string& out, size_t start) {
+    size_t body = out.size() - start - 2;
+    if (body > MAX_FRAME_BODY) {
+        throw std::runtime_error("Frame too large");
+    }
+    out[start] = static_cast<char>(body & 0xFF);
+    out[start + 1] = static_cast<char>(body >> 8);
+}
+
+void putString(std::string& out, const std::string& text) {
+    putVarint(out, text.size());
+    out.append(text);
+}
+
+std::string getString(const char*& cursor, const char* end) {
+    uint64_t size = getVarint(cursor, end);
+    if (size > static_cast<uint64_t>(end - cursor)) {
+        throw std::runtime_error("Truncated string");
+    }
+    std::string text(cursor, static_cast<size_t>(size));
+    cursor += size;
+    return text;
+}
+
+/**
+ * @brief Reads a varint that must fit a range.
+ */
+uint64_t getBounded(const char*& cursor, const char* end, uint64_t limit, const char* field) {
+    uint64_t value = getVarint(cursor, end);
+    if (value > limit) {
+        throw std::runtime_error(std::string("Invalid ") + field);
+    }
+    return value;
+}
+
+/**
+ * @brief Reads a zigzag encoded seat, -1 included.
+ */
+int getSeat(const char*& cursor, const char* end) {
+    int64_t seat = unzigzag(getVarint(cursor, end));
+    if (seat < -1 || seat >= MAX_PLAYERS) {
+        throw std::runtime_error("Invalid seat");
+    }
+    return static_cast<int>(seat);
+}
+
+void checkEnd(const char* cursor, const char* end) {
+    if (cursor != end) {
+        throw std::runtime_error("Trailing bytes in frame");
+    }
+}
+
+}
+
+// === Encoding ===
+
+void encodeRequest(const Request& request, std::string& out) {
+    size_t start = beginFrame(out, request.type);
+    putVarint(out, request.seq);
+    switch (request.type) {
+        case MessageType::CreateTable:
+            break;
+        case MessageType::AddPlayer:
+            putVarint(out, request.table);
+            putVarint(out, static_cast<uint64_t>(request.role));
+            putString(out, request.name);
+            break;
+        case MessageType::StartGame:
+        case MessageType::Subscribe:
+            putVarint(out, request.table);
+            break;
+        case MessageType::Act:
+            putVarint(out, request.table);
+            putVarint(out, static_cast<uint64_t>(request.seat));
+            putVarint(out, static_cast<uint64_t>(request.action));
+            putVarint(out, zigzag(request.target));
+            break;
+        case MessageType::Answer:
+            putVarint(out, request.table);
+            putVarint(out, static_cast<uint64_t>(request.seat));
+            out.push_back(request.cancel ? 1 : 0);
+            break;
+        default:
+            throw std::runtime_error("Not a request type");
+    }
+    endFrame(out, start);
+}
+
+void encodeReply(const Reply& reply, std::string& out) {
+    if (reply.type != MessageType::Created && reply.type != MessageType::Ok && reply.type != MessageType::Error) {
+        throw std::runtime_error("Not a reply type");
+    }
+    size_t start = beginFrame(out, reply.type);
+    putVarint(out, reply.seq);
+    putVarint(out, reply.table);
+    if (reply.type == MessageType::Error) {
+        putString(out, reply.error);
+    }
+    endFrame(out, start);
+}
+
+/**
+ * @brief Writes the table fields, then role, coins and a flag byte (active, sanctioned) per seat.
+ */
+void encodeState(const TableState& state, std::string& out) {
+    size_t start = beginFrame(out, MessageType::State);
+    putVarint(out, state.table);
+    putVarint(out, state.version);
+    out.push_back(static_cast<char>(state.phase));
+    putVarint(out, static_cast<uint64_t>(state.current));
+    putVarint(out, zigzag(state.asked));
+    putVarint(out, zigzag(state.winner));
+    putVarint(out, static_cast<uint64_t>(state.playerCount));
+    for (int i = 0; i < state.playerCount; ++i) {
+        out.push_back(static_cast<char>(state.roles[i]));
+        putVarint(out, static_cast<uint64_t>(state.coins[i]));
+        out.push_back(static_cast<char>((state.active[i] ? 1 : 0) | (state.sanctioned[i] ? 2 : 0)));
+    }
+    endFrame(out, start);
+}
+
+/**
+ * @brief Writes the fields that changed, and one bit set per seat list.
+ */
+bool encodeDelta(const TableState& from, const TableState& to, std::string& out) {
+    if (from.table != to.table || from.playerCount != to.playerCount ||
+        !std::equal(from.roles, from.roles + from.playerCount, to.roles)) {
+        return false;
+    }
+    uint8_t changes = 0;
+    uint8_t coinSeats = 0;
+    uint8_t flagSeats = 0;
+    changes |= from.phase != to.phase ? DeltaChange::Phase : 0;
+    changes |= from.current != to.current ? DeltaChange::Current : 0;
+    changes |= from.asked != to.asked ? DeltaChange::Asked : 0;
+    changes |= from.winner != to.winner ? DeltaChange::Winner : 0;
+    for (int i = 0; i < to.playerCount; ++i) {
+        coinSeats |= from.coins[i] != to.coins[i] ? 1 << i : 0;
+        flagSeats |= from.active[i] != to.active[i] || from.sanctioned[i] != to.sanctioned[i] ? 1 << i : 0;
+    }
+    changes |= coinSeats ? DeltaChange::Coins : 0;
+    changes |= flagSeats ? DeltaChange::Flags : 0;
+
+    size_t start = beginFrame(out, MessageType::Delta);
+    putVarint(out, to.table);
+    putVarint(out, to.version - from.version);
+    out.push_back(static_cast<char>(changes));
+    if (changes & DeltaChange::Phase) {
+        out.push_back(static_cast<char>(to.phase));
+    }
+    if (changes & DeltaChange::Current) {
+        putVarint(out, static_cast<uint64_t>(to.current));
+    }
+    if (changes & DeltaChange::Asked) {
+        putVarint(out, zigzag(to.asked));
+    }
+    if (changes & DeltaChange::Winner) {
+        putVarint(out, zigzag(to.winner));
+    }
+    if (coinSeats) {
+        out.push_back(static_cast<char>(coinSeats));
+        for (int i = 0; i < to.playerCount; ++i) {
+            if (coinSeats & (1 << i)) {
+                putVarint(out, static_cast<uint64_t>(to.coins[i]));
+            }
+        }
+    }
+    if (flagSeats) {
+        out.push_back(static_cast<char>(flagSeats));
+        for (int i = 0; i < to.playerCount; ++i) {
+            if (flagSeats & (1 << i)) {
+                out.push_back(static_cast<char>((to.active[i] ? 1 : 0) | (to.sanctioned[i] ? 2 : 0)));
+            }
+        }
+    }
+    endFrame(out, start);
+    return true;
+}
+
+// === Decoding ===
+
+size_t nextFrame(const char* data, size_t size, const char*& body, size_t& bodySize) {
+    if (size < 2) {
+        return 0;
+    }
+    bodySize = static_cast<uint8_t>(data[0]) | (static_cast<size_t>(static_cast<uint8_t>(data[1])) << 8);
+    if (bodySize == 0 || bodySize > MAX_FRAME_BODY) {
+        throw std::runtime_error("Invalid frame size");
+    }
+    if (size < 2 + bodySize) {
+        return 0;
+    }
+    body = data + 2;
+    return 2 + bodySize;
+}
+
+void decodeRequest(const char* body, size_t size, Request& request) {
+    const char* cursor = body;
+    const char* end = body + size;
+    request.type = static_cast<MessageType>(getByte(cursor, end));
+    request.seq = static_cast<uint32_t>(getBounded(cursor, end, UINT32_MAX, "sequence number"));
+    switch (request.type) {
+        case MessageType::CreateTable:
+            break;
+        case MessageType::AddPlayer:
+            request.table = static_cast<uint32_t>(getBounded(cursor, end, UINT32_MAX, "table"));
+            request.role = static_cast<Role>(getBounded(cursor, end, ROLE_COUNT - 1, "role"));
+            request.name = getString(cursor, end);
+            break;
+        case MessageType::StartGame:
+        case MessageType::Subscribe:
+            request.table = static_cast<uint32_t>(getBounded(cursor, end, UINT32_MAX, "table"));
+            break;
+        case MessageType::Act:
+            request.table = static_cast<uint32_t>(getBounded(cursor, end, UINT32_MAX, "table"));
+            request.seat = static_cast<int>(getBounded(cursor, end, MAX_PLAYERS - 1, "seat"));
+            request.action = static_cast<ActionType>(getBounded(cursor, end, ACTION_COUNT - 1, "action"));
+            request.target = getSeat(cursor, end);
+            break;
+        case MessageType::Answer:
+            request.table = static_cast<uint32_t>(getBounded(cursor, end, UINT32_MAX, "table"));
+            request.seat = static_cast<int>(getBounded(cursor, end, MAX_PLAYERS - 1, "seat"));
+            request.cancel = getByte(cursor, end) != 0;
+            break;
+        default:
+            throw std::runtime_error("Unknown request type");
+    }
+    checkEnd(cursor, end);
+}
+
+void decodeReply(const char* body, size_t size, Reply& reply) {
+    const char* cursor = body;
+    const char* end = body + size;
+    reply.type = static_cast<MessageType>(getByte(cursor, end));
+    if (reply.type != MessageType::Created && reply.type != MessageType::Ok && reply.type != MessageType::Error) {
+        throw std::runtime_error("Unknown reply type");
+    }
+    reply.seq = static_cast<uint32_t>(getBounded(cursor, end, UINT32_MAX, "sequence number"));
+    reply.table = static_cast<uint32_t>(getBounded(cursor, end, UINT32_MAX, "table"));
+    reply.error.clear();
+    if (reply.type == MessageType::Error) {
+        reply.error = getString(cursor, end);
+    }
+    checkEnd(cursor, end);
+}
+
+void decodeState(const char* body, size_t size, TableState& state) {
+    const char* cursor = body;
+    const char* end = body + size;
+    if (static_cast<MessageType>(getByte(cursor, end)) != MessageType::State) {
+        throw std::runtime_error("Not a state frame");
+    }
+    state.table = static_cast<uint32_t>(getBounded(cursor, end, UINT32_MAX, "table"));
+    state.version = static_cast<uint32_t>(getBounded(cursor, end, UINT32_MAX, "version"));
+    uint8_t phase = getByte(cursor, end);
+    if (phase > static_cast<uint8_t>(ServerPhase::GameOver)) {
+        throw std::runtime_error("Invalid phase");
+    }
+    state.phase = static_cast<ServerPhase>(phase);
+    state.current = static_cast<int>(getBounded(cursor, end, MAX_PLAYERS - 1, "seat"));
+    state.asked = getSeat(cursor, end);
+    state.winner = getSeat(cursor, end);
+    state.playerCount = static_cast<int>(getBounded(cursor, end, MAX_PLAYERS, "player count"));
+    for (int i = 0; i < state.playerCount; ++i) {
+        uint8_t role = getByte(cursor, end);
+        if (role >= ROLE_COUNT) {
+            throw std::runtime_error("Invalid role");
+        }
+        state.roles[i] = static_cast<Role>(role);
+        state.coins[i] = static_cast<int>(getBounded(cursor, end, INT32_MAX, "coins"));
+        uint8_t flags = getByte(cursor, end);
+        state.active[i] = (flags & 1) != 0;
+        state.sanctioned[i] = (flags & 2) != 0;
+    }
+    checkEnd(cursor, end);
+}
+
+void decodeDelta(const char* body, size_t size, StateDelta& delta) {
+    const char* cursor = body;
+    const char* end = body + size;
+    if (static_cast<MessageType>(getByte(cursor, end)) != MessageType::Delta) {
+        throw std::runtime_error("Not a delta frame");
+    }
+    delta.table = static_cast<uint32_t>(getBounded(cursor, end, UINT32_MAX, "table"));
+    delta.step = static_cast<uint32_t>(getBounded(cursor, end, UINT32_MAX, "version step"));
+    delta.changes = getByte(cursor, end);
+    if (delta.changes & ~(DeltaChange::Phase | DeltaChange::Current | DeltaChange::Asked | DeltaChange::Winner |
+                          DeltaChange::Coins | DeltaChange::Flags)) {
+        throw std::runtime_error("Invalid delta changes");
+    }
+    if (delta.changes & DeltaChange::Phase) {
+        uint8_t phase = getByte(cursor, end);
+        if (phase > static_cast<uint8_t>(ServerPhase::GameOver)) {
+            throw std::runtime_error("Invalid phase");
+        }
+        delta.phase = static_cast<ServerPhase>(phase);
+    }
+    if (delta.changes & DeltaChange::Current) {
+        delta.current = static_cast<int>(getBounded(cursor, end, MAX_PLAYERS - 1, "seat"));
+    }
+    if (delta.changes & DeltaChange::Asked) {
+        delta.asked = getSeat(cursor, end);
+    }
+    if (delta.changes & DeltaChange::Winner) {
+        delta.winner = getSeat(cursor, end);
+    }
+    delta.coinSeats = 0;
+    if (delta.changes & DeltaChange::Coins) {
+        delta.coinSeats = getByte(cursor, end);
+        for (int i = 0; i < MAX_PLAYERS; ++i) {
+            if (delta.coinSeats & (1 << i)) {
+                delta.coins[i] = static_cast<int>(getBounded(cursor, end, INT32_MAX, "coins"));
+            }
+        }
+    }
+    delta.flagSeats = 0;
+    if (delta.changes & DeltaChange::Flags) {
+        delta.flagSeats = getByte(cursor, end);
+        for (int i = 0; i < MAX_PLAYERS; ++i) {
+            if (delta.flagSeats & (1 << i)) {
+                uint8_t flags = getByte(cursor, end);
+                delta.active[i] = (flags & 1) != 0;
+                delta.sanctioned[i] = (flags & 2) != 0;
+            }
+        }
+    }
+    if ((delta.coinSeats | delta.flagSeats) >> MAX_PLAYERS) {
+        throw std::runtime_error("Invalid seat");
+    }
+    checkEnd(cursor, end);
+}
+
+void applyDelta(const StateDelta& delta, TableState& state) {
+    if (delta.table != state.table) {
+        throw std::runtime_error("Delta of another table");
+    }
+    if ((delta.coinSeats | delta.flagSeats) >> state.playerCount) {
+        throw std::runtime_error("Delta of an empty seat");
+    }
+    state.version += delta.step;
+    if (delta.changes & DeltaChange::Phase) {
+        state.phase = delta.phase;
+    }
+    if (delta.changes & DeltaChange::Current) {
+        state.current = delta.current;
+    }
+    if (delta.changes & DeltaChange::Asked) {
+        state.asked = delta.asked;
+    }
+    if (delta.changes & DeltaChange::Winner) {
+        state.winner = delta.winner;
+    }
+    for (int i = 0; i < state.playerCount; ++i) {
+        if (delta.coinSeats & (1 << i)) {
+            state.coins[i] = delta.coins[i];
+        }
+        if (delta.flagSeats & (1 << i)) {
+            state.active[i] = delta.active[i];
+            state.sanctioned[i] = delta.sanctioned[i];
+        }
+    }
+}
+
+}
@@ -0,0 +1,244 @@
+// idocohen963@gmail.com
+#ifndef PROTOCOL_HPP
+#define PROTOCOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "PLAYER/player.hpp"
+
+/**
+ * @file protocol.hpp
+ * @brief Binary protocol between the game server and its clients.
+ *
+ * Every message is a frame: the body size (2 bytes, little endian), then the body. The body starts
+ * with the message type (one byte); its fields follow as varints (see encoding.hpp), signed
+ * fields zigzag encoded, strings as a varint size and the bytes.
+ *
+ *   CreateTable  seq                         -> Created seq table
+ *   AddPlayer    seq table role name         -> Ok seq table, or Error
+ *   StartGame    seq table                   -> Ok / Error
+ *   Act          seq table seat action target(zz)  -> Ok / Error
+ *   Answer       seq table seat cancel       -> Ok / Error (the asked player, in a cancel window)
+ *   Subscribe    seq table                   -> State, then Ok / Error
+ *   Error        seq table message
+ *   State        table version phase current asked(zz) winner(zz) count, per seat: role coins flags
+ *   Delta        table step changes [phase] [current] [asked(zz)] [winner(zz)]
+ *                [seats, coins of each] [seats, flags of each]
+ *
+ * A subscriber first receives the full State of the table, then Deltas: only the fields that
+ * changed since the previous State or Delta of the table on the connection, the bracketed fields
+ * being present when their bit of the changes byte is set (see DeltaChange), seats as a bit set.
+ * The version grows by step. A change of the seated players is always sent as a full State.
+ *
+ * The server publishes the changes of a table once per loop iteration, coalescing the requests
+ * that changed it meanwhile, and sends the replies of those requests after the state, so a
+ * client that sees a reply has already seen the state it led to.
+ */
+
+namespace coup {
+
+/**
+ * @enum MessageType
+ * @brief First byte of a frame body.
+ */
+enum class MessageType : uint8_t {
+    CreateTable = 1,
+    AddPlayer = 2,
+    StartGame = 3,
+    Act = 4,
+    Answer = 5,
+    Subscribe = 6,
+    Created = 0x81,
+    Ok = 0x82,
+    Error = 0x83,
+    State = 0x84,
+    Delta = 0x85
+};
+
+/**
+ * @brief Bits of the changes byte of a Delta.
+ */
+namespace DeltaChange {
+constexpr uint8_t Phase = 1;
+constexpr uint8_t Current = 2;
+constexpr uint8_t Asked = 4;
+constexpr uint8_t Winner = 8;
+constexpr uint8_t Coins = 16;
+constexpr uint8_t Flags = 32;
+}
+
+/**
+ * @enum ServerPhase
+ * @brief What a server table waits for.
+ */
+enum class ServerPhase : uint8_t {
+    Seating,       ///< Players, then the start of the game
+    Turn,          ///< An action of the current player
+    CancelWindow,  ///< The answer of the player asked whether to cancel the last action
+    GameOver       ///< Nothing, the game ended
+};
+
+/**
+ * @brief Largest frame body accepted.
+ */
+constexpr size_t MAX_FRAME_BODY = 1024;
+
+/**
+ * @struct Request
+ * @brief A message from a client. Only the fields of its type are meaningful.
+ */
+struct Request {
+    MessageType type = MessageType::CreateTable;
+    uint32_t seq = 0;                     ///< Chosen by the client, echoed in the reply
+    uint32_t table = 0;                   ///< All but CreateTable
+    Role role = Role::Spy;                ///< AddPlayer
+    std::string name;                     ///< AddPlayer
+    int seat = 0;                         ///< Act, Answer: seat of the player sending
+    ActionType action = ActionType::Gather;  ///< Act
+    int target = -1;                      ///< Act: seat of the target, or -1
+    bool cancel = false;                  ///< Answer
+};
+
+/**
+ * @struct Reply
+ * @brief The answer of the server to a request.
+ */
+struct Reply {
+    MessageType type = MessageType::Ok;  ///< Created, Ok or Error
+    uint32_t seq = 0;                    ///< Seq of the request
+    uint32_t table = 0;                  ///< The table of the request, or the created table
+    std::string error;                   ///< Error: why the request was refused
+};
+
+/**
+ * @struct TableState
+ * @brief State of a table, pushed to its subscribers.
+ */
+struct TableState {
+    uint32_t table = 0;
+    uint32_t version = 0;               ///< Increases with every change of the table
+    ServerPhase phase = ServerPhase::Seating;
+    int current = 0;                    ///< Seat whose turn it is
+    int asked = -1;                     ///< CancelWindow: seat asked whether to cancel
+    int winner = -1;                    ///< GameOver: seat of the winner
+    int playerCount = 0;
+    Role roles[6] = {};
+    int coins[6] = {};
+    bool active[6] = {};
+    bool sanctioned[6] = {};
+};
+
+/**
+ * @struct StateDelta
+ * @brief The changes of a table between two states (see the Delta message).
+ */
+struct StateDelta {
+    uint32_t table = 0;
+    uint32_t step = 0;                  ///< Growth of the version
+    uint8_t changes = 0;                ///< DeltaChange bits of the fields present
+    ServerPhase phase = ServerPhase::Seating;
+    int current = 0;
+    int asked = -1;
+    int winner = -1;
+    uint8_t coinSeats = 0;              ///< Seats whose coins changed, one bit each
+    int coins[6] = {};
+    uint8_t flagSeats = 0;              ///< Seats whose flags changed, one bit each
+    bool active[6] = {};
+    bool sanctioned[6] = {};
+};
+
+/**
+ * @brief Appends a request frame.
+ * @param request The request.
+ * @param out The buffer.
+ */
+void encodeRequest(const Request& request, std::string& out);
+
+/**
+ * @brief Appends a reply frame.
+ * @param reply The reply.
+ * @param out The buffer.
+ */
+void encodeReply(const Reply& reply, std::string& out);
+
+/**
+ * @brief Appends a state frame.
+ * @param state The state.
+ * @param out The buffer.
+ */
+void encodeState(const TableState& state, std::string& out);
+
+/**
+ * @brief Appends a delta frame taking a subscriber from one state of a table to a later one.
+ * @param from The state the subscriber has.
+ * @param to The new state.
+ * @param out The buffer.
+ * @return false, appending nothing, if the seated players changed and a full State is needed.
+ */
+bool encodeDelta(const TableState& from, const TableState& to, std::string& out);
+
+/**
+ * @brief Finds the first complete frame of a buffer.
+ * @param data Start of the received bytes.
+ * @param size Number of received bytes.
+ * @param body Receives the start of the frame body.
+ * @param bodySize Receives the size of the body.
+ * @return Size of the whole frame, or 0 if it is not complete yet.
+ * @throws std::runtime_error if the frame is empty or larger than MAX_FRAME_BODY.
+ */
+size_t nextFrame(const char* data, size_t size, const char*& body, size_t& bodySize);
+
+/**
+ * @brief Returns the type of a frame body.
+ * @param body The body (at least one byte).
+ * @return The message type.
+ */
+inline MessageType frameType(const char* body) { return static_cast<MessageType>(static_cast<uint8_t>(*body)); }
+
+/**
+ * @brief Decodes a request body.
+ * @param body The body.
+ * @param size Its size.
+ * @param request Receives the request.
+ * @throws std::runtime_error if the body is not a valid request.
+ */
+void decodeRequest(const char* body, size_t size, Request& request);
+
+/**
+ * @brief Decodes a reply body.
+ * @param body The body.
+ * @param size Its size.
+ * @param reply Receives the reply.
+ * @throws std::runtime_error if the body is not a valid reply.
+ */
+void decodeReply(const char* body, size_t size, Reply& reply);
+
+/**
+ * @brief Decodes a state body.
+ * @param body The body.
+ * @param size Its size.
+ * @param state Receives the state.
+ * @throws std::runtime_error if the body is not a valid state.
+ */
+void decodeState(const char* body, size_t size, TableState& state);
+
+/**
+ * @brief Decodes a delta body.
+ * @param body The body.
+ * @param size Its size.
+ * @param delta Receives the delta.
+ * @throws std::runtime_error if the body is not a valid delta.
+ */
+void decodeDelta(const char* body, size_t size, StateDelta& delta);
+
+/**
+ * @brief Applies a delta to the state it follows.
+ * @param delta The delta.
+ * @param state The state, updated.
+ * @throws std::runtime_error if the delta is of another table or names an empty seat.
+ */
+void applyDelta(const StateDelta& delta, TableState& state);
+
+}
+#endif
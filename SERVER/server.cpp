@@ -0,0 +1,214 @@
+// idocohen963@gmail.com
+#include "server.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace coup {
+
+namespace {
+
+std::runtime_error systemError(const std::string& what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+/**
+ * @brief Pins the calling thread to a core; a failure only costs locality.
+ */
+void pinToCore(unsigned core) {
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core % cores, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+}
+
+GameServer::GameServer(unsigned shards)
+    : _stopping(false), _balancePeriod(100), _minImbalance(100), _stateDeltas(true), _turnLimit(0),
+      _cancelLimit(0), _timeoutPolicy(TurnFlow::Timeout::Pass),
+      _routes(new std::atomic<std::atomic<uint64_t>*>[MAX_TABLES / ROUTE_CHUNK]), _nextTable(1) {
+    for (uint32_t c = 0; c < MAX_TABLES / ROUTE_CHUNK; ++c) {
+        _routes[c].store(nullptr);
+    }
+    for (unsigned s = 0; s < std::max(1u, shards); ++s) {
+        _shards.push_back(std::unique_ptr<Shard>(new Shard(*this, s)));
+    }
+}
+
+GameServer::~GameServer() {
+    _shards.clear(); // Closes the connections before the listeners
+    for (int fd : _listeners) {
+        ::close(fd);
+    }
+    if (!_unixPath.empty()) {
+        unlink(_unixPath.c_str());
+    }
+}
+
+uint16_t GameServer::listenTcp(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw systemError("socket");
+    }
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    socklen_t size = sizeof(address);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), size) < 0 || listen(fd, SOMAXCONN) < 0 ||
+        getsockname(fd, reinterpret_cast<sockaddr*>(&address), &size) < 0) {
+        std::runtime_error error = systemError("Cannot listen on TCP port " + std::to_string(port));
+        ::close(fd);
+        throw error;
+    }
+    _listeners.push_back(fd);
+    _shards[0]->addListener(fd);
+    return ntohs(address.sin_port);
+}
+
+void GameServer::listenUnix(const std::string& path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Unix socket path too long: " + path);
+    }
+    struct stat info;
+    if (lstat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+        unlink(path.c_str()); // Left by a server that did not shut down
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw systemError("socket");
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        std::runtime_error error = systemError("Cannot listen on " + path);
+        ::close(fd);
+        throw error;
+    }
+    _unixPath = path;
+    _listeners.push_back(fd);
+    _shards[0]->addListener(fd);
+}
+
+void GameServer::setBalancing(std::chrono::milliseconds period, uint64_t minImbalance) {
+    _balancePeriod = period;
+    _minImbalance = minImbalance;
+}
+
+void GameServer::setTurnLimits(std::chrono::milliseconds turn, std::chrono::milliseconds cancelWindow,
+                               TurnFlow::Timeout policy) {
+    _turnLimit = turn;
+    _cancelLimit = cancelWindow;
+    _timeoutPolicy = policy;
+}
+
+/**
+ * @brief Runs the shards, one per core, until stop(). A shard that fails stops the others.
+ */
+void GameServer::run() {
+    std::vector<std::thread> threads;
+    std::exception_ptr failure;
+    std::mutex failureMutex;
+    auto serve = [this, &failure, &failureMutex](unsigned s) {
+        pinToCore(s);
+        try {
+            _shards[s]->run();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(failureMutex);
+            if (!failure) {
+                failure = std::current_exception();
+            }
+            stop();
+        }
+    };
+    for (unsigned s = 1; s < _shards.size(); ++s) {
+        threads.emplace_back(serve, s);
+    }
+    serve(0);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    _stopping.store(false);
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+void GameServer::stop() {
+    _stopping.store(true);
+    for (const std::unique_ptr<Shard>& shard : _shards) {
+        shard->wake();
+    }
+}
+
+std::vector<ShardMetrics> GameServer::metrics() const {
+    std::vector<ShardMetrics> all;
+    for (const std::unique_ptr<Shard>& shard : _shards) {
+        all.push_back(shard->metrics());
+    }
+    return all;
+}
+
+uint64_t GameServer::requests() const {
+    uint64_t total = 0;
+    for (const std::unique_ptr<Shard>& shard : _shards) {
+        total += shard->metrics().requests;
+    }
+    return total;
+}
+
+/**
+ * @brief Numbers a new table and routes it to its shard.
+ * Routes are allocated by chunks, which are never freed or moved while the server lives, so
+ * readers find them without a lock.
+ * @return The table id, or 0 if the server created MAX_TABLES tables.
+ */
+uint32_t GameServer::createRoute(unsigned shard) {
+    uint32_t id = _nextTable.fetch_add(1);
+    if (id >= MAX_TABLES) {
+        _nextTable.store(MAX_TABLES);
+        return 0;
+    }
+    std::atomic<uint64_t>* chunk = _routes[id / ROUTE_CHUNK].load(std::memory_order_acquire);
+    if (!chunk) {
+        std::lock_guard<std::mutex> lock(_routesMutex);
+        chunk = _routes[id / ROUTE_CHUNK].load(std::memory_order_acquire);
+        if (!chunk) {
+            _chunks.emplace_back(new std::atomic<uint64_t>[ROUTE_CHUNK]);
+            chunk = _chunks.back().get();
+            for (uint32_t i = 0; i < ROUTE_CHUNK; ++i) {
+                chunk[i].store(0, std::memory_order_relaxed);
+            }
+            _routes[id / ROUTE_CHUNK].store(chunk, std::memory_order_release);
+        }
+    }
+    chunk[id % ROUTE_CHUNK].store(static_cast<uint64_t>(shard) << ROUTE_OWNER_SHIFT, std::memory_order_release);
+    return id;
+}
+
+std::atomic<uint64_t>* GameServer::route(uint32_t table) const {
+    if (table == 0 || table >= _nextTable.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    std::atomic<uint64_t>* chunk = _routes[table / ROUTE_CHUNK].load(std::memory_order_acquire);
+    return chunk ? &chunk[table % ROUTE_CHUNK] : nullptr;
+}
+
+}
@@ -0,0 +1,174 @@
+// idocohen963@gmail.com
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "protocol.hpp"
+#include "shard.hpp"
+
+/**
+ * @file server.hpp
+ * @brief Game server hosting many tables on one event loop per core.
+ */
+
+namespace coup {
+
+/**
+ * @class GameServer
+ * @brief Serves tables to clients over TCP and Unix sockets (see protocol.hpp).
+ *
+ * The server runs one Shard per thread, each pinned to its own core. Shard 0 accepts the
+ * connections and deals them to the shards in turn; a table belongs to the shard of the
+ * connection that created it, and migrates to another shard when its own is overloaded (see
+ * setBalancing()). Every shard reads the requests of its connections, applies those of its
+ * tables and routes the others to their owner, so no table is ever shared between threads.
+ *
+ * Within a shard, the output queued while handling ready sockets is written once per loop
+ * iteration, so a burst of requests costs one write per connection. Output a connection cannot
+ * take yet waits for EPOLLOUT; a client that stops reading and lets MAX_PENDING_OUTPUT bytes pile
+ * up is disconnected, as is a client sending a malformed frame. Requests refused by the table get
+ * an Error reply and change nothing.
+ *
+ * Tables are numbered from 1 in creation order. A finished table is dropped once its final
+ * state was pushed, so the memory of the server follows the number of running games.
+ */
+class GameServer {
+public:
+    static const size_t MAX_PENDING_OUTPUT = 4 << 20;  ///< Bytes a connection may leave unread
+    static const uint32_t MAX_TABLES = 1u << 24;       ///< Tables a server can create in its life
+
+    /**
+     * @brief Constructor.
+     * @param shards Number of event loops (at least 1).
+     * @throws std::runtime_error if an event loop cannot be created.
+     */
+    explicit GameServer(unsigned shards = 1);
+
+    /**
+     * @brief Destructor. Closes every socket and removes the Unix socket file.
+     */
+    ~GameServer();
+
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+    /**
+     * @brief Listens on a TCP port of every interface. Before run() only.
+     * @param port The port, or 0 for any free port.
+     * @return The port listened on.
+     * @throws std::runtime_error if the port cannot be bound.
+     */
+    uint16_t listenTcp(uint16_t port);
+
+    /**
+     * @brief Listens on a Unix socket. A socket file left at the path is replaced. Before run() only.
+     * @param path Path of the socket file.
+     * @throws std::runtime_error if the path cannot be bound.
+     */
+    void listenUnix(const std::string& path);
+
+    /**
+     * @brief Sets how tables are balanced between the shards. Before run() only.
+     * Every period, a shard that applied more than 1.25 times the average number of requests, and
+     * at least minImbalance more than the least loaded shard, hands it tables carrying half the
+     * difference.
+     * @param period Length of a balancing period; zero disables migrations.
+     * @param minImbalance Smallest difference of requests per period worth a migration.
+     */
+    void setBalancing(std::chrono::milliseconds period, uint64_t minImbalance);
+
+    /**
+     * @brief Sets whether subscribers receive the changes of their tables as Deltas (the default)
+     * or as full States. Before run() only.
+     * @param enabled Whether to send Deltas.
+     */
+    void setStateDeltas(bool enabled) { _stateDeltas = enabled; }
+
+    /**
+     * @brief Sets how long players may think. Before run() only.
+     * The clock of a table restarts with every change of the table. When a turn runs out, the
+     * current player does what the policy says; when a cancel window runs out, the asked player
+     * answers no. Deadlines are kept by a TimerWheel of 1 ms ticks in every shard, and follow
+     * the tables that migrate.
+     * @param turn Time to act; zero (the default) for no limit.
+     * @param cancelWindow Time to answer a cancel question; zero (the default) for no limit.
+     * @param policy What a player whose turn runs out does.
+     */
+    void setTurnLimits(std::chrono::milliseconds turn, std::chrono::milliseconds cancelWindow,
+                       TurnFlow::Timeout policy);
+
+    /**
+     * @brief Serves clients until stop() is called.
+     * Shard 0 runs on the calling thread, the other shards on their own threads.
+     * @throws std::runtime_error if an event loop fails.
+     */
+    void run();
+
+    /**
+     * @brief Makes run() return. Safe from any thread and from a signal handler.
+     */
+    void stop();
+
+    /**
+     * @brief Returns the number of shards.
+     * @return Number of event loops.
+     */
+    unsigned shards() const { return static_cast<unsigned>(_shards.size()); }
+
+    /**
+     * @brief Returns the counters of every shard. Safe from any thread.
+     * @return One entry per shard.
+     */
+    std::vector<ShardMetrics> metrics() const;
+
+    /**
+     * @brief Returns the number of tables created so far.
+     * @return Number of tables, finished ones included.
+     */
+    size_t tablesCreated() const { return _nextTable.load() - 1; }
+
+    /**
+     * @brief Returns the number of requests applied so far.
+     * @return Number of requests.
+     */
+    uint64_t requests() const;
+
+private:
+    friend class Shard;
+
+    // A route packs the shard owning a table, a flag raised while the table migrates and the
+    // number of requests routed to the owner and not applied yet.
+    static const uint64_t ROUTE_PENDING = 0xFFFFFFFFu;
+    static const uint64_t ROUTE_MOVING = uint64_t(1) << 48;
+    static const int ROUTE_OWNER_SHIFT = 32;
+    static const uint32_t ROUTE_CHUNK = 1u << 14;
+
+    std::vector<std::unique_ptr<Shard>> _shards;
+    std::vector<int> _listeners;
+    std::string _unixPath;
+    std::atomic<bool> _stopping;
+    std::chrono::milliseconds _balancePeriod;
+    uint64_t _minImbalance;
+    bool _stateDeltas;
+    std::chrono::milliseconds _turnLimit;
+    std::chrono::milliseconds _cancelLimit;
+    TurnFlow::Timeout _timeoutPolicy;
+
+    std::mutex _routesMutex;                                      ///< Only taken to add a chunk
+    std::unique_ptr<std::atomic<std::atomic<uint64_t>*>[]> _routes;  ///< Chunks of routes, by table id
+    std::vector<std::unique_ptr<std::atomic<uint64_t>[]>> _chunks;   ///< Owns the chunks
+    std::atomic<uint32_t> _nextTable;
+
+    uint32_t createRoute(unsigned shard);
+    std::atomic<uint64_t>* route(uint32_t table) const;
+    bool stopping() const { return _stopping.load(std::memory_order_relaxed); }
+};
+
+}
+#endif
@@ -0,0 +1,101 @@
+// idocohen963@gmail.com
+#include "server.hpp"
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+/**
+ * @file server_main.cpp
+ * @brief Command line runner of the game server.
+ *
+ * Usage: coup_server [--port <port>] [--unix <path>] [--shards N] [--full-states]
+ *                    [--turn-ms N] [--cancel-ms N] [--timeout pass|gather|forfeit]
+ * Listens on TCP port 7777 unless another port or a Unix socket is given (both can be),
+ * and serves on N event loops (one per core by default) until interrupted (Ctrl+C or SIGTERM),
+ * then prints the metrics of every shard. Subscribers receive Deltas, or full States with
+ * --full-states. Players have N ms to act with --turn-ms and to answer a cancel question with
+ * --cancel-ms; a player whose turn runs out passes, gathers or leaves the game as --timeout says.
+ */
+
+using namespace coup;
+
+static GameServer* running = nullptr;
+
+static void onSignal(int) {
+    if (running) {
+        running->stop();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    long port = -1;
+    std::string unixPath;
+    unsigned shards = std::max(1u, std::thread::hardware_concurrency());
+    bool deltas = true;
+    long turnMs = 0;
+    long cancelMs = 0;
+    TurnFlow::Timeout policy = TurnFlow::Timeout::Pass;
+    bool valid = true;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = std::strtol(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--unix") == 0 && i + 1 < argc) {
+            unixPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--shards") == 0 && i + 1 < argc) {
+            shards = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--full-states") == 0) {
+            deltas = false;
+        } else if (std::strcmp(argv[i], "--turn-ms") == 0 && i + 1 < argc) {
+            turnMs = std::strtol(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--cancel-ms") == 0 && i + 1 < argc) {
+            cancelMs = std::strtol(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "gather") {
+                policy = TurnFlow::Timeout::Gather;
+            } else if (name == "forfeit") {
+                policy = TurnFlow::Timeout::Forfeit;
+            } else if (name != "pass") {
+                valid = false;
+            }
+        } else {
+            valid = false;
+        }
+    }
+    if (!valid) {
+        std::cerr << "Usage: coup_server [--port <port>] [--unix <path>] [--shards N] [--full-states]\n"
+                  << "                   [--turn-ms N] [--cancel-ms N] [--timeout pass|gather|forfeit]" << std::endl;
+        return 1;
+    }
+    if (port < 0 && unixPath.empty()) {
+        port = 7777;
+    }
+
+    try {
+        GameServer server(shards);
+        server.setStateDeltas(deltas);
+        server.setTurnLimits(std::chrono::milliseconds(turnMs), std::chrono::milliseconds(cancelMs), policy);
+        if (port >= 0) {
+            std::cout << "Listening on TCP port " << server.listenTcp(static_cast<uint16_t>(port)) << std::endl;
+        }
+        if (!unixPath.empty()) {
+            server.listenUnix(unixPath);
+            std::cout << "Listening on " << unixPath << std::endl;
+        }
+        running = &server;
+        std::signal(SIGINT, onSignal);
+        std::signal(SIGTERM, onSignal);
+        server.run();
+        running = nullptr;
+        std::cout << "Served " << server.requests() << " requests on " << server.tablesCreated() << " tables, "
+                  << server.shards() << " shards" << std::endl;
+        printShardMetrics(server.metrics(), std::cout);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
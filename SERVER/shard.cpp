@@ -0,0 +1,828 @@
+// idocohen963@gmail.com
+#include "shard.hpp"
+#include "server.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace coup {
+
+namespace {
+
+const uint64_t WAKE_TAG = 0;                      ///< epoll data of the eventfd
+const uint64_t LISTENER_TAG = uint64_t(1) << 63;  ///< epoll data of a listener: tag | fd
+const int CONNECTION_SHIFT = 48;                  ///< Connection id: shard << shift | number
+const int MAX_EVENTS = 256;
+
+std::runtime_error systemError(const std::string& what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+unsigned shardOf(uint64_t connection) {
+    return static_cast<unsigned>(connection >> CONNECTION_SHIFT);
+}
+
+}
+
+// === Latency histogram ===
+
+LatencyHistogram::LatencyHistogram() {
+    for (std::atomic<uint64_t>& bucket : _buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Finds the power of two of the duration, then its quarter from the next two bits.
+ */
+void LatencyHistogram::record(uint64_t nanoseconds) {
+    int bucket = 0;
+    if (nanoseconds >= 4) {
+        int power = 63 - __builtin_clzll(nanoseconds);
+        bucket = std::min(BUCKETS - 1, 4 * power + static_cast<int>((nanoseconds >> (power - 2)) & 3));
+    }
+    _buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::percentile(double fraction) const {
+    uint64_t counts[BUCKETS];
+    uint64_t total = 0;
+    for (int b = 0; b < BUCKETS; ++b) {
+        counts[b] = _buckets[b].load(std::memory_order_relaxed);
+        total += counts[b];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(fraction * (total - 1));
+    uint64_t seen = 0;
+    int b = 0;
+    for (; b < BUCKETS - 1; ++b) {
+        seen += counts[b];
+        if (seen > rank) {
+            break;
+        }
+    }
+    // Upper bound of bucket b: 2^power * (1 + (quarter + 1) / 4)
+    int power = b / 4;
+    double bound = static_cast<double>(uint64_t(1) << power) * (1.0 + (b % 4 + 1) / 4.0);
+    return bound / 1000.0;
+}
+
+void printShardMetrics(const std::vector<ShardMetrics>& metrics, std::ostream& out) {
+    out << "shard  requests  forwarded  tables  connections  migrated in/out  queue max  p50 us  p99 us\n";
+    for (const ShardMetrics& m : metrics) {
+        char line[160];
+        std::snprintf(line, sizeof(line), "%5u %9llu %10llu %7zu %12zu %9llu / %-6llu %9zu %7.1f %7.1f\n", m.shard,
+                      static_cast<unsigned long long>(m.requests), static_cast<unsigned long long>(m.forwarded),
+                      m.tables, m.connections, static_cast<unsigned long long>(m.migratedIn),
+                      static_cast<unsigned long long>(m.migratedOut), m.maxQueueDepth, m.p50Us, m.p99Us);
+        out << line;
+    }
+    out.flush();
+}
+
+// === Shard ===
+
+Shard::Shard(GameServer& server, unsigned index)
+    : _server(server), _index(index), _epoll(-1), _wake(-1), _nextConnection(1), _nextShard(0),
+      _clockStart(std::chrono::steady_clock::now()), _periodRequests(0), _load(0), _requests(0), _forwarded(0),
+      _tableCount(0), _connectionCount(0), _migratedIn(0), _migratedOut(0), _queueDepth(0), _maxQueueDepth(0) {
+    _epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (_epoll < 0) {
+        throw systemError("epoll_create1");
+    }
+    _wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_wake < 0) {
+        ::close(_epoll);
+        throw systemError("eventfd");
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = WAKE_TAG;
+    epoll_ctl(_epoll, EPOLL_CTL_ADD, _wake, &event);
+}
+
+Shard::~Shard() {
+    for (auto& entry : _connections) {
+        ::close(entry.second.fd);
+    }
+    std::lock_guard<std::mutex> lock(_inboxMutex);
+    for (const ShardMessage& message : _inbox) {
+        if (message.kind == ShardMessage::Accept) {
+            ::close(message.fd); // Dealt to this shard but never adopted
+        }
+    }
+    ::close(_wake);
+    ::close(_epoll);
+}
+
+void Shard::addListener(int fd) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = LISTENER_TAG | static_cast<uint64_t>(fd);
+    if (epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &event) < 0) {
+        throw systemError("epoll_ctl");
+    }
+}
+
+void Shard::wake() {
+    uint64_t one = 1;
+    ssize_t written = write(_wake, &one, sizeof(one)); // write() is async-signal-safe
+    (void)written;
+}
+
+void Shard::post(std::vector<ShardMessage>& messages) {
+    bool idle;
+    {
+        std::lock_guard<std::mutex> lock(_inboxMutex);
+        idle = _inbox.empty();
+        for (ShardMessage& message : messages) {
+            _inbox.push_back(std::move(message));
+        }
+    }
+    messages.clear();
+    if (idle) {
+        wake(); // A non-empty inbox already has a wake-up on the way
+    }
+}
+
+ShardMetrics Shard::metrics() const {
+    ShardMetrics metrics;
+    metrics.shard = _index;
+    metrics.requests = _requests.load(std::memory_order_relaxed);
+    metrics.forwarded = _forwarded.load(std::memory_order_relaxed);
+    metrics.tables = _tableCount.load(std::memory_order_relaxed);
+    metrics.connections = _connectionCount.load(std::memory_order_relaxed);
+    metrics.migratedIn = _migratedIn.load(std::memory_order_relaxed);
+    metrics.migratedOut = _migratedOut.load(std::memory_order_relaxed);
+    metrics.queueDepth = _queueDepth.load(std::memory_order_relaxed);
+    metrics.maxQueueDepth = _maxQueueDepth.load(std::memory_order_relaxed);
+    metrics.p50Us = _latency.percentile(0.50);
+    metrics.p99Us = _latency.percentile(0.99);
+    return metrics;
+}
+
+/**
+ * @brief Waits for events, handles the ready sockets and the inbox, expires the deadlines, then
+ * delivers the output.
+ * Stalled connections are retried every iteration, without sleeping while there are any, and
+ * the loop wakes up every tick while tables are timed.
+ */
+void Shard::run() {
+    epoll_event events[MAX_EVENTS];
+    _outbox.resize(_server._shards.size());
+    _periodStart = std::chrono::steady_clock::now();
+    while (!_server.stopping()) {
+        int timeout = -1;
+        if (!_stalled.empty()) {
+            timeout = 0;
+        } else if (_server._balancePeriod.count() > 0 && _server._shards.size() > 1) {
+            timeout = static_cast<int>(_server._balancePeriod.count());
+        }
+        if (_timers.size() > 0 && (timeout < 0 || timeout > 1)) {
+            timeout = 1;
+        }
+        int count = epoll_wait(_epoll, events, MAX_EVENTS, timeout);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw systemError("epoll_wait");
+        }
+        for (int i = 0; i < count; ++i) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == WAKE_TAG) {
+                uint64_t value;
+                ssize_t drained = read(_wake, &value, sizeof(value));
+                (void)drained;
+            } else if (tag & LISTENER_TAG) {
+                accept(static_cast<int>(tag & ~LISTENER_TAG));
+            } else {
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    receive(tag);
+                }
+                if (events[i].events & EPOLLOUT) {
+                    flush(tag);
+                }
+            }
+        }
+        handleInbox();
+        if (!_stalled.empty()) {
+            std::vector<uint64_t> stalled;
+            stalled.swap(_stalled);
+            for (uint64_t id : stalled) {
+                auto found = _connections.find(id);
+                if (found != _connections.end()) {
+                    found->second.stalled = false;
+                    if (parse(id, found->second)) {
+                        closeIfAnswered(id, found->second);
+                    }
+                }
+            }
+        }
+        expireTimers();
+        deliver();
+        balance();
+    }
+}
+
+/**
+ * @brief Accepts every pending connection and deals them to the shards in turn.
+ */
+void Shard::accept(int listener) {
+    while (true) {
+        int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return; // EAGAIN once the backlog is empty; other errors are the client's
+        }
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)); // Fails harmlessly on Unix sockets
+        unsigned shard = _nextShard;
+        _nextShard = (_nextShard + 1) % _server._shards.size();
+        if (shard == _index) {
+            adoptConnection(fd);
+        } else {
+            ShardMessage message;
+            message.kind = ShardMessage::Accept;
+            message.fd = fd;
+            _outbox[shard].push_back(std::move(message));
+        }
+    }
+}
+
+void Shard::adoptConnection(int fd) {
+    uint64_t id = (static_cast<uint64_t>(_index) << CONNECTION_SHIFT) | _nextConnection++;
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = id;
+    if (epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &event) < 0) {
+        ::close(fd);
+        return;
+    }
+    _connections[id].fd = fd;
+    _connectionCount.store(_connections.size(), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Reads everything available and handles the complete frames.
+ */
+void Shard::receive(uint64_t id) {
+    auto found = _connections.find(id);
+    if (found == _connections.end()) {
+        return; // Closed earlier in this iteration
+    }
+    Connection& connection = found->second;
+    if (connection.readClosed) {
+        close(id); // Only a hangup or an error is still reported: the client is gone
+        return;
+    }
+    char buffer[16384];
+    bool closed = false;
+    while (true) {
+        ssize_t received = read(connection.fd, buffer, sizeof(buffer));
+        if (received > 0) {
+            connection.input.append(buffer, static_cast<size_t>(received));
+            continue;
+        }
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        closed = received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+        break;
+    }
+    if (closed && !connection.readClosed) {
+        // Half closed: stop reading, but answer what was sent before closing
+        connection.readClosed = true;
+        epoll_event event{};
+        event.events = connection.waiting ? static_cast<uint32_t>(EPOLLOUT) : 0;
+        event.data.u64 = id;
+        epoll_ctl(_epoll, EPOLL_CTL_MOD, connection.fd, &event);
+    }
+    if (connection.stalled) {
+        return; // The frames wait for the migrating table, the retry handles them in order
+    }
+    if (parse(id, connection)) {
+        closeIfAnswered(id, connection);
+    }
+}
+
+/**
+ * @brief Handles the complete frames of a connection, in order.
+ * Stops at a request for a migrating table, and queues the connection to retry from there.
+ * @return false if the connection was closed.
+ */
+bool Shard::parse(uint64_t id, Connection& connection) {
+    Request request;
+    size_t used = 0;
+    try {
+        const char* body;
+        size_t bodySize;
+        size_t frame;
+        while ((frame = nextFrame(connection.input.data() + used, connection.input.size() - used, body, bodySize)) > 0) {
+            decodeRequest(body, bodySize, request);
+            if (!route(id, request)) {
+                connection.stalled = true;
+                _stalled.push_back(id);
+                break;
+            }
+            ++connection.unanswered;
+            used += frame;
+        }
+    } catch (const std::runtime_error&) {
+        close(id); // A malformed frame, the stream cannot be trusted any more
+        return false;
+    }
+    connection.input.erase(0, used);
+    return true;
+}
+
+/**
+ * @brief Applies a request here or routes it to the shard owning its table.
+ *
+ * The route of a table counts the requests routed to its owner and not applied yet, and a table
+ * only migrates when that count is zero: the owner raises the moving flag with a compare and
+ * swap, and the new owner clears it once it adopted the table. A request for a moving table
+ * waits on its connection, so every request reaches the table in the order it was read, and a
+ * reply routed back before the migration is delivered before any later one (see deliver()).
+ * @return false if the table is migrating and the request must be retried later.
+ */
+bool Shard::route(uint64_t origin, const Request& request) {
+    auto read = std::chrono::steady_clock::now();
+    if (request.type == MessageType::CreateTable) {
+        apply(origin, request, read);
+        return true;
+    }
+    std::atomic<uint64_t>* entry = _server.route(request.table);
+    if (entry) {
+        uint64_t state = entry->load(std::memory_order_acquire);
+        if (state & GameServer::ROUTE_MOVING) {
+            return false;
+        }
+        unsigned owner = static_cast<unsigned>((state >> GameServer::ROUTE_OWNER_SHIFT) & 0xFFFF);
+        if (owner != _index) {
+            state = entry->fetch_add(1, std::memory_order_acq_rel);
+            if (state & GameServer::ROUTE_MOVING) {
+                entry->fetch_sub(1, std::memory_order_release);
+                return false;
+            }
+            owner = static_cast<unsigned>((state >> GameServer::ROUTE_OWNER_SHIFT) & 0xFFFF);
+            if (owner != _index) {
+                ShardMessage message;
+                message.kind = ShardMessage::Route;
+                message.connection = origin;
+                message.request = request;
+                message.read = read;
+                _outbox[owner].push_back(std::move(message));
+                _forwarded.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            entry->fetch_sub(1, std::memory_order_release); // Adopted here meanwhile
+        }
+    }
+    apply(origin, request, read); // Also answers requests for unknown tables
+    return true;
+}
+
+/**
+ * @brief Applies a request to a table of this shard, and holds the reply until the table is
+ * published (see publish()).
+ */
+void Shard::apply(uint64_t origin, const Request& request, std::chrono::steady_clock::time_point read) {
+    Reply reply;
+    reply.seq = request.seq;
+    reply.table = request.table;
+    if (request.type == MessageType::CreateTable) {
+        uint32_t id = _server.createRoute(_index);
+        if (id == 0) {
+            reply.type = MessageType::Error;
+            reply.error = "Too many tables";
+        } else {
+            std::unique_ptr<HostedTable>& created = _tables[id];
+            created.reset(new HostedTable());
+            created->table.reset(new ServerTable(id));
+            created->table->capture(created->published);
+            _tableCount.store(_tables.size(), std::memory_order_relaxed);
+            reply.type = MessageType::Created;
+            reply.table = id;
+        }
+    } else {
+        auto found = _tables.find(request.table);
+        if (found == _tables.end()) {
+            reply.type = MessageType::Error;
+            reply.error = "Unknown table";
+        } else {
+            HostedTable* hosted = found->second.get();
+            ServerTable& table = *hosted->table;
+            uint32_t version = table.version();
+            try {
+                switch (request.type) {
+                    case MessageType::AddPlayer: table.addPlayer(request.name, request.role); break;
+                    case MessageType::StartGame: table.start(); break;
+                    case MessageType::Act: table.act(request.seat, request.action, request.target); break;
+                    case MessageType::Answer: table.answer(request.seat, request.cancel); break;
+                    case MessageType::Subscribe:
+                        push(*hosted); // The state sent below must be the one the deltas follow
+                        if (std::find(hosted->subscribers.begin(), hosted->subscribers.end(), origin) ==
+                            hosted->subscribers.end()) {
+                            hosted->subscribers.push_back(origin);
+                        }
+                        _frame.clear();
+                        encodeState(hosted->published, _frame);
+                        send(origin, _frame);
+                        break;
+                    default: break;
+                }
+                reply.type = MessageType::Ok;
+            } catch (const std::runtime_error& e) {
+                reply.type = MessageType::Error;
+                reply.error = e.what();
+            }
+            if (table.version() != version && !hosted->dirty) {
+                hosted->dirty = true;
+                _dirty.push_back(request.table);
+            }
+            ++hosted->recent;
+        }
+    }
+
+    _replies.emplace_back(origin, std::string());
+    encodeReply(reply, _replies.back().second);
+    ++_periodRequests;
+    _requests.fetch_add(1, std::memory_order_relaxed);
+    _latency.record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - read).count()));
+}
+
+/**
+ * @brief Handles the messages of the other shards, in the order they were posted.
+ */
+void Shard::handleInbox() {
+    {
+        std::lock_guard<std::mutex> lock(_inboxMutex);
+        _received.swap(_inbox);
+    }
+    if (_received.empty()) {
+        return;
+    }
+    _queueDepth.store(_received.size(), std::memory_order_relaxed);
+    if (_received.size() > _maxQueueDepth.load(std::memory_order_relaxed)) {
+        _maxQueueDepth.store(_received.size(), std::memory_order_relaxed);
+    }
+    for (ShardMessage& message : _received) {
+        switch (message.kind) {
+            case ShardMessage::Route:
+                apply(message.connection, message.request, message.read);
+                _release.push_back(_server.route(message.request.table));
+                break;
+            case ShardMessage::Output: {
+                auto found = _connections.find(message.connection);
+                if (found != _connections.end()) {
+                    output(message.connection, found->second, message.bytes, message.reply);
+                }
+                break;
+            }
+            case ShardMessage::Adopt: {
+                HostedTable& adopted = *message.table;
+                _tables[message.tableId] = std::move(message.table);
+                if (adopted.deadline != std::chrono::steady_clock::time_point()) {
+                    uint64_t due = tick(adopted.deadline); // The clock goes on where the old owner left it
+                    adopted.timer = _timers.schedule(due > _timers.now() ? due - _timers.now() : 0, message.tableId);
+                }
+                _tableCount.store(_tables.size(), std::memory_order_relaxed);
+                _migratedIn.fetch_add(1, std::memory_order_relaxed);
+                // Taking over clears the moving flag; requests routed meanwhile count in the low bits
+                std::atomic<uint64_t>* entry = _server.route(message.tableId);
+                uint64_t state = entry->load(std::memory_order_relaxed);
+                uint64_t owned;
+                do {
+                    owned = (state & GameServer::ROUTE_PENDING) |
+                            (static_cast<uint64_t>(_index) << GameServer::ROUTE_OWNER_SHIFT);
+                } while (!entry->compare_exchange_weak(state, owned, std::memory_order_acq_rel));
+                break;
+            }
+            case ShardMessage::Accept:
+                adoptConnection(message.fd);
+                break;
+        }
+    }
+    _received.clear();
+}
+
+/**
+ * @brief Queues the changes of a table to its subscribers, as a Delta from the state they have
+ * or as a full State.
+ * Subscribers of this shard that disconnected are dropped from the list; the others are dropped
+ * by their own shard when the state reaches it.
+ */
+void Shard::push(HostedTable& hosted) {
+    if (!hosted.dirty) {
+        return;
+    }
+    hosted.dirty = false;
+    hosted.table->capture(_state);
+    if (!hosted.subscribers.empty()) {
+        _frame.clear();
+        if (!_server._stateDeltas || !encodeDelta(hosted.published, _state, _frame)) {
+            encodeState(_state, _frame);
+        }
+        size_t kept = 0;
+        for (uint64_t subscriber : hosted.subscribers) {
+            if (shardOf(subscriber) == _index && _connections.find(subscriber) == _connections.end()) {
+                continue;
+            }
+            hosted.subscribers[kept++] = subscriber;
+            send(subscriber, _frame);
+        }
+        hosted.subscribers.resize(kept);
+    }
+    hosted.published = _state;
+}
+
+/**
+ * @brief Pushes the changes of the tables changed in this iteration, drops the finished ones,
+ * then sends the replies held meanwhile, in the order of their requests.
+ */
+void Shard::publish() {
+    for (uint32_t id : _dirty) {
+        auto found = _tables.find(id);
+        if (found == _tables.end()) {
+            continue;
+        }
+        push(*found->second);
+        arm(id, *found->second);
+        if (found->second->published.phase == ServerPhase::GameOver) {
+            _tables.erase(found); // The final state is out, nothing can change any more
+        }
+    }
+    if (!_dirty.empty()) {
+        _dirty.clear();
+        _tableCount.store(_tables.size(), std::memory_order_relaxed);
+    }
+    for (const auto& reply : _replies) {
+        send(reply.first, reply.second, true);
+    }
+    _replies.clear();
+}
+
+/**
+ * @brief Restarts the clock of a published table for the player it waits for, or stops it when
+ * the table waits for no one or without a time limit.
+ */
+void Shard::arm(uint32_t id, HostedTable& hosted) {
+    _timers.cancel(hosted.timer);
+    hosted.timer = 0;
+    hosted.deadline = std::chrono::steady_clock::time_point();
+    std::chrono::milliseconds limit(0);
+    if (hosted.published.phase == ServerPhase::Turn) {
+        limit = _server._turnLimit;
+    } else if (hosted.published.phase == ServerPhase::CancelWindow) {
+        limit = _server._cancelLimit;
+    }
+    if (limit.count() <= 0) {
+        return;
+    }
+    hosted.deadline = std::chrono::steady_clock::now() + limit;
+    hosted.timer = _timers.schedule(tick(hosted.deadline) - _timers.now(), id);
+}
+
+/**
+ * @brief Turns the wheel to the current tick, and takes the default decision of the tables whose
+ * awaited player ran out of time. A table changed since it was published is spared: its clock
+ * restarts when it is published.
+ */
+void Shard::expireTimers() {
+    _timers.advance(tick(std::chrono::steady_clock::now()), _expired);
+    for (uint64_t expired : _expired) {
+        uint32_t id = static_cast<uint32_t>(expired);
+        auto found = _tables.find(id);
+        if (found == _tables.end() || found->second->table->version() != found->second->published.version) {
+            continue;
+        }
+        HostedTable& hosted = *found->second;
+        hosted.timer = 0;
+        hosted.deadline = std::chrono::steady_clock::time_point();
+        hosted.table->expire(_server._timeoutPolicy);
+        hosted.dirty = true;
+        _dirty.push_back(id);
+    }
+    _expired.clear();
+}
+
+/**
+ * @brief Returns the tick of the wheel at a time, counting milliseconds from the creation of the shard.
+ */
+uint64_t Shard::tick(std::chrono::steady_clock::time_point time) const {
+    if (time <= _clockStart) {
+        return 0;
+    }
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(time - _clockStart).count());
+}
+
+/**
+ * @brief Queues bytes for a connection of this shard, or for the shard serving it.
+ */
+void Shard::send(uint64_t connection, const std::string& bytes, bool reply) {
+    unsigned shard = shardOf(connection);
+    if (shard != _index) {
+        ShardMessage message;
+        message.kind = ShardMessage::Output;
+        message.connection = connection;
+        message.bytes = bytes;
+        message.reply = reply;
+        _outbox[shard].push_back(std::move(message));
+        return;
+    }
+    auto found = _connections.find(connection);
+    if (found == _connections.end()) {
+        return;
+    }
+    output(connection, found->second, bytes, reply);
+}
+
+/**
+ * @brief Appends bytes to the output of a connection of this shard and queues it for writing.
+ */
+void Shard::output(uint64_t id, Connection& connection, const std::string& bytes, bool reply) {
+    connection.output.append(bytes);
+    if (reply && connection.unanswered > 0) {
+        --connection.unanswered;
+    }
+    if (!connection.queued) {
+        connection.queued = true;
+        _flush.push_back(id);
+    }
+}
+
+/**
+ * @brief Publishes the tables changed, hands the gathered messages to the other shards, then
+ * releases the routes of the requests applied and writes the output of the connections.
+ * A route is only released once the reply is posted, so a table cannot migrate and answer a
+ * later request of the same client before an earlier reply left.
+ */
+void Shard::deliver() {
+    publish();
+    for (size_t s = 0; s < _outbox.size(); ++s) {
+        if (!_outbox[s].empty()) {
+            _server._shards[s]->post(_outbox[s]);
+        }
+    }
+    for (std::atomic<uint64_t>* entry : _release) {
+        entry->fetch_sub(1, std::memory_order_release);
+    }
+    _release.clear();
+    for (uint64_t id : _flush) {
+        flush(id);
+    }
+    _flush.clear();
+}
+
+/**
+ * @brief Once per period, publishes the load of the shard and hands tables to the least loaded
+ * shard when this one is well above the average. The busiest tables go first; a table with
+ * requests in flight stays, it can go in a later period.
+ */
+void Shard::balance() {
+    auto now = std::chrono::steady_clock::now();
+    if (_server._balancePeriod.count() <= 0 || now - _periodStart < _server._balancePeriod) {
+        return;
+    }
+    _periodStart = now;
+    _load.store(_periodRequests, std::memory_order_relaxed);
+    _periodRequests = 0;
+
+    const std::vector<std::unique_ptr<Shard>>& shards = _server._shards;
+    uint64_t total = 0;
+    unsigned coldest = _index;
+    for (unsigned s = 0; s < shards.size(); ++s) {
+        uint64_t load = shards[s]->load();
+        total += load;
+        if (load < shards[coldest]->load()) {
+            coldest = s;
+        }
+    }
+    uint64_t own = load();
+    uint64_t coldLoad = shards[coldest]->load();
+    bool overloaded = own * 4 * shards.size() > total * 5; // own > 1.25 * average
+    std::vector<std::pair<uint64_t, uint32_t>> candidates;
+    if (coldest != _index && overloaded && own - coldLoad >= _server._minImbalance) {
+        for (const auto& entry : _tables) {
+            candidates.emplace_back(entry.second->recent, entry.first);
+        }
+        std::sort(candidates.begin(), candidates.end(), std::greater<std::pair<uint64_t, uint32_t>>());
+    }
+
+    uint64_t budget = (own - coldLoad) / 2;
+    uint64_t moved = 0;
+    for (const auto& candidate : candidates) {
+        if (candidate.first == 0 || moved + candidate.first > budget) {
+            continue;
+        }
+        std::atomic<uint64_t>* entry = _server.route(candidate.second);
+        uint64_t idle = static_cast<uint64_t>(_index) << GameServer::ROUTE_OWNER_SHIFT;
+        if (!entry->compare_exchange_strong(idle, idle | GameServer::ROUTE_MOVING, std::memory_order_acq_rel)) {
+            continue; // Requests in flight
+        }
+        auto found = _tables.find(candidate.second);
+        _timers.cancel(found->second->timer); // The new owner times it from its deadline
+        found->second->timer = 0;
+        ShardMessage message;
+        message.kind = ShardMessage::Adopt;
+        message.tableId = candidate.second;
+        message.table = std::move(found->second);
+        _tables.erase(found);
+        _outbox[coldest].push_back(std::move(message));
+        _migratedOut.fetch_add(1, std::memory_order_relaxed);
+        moved += candidate.first;
+    }
+    for (auto& entry : _tables) {
+        entry.second->recent = 0;
+    }
+    if (moved > 0) {
+        _tableCount.store(_tables.size(), std::memory_order_relaxed);
+        _load.store(own - moved, std::memory_order_relaxed); // So other shards do not all pick the same one
+        deliver();
+    }
+}
+
+/**
+ * @brief Writes as much queued output as the socket takes, and waits for EPOLLOUT for the rest.
+ */
+void Shard::flush(uint64_t id) {
+    auto found = _connections.find(id);
+    if (found == _connections.end()) {
+        return;
+    }
+    Connection& connection = found->second;
+    connection.queued = false;
+    while (connection.sent < connection.output.size()) {
+        ssize_t written = ::send(connection.fd, connection.output.data() + connection.sent,
+                                 connection.output.size() - connection.sent, MSG_NOSIGNAL);
+        if (written > 0) {
+            connection.sent += static_cast<size_t>(written);
+        } else if (written < 0 && errno == EINTR) {
+            continue;
+        } else if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            close(id);
+            return;
+        }
+    }
+    bool pending = connection.sent < connection.output.size();
+    if (!pending) {
+        connection.output.clear();
+        connection.sent = 0;
+    } else if (connection.output.size() - connection.sent > GameServer::MAX_PENDING_OUTPUT) {
+        close(id); // The client does not read its replies
+        return;
+    } else if (connection.sent > connection.output.size() / 2) {
+        connection.output.erase(0, connection.sent);
+        connection.sent = 0;
+    }
+    if (pending != connection.waiting) {
+        epoll_event event{};
+        uint32_t readable = connection.readClosed ? 0 : static_cast<uint32_t>(EPOLLIN);
+        event.events = pending ? (readable | EPOLLOUT) : readable;
+        event.data.u64 = id;
+        epoll_ctl(_epoll, EPOLL_CTL_MOD, connection.fd, &event);
+        connection.waiting = pending;
+    }
+    if (!pending) {
+        closeIfAnswered(id, connection);
+    }
+}
+
+/**
+ * @brief Closes a half closed connection once every request it sent is answered and written.
+ * @return true if the connection was closed.
+ */
+bool Shard::closeIfAnswered(uint64_t id, const Connection& connection) {
+    if (!connection.readClosed || connection.stalled || connection.unanswered > 0 ||
+        connection.sent < connection.output.size()) {
+        return false;
+    }
+    close(id);
+    return true;
+}
+
+void Shard::close(uint64_t id) {
+    auto found = _connections.find(id);
+    if (found == _connections.end()) {
+        return;
+    }
+    ::close(found->second.fd); // Also removes the socket from the epoll set
+    _connections.erase(found);
+    _connectionCount.store(_connections.size(), std::memory_order_relaxed);
+}
+
+}
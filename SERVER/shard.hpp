@@ -0,0 +1,271 @@
+// idocohen963@gmail.com
+#ifndef SHARD_HPP
+#define SHARD_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "protocol.hpp"
+#include "table.hpp"
+#include "timerwheel.hpp"
+
+/**
+ * @file shard.hpp
+ * @brief One event loop of the game server and the tables it owns.
+ */
+
+namespace coup {
+
+class GameServer;
+
+/**
+ * @class LatencyHistogram
+ * @brief Lock-free histogram of durations, four buckets per power of two of nanoseconds.
+ * Written by one thread, read by any.
+ */
+class LatencyHistogram {
+public:
+    static const int BUCKETS = 4 * 40;  ///< Up to 2^40 ns, about 18 minutes
+
+    LatencyHistogram();
+
+    /**
+     * @brief Counts a duration.
+     * @param nanoseconds The duration.
+     */
+    void record(uint64_t nanoseconds);
+
+    /**
+     * @brief Returns a percentile of the durations counted so far.
+     * @param fraction The percentile, between 0 and 1.
+     * @return Upper bound of the bucket holding the percentile, in microseconds (0 if empty).
+     */
+    double percentile(double fraction) const;
+
+private:
+    std::atomic<uint64_t> _buckets[BUCKETS];
+};
+
+/**
+ * @struct ShardMetrics
+ * @brief Counters of one shard, read while the server runs.
+ */
+struct ShardMetrics {
+    unsigned shard = 0;
+    uint64_t requests = 0;       ///< Requests applied to the tables of the shard
+    uint64_t forwarded = 0;      ///< Requests read by the shard for tables of other shards
+    size_t tables = 0;           ///< Tables owned right now
+    size_t connections = 0;      ///< Connections served right now
+    uint64_t migratedIn = 0;     ///< Tables taken over from other shards
+    uint64_t migratedOut = 0;    ///< Tables handed over to other shards
+    size_t queueDepth = 0;       ///< Messages found in the inbox at the last look
+    size_t maxQueueDepth = 0;    ///< Most messages ever found in the inbox
+    double p50Us = 0;            ///< Median time from reading a request to applying it
+    double p99Us = 0;            ///< 99th percentile of that time
+};
+
+/**
+ * @brief Prints the metrics of the shards as a table, one line per shard.
+ * @param metrics The metrics.
+ * @param out The stream to write to.
+ */
+void printShardMetrics(const std::vector<ShardMetrics>& metrics, std::ostream& out);
+
+/**
+ * @struct HostedTable
+ * @brief A table with its subscribers: everything that moves when the table migrates.
+ */
+struct HostedTable {
+    std::unique_ptr<ServerTable> table;
+    std::vector<uint64_t> subscribers;  ///< Connection ids, which tell their shard
+    TableState published;               ///< The state the subscribers have
+    bool dirty = false;                 ///< Whether the table changed since it was published
+    TimerWheel::Handle timer = 0;       ///< Timer of the deadline in the wheel of the owner
+    std::chrono::steady_clock::time_point deadline;  ///< When the awaited player runs out of time, if timed
+    uint64_t recent = 0;                ///< Requests in the current balancing period
+};
+
+/**
+ * @struct ShardMessage
+ * @brief What shards send each other through their inboxes.
+ */
+struct ShardMessage {
+    enum Kind {
+        Route,    ///< A request for a table of the receiving shard
+        Output,   ///< Bytes to send to a connection of the receiving shard
+        Adopt,    ///< A table migrating to the receiving shard
+        Accept    ///< A new connection for the receiving shard
+    };
+    Kind kind = Route;
+    uint64_t connection = 0;                ///< Route: the connection that sent it; Output: the receiver
+    Request request;                        ///< Route
+    std::chrono::steady_clock::time_point read;  ///< Route: when the request was read
+    std::string bytes;                      ///< Output
+    bool reply = false;                     ///< Output: whether the bytes are the reply to a request
+    uint32_t tableId = 0;                   ///< Adopt
+    std::unique_ptr<HostedTable> table;     ///< Adopt
+    int fd = -1;                            ///< Accept
+};
+
+/**
+ * @class Shard
+ * @brief An event loop that owns a set of tables and connections, run by one thread.
+ *
+ * A table is only ever touched by the shard owning it, so tables need no locks. A request read
+ * from a connection is applied on the spot when the shard owns its table, and is otherwise routed
+ * to the owner's inbox; the reply and the state pushes travel back the same way to the shards of
+ * the connections. Messages for another shard are gathered during a loop iteration and handed
+ * over in one batch per shard, with one wake-up.
+ *
+ * The changes of the tables are published once per loop iteration: a table changed by several
+ * requests meanwhile sends its subscribers one Delta (or one State, see GameServer::setStateDeltas())
+ * covering them all, and the replies of the iteration are held until then, so they follow the
+ * states they led to.
+ *
+ * The deadlines of the tables (see GameServer::setTurnLimits()) are timers of a TimerWheel
+ * turned once per loop iteration, before the tables are published; a table is timed again
+ * whenever it is published, and takes its deadline along when it migrates.
+ *
+ * Every period the shard compares its load (requests applied) with the other shards, and hands
+ * tables to the least loaded one when it is well above the average (see route() for how a
+ * migration keeps the requests of a table in order).
+ */
+class Shard {
+public:
+    /**
+     * @brief Constructor.
+     * @param server The server the shard belongs to.
+     * @param index Index of the shard.
+     * @throws std::runtime_error if the event loop cannot be created.
+     */
+    Shard(GameServer& server, unsigned index);
+
+    /**
+     * @brief Destructor. Closes the connections of the shard.
+     */
+    ~Shard();
+
+    Shard(const Shard&) = delete;
+    Shard& operator=(const Shard&) = delete;
+
+    /**
+     * @brief Serves until the server stops.
+     * @throws std::runtime_error if the event loop fails.
+     */
+    void run();
+
+    /**
+     * @brief Interrupts the wait of the event loop. Safe from any thread and from a signal handler.
+     */
+    void wake();
+
+    /**
+     * @brief Hands messages to the shard. Safe from any thread.
+     * @param messages The messages, moved out (the vector is left empty).
+     */
+    void post(std::vector<ShardMessage>& messages);
+
+    /**
+     * @brief Watches a listening socket. Before run() only.
+     * @param fd The socket, non-blocking.
+     * @throws std::runtime_error if the socket cannot be watched.
+     */
+    void addListener(int fd);
+
+    /**
+     * @brief Returns the requests applied in the last balancing period.
+     * @return The load of the shard.
+     */
+    uint64_t load() const { return _load.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Returns the counters of the shard. Safe from any thread.
+     * @return The metrics.
+     */
+    ShardMetrics metrics() const;
+
+private:
+    /**
+     * @brief A client connection and its buffers.
+     */
+    struct Connection {
+        int fd;
+        std::string input;     ///< Received bytes not handled yet
+        std::string output;    ///< Bytes to send
+        size_t sent = 0;       ///< Bytes of output already sent
+        bool waiting = false;  ///< Whether EPOLLOUT is requested
+        bool queued = false;   ///< Whether the connection is in _flush
+        bool stalled = false;  ///< Whether the connection is in _stalled
+        bool readClosed = false;  ///< Whether the client stopped sending; closed once all is answered
+        uint64_t unanswered = 0;  ///< Requests handed on whose reply did not reach the output yet
+    };
+
+    GameServer& _server;
+    unsigned _index;
+    int _epoll;
+    int _wake;
+    std::unordered_map<uint64_t, Connection> _connections;  ///< By id, ids are never reused
+    uint64_t _nextConnection;
+    std::unordered_map<uint32_t, std::unique_ptr<HostedTable>> _tables;
+    std::vector<uint64_t> _flush;                   ///< Connections with output to write
+    std::vector<uint64_t> _stalled;                 ///< Connections waiting for a migrating table
+    std::vector<std::vector<ShardMessage>> _outbox;  ///< Messages for every shard
+    std::vector<std::atomic<uint64_t>*> _release;   ///< Routes of the requests applied, see deliver()
+    std::vector<uint32_t> _dirty;                   ///< Tables changed in this iteration
+    std::vector<std::pair<uint64_t, std::string>> _replies;  ///< Held until the tables are published
+    unsigned _nextShard;                            ///< Shard of the next accepted connection
+    TableState _state;                              ///< Reused buffer of the state pushes
+    TimerWheel _timers;                             ///< Deadlines of the tables, payload the table id
+    std::chrono::steady_clock::time_point _clockStart;  ///< Tick 0 of _timers
+    std::vector<uint64_t> _expired;                 ///< Reused buffer of the expired timers
+    std::string _frame;                             ///< Reused buffer of the encoded frames
+
+    std::mutex _inboxMutex;
+    std::vector<ShardMessage> _inbox;               ///< Guarded by _inboxMutex
+    std::vector<ShardMessage> _received;            ///< The inbox being handled
+
+    std::chrono::steady_clock::time_point _periodStart;
+    uint64_t _periodRequests;
+    std::atomic<uint64_t> _load;
+
+    // Metrics, written by the shard thread only
+    std::atomic<uint64_t> _requests;
+    std::atomic<uint64_t> _forwarded;
+    std::atomic<size_t> _tableCount;
+    std::atomic<size_t> _connectionCount;
+    std::atomic<uint64_t> _migratedIn;
+    std::atomic<uint64_t> _migratedOut;
+    std::atomic<size_t> _queueDepth;
+    std::atomic<size_t> _maxQueueDepth;
+    LatencyHistogram _latency;
+
+    void accept(int listener);
+    void adoptConnection(int fd);
+    void receive(uint64_t id);
+    bool parse(uint64_t id, Connection& connection);
+    bool route(uint64_t origin, const Request& request);
+    void apply(uint64_t origin, const Request& request, std::chrono::steady_clock::time_point read);
+    void handleInbox();
+    void push(HostedTable& hosted);
+    void publish();
+    void arm(uint32_t id, HostedTable& hosted);
+    void expireTimers();
+    uint64_t tick(std::chrono::steady_clock::time_point time) const;
+    void send(uint64_t connection, const std::string& bytes, bool reply = false);
+    void output(uint64_t id, Connection& connection, const std::string& bytes, bool reply);
+    void balance();
+    void deliver();
+    void flush(uint64_t id);
+    void close(uint64_t id);
+    bool closeIfAnswered(uint64_t id, const Connection& connection);
+};
+
+}
+#endif
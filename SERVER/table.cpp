@@ -0,0 +1,85 @@
+// idocohen963@gmail.com
+#include "table.hpp"
+#include <stdexcept>
+
+namespace coup {
+
+ServerTable::ServerTable(uint32_t id) : _id(id), _game(Game::create()), _flow(*_game), _started(false), _version(1) {
+    _game->setVerbose(false);
+}
+
+ServerPhase ServerTable::phase() const {
+    if (!_started) {
+        return ServerPhase::Seating;
+    }
+    switch (_flow.awaiting()) {
+        case TurnFlow::Await::Action: return ServerPhase::Turn;
+        case TurnFlow::Await::Cancel: return ServerPhase::CancelWindow;
+        default: return ServerPhase::GameOver;
+    }
+}
+
+void ServerTable::addPlayer(const std::string& name, Role role) {
+    if (_started) {
+        throw std::runtime_error("The game already started");
+    }
+    Game::Binding binding(*_game);
+    _game->addPlayer(name, roleName(role));
+    ++_version;
+}
+
+void ServerTable::start() {
+    if (_started) {
+        throw std::runtime_error("The game already started");
+    }
+    Game::Binding binding(*_game);
+    _game->startGame();
+    _started = true;
+    _flow.start();
+    ++_version;
+}
+
+void ServerTable::act(int seat, ActionType action, int target) {
+    if (_flow.awaiting() != TurnFlow::Await::Action) {
+        throw std::runtime_error("The table is not waiting for an action");
+    }
+    if (seat != _game->getCurrentPlayerIndex()) {
+        throw std::runtime_error("Not your turn");
+    }
+    _flow.act(Move{action, target});
+    ++_version;
+}
+
+void ServerTable::answer(int seat, bool cancel) {
+    if (_flow.awaiting() != TurnFlow::Await::Cancel || seat != _flow.asked()) {
+        throw std::runtime_error("You were not asked to cancel");
+    }
+    ++_version; // A refused cancel moves the window on too
+    _flow.answer(cancel);
+}
+
+void ServerTable::expire(TurnFlow::Timeout policy) {
+    if (_started && _flow.awaiting() != TurnFlow::Await::Nothing) {
+        _flow.expire(policy);
+        ++_version;
+    }
+}
+
+void ServerTable::capture(TableState& state) const {
+    const std::vector<Player*>& players = _game->getPlayers();
+    state.table = _id;
+    state.version = _version;
+    state.phase = phase();
+    state.current = players.empty() ? 0 : _game->getCurrentPlayerIndex();
+    state.asked = _flow.asked();
+    state.winner = _flow.winner();
+    state.playerCount = static_cast<int>(players.size());
+    for (size_t i = 0; i < players.size(); ++i) {
+        state.roles[i] = players[i]->getRole();
+        state.coins[i] = players[i]->getCoins();
+        state.active[i] = players[i]->isActive();
+        state.sanctioned[i] = players[i]->isSanctioned();
+    }
+}
+
+}
@@ -0,0 +1,114 @@
+// idocohen963@gmail.com
+#ifndef TABLE_HPP
+#define TABLE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "protocol.hpp"
+#include "SIM/turnflow.hpp"
+
+/**
+ * @file table.hpp
+ * @brief One game hosted by the server.
+ */
+
+namespace coup {
+
+/**
+ * @class ServerTable
+ * @brief A game played by remote clients, one request at a time.
+ *
+ * Every table owns its own Game (see Game::create()), so thousands of tables live side by side
+ * on the server thread; each call binds the table's game for the player actions (see Game::Binding).
+ * Once started, the game is played through a TurnFlow, suspended between requests: after an
+ * action, the players able to cancel it are asked in seat order, and the first one who cancels
+ * ends the window. A player without legal moves passes automatically.
+ */
+class ServerTable {
+public:
+    /**
+     * @brief Constructor. The table starts seating players.
+     * @param id Identifier of the table, reported in its state.
+     */
+    explicit ServerTable(uint32_t id);
+
+    /**
+     * @brief Returns the identifier of the table.
+     * @return The table id.
+     */
+    uint32_t id() const { return _id; }
+
+    /**
+     * @brief Returns what the table waits for.
+     * @return The phase.
+     */
+    ServerPhase phase() const;
+
+    /**
+     * @brief Returns the version of the table, increased by every change.
+     * @return The version.
+     */
+    uint32_t version() const { return _version; }
+
+    /**
+     * @brief Seats a player.
+     * @param name Name of the player.
+     * @param role Role of the player.
+     * @throws std::runtime_error if the game started or the rules refuse the player.
+     */
+    void addPlayer(const std::string& name, Role role);
+
+    /**
+     * @brief Starts the game.
+     * @throws std::runtime_error if the game started or has fewer than two players.
+     */
+    void start();
+
+    /**
+     * @brief Performs an action of the current player.
+     * @param seat Seat of the player sending the action.
+     * @param action The action.
+     * @param target Seat of the target, or -1.
+     * @throws std::runtime_error if it is not the turn of the seat or the rules refuse the action.
+     */
+    void act(int seat, ActionType action, int target);
+
+    /**
+     * @brief Answers the cancel question of the cancel window.
+     * @param seat Seat of the player sending the answer.
+     * @param cancel Whether the player cancels the action.
+     * @throws std::runtime_error if the seat was not asked. A cancel refused by the rules throws
+     * too, after the window moved on to the next player as if the seat had answered no.
+     */
+    void answer(int seat, bool cancel);
+
+    /**
+     * @brief Takes the default decision of the player the table waits for (see TurnFlow::expire()).
+     * Does nothing while seating or once the game is over.
+     * @param policy What the current player does when their turn expires.
+     */
+    void expire(TurnFlow::Timeout policy = TurnFlow::Timeout::Pass);
+
+    /**
+     * @brief Fills a state message with the table.
+     * @param state Receives the state.
+     */
+    void capture(TableState& state) const;
+
+    /**
+     * @brief Returns the state of the game of the table.
+     * @return The snapshot.
+     */
+    GameSnapshot snapshot() const { return _game->snapshot(); }
+
+private:
+    uint32_t _id;
+    std::unique_ptr<Game> _game;
+    TurnFlow _flow;
+    bool _started;
+    uint32_t _version;
+};
+
+}
+#endif
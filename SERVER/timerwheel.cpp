@@ -0,0 +1,137 @@
+// idocohen963@gmail.com
+#include "timerwheel.hpp"
+
+namespace coup {
+
+TimerWheel::TimerWheel(uint64_t now) : _now(now), _size(0), _free(NONE) {
+    for (uint32_t& head : _slots) {
+        head = NONE;
+    }
+}
+
+TimerWheel::Handle TimerWheel::schedule(uint64_t delay, uint64_t payload) {
+    uint32_t index = _free;
+    if (index != NONE) {
+        _free = _nodes[index].next;
+    } else {
+        index = static_cast<uint32_t>(_nodes.size());
+        _nodes.push_back(Node{0, 0, NONE, NONE, 0, 0, false});
+    }
+    Node& node = _nodes[index];
+    node.expiry = _now + (delay > 0 ? delay : 1);
+    node.payload = payload;
+    node.running = true;
+    ++_size;
+    place(index);
+    return (static_cast<uint64_t>(node.generation) << 32) | (index + 1);
+}
+
+bool TimerWheel::cancel(Handle handle) {
+    uint64_t index = (handle & 0xFFFFFFFFu) - 1;
+    if (handle == 0 || index >= _nodes.size()) {
+        return false;
+    }
+    Node& node = _nodes[index];
+    if (!node.running || node.generation != static_cast<uint32_t>(handle >> 32)) {
+        return false;
+    }
+    unlink(static_cast<uint32_t>(index));
+    release(static_cast<uint32_t>(index));
+    return true;
+}
+
+/**
+ * @brief Turns tick by tick while timers run: the slots of the higher levels whose turn comes
+ * are cascaded first, then the level 0 slot of the tick expires whole.
+ */
+void TimerWheel::advance(uint64_t now, std::vector<uint64_t>& expired) {
+    while (_now < now) {
+        if (_size == 0) {
+            _now = now;
+            return;
+        }
+        ++_now;
+        for (int level = 1; level < LEVELS; ++level) {
+            if ((_now & ((uint64_t(1) << (SLOT_BITS * level)) - 1)) != 0) {
+                break;
+            }
+            cascade(level);
+        }
+        uint32_t& head = _slots[_now & (SLOTS - 1)];
+        uint32_t index = head;
+        head = NONE;
+        while (index != NONE) {
+            uint32_t next = _nodes[index].next;
+            expired.push_back(_nodes[index].payload);
+            release(index);
+            index = next;
+        }
+    }
+}
+
+/**
+ * @brief Links a running timer into the lowest level whose span reaches its expiry.
+ */
+void TimerWheel::place(uint32_t index) {
+    uint64_t expiry = _nodes[index].expiry;
+    uint64_t delta = expiry > _now ? expiry - _now : 0;
+    for (int level = 0; level < LEVELS; ++level) {
+        if (delta < (uint64_t(1) << (SLOT_BITS * (level + 1)))) {
+            link(index, level * SLOTS + ((expiry >> (SLOT_BITS * level)) & (SLOTS - 1)));
+            return;
+        }
+    }
+    // Beyond the span: the slot of the highest level that comes back last, placed again then
+    int top = LEVELS - 1;
+    link(index, top * SLOTS + ((_now >> (SLOT_BITS * top)) & (SLOTS - 1)));
+}
+
+void TimerWheel::link(uint32_t index, uint32_t slot) {
+    Node& node = _nodes[index];
+    node.slot = static_cast<uint16_t>(slot);
+    node.prev = NONE;
+    node.next = _slots[slot];
+    if (node.next != NONE) {
+        _nodes[node.next].prev = index;
+    }
+    _slots[slot] = index;
+}
+
+void TimerWheel::unlink(uint32_t index) {
+    Node& node = _nodes[index];
+    if (node.prev != NONE) {
+        _nodes[node.prev].next = node.next;
+    } else {
+        _slots[node.slot] = node.next;
+    }
+    if (node.next != NONE) {
+        _nodes[node.next].prev = node.prev;
+    }
+}
+
+void TimerWheel::release(uint32_t index) {
+    Node& node = _nodes[index];
+    node.running = false;
+    ++node.generation;
+    node.next = _free;
+    _free = index;
+    --_size;
+}
+
+/**
+ * @brief Places again the timers of the slot of a level the wheel turned to, one level lower
+ * (or in the same slot, for timers beyond the span). The list is detached first, so a timer
+ * placed back in it waits for the next turn.
+ */
+void TimerWheel::cascade(int level) {
+    uint32_t& head = _slots[level * SLOTS + ((_now >> (SLOT_BITS * level)) & (SLOTS - 1))];
+    uint32_t index = head;
+    head = NONE;
+    while (index != NONE) {
+        uint32_t next = _nodes[index].next;
+        place(index);
+        index = next;
+    }
+}
+
+}
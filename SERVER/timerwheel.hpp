@@ -0,0 +1,109 @@
+// idocohen963@gmail.com
+#ifndef TIMERWHEEL_HPP
+#define TIMERWHEEL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @file timerwheel.hpp
+ * @brief Hierarchical timing wheel for the deadlines of many tables.
+ */
+
+namespace coup {
+
+/**
+ * @class TimerWheel
+ * @brief Schedules, cancels and expires timers in constant time, whatever their number.
+ *
+ * Time is counted in ticks. The wheel has LEVELS levels of SLOTS slots: a level 0 slot holds the
+ * timers of one tick, a slot of level L the timers of SLOTS^L ticks. A timer goes to the lowest
+ * level whose span reaches its expiry, and moves down one level (is cascaded) when the wheel
+ * turns to its slot, so every timer is touched at most LEVELS times in its life and a tick only
+ * looks at one slot per level. Timers are linked into their slot through a pool of nodes, so
+ * a cancel unlinks its node in place; a handle carries a generation, and handles of timers that
+ * expired or were cancelled are recognised and ignored.
+ *
+ * Timers further than the span of the wheel (SLOTS^LEVELS ticks) wait in the farthest slot and
+ * are placed again each time the wheel comes back to it. Not thread safe: one wheel per thread.
+ */
+class TimerWheel {
+public:
+    using Handle = uint64_t;            ///< Names a timer; 0 names none
+    static const int SLOT_BITS = 6;
+    static const uint32_t SLOTS = 1u << SLOT_BITS;
+    static const int LEVELS = 4;        ///< 2^24 ticks, 4.6 hours of 1 ms ticks
+
+    /**
+     * @brief Constructor.
+     * @param now The current tick.
+     */
+    explicit TimerWheel(uint64_t now = 0);
+
+    /**
+     * @brief Starts a timer.
+     * @param delay Ticks from now to the expiry; 0 expires at the next tick.
+     * @param payload Value handed back when the timer expires.
+     * @return The handle of the timer.
+     */
+    Handle schedule(uint64_t delay, uint64_t payload);
+
+    /**
+     * @brief Stops a timer.
+     * @param handle The handle of the timer; 0 and handles of finished timers are ignored.
+     * @return Whether a running timer was stopped.
+     */
+    bool cancel(Handle handle);
+
+    /**
+     * @brief Turns the wheel up to a tick, collecting the payloads of the timers that expire.
+     * An empty wheel jumps to the tick at once.
+     * @param now The tick to reach; ticks in the past are ignored.
+     * @param expired Receives the payloads, in order of expiry.
+     */
+    void advance(uint64_t now, std::vector<uint64_t>& expired);
+
+    /**
+     * @brief Returns the current tick.
+     * @return The tick the wheel reached.
+     */
+    uint64_t now() const { return _now; }
+
+    /**
+     * @brief Returns the number of running timers.
+     * @return The number of timers.
+     */
+    size_t size() const { return _size; }
+
+private:
+    static const uint32_t NONE = 0xFFFFFFFFu;
+
+    /**
+     * @brief A timer, linked into the list of its slot, or into the free list.
+     */
+    struct Node {
+        uint64_t expiry;
+        uint64_t payload;
+        uint32_t prev;
+        uint32_t next;
+        uint32_t generation;   ///< Bumped when the node is freed, so old handles miss
+        uint16_t slot;         ///< Index in _slots while running
+        bool running;
+    };
+
+    uint64_t _now;
+    size_t _size;
+    std::vector<Node> _nodes;
+    uint32_t _free;                      ///< Head of the free list
+    uint32_t _slots[LEVELS * SLOTS];     ///< Head of the list of every slot, level by level
+
+    void place(uint32_t index);
+    void link(uint32_t index, uint32_t slot);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+    void cascade(int level);
+};
+
+}
+#endif
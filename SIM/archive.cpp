@@ -0,0 +1,407 @@
+// idocohen963@gmail.com
+#include "archive.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "encoding.hpp"
+#include "GAME/game.hpp"
+
+/**
+ * @file archive.cpp
+ * @brief Implementation of the replay archive writer, reader and replayer.
+ */
+
+namespace coup {
+
+namespace {
+
+const char ARCHIVE_MAGIC[4] = {'C', 'P', 'R', '1'};
+const char FOOTER_MAGIC[4] = {'C', 'P', 'R', 'I'};
+const size_t FOOTER_SIZE = 12;
+const uint8_t NONE = 255;
+const uint8_t CANCELLED = 0x80;
+
+}
+
+// === ReplayArchiveWriter ===
+
+/**
+ * @brief Constructor. Writes the magic.
+ */
+ReplayArchiveWriter::ReplayArchiveWriter(std::ostream& out, size_t gamesPerBlock)
+    : _out(out), _gamesPerBlock(gamesPerBlock == 0 ? 1 : gamesPerBlock), _offset(0), _finished(false),
+      _current{0, {}, -1, {}}, _previousId(0), _open{0, 0, 0, UINT64_MAX, 0} {
+    write(std::string(ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)));
+}
+
+/**
+ * @brief Destructor. Errors cannot be reported from here, call finish() to see them.
+ */
+ReplayArchiveWriter::~ReplayArchiveWriter() {
+    try {
+        finish();
+    } catch (...) {
+    }
+}
+
+/**
+ * @brief Starts recording a game.
+ */
+void ReplayArchiveWriter::onGameStart(uint64_t gameId, const Lineup& lineup) {
+    _current.gameId = gameId;
+    _current.lineup = lineup;
+    _current.moves.clear();
+}
+
+/**
+ * @brief Records a move and its canceller.
+ */
+void ReplayArchiveWriter::onAction(const ActionEvent& event) {
+    _current.moves.push_back(ReplayMove{event.action, event.target, event.canceller});
+}
+
+/**
+ * @brief Adds the recorded game to the open block.
+ */
+void ReplayArchiveWriter::onGameEnd(const Lineup& lineup, const GameResult& result) {
+    (void)lineup; // Already stored by onGameStart
+    _current.winner = result.winner;
+    add(_current);
+}
+
+/**
+ * @brief Encodes a game at the end of the open block, and writes the block once it is full.
+ */
+void ReplayArchiveWriter::add(const ReplayRecord& record) {
+    if (_finished) {
+        throw std::runtime_error("Archive is already finished");
+    }
+    if (record.lineup.size() < 2 || record.lineup.size() > MAX_PLAYERS) {
+        throw std::runtime_error("Illegal number of players in replay");
+    }
+    size_t start = _games.size();
+    putVarint(_games, zigzag(static_cast<int64_t>(record.gameId - _previousId)));
+    _games.push_back(static_cast<char>(record.lineup.size()));
+    for (Role role : record.lineup) {
+        _games.push_back(static_cast<char>(role));
+    }
+    _games.push_back(static_cast<char>(record.winner < 0 ? NONE : record.winner));
+    putVarint(_games, record.moves.size());
+    for (const ReplayMove& move : record.moves) {
+        uint8_t packed = static_cast<uint8_t>(static_cast<int>(move.action) | ((move.target + 1) << 4));
+        if (move.canceller >= 0) {
+            _games.push_back(static_cast<char>(packed | CANCELLED));
+            _games.push_back(static_cast<char>(move.canceller));
+        } else {
+            _games.push_back(static_cast<char>(packed));
+        }
+    }
+    _gameSizes.push_back(static_cast<uint32_t>(_games.size() - start));
+    _previousId = record.gameId;
+    _open.minId = std::min(_open.minId, record.gameId);
+    _open.maxId = std::max(_open.maxId, record.gameId);
+    if (_gameSizes.size() >= _gamesPerBlock) {
+        writeBlock();
+    }
+}
+
+/**
+ * @brief Writes the open block: its game count, the game sizes and the games.
+ */
+void ReplayArchiveWriter::writeBlock() {
+    _buffer.clear();
+    putVarint(_buffer, _gameSizes.size());
+    for (uint32_t size : _gameSizes) {
+        putVarint(_buffer, size);
+    }
+    _buffer += _games;
+    _open.offset = _offset;
+    _open.size = _buffer.size();
+    _open.games = _gameSizes.size();
+    _index.push_back(_open);
+    write(_buffer);
+
+    _games.clear();
+    _gameSizes.clear();
+    _previousId = 0;
+    _open = BlockEntry{0, 0, 0, UINT64_MAX, 0};
+}
+
+/**
+ * @brief Writes the last block, the index and the footer.
+ */
+void ReplayArchiveWriter::finish() {
+    if (_finished) {
+        return;
+    }
+    _finished = true;
+    if (!_gameSizes.empty()) {
+        writeBlock();
+    }
+    uint64_t indexOffset = _offset;
+    _buffer.clear();
+    putVarint(_buffer, _index.size());
+    uint64_t previous = 0;
+    for (const BlockEntry& entry : _index) {
+        putVarint(_buffer, entry.offset - previous);
+        putVarint(_buffer, entry.size);
+        putVarint(_buffer, entry.games);
+        putVarint(_buffer, entry.minId);
+        putVarint(_buffer, entry.maxId - entry.minId);
+        previous = entry.offset;
+    }
+    for (int i = 0; i < 8; ++i) {
+        _buffer.push_back(static_cast<char>((indexOffset >> (8 * i)) & 0xFF));
+    }
+    _buffer.append(FOOTER_MAGIC, sizeof(FOOTER_MAGIC));
+    write(_buffer);
+    _out.flush();
+    if (!_out) {
+        throw std::runtime_error("Failed to write replay archive");
+    }
+}
+
+/**
+ * @brief Writes bytes to the stream and advances the offset.
+ */
+void ReplayArchiveWriter::write(const std::string& bytes) {
+    _out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    _offset += bytes.size();
+}
+
+// === ReplayArchiveReader ===
+
+/**
+ * @brief Constructor. Checks both magics and loads the block index.
+ */
+ReplayArchiveReader::ReplayArchiveReader(std::istream& in) : _in(in), _games(0), _loaded(SIZE_MAX) {
+    _in.seekg(0, std::ios::end);
+    std::streamoff fileSize = _in.tellg();
+    if (!_in || fileSize < static_cast<std::streamoff>(sizeof(ARCHIVE_MAGIC) + FOOTER_SIZE)) {
+        throw std::runtime_error("Not a replay archive");
+    }
+    char magic[sizeof(ARCHIVE_MAGIC)];
+    char footer[FOOTER_SIZE];
+    _in.seekg(0);
+    _in.read(magic, sizeof(magic));
+    _in.seekg(fileSize - static_cast<std::streamoff>(FOOTER_SIZE));
+    _in.read(footer, sizeof(footer));
+    if (!_in || std::memcmp(magic, ARCHIVE_MAGIC, sizeof(magic)) != 0 ||
+        std::memcmp(footer + 8, FOOTER_MAGIC, sizeof(FOOTER_MAGIC)) != 0) {
+        throw std::runtime_error("Not a replay archive");
+    }
+    uint64_t indexOffset = 0;
+    for (int i = 0; i < 8; ++i) {
+        indexOffset |= static_cast<uint64_t>(static_cast<uint8_t>(footer[i])) << (8 * i);
+    }
+    uint64_t indexEnd = static_cast<uint64_t>(fileSize) - FOOTER_SIZE;
+    if (indexOffset < sizeof(ARCHIVE_MAGIC) || indexOffset > indexEnd) {
+        throw std::runtime_error("Corrupted replay archive index");
+    }
+
+    std::string index(indexEnd - indexOffset, '\0');
+    _in.seekg(static_cast<std::streamoff>(indexOffset));
+    _in.read(&index[0], static_cast<std::streamsize>(index.size()));
+    if (!_in) {
+        throw std::runtime_error("Corrupted replay archive index");
+    }
+    const char* cursor = index.data();
+    const char* end = index.data() + index.size();
+    uint64_t count = getVarint(cursor, end);
+    uint64_t offset = 0;
+    for (uint64_t b = 0; b < count; ++b) {
+        BlockEntry entry;
+        offset += getVarint(cursor, end);
+        entry.offset = offset;
+        entry.size = getVarint(cursor, end);
+        entry.games = getVarint(cursor, end);
+        entry.minId = getVarint(cursor, end);
+        entry.maxId = entry.minId + getVarint(cursor, end);
+        entry.firstPosition = _games;
+        if (entry.offset < sizeof(ARCHIVE_MAGIC) || entry.offset > indexOffset ||
+            entry.size > indexOffset - entry.offset || entry.games == 0) {
+            throw std::runtime_error("Corrupted replay archive index");
+        }
+        _games += entry.games;
+        _index.push_back(entry);
+    }
+}
+
+/**
+ * @brief Finds the block holding the position and decodes the game.
+ */
+void ReplayArchiveReader::read(uint64_t position, ReplayRecord& record) {
+    if (position >= _games) {
+        throw std::out_of_range("Replay position out of range");
+    }
+    auto after = std::upper_bound(_index.begin(), _index.end(), position,
+                                  [](uint64_t p, const BlockEntry& entry) { return p < entry.firstPosition; });
+    size_t block = static_cast<size_t>(after - _index.begin()) - 1;
+    load(block);
+    decode(static_cast<size_t>(position - _index[block].firstPosition), record);
+}
+
+/**
+ * @brief Scans the blocks whose id range contains the id.
+ */
+bool ReplayArchiveReader::find(uint64_t gameId, ReplayRecord& record) {
+    for (size_t b = 0; b < _index.size(); ++b) {
+        if (gameId < _index[b].minId || gameId > _index[b].maxId) {
+            continue;
+        }
+        load(b);
+        for (size_t slot = 0; slot < _gameIds.size(); ++slot) {
+            if (_gameIds[slot] == gameId) {
+                decode(slot, record);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Reads a block and locates its games, unless it is already loaded.
+ */
+void ReplayArchiveReader::load(size_t block) {
+    if (_loaded == block) {
+        return;
+    }
+    _loaded = SIZE_MAX; // Stays invalid if the block turns out to be corrupted
+    const BlockEntry& entry = _index[block];
+    _block.resize(entry.size);
+    _in.clear();
+    _in.seekg(static_cast<std::streamoff>(entry.offset));
+    _in.read(&_block[0], static_cast<std::streamsize>(entry.size));
+    if (!_in) {
+        throw std::runtime_error("Failed to read replay block");
+    }
+
+    const char* cursor = _block.data();
+    const char* end = _block.data() + _block.size();
+    if (getVarint(cursor, end) != entry.games) {
+        throw std::runtime_error("Corrupted replay block");
+    }
+    _gameOffsets.resize(entry.games + 1);
+    uint64_t offset = 0;
+    for (uint64_t g = 0; g < entry.games; ++g) {
+        _gameOffsets[g] = static_cast<uint32_t>(offset);
+        offset += getVarint(cursor, end);
+    }
+    uint64_t base = static_cast<uint64_t>(cursor - _block.data());
+    if (offset > _block.size() - base) {
+        throw std::runtime_error("Corrupted replay block");
+    }
+    _gameOffsets[entry.games] = static_cast<uint32_t>(offset);
+    _gameIds.resize(entry.games);
+    uint64_t id = 0;
+    for (uint64_t g = 0; g < entry.games; ++g) {
+        _gameOffsets[g] += static_cast<uint32_t>(base);
+        const char* game = _block.data() + _gameOffsets[g];
+        id += static_cast<uint64_t>(unzigzag(getVarint(game, end)));
+        _gameIds[g] = id;
+    }
+    _gameOffsets[entry.games] += static_cast<uint32_t>(base);
+    _loaded = block;
+}
+
+/**
+ * @brief Decodes one game of the loaded block.
+ */
+void ReplayArchiveReader::decode(size_t slot, ReplayRecord& record) const {
+    const char* cursor = _block.data() + _gameOffsets[slot];
+    const char* end = _block.data() + _gameOffsets[slot + 1];
+    getVarint(cursor, end); // Id delta, already resolved by load()
+    record.gameId = _gameIds[slot];
+
+    int players = getByte(cursor, end);
+    if (players < 2 || players > MAX_PLAYERS) {
+        throw std::runtime_error("Corrupted replay: illegal number of players");
+    }
+    record.lineup.clear();
+    for (int p = 0; p < players; ++p) {
+        uint8_t role = getByte(cursor, end);
+        if (role >= ROLE_COUNT) {
+            throw std::runtime_error("Corrupted replay: unknown role");
+        }
+        record.lineup.push_back(static_cast<Role>(role));
+    }
+    uint8_t winner = getByte(cursor, end);
+    record.winner = (winner == NONE) ? -1 : winner;
+
+    uint64_t count = getVarint(cursor, end);
+    if (count > static_cast<uint64_t>(end - cursor)) {
+        throw std::runtime_error("Corrupted replay: truncated moves");
+    }
+    record.moves.resize(count);
+    for (ReplayMove& move : record.moves) {
+        uint8_t packed = getByte(cursor, end);
+        int action = packed & 0x0F;
+        move.action = static_cast<ActionType>(action);
+        move.target = ((packed >> 4) & 0x07) - 1;
+        move.canceller = (packed & CANCELLED) ? getByte(cursor, end) : -1;
+        if (action >= ACTION_COUNT || move.target >= players || move.canceller >= players) {
+            throw std::runtime_error("Corrupted replay: illegal move");
+        }
+    }
+}
+
+// === Replay ===
+
+/**
+ * @brief Applies a recorded move, passing turns like Simulator::step() does.
+ */
+int replayMove(Game& game, const ReplayMove& recorded, std::vector<Move>& legal, int* actor) {
+    int steps = 0;
+    int passes = 0;
+    while (true) {
+        steps++;
+        if (!game.getCurrentPlayer()->isActive()) {
+            game.nextTurn();
+        }
+        Simulator::legalMoves(game, legal);
+        if (!legal.empty()) {
+            break;
+        }
+        if (++passes > 2 * MAX_PLAYERS) {
+            throw std::runtime_error("Replay does not match the game rules");
+        }
+        Simulator::passTurn(game);
+    }
+    Move move{recorded.action, recorded.target};
+    int self = game.getCurrentPlayerIndex();
+    if (actor) {
+        *actor = self;
+    }
+    Simulator::applyMove(game, move);
+    if (recorded.canceller >= 0) {
+        Simulator::applyCancel(game, recorded.canceller, self, move);
+    }
+    return steps;
+}
+
+/**
+ * @brief Applies the recorded moves on a fresh table.
+ */
+GameResult replayGame(const ReplayRecord& record, size_t moves) {
+    Game& game = Game::getInstance();
+    Simulator::seatLineup(game, record.lineup);
+    std::vector<Move> legal;
+    legal.reserve(4 + 4 * MAX_PLAYERS);
+    GameResult result{-1, 0};
+    size_t count = std::min(moves, record.moves.size());
+    for (size_t m = 0; m < count; ++m) {
+        result.actions += replayMove(game, record.moves[m], legal);
+    }
+    if (Simulator::countActive(game) == 1) {
+        const std::vector<Player*>& players = game.getPlayers();
+        for (size_t i = 0; i < players.size(); ++i) {
+            if (players[i]->isActive()) {
+                result.winner = static_cast<int>(i);
+            }
+        }
+    }
+    return result;
+}
+
+}
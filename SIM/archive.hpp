@@ -0,0 +1,218 @@
+// idocohen963@gmail.com
+#ifndef ARCHIVE_HPP
+#define ARCHIVE_HPP
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "simulator.hpp"
+
+/**
+ * @file archive.hpp
+ * @brief Compressed replay archive with random access to single games.
+ *
+ * A replay stores the lineup and the decisions of a game (moves and cancels), which is enough to
+ * replay it exactly: passes are not stored since they follow from the position.
+ * Games are grouped in blocks that are encoded independently, and a block index at the end of the
+ * file lets a reader decode any single game by reading one block.
+ *
+ * File layout (integers are LEB128 varints unless noted, "zz" means zigzag encoded):
+ *   header:  "CPR1"
+ *   blocks:  game count, encoded size of every game, then the games
+ *            game: game id (zz delta from the previous game of the block), player count (byte),
+ *                  role per seat (byte), winner seat (byte, 255 = draw), move count, moves
+ *            move: one byte, action in bits 0-3, target seat + 1 in bits 4-6 (0 = none),
+ *                  bit 7 set when the move was cancelled, then followed by the canceller seat (byte)
+ *   index:   block count, then per block: offset delta, size, game count, smallest and largest game id
+ *   footer:  index offset (8 bytes, little endian), "CPRI"
+ */
+
+namespace coup {
+
+/**
+ * @struct ReplayMove
+ * @brief One decision of a replayed game.
+ */
+struct ReplayMove {
+    ActionType action;  ///< The action
+    int target;         ///< Seat of the target, or -1
+    int canceller;      ///< Seat of the player who cancelled the action, or -1
+};
+
+/**
+ * @struct ReplayRecord
+ * @brief Everything needed to replay a game.
+ */
+struct ReplayRecord {
+    uint64_t gameId;                ///< Identifier of the game
+    Lineup lineup;                  ///< Roles of the players, in seat order
+    int winner;                     ///< Seat of the winner, or -1 for a draw
+    std::vector<ReplayMove> moves;  ///< The moves, in the order they were played
+};
+
+/**
+ * @class ReplayArchiveWriter
+ * @brief Observer that writes every game it sees to a replay archive.
+ */
+class ReplayArchiveWriter : public GameObserver {
+public:
+    /**
+     * @brief Constructor. Writes the file header.
+     * @param out The stream to write to (opened in binary mode).
+     * @param gamesPerBlock Number of games per block; smaller blocks make single game reads faster.
+     */
+    explicit ReplayArchiveWriter(std::ostream& out, size_t gamesPerBlock = 128);
+
+    /**
+     * @brief Destructor. Finishes the archive if finish() was not called.
+     */
+    ~ReplayArchiveWriter() override;
+
+    void onGameStart(uint64_t gameId, const Lineup& lineup) override;
+    void onAction(const ActionEvent& event) override;
+    void onGameEnd(const Lineup& lineup, const GameResult& result) override;
+
+    /**
+     * @brief Appends a complete game.
+     * @param record The game.
+     */
+    void add(const ReplayRecord& record);
+
+    /**
+     * @brief Writes the last block, the index and the footer. Further games are rejected.
+     * @throws std::runtime_error if the stream failed.
+     */
+    void finish();
+
+    /**
+     * @brief Returns the number of bytes written so far.
+     * @return Bytes written.
+     */
+    uint64_t bytesWritten() const { return _offset; }
+
+private:
+    /**
+     * @struct BlockEntry
+     * @brief Index entry of a written block.
+     */
+    struct BlockEntry {
+        uint64_t offset;  ///< Offset of the block in the file
+        uint64_t size;    ///< Encoded size
+        uint64_t games;   ///< Number of games
+        uint64_t minId;   ///< Smallest game id
+        uint64_t maxId;   ///< Largest game id
+    };
+
+    std::ostream& _out;                ///< Destination stream
+    size_t _gamesPerBlock;             ///< Games per block
+    uint64_t _offset;                  ///< Bytes written so far
+    bool _finished;                    ///< Whether the index was written
+    ReplayRecord _current;             ///< Game being recorded from the observer events
+    std::string _games;                ///< Encoded games of the open block
+    std::vector<uint32_t> _gameSizes;  ///< Encoded size of every game of the open block
+    uint64_t _previousId;              ///< Id of the last game of the open block
+    BlockEntry _open;                  ///< Index entry of the open block
+    std::vector<BlockEntry> _index;    ///< Entries of the written blocks
+    std::string _buffer;               ///< Reused output buffer
+
+    void writeBlock();
+    void write(const std::string& bytes);
+};
+
+/**
+ * @class ReplayArchiveReader
+ * @brief Random access reader of a replay archive.
+ *
+ * Only the index is loaded when the archive is opened. Reading a game decodes its block header
+ * and the game itself; the last block read is kept, so sequential reads touch every block once.
+ */
+class ReplayArchiveReader {
+public:
+    /**
+     * @brief Constructor. Reads the footer and the block index.
+     * @param in The stream to read from (opened in binary mode, must stay open).
+     * @throws std::runtime_error if the stream is not a valid archive.
+     */
+    explicit ReplayArchiveReader(std::istream& in);
+
+    /**
+     * @brief Returns the number of games in the archive.
+     * @return Number of games.
+     */
+    uint64_t games() const { return _games; }
+
+    /**
+     * @brief Returns the number of blocks in the archive.
+     * @return Number of blocks.
+     */
+    size_t blocks() const { return _index.size(); }
+
+    /**
+     * @brief Reads a game by its position in the archive.
+     * @param position Position of the game, from 0 to games() - 1.
+     * @param record Receives the game.
+     * @throws std::out_of_range if the position is past the end.
+     * @throws std::runtime_error if the archive is corrupted.
+     */
+    void read(uint64_t position, ReplayRecord& record);
+
+    /**
+     * @brief Looks a game up by its id. Only the blocks whose id range contains the id are decoded.
+     * @param gameId Id of the game.
+     * @param record Receives the game.
+     * @return true if the game was found.
+     */
+    bool find(uint64_t gameId, ReplayRecord& record);
+
+private:
+    /**
+     * @struct BlockEntry
+     * @brief Index entry of a block.
+     */
+    struct BlockEntry {
+        uint64_t offset;         ///< Offset of the block in the file
+        uint64_t size;           ///< Encoded size
+        uint64_t games;          ///< Number of games
+        uint64_t minId;          ///< Smallest game id
+        uint64_t maxId;          ///< Largest game id
+        uint64_t firstPosition;  ///< Position of the first game of the block
+    };
+
+    std::istream& _in;                   ///< Source stream
+    std::vector<BlockEntry> _index;      ///< Block index
+    uint64_t _games;                     ///< Number of games
+    size_t _loaded;                      ///< Block held in _block, or SIZE_MAX
+    std::string _block;                  ///< Bytes of the loaded block
+    std::vector<uint32_t> _gameOffsets;  ///< Offset of every game in the loaded block
+    std::vector<uint64_t> _gameIds;      ///< Id of every game in the loaded block
+
+    void load(size_t block);
+    void decode(size_t slot, ReplayRecord& record) const;
+};
+
+/**
+ * @brief Applies one recorded move, after passing the turns of the players who cannot move.
+ * @param game The game, in the position the move was played from.
+ * @param move The move and its cancel.
+ * @param legal Reused buffer of legal moves.
+ * @param actor Receives the seat of the player who made the move, if not null.
+ * @return Number of turn steps taken (the passes and the move).
+ * @throws std::runtime_error if the move is illegal in the position.
+ */
+int replayMove(Game& game, const ReplayMove& move, std::vector<Move>& legal, int* actor = nullptr);
+
+/**
+ * @brief Replays a game on the calling thread's Game.
+ * The table is reset and seated, then the recorded moves and cancels are applied, with passes
+ * inserted wherever the current player has no legal move, exactly as the simulator plays.
+ * @param record The game.
+ * @param moves Number of recorded moves to apply (all by default).
+ * @return The outcome after the applied moves (winner -1 while more than one player is active).
+ * @throws std::runtime_error if a recorded move is illegal in the replayed position.
+ */
+GameResult replayGame(const ReplayRecord& record, size_t moves = SIZE_MAX);
+
+}
+#endif
@@ -0,0 +1,293 @@
+// idocohen963@gmail.com
+#include "belief.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * @file belief.cpp
+ * @brief Implementation of the observation model and of the particle belief over hidden coins.
+ */
+
+namespace coup {
+
+Observation observe(const ActionEvent& event, int viewer, int viewerCoins) {
+    bool peeked = event.action == ActionType::SpyOn && event.actor == viewer;
+    return Observation{event.actor, event.action, event.target, event.canceller,
+                       peeked ? event.targetCoinsAfter : -1, viewerCoins};
+}
+
+BeliefTracker::BeliefTracker(int particles, uint64_t seed)
+    : _count(particles), _viewer(0), _maxHidden(12), _rng(seed), _redraws(0), _scratch(Game::create()),
+      _public(), _work(), _next(), _particles(), _spare() {
+    if (particles < 1 || particles > MAX_PARTICLES) {
+        throw std::invalid_argument("Illegal number of particles");
+    }
+    _moves.reserve(4 + 4 * MAX_PLAYERS);
+}
+
+void BeliefTracker::reset(const GameSnapshot& state, int viewer, int maxHidden) {
+    if (state.playerCount < 2 || state.playerCount > MAX_PLAYERS) {
+        throw std::runtime_error("Illegal number of players to track");
+    }
+    bool seated = static_cast<int>(_lineup.size()) == state.playerCount;
+    for (int i = 0; seated && i < state.playerCount; ++i) {
+        seated = _lineup[i] == state.roles[i];
+    }
+    if (!seated) {
+        Game::Binding binding(*_scratch);
+        _lineup.assign(state.roles, state.roles + state.playerCount);
+        Simulator::seatLineup(*_scratch, _lineup);
+    }
+    _public = state;
+    _viewer = viewer;
+    _maxHidden = maxHidden >= 0 ? maxHidden : 12;
+    _redraws = 0;
+    for (int i = 0; i < _count; ++i) {
+        Particle& particle = _particles[i];
+        for (int s = 0; s < MAX_PLAYERS; ++s) {
+            particle.coins[s] = static_cast<int8_t>(s < state.playerCount ? state.players[s].coins : 0);
+        }
+        if (maxHidden >= 0) {
+            drawPrior(particle, nullptr);
+        }
+        particle.weight = 1.0f / _count;
+    }
+}
+
+/**
+ * @brief Advances the particles; if none explains the observation, starts again from the prior,
+ * and if that fails too, goes back to the particles from before.
+ */
+bool BeliefTracker::update(const Observation& observation) {
+    Game::Binding binding(*_scratch);
+    std::copy(_particles, _particles + _count, _spare);
+    if (advanceAll(observation) == 0) {
+        _redraws++;
+        for (int i = 0; i < _count; ++i) {
+            drawPrior(_particles[i], &observation);
+            _particles[i].weight = 1.0f / _count;
+        }
+        if (advanceAll(observation) == 0) {
+            std::copy(_spare, _spare + _count, _particles);
+            return false;
+        }
+    }
+    _public = _next;
+    normalize();
+    if (effectiveParticles() < _count / 2.0) {
+        resample();
+    }
+    return true;
+}
+
+/**
+ * @brief Replays the observation under the coins of a particle: the turns passed before the
+ * action (a pass is only possible without a legal move), the action (it must be legal) and the
+ * cancel, then checks the coins the viewer knows.
+ */
+bool BeliefTracker::advance(Particle& particle, const Observation& observation) {
+    Game& game = *_scratch;
+    _work = _public;
+    for (int s = 0; s < _work.playerCount; ++s) {
+        _work.players[s].coins = particle.coins[s];
+    }
+    game.restore(_work);
+    for (int turns = 0;; ++turns) {
+        if (turns > 2 * MAX_PLAYERS) {
+            return false;
+        }
+        if (!game.getCurrentPlayer()->isActive()) {
+            game.nextTurn();
+            continue;
+        }
+        Simulator::legalMoves(game, _moves);
+        if (!_moves.empty()) {
+            if (game.getCurrentPlayerIndex() != observation.actor) {
+                return false; // This player would have moved
+            }
+            break;
+        }
+        Simulator::passTurn(game); // Even the actor may pass a round first
+    }
+    const Move move{observation.action, observation.target};
+    bool legal = std::any_of(_moves.begin(), _moves.end(), [&move](const Move& m) {
+        return m.action == move.action && m.target == move.target;
+    });
+    if (!legal) {
+        return false;
+    }
+    Simulator::applyMove(game, move);
+    if (observation.canceller >= 0) {
+        try {
+            Simulator::applyCancel(game, observation.canceller, observation.actor, move);
+        } catch (const std::runtime_error&) {
+            return false; // The rules refuse this cancel under these coins
+        }
+    }
+    game.snapshot(_work);
+    for (int s = 0; s < _work.playerCount; ++s) {
+        particle.coins[s] = static_cast<int8_t>(_work.players[s].coins);
+    }
+    if (observation.revealed >= 0 && particle.coins[observation.target] != observation.revealed) {
+        return false;
+    }
+    return observation.ownCoins < 0 || particle.coins[_viewer] == observation.ownCoins;
+}
+
+/**
+ * @brief Advances every particle with weight; a particle equal to the previous one (before the
+ * update) takes its result. Returns the number of particles left.
+ */
+int BeliefTracker::advanceAll(const Observation& observation) {
+    Particle before = Particle();
+    Particle after = Particle();
+    bool repeated = false;
+    bool explained = false;
+    int alive = 0;
+    for (int i = 0; i < _count; ++i) {
+        Particle& particle = _particles[i];
+        if (particle.weight <= 0) {
+            continue;
+        }
+        const float weight = particle.weight;
+        if (repeated && std::equal(particle.coins, particle.coins + MAX_PLAYERS, before.coins)) {
+            particle = after;
+        } else {
+            before = particle;
+            if (!advance(particle, observation)) {
+                particle.weight = 0;
+            } else if (!explained) {
+                explained = true;
+                _next = _work;
+            }
+            after = particle;
+            repeated = true;
+        }
+        particle.weight = after.weight > 0 ? weight : 0;
+        alive += particle.weight > 0;
+    }
+    return alive;
+}
+
+/**
+ * @brief Draws the coins of the other active players uniformly; the viewer's coins are known,
+ * and so are the coins a SpyOn reveals (a SpyOn moves no coins of its target).
+ */
+void BeliefTracker::drawPrior(Particle& particle, const Observation* observation) {
+    std::uniform_int_distribution<int> coins(0, _maxHidden);
+    for (int s = 0; s < _public.playerCount; ++s) {
+        if (s == _viewer) {
+            particle.coins[s] = static_cast<int8_t>(_public.players[s].coins);
+        } else if (observation && observation->revealed >= 0 && s == observation->target) {
+            particle.coins[s] = static_cast<int8_t>(observation->revealed);
+        } else if (_public.players[s].active) {
+            particle.coins[s] = static_cast<int8_t>(coins(_rng));
+        }
+    }
+}
+
+void BeliefTracker::normalize() {
+    float total = 0;
+    for (int i = 0; i < _count; ++i) {
+        total += _particles[i].weight;
+    }
+    for (int i = 0; i < _count; ++i) {
+        _particles[i].weight /= total;
+    }
+}
+
+/**
+ * @brief Systematic resampling: one random offset, then evenly spaced picks along the weights,
+ * so copies of a particle land next to each other.
+ */
+void BeliefTracker::resample() {
+    std::uniform_real_distribution<float> offset(0.0f, 1.0f / _count);
+    float pick = offset(_rng);
+    float cumulative = _particles[0].weight;
+    int source = 0;
+    for (int i = 0; i < _count; ++i) {
+        while (pick > cumulative && source + 1 < _count) {
+            cumulative += _particles[++source].weight;
+        }
+        _spare[i] = _particles[source];
+        _spare[i].weight = 1.0f / _count;
+        pick += 1.0f / _count;
+    }
+    std::copy(_spare, _spare + _count, _particles);
+}
+
+double BeliefTracker::expectedCoins(int seat) const {
+    double sum = 0;
+    for (int i = 0; i < _count; ++i) {
+        sum += _particles[i].weight * _particles[i].coins[seat];
+    }
+    return sum;
+}
+
+double BeliefTracker::probabilityAtLeast(int seat, int coins) const {
+    double sum = 0;
+    for (int i = 0; i < _count; ++i) {
+        if (_particles[i].coins[seat] >= coins) {
+            sum += _particles[i].weight;
+        }
+    }
+    return sum;
+}
+
+void BeliefTracker::sample(Rng& rng, GameSnapshot& out) const {
+    std::uniform_real_distribution<double> pick(0.0, 1.0);
+    double target = pick(rng);
+    int chosen = 0;
+    double cumulative = 0;
+    for (int i = 0; i < _count; ++i) {
+        if (_particles[i].weight <= 0) {
+            continue;
+        }
+        chosen = i;
+        cumulative += _particles[i].weight;
+        if (cumulative >= target) {
+            break;
+        }
+    }
+    out = _public;
+    for (int s = 0; s < out.playerCount; ++s) {
+        out.players[s].coins = _particles[chosen].coins[s];
+    }
+}
+
+double BeliefTracker::effectiveParticles() const {
+    double sumSq = 0;
+    for (int i = 0; i < _count; ++i) {
+        sumSq += static_cast<double>(_particles[i].weight) * _particles[i].weight;
+    }
+    return sumSq > 0 ? 1.0 / sumSq : 0.0;
+}
+
+BeliefObserver::BeliefObserver(BeliefTracker& tracker, int viewer, int joinAt, int maxHidden)
+    : _tracker(tracker), _viewer(viewer), _joinAt(joinAt), _maxHidden(maxHidden), _tracking(false) {}
+
+void BeliefObserver::onGameStart(uint64_t gameId, const Lineup& lineup) {
+    (void)gameId;
+    (void)lineup;
+    _tracking = _joinAt <= 0;
+    if (_tracking) {
+        _tracker.reset(Game::getInstance().snapshot(), _viewer);
+    }
+}
+
+/**
+ * @brief Joins after the join point, or hands the observation of the viewer to the belief.
+ */
+void BeliefObserver::onAction(const ActionEvent& event) {
+    const Game& game = Game::getInstance();
+    if (!_tracking) {
+        if (event.index + 1 >= _joinAt && Simulator::countActive(game) > 1) {
+            _tracker.reset(game.snapshot(), _viewer, _maxHidden);
+            _tracking = true;
+        }
+        return;
+    }
+    _tracker.update(observe(event, _viewer, game.getPlayers()[_viewer]->getCoins()));
+}
+
+}
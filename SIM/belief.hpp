@@ -0,0 +1,207 @@
+// idocohen963@gmail.com
+#ifndef BELIEF_HPP
+#define BELIEF_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "simulator.hpp"
+
+/**
+ * @file belief.hpp
+ * @brief Hidden coins: what a player observes of an action, and a particle belief over the
+ * coins of the other players.
+ */
+
+namespace coup {
+
+/**
+ * @struct Observation
+ * @brief What one player learns from an action: everything but the coins of the others.
+ *
+ * Actions, targets and cancels are public; coins are not. A player knows their own coins, and a
+ * Spy looking at a player (SpyOn) learns the coins of the target.
+ */
+struct Observation {
+    int actor;          ///< Seat index of the player who acted
+    ActionType action;  ///< The action performed
+    int target;         ///< Seat index of the target, or -1
+    int canceller;      ///< Seat index of the player who cancelled the action, or -1
+    int revealed;       ///< Coins of the target shown to the viewer by a SpyOn, or -1
+    int ownCoins;       ///< Coins of the viewer after the action, or -1 if not given
+};
+
+/**
+ * @brief Returns what a player observes of an action.
+ * @param event The action, as reported by the simulator (with every player's coins).
+ * @param viewer Seat index of the observing player.
+ * @param viewerCoins Coins of the viewer after the action, or -1.
+ * @return The observation.
+ */
+Observation observe(const ActionEvent& event, int viewer, int viewerCoins = -1);
+
+/**
+ * @class BeliefTracker
+ * @brief Particle belief of one player over the hidden coins of the others.
+ *
+ * A particle is one guess of the coins of every seat. The rest of the position (sanctions,
+ * arrests, bribes, whose turn it is) follows from public actions and is tracked exactly, once.
+ * An observation advances every particle through the Player rules on a private Game, turns
+ * passed in between included, so coin effects that depend on the coins themselves (the
+ * Merchant's bonus) are followed per particle. A particle under which the observed action was
+ * not legal (a coup under 7 coins, any other action from 10 coins, an arrest of a player without
+ * coins, a General cancelling a coup under 5 coins, a pass with a legal move...) or that
+ * disagrees with the revealed coins is dropped. When too few particles remain, the survivors are
+ * resampled; when none does, particles are drawn again from the prior, keeping those that
+ * explain the observation.
+ *
+ * Particles live in two fixed arrays (the second one for resampling) and the move buffer is
+ * reserved once, so an update allocates nothing. Particles copied by resampling sit next to each
+ * other, and a particle equal to the previous one reuses its update instead of replaying it.
+ *
+ * From the start of a game every coin follows from the public actions, so a belief that starts
+ * exact stays exact; the particles matter for a player who starts with unknown coins, such as a
+ * spectator taking over a seat in the middle of a game.
+ */
+class BeliefTracker {
+public:
+    static const int MAX_PARTICLES = 256;
+
+    /**
+     * @brief Constructor.
+     * @param particles Number of particles, at most MAX_PARTICLES.
+     * @param seed Seed of the random draws (prior and resampling).
+     * @throws std::invalid_argument on an illegal number of particles.
+     */
+    explicit BeliefTracker(int particles = 128, uint64_t seed = 1);
+
+    /**
+     * @brief Starts tracking a position.
+     * @param state The position; its coins are used for the viewer, and for everyone if maxHidden < 0.
+     * @param viewer Seat index of the tracking player.
+     * @param maxHidden Coins of the other players are unknown, uniform in 0..maxHidden; -1 if known.
+     * @throws std::runtime_error if the position has an illegal number of seats.
+     */
+    void reset(const GameSnapshot& state, int viewer, int maxHidden = -1);
+
+    /**
+     * @brief Advances the belief by one action.
+     * @param observation What the viewer saw.
+     * @return Whether some particle explained the observation (false if the prior was drawn again
+     *         and nothing explained it either; the belief is kept as it was then).
+     */
+    bool update(const Observation& observation);
+
+    /**
+     * @brief Returns the expected coins of a seat.
+     * @param seat The seat.
+     * @return The mean over the particles.
+     */
+    double expectedCoins(int seat) const;
+
+    /**
+     * @brief Returns the probability that a seat has at least some coins.
+     * @param seat The seat.
+     * @param coins The threshold (7 for a coup).
+     * @return The share of the particle weight.
+     */
+    double probabilityAtLeast(int seat, int coins) const;
+
+    /**
+     * @brief Draws a full position from the belief, for a rollout that needs exact coins.
+     * @param rng Random engine.
+     * @param out Receives the public position with the coins of one particle.
+     */
+    void sample(Rng& rng, GameSnapshot& out) const;
+
+    /**
+     * @brief Returns the public position: exact except for the coins of the other players.
+     * @return The tracked position.
+     */
+    const GameSnapshot& position() const { return _public; }
+
+    /**
+     * @brief Returns the number of particles.
+     * @return The number of particles.
+     */
+    int particles() const { return _count; }
+
+    /**
+     * @brief Returns the effective number of particles (1 / sum of squared weights).
+     * @return Between 1 and particles().
+     */
+    double effectiveParticles() const;
+
+    /**
+     * @brief Returns how many times no particle explained an observation and the prior was drawn again.
+     * @return The number of redraws.
+     */
+    uint64_t redraws() const { return _redraws; }
+
+private:
+    /**
+     * @brief One guess of the coins of every seat, with its weight.
+     */
+    struct Particle {
+        int8_t coins[MAX_PLAYERS];
+        float weight;
+    };
+
+    int _count;
+    int _viewer;
+    int _maxHidden;                   ///< Maximum coins of the prior
+    Rng _rng;
+    uint64_t _redraws;
+    std::unique_ptr<Game> _scratch;   ///< The game the particles are played on
+    Lineup _lineup;                   ///< Roles seated on _scratch
+    GameSnapshot _public;             ///< The position, with the coins of a surviving particle
+    GameSnapshot _work;               ///< Position of the particle being advanced
+    GameSnapshot _next;               ///< The position after the observation
+    std::vector<Move> _moves;
+    Particle _particles[MAX_PARTICLES];
+    Particle _spare[MAX_PARTICLES];   ///< Target of the resampling
+
+    bool advance(Particle& particle, const Observation& observation);
+    int advanceAll(const Observation& observation);
+    void drawPrior(Particle& particle, const Observation* observation);
+    void normalize();
+    void resample();
+};
+
+/**
+ * @class BeliefObserver
+ * @brief Feeds the simulated games to the belief of one seat.
+ *
+ * The belief starts exact when the game starts, or, with a join point, from the prior at the
+ * first action after it, like a player taking over a seat in the middle of a game.
+ */
+class BeliefObserver : public GameObserver {
+public:
+    /**
+     * @brief Constructor.
+     * @param tracker The belief to feed; it outlives the observer.
+     * @param viewer Seat index of the tracking player.
+     * @param joinAt Index of the action after which the viewer joins (0 from the start).
+     * @param maxHidden Maximum of the prior of the coins when joining late.
+     */
+    BeliefObserver(BeliefTracker& tracker, int viewer, int joinAt = 0, int maxHidden = 12);
+
+    void onGameStart(uint64_t gameId, const Lineup& lineup) override;
+    void onAction(const ActionEvent& event) override;
+
+    /**
+     * @brief Returns whether the viewer is tracking the current game.
+     * @return Whether the belief follows the game.
+     */
+    bool tracking() const { return _tracking; }
+
+private:
+    BeliefTracker& _tracker;
+    int _viewer;
+    int _joinAt;
+    int _maxHidden;
+    bool _tracking;
+};
+
+}
+#endif
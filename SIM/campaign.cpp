@@ -0,0 +1,210 @@
+// idocohen963@gmail.com
+#include "campaign.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+/**
+ * @file campaign.cpp
+ * @brief Implementation of the work-stealing pool and the campaign runner.
+ */
+
+namespace coup {
+
+/**
+ * @brief Constructor. Creates one task queue per worker.
+ */
+WorkStealingPool::WorkStealingPool(unsigned threads) : _threads(threads), _steals(0) {
+    if (_threads == 0) {
+        _threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < _threads; ++i) {
+        _queues.push_back(std::make_unique<WorkerQueue>());
+    }
+}
+
+/**
+ * @brief Pops the most recently dealt task of a worker's own queue.
+ */
+bool WorkStealingPool::popLocal(unsigned worker, uint64_t& task) {
+    WorkerQueue& queue = *_queues[worker];
+    std::lock_guard<std::mutex> guard(queue.lock);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = queue.tasks.back();
+    queue.tasks.pop_back();
+    return true;
+}
+
+/**
+ * @brief Steals the oldest task of another worker, visiting victims round-robin.
+ */
+bool WorkStealingPool::steal(unsigned worker, uint64_t& task) {
+    for (unsigned offset = 1; offset < _threads; ++offset) {
+        WorkerQueue& victim = *_queues[(worker + offset) % _threads];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Runs all tasks and waits for completion.
+ *
+ * Since no task creates new tasks, a worker that finds every queue empty is done.
+ */
+void WorkStealingPool::run(uint64_t count, const Task& task) {
+    // Deal contiguous blocks, so every worker starts on its own region of the index space
+    for (unsigned w = 0; w < _threads; ++w) {
+        uint64_t begin = count * w / _threads;
+        uint64_t end = count * (w + 1) / _threads;
+        std::lock_guard<std::mutex> guard(_queues[w]->lock);
+        _queues[w]->tasks.clear();
+        for (uint64_t t = end; t > begin; --t) {
+            _queues[w]->tasks.push_back(t - 1); // Lowest index at the back, popped first
+        }
+    }
+
+    std::atomic<uint64_t> steals(0);
+    std::exception_ptr failure;
+    std::mutex failureLock;
+    auto worker = [&](unsigned id) {
+        uint64_t current;
+        try {
+            while (true) {
+                if (!popLocal(id, current)) {
+                    if (!steal(id, current)) {
+                        break;
+                    }
+                    steals++;
+                }
+                task(id, current);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(failureLock);
+            if (!failure) {
+                failure = std::current_exception();
+            }
+            // Drain the queues so the other workers stop early
+            for (auto& queue : _queues) {
+                std::lock_guard<std::mutex> queueGuard(queue->lock);
+                queue->tasks.clear();
+            }
+        }
+    };
+
+    // Every worker gets a thread of its own, so the caller's thread-local Game is never touched
+    std::vector<std::thread> threads;
+    threads.reserve(_threads);
+    for (unsigned w = 0; w < _threads; ++w) {
+        threads.emplace_back(worker, w);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    _steals = steals.load();
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+/**
+ * @brief Records the result of one game.
+ */
+void CampaignTotals::add(const Lineup& lineup, const GameResult& result) {
+    games++;
+    actions += static_cast<uint64_t>(result.actions);
+    for (Role role : lineup) {
+        seats[static_cast<int>(role)]++;
+    }
+    if (result.winner < 0) {
+        draws++;
+    } else {
+        wins[static_cast<int>(lineup[result.winner])]++;
+    }
+}
+
+/**
+ * @brief Adds the counts of another accumulator to this one.
+ */
+void CampaignTotals::merge(const CampaignTotals& other) {
+    games += other.games;
+    draws += other.draws;
+    actions += other.actions;
+    for (int i = 0; i < ROLE_COUNT; ++i) {
+        seats[i] += other.seats[i];
+        wins[i] += other.wins[i];
+    }
+}
+
+/**
+ * @brief Returns the win rate of a role per seat it occupied.
+ */
+double CampaignTotals::winRate(Role role) const {
+    uint64_t played = seats[static_cast<int>(role)];
+    return played == 0 ? 0.0 : static_cast<double>(wins[static_cast<int>(role)]) / played;
+}
+
+/**
+ * @brief SplitMix64 finalizer over (seed, stream).
+ */
+uint64_t deriveSeed(uint64_t seed, uint64_t stream) {
+    uint64_t z = seed + 0x9E3779B97F4A7C15ULL * (stream + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Runs a campaign on the pool and merges the per-worker totals.
+ */
+CampaignTotals runCampaign(const CampaignConfig& config, const PolicyFactory& makePolicy, WorkStealingPool& pool,
+                           const ObserverFactory& observerFor) {
+    if (config.lineups.empty()) {
+        throw std::invalid_argument("Campaign needs at least one lineup");
+    }
+    const uint64_t shardSize = std::max<uint64_t>(1, config.shardSize);
+    const uint64_t shards = (config.games + shardSize - 1) / shardSize;
+
+    // Per-worker state, created lazily on the worker's own thread
+    struct WorkerState {
+        std::unique_ptr<Policy> policy;
+        std::unique_ptr<Simulator> simulator;
+        Rng rng;
+        CampaignTotals totals;
+    };
+    std::vector<WorkerState> workers(pool.size());
+
+    pool.run(shards, [&](unsigned id, uint64_t shard) {
+        WorkerState& state = workers[id];
+        if (!state.simulator) {
+            state.policy = makePolicy();
+            state.simulator = std::make_unique<Simulator>(*state.policy, config.maxActions);
+            if (observerFor) {
+                state.simulator->setObserver(observerFor(id));
+            }
+        }
+        state.rng.seed(deriveSeed(config.seed, shard));
+        uint64_t begin = shard * shardSize;
+        uint64_t end = std::min(config.games, begin + shardSize);
+        for (uint64_t gameIndex = begin; gameIndex < end; ++gameIndex) {
+            const Lineup& lineup = config.lineups[gameIndex % config.lineups.size()];
+            state.totals.add(lineup, state.simulator->playGame(lineup, state.rng, gameIndex));
+        }
+    });
+
+    CampaignTotals merged;
+    for (const WorkerState& state : workers) {
+        merged.merge(state.totals);
+    }
+    return merged;
+}
+
+}
@@ -0,0 +1,172 @@
+// idocohen963@gmail.com
+#ifndef CAMPAIGN_HPP
+#define CAMPAIGN_HPP
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "simulator.hpp"
+
+/**
+ * @file campaign.hpp
+ * @brief Parallel simulation campaigns over many lineups.
+ *
+ * This file declares the work-stealing thread pool that shards games over all cores,
+ * the per-thread result accumulator, and the campaign runner that ties them together.
+ * Every worker plays on its own thread-local Game instance with its own random engine.
+ */
+
+namespace coup {
+
+/**
+ * @class WorkStealingPool
+ * @brief Fixed-size thread pool that runs a known set of tasks with work stealing.
+ *
+ * Tasks are numbered 0..count-1 and dealt out in contiguous blocks to the workers' deques.
+ * A worker pops tasks from the back of its own deque and, when it runs dry, steals from
+ * the front of another worker's deque, so uneven task costs are balanced automatically.
+ */
+class WorkStealingPool {
+public:
+    /**
+     * @brief Function executed for every task: (worker index, task index).
+     */
+    using Task = std::function<void(unsigned, uint64_t)>;
+
+    /**
+     * @brief Constructor.
+     * @param threads Number of worker threads (0 uses all hardware threads).
+     */
+    explicit WorkStealingPool(unsigned threads = 0);
+
+    /**
+     * @brief Returns the number of worker threads.
+     * @return Number of workers.
+     */
+    unsigned size() const { return _threads; }
+
+    /**
+     * @brief Runs tasks 0..count-1 on the workers and waits for all of them.
+     * Workers run on their own threads, the calling thread only waits.
+     * The first exception thrown by a task is rethrown on the calling thread.
+     * @param count Number of tasks.
+     * @param task Function executed for every task.
+     */
+    void run(uint64_t count, const Task& task);
+
+    /**
+     * @brief Returns the number of tasks taken from another worker's deque during the last run.
+     * @return Number of steals.
+     */
+    uint64_t steals() const { return _steals; }
+
+private:
+    /**
+     * @struct WorkerQueue
+     * @brief Double-ended task queue owned by one worker.
+     */
+    struct WorkerQueue {
+        std::mutex lock;             ///< Protects tasks
+        std::deque<uint64_t> tasks;  ///< Pending task indices
+    };
+
+    unsigned _threads;                                  ///< Number of workers
+    std::vector<std::unique_ptr<WorkerQueue>> _queues;  ///< One queue per worker
+    uint64_t _steals;                                   ///< Steal count of the last run
+
+    bool popLocal(unsigned worker, uint64_t& task);
+    bool steal(unsigned worker, uint64_t& task);
+};
+
+/**
+ * @struct CampaignTotals
+ * @brief Mergeable accumulator of game results.
+ *
+ * Each worker fills its own instance, and the instances are merged once at the end,
+ * so no synchronization happens per game.
+ */
+struct CampaignTotals {
+    uint64_t games = 0;                              ///< Number of games played
+    uint64_t draws = 0;                              ///< Games that hit the action limit
+    uint64_t actions = 0;                            ///< Total number of actions
+    std::array<uint64_t, ROLE_COUNT> seats{};        ///< Number of seats taken by each role
+    std::array<uint64_t, ROLE_COUNT> wins{};         ///< Number of wins of each role
+
+    /**
+     * @brief Records the result of one game.
+     * @param lineup The lineup that was played.
+     * @param result The result of the game.
+     */
+    void add(const Lineup& lineup, const GameResult& result);
+
+    /**
+     * @brief Adds the counts of another accumulator to this one.
+     * @param other The accumulator to merge.
+     */
+    void merge(const CampaignTotals& other);
+
+    /**
+     * @brief Returns the win rate of a role per seat it occupied.
+     * @param role The role.
+     * @return Wins divided by seats, or 0 if the role never played.
+     */
+    double winRate(Role role) const;
+};
+
+/**
+ * @brief Creates a fresh policy for a worker. Called once per worker thread.
+ */
+using PolicyFactory = std::function<std::unique_ptr<Policy>()>;
+
+/**
+ * @brief Returns the observer that receives the game events of a worker, or nullptr.
+ * Called once per worker with the worker index; the caller keeps ownership of the observer.
+ */
+using ObserverFactory = std::function<GameObserver*(unsigned)>;
+
+/**
+ * @struct CampaignConfig
+ * @brief Parameters of a simulation campaign.
+ */
+struct CampaignConfig {
+    uint64_t games = 100000;      ///< Number of games to play
+    std::vector<Lineup> lineups;  ///< Lineups played in rotation (game i uses lineups[i % size])
+    uint64_t seed = 1;            ///< Base seed of the random streams
+    uint64_t shardSize = 4096;    ///< Games per task
+    int maxActions = 1000;        ///< Action limit per game
+};
+
+/**
+ * @brief Derives an independent 64 bit seed from a base seed and a stream index (SplitMix64).
+ * @param seed Base seed.
+ * @param stream Stream index.
+ * @return The derived seed.
+ */
+uint64_t deriveSeed(uint64_t seed, uint64_t stream);
+
+/**
+ * @brief Runs a campaign and returns the merged totals.
+ *
+ * Games are split into shards of config.shardSize games, and every shard reseeds the
+ * worker's random engine from (seed, shard). The result therefore depends only on the
+ * configuration, never on the number of threads or on which worker ran which shard.
+ *
+ * Per-worker observers (for example statistics partials or exporters) receive the events of
+ * the games played by their worker only, and are merged by the caller once the campaign is over.
+ *
+ * @param config The campaign parameters.
+ * @param makePolicy Factory creating one policy per worker.
+ * @param pool The pool to run on.
+ * @param observerFor Returns the observer of each worker (optional).
+ * @return The merged totals of all workers.
+ * @throws std::invalid_argument if no lineup is given.
+ */
+CampaignTotals runCampaign(const CampaignConfig& config, const PolicyFactory& makePolicy, WorkStealingPool& pool,
+                           const ObserverFactory& observerFor = nullptr);
+
+}
+#endif
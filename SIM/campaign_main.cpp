@@ -0,0 +1,574 @@
+// idocohen963@gmail.com
+#include "campaign.hpp"
+#include "statistics.hpp"
+#include "exporter.hpp"
+#include "archive.hpp"
+#include "search.hpp"
+#include "evaluator.hpp"
+#include "tournament.hpp"
+#include "belief.hpp"
+#include "openingbook.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+/**
+ * @file campaign_main.cpp
+ * @brief Command line runner for simulation campaigns.
+ *
+ * Usage: campaign_exec [games] [threads] [--scaling] [--stats] [--export <prefix> [--csv]] [--archive <prefix>]
+ *        campaign_exec --search <games> [--depth N] [--nodes N] [--maxn] [--weights <file>]
+ *        campaign_exec --tune <games> [threads] [--weights <file>]
+ *        campaign_exec --tournament <games> [threads] [--swiss] [--depth N] [--nodes N]
+ *        campaign_exec --belief <games> [--join N]
+ *        campaign_exec --book <games per lineup> [threads] [--plies N] [--book-file <file>] [--depth N] [--nodes N]
+ * Plays random-policy games over a rotation of random lineups and prints the win rate of every role.
+ * With --stats every worker streams its games into a StatisticsAggregator and the merged report is printed.
+ * With --export every worker writes its games and actions to <prefix>.<worker>.cpx (columnar format),
+ * or to <prefix>.<worker>.games.csv and <prefix>.<worker>.actions.csv with --csv.
+ * With --archive every worker stores its replays in <prefix>.<worker>.cpr, and the time to read
+ * random games back from the first archive is reported.
+ * With --scaling the same campaign is repeated with 1, 2, 4, ... threads up to the requested
+ * count and the speedup over one thread is reported.
+ * With --search the search bot (see SearchPolicy) plays seat 0 of the lineups against random bots,
+ * on one thread, and its win rate, nodes per second and depth reached are reported; --weights
+ * loads the weights of its leaf evaluation.
+ * With --tune the positions of random-policy games are sampled on all the threads, the evaluator
+ * weights are fitted to the winners and written to the --weights file (or printed).
+ * With --tournament random bots with three cancel rates and the paranoid and max-n search bots
+ * play a round robin (or a Swiss tournament) of at most the given number of games, which stops
+ * once every comparison is decided, and the ratings are reported.
+ * With --belief seat 0 of random-policy games joins after N actions (10 by default) without
+ * knowing the coins of the others, and the error of its belief and the time per update are reported.
+ * With --book an opening book of the first N moves (4 by default) of every lineup is built on all
+ * the threads and written to the --book-file, the lookup time is measured, and the search bot plays
+ * 200 games at seat 0 with and without the book.
+ */
+
+using namespace coup;
+
+/**
+ * @brief Builds a reproducible rotation of lineups with 2-6 seats (roles may repeat).
+ */
+static std::vector<Lineup> makeLineups(size_t count, uint64_t seed) {
+    Rng rng(seed);
+    std::uniform_int_distribution<int> seatCount(2, MAX_PLAYERS);
+    std::uniform_int_distribution<int> roleIndex(0, ROLE_COUNT - 1);
+    std::vector<Lineup> lineups(count);
+    for (Lineup& lineup : lineups) {
+        int seats = seatCount(rng);
+        for (int i = 0; i < seats; ++i) {
+            lineup.push_back(static_cast<Role>(roleIndex(rng)));
+        }
+    }
+    return lineups;
+}
+
+/**
+ * @class WorkerObservers
+ * @brief Forwards the events of one worker to its statistics aggregator, exporter and replay archive.
+ */
+class WorkerObservers : public GameObserver {
+public:
+    StatisticsAggregator* stats = nullptr;
+    std::unique_ptr<std::ofstream> files[3];
+    std::unique_ptr<ColumnarExporter> columnar;
+    std::unique_ptr<CsvExporter> csv;
+    std::unique_ptr<ReplayArchiveWriter> archive;
+
+    void onGameStart(uint64_t gameId, const Lineup& lineup) override {
+        if (stats) stats->onGameStart(gameId, lineup);
+        if (exporter()) exporter()->onGameStart(gameId, lineup);
+        if (archive) archive->onGameStart(gameId, lineup);
+    }
+    void onAction(const ActionEvent& event) override {
+        if (stats) stats->onAction(event);
+        if (exporter()) exporter()->onAction(event);
+        if (archive) archive->onAction(event);
+    }
+    void onCancel(const CancelEvent& event) override {
+        if (stats) stats->onCancel(event);
+    }
+    void onGameEnd(const Lineup& lineup, const GameResult& result) override {
+        if (stats) stats->onGameEnd(lineup, result);
+        if (exporter()) exporter()->onGameEnd(lineup, result);
+        if (archive) archive->onGameEnd(lineup, result);
+    }
+    void finish() {
+        if (columnar) columnar->finish();
+        if (csv) csv->finish();
+        if (archive) archive->finish();
+    }
+
+private:
+    GameObserver* exporter() const {
+        return columnar ? static_cast<GameObserver*>(columnar.get()) : csv.get();
+    }
+};
+
+/**
+ * @brief Opens an output file, throwing if it cannot be created.
+ */
+static std::unique_ptr<std::ofstream> openOutput(const std::string& path) {
+    auto file = std::make_unique<std::ofstream>(path, std::ios::binary);
+    if (!*file) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    return file;
+}
+
+/**
+ * @brief Runs the campaign on a pool of the given size and returns the elapsed seconds.
+ * The export files are written by the workers, the final flush is included in the time.
+ */
+static double timedRun(const CampaignConfig& config, unsigned threads, CampaignTotals& totals, uint64_t& steals,
+                       StatisticsAggregator* stats, const std::string& exportPrefix = "", bool csv = false,
+                       const std::string& archivePrefix = "") {
+    WorkStealingPool pool(threads);
+    std::vector<StatisticsAggregator> partials(stats ? pool.size() : 0);
+    std::vector<WorkerObservers> observers(pool.size());
+    for (unsigned w = 0; w < pool.size(); ++w) {
+        WorkerObservers& observer = observers[w];
+        observer.stats = stats ? &partials[w] : nullptr;
+        if (!archivePrefix.empty()) {
+            observer.files[2] = openOutput(archivePrefix + "." + std::to_string(w) + ".cpr");
+            observer.archive = std::make_unique<ReplayArchiveWriter>(*observer.files[2]);
+        }
+        if (exportPrefix.empty()) {
+            continue;
+        }
+        std::string base = exportPrefix + "." + std::to_string(w);
+        if (csv) {
+            observer.files[0] = openOutput(base + ".games.csv");
+            observer.files[1] = openOutput(base + ".actions.csv");
+            observer.csv = std::make_unique<CsvExporter>(*observer.files[0], *observer.files[1]);
+        } else {
+            observer.files[0] = openOutput(base + ".cpx");
+            observer.columnar = std::make_unique<ColumnarExporter>(*observer.files[0]);
+        }
+    }
+    ObserverFactory observerFor = nullptr;
+    if (stats || !exportPrefix.empty() || !archivePrefix.empty()) {
+        observerFor = [&observers](unsigned worker) { return &observers[worker]; };
+    }
+    auto start = std::chrono::steady_clock::now();
+    totals = runCampaign(config, [] { return std::make_unique<RandomPolicy>(0.5); }, pool, observerFor);
+    steals = pool.steals();
+    for (WorkerObservers& observer : observers) {
+        observer.finish();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (const StatisticsAggregator& partial : partials) {
+        stats->merge(partial);
+    }
+    return seconds;
+}
+
+/**
+ * @brief Reads random games from an archive and reports the average time per game.
+ */
+static void timeRandomReads(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    ReplayArchiveReader reader(file);
+    if (reader.games() == 0) {
+        return;
+    }
+    Rng rng(12345);
+    std::uniform_int_distribution<uint64_t> position(0, reader.games() - 1);
+    ReplayRecord record;
+    const int reads = 1000;
+    uint64_t moves = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < reads; ++i) {
+        reader.read(position(rng), record);
+        moves += record.moves.size();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    file.seekg(0, std::ios::end);
+    std::cout << "\n" << path << ": " << reader.games() << " games in " << reader.blocks() << " blocks, "
+              << std::setprecision(1) << static_cast<double>(file.tellg()) / reader.games() << " bytes/game, "
+              << std::setprecision(2) << seconds * 1e6 / reads << " us per random game read ("
+              << moves / reads << " moves on average)" << std::endl;
+}
+
+/**
+ * @brief Plays the search bot at seat 0 against random bots and reports how it fares and how fast it searches.
+ */
+static void runSearchBot(const CampaignConfig& config, uint64_t games, const SearchConfig& searchConfig) {
+    SearchPolicy search(searchConfig);
+    RandomPolicy random(0.5);
+    Rng rng(config.seed);
+    uint64_t wins = 0;
+    uint64_t draws = 0;
+    double fairShare = 0;
+    for (uint64_t g = 0; g < games; ++g) {
+        const Lineup& lineup = config.lineups[g % config.lineups.size()];
+        std::vector<Policy*> seats(lineup.size(), &random);
+        seats[0] = &search;
+        SeatPolicies policy(seats);
+        Simulator simulator(policy, config.maxActions);
+        GameResult result = simulator.playGame(lineup, rng, g);
+        wins += result.winner == 0;
+        draws += result.winner < 0;
+        fairShare += 1.0 / lineup.size();
+    }
+    const SearchStats& stats = search.stats();
+    std::cout << games << " games, search bot at seat 0 ("
+              << (searchConfig.mode == SearchMode::MaxN ? "max-n" : "paranoid alpha-beta") << ", depth "
+              << searchConfig.maxDepth << ", " << searchConfig.nodeBudget << " nodes) against random bots\n"
+              << std::fixed << std::setprecision(1) << "won " << 100.0 * wins / games << "% (fair share "
+              << 100.0 * fairShare / games << "%), " << draws << " draws\n"
+              << stats.decisions << " decisions, " << std::setprecision(0) << stats.nodesPerSecond()
+              << " nodes/sec, " << std::setprecision(2) << stats.averageDepth() << " average depth, "
+              << std::setprecision(3) << stats.seconds * 1000 / std::max<uint64_t>(1, stats.decisions)
+              << " ms per decision" << std::endl;
+}
+
+/**
+ * @brief Samples positions from a campaign, fits the evaluator weights to the winners and reports
+ * the loss, the accuracy and the batch scoring speed before and after.
+ */
+static void runTune(CampaignConfig config, uint64_t games, unsigned threads, const std::string& weightsPath) {
+    config.games = games;
+    WorkStealingPool pool(threads);
+    std::vector<PositionSampler> samplers(pool.size());
+    auto start = std::chrono::steady_clock::now();
+    runCampaign(config, [] { return std::make_unique<RandomPolicy>(0.5); }, pool,
+                [&samplers](unsigned worker) { return &samplers[worker]; });
+    PositionBatch batch;
+    for (const PositionSampler& sampler : samplers) {
+        batch.append(sampler.batch());
+    }
+    double sampling = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << games << " games sampled on " << pool.size() << " threads in " << std::fixed
+              << std::setprecision(2) << sampling << "s: " << batch.positions() << " positions, "
+              << batch.rows() << " seats" << std::endl;
+
+    EvalWeights initial = defaultWeights();
+    std::vector<float> values;
+    start = std::chrono::steady_clock::now();
+    batch.evaluate(initial, values);
+    double scoring = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "batch evaluation: " << std::setprecision(0) << batch.positions() / std::max(scoring, 1e-9)
+              << " positions/sec" << std::endl;
+
+    TuneConfig tune;
+    start = std::chrono::steady_clock::now();
+    TuneResult result = tuneWeights(batch, initial, tune, pool);
+    double fitting = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << tune.iterations << " iterations in " << std::setprecision(2) << fitting << "s\n"
+              << std::setprecision(4) << "log loss " << result.initialLoss << " -> " << result.finalLoss
+              << ", winner called " << 100 * batch.accuracy(initial) << "% -> "
+              << 100 * batch.accuracy(result.weights) << "% of positions\n" << std::endl;
+
+    if (weightsPath.empty()) {
+        writeWeights(std::cout, result.weights);
+        return;
+    }
+    std::ofstream file(weightsPath);
+    if (!file) {
+        throw std::runtime_error("Cannot open " + weightsPath);
+    }
+    writeWeights(file, result.weights);
+    std::cout << "weights written to " << weightsPath << std::endl;
+}
+
+/**
+ * @brief Plays a tournament between the random and the search bots and prints the standings.
+ */
+static void runTournament(const TournamentConfig& tournamentConfig, unsigned threads, const SearchConfig& searchConfig) {
+    Tournament tournament(tournamentConfig);
+    tournament.add("random", [] { return std::make_unique<RandomPolicy>(0.5); });
+    tournament.add("never-cancel", [] { return std::make_unique<RandomPolicy>(0.0); });
+    tournament.add("always-cancel", [] { return std::make_unique<RandomPolicy>(1.0); });
+    SearchConfig paranoid = searchConfig;
+    paranoid.mode = SearchMode::Paranoid;
+    tournament.add("paranoid", [paranoid] { return std::make_unique<SearchPolicy>(paranoid); });
+    SearchConfig maxN = searchConfig;
+    maxN.mode = SearchMode::MaxN;
+    tournament.add("max-n", [maxN] { return std::make_unique<SearchPolicy>(maxN); });
+
+    WorkStealingPool pool(threads);
+    auto start = std::chrono::steady_clock::now();
+    tournament.run(pool);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << (tournamentConfig.pairing == Pairing::Swiss ? "Swiss" : "Round robin") << " tournament on "
+              << pool.size() << " threads in " << std::fixed << std::setprecision(2) << seconds << "s" << std::endl;
+    tournament.report(std::cout);
+}
+
+/**
+ * @brief Belief of one seat that measures its error against the real coins after every update.
+ */
+class BeliefError : public BeliefObserver {
+public:
+    BeliefError(BeliefTracker& tracker, int joinAt) : BeliefObserver(tracker, 0, joinAt), _tracker(tracker) {}
+
+    void onAction(const ActionEvent& event) override {
+        bool joined = !tracking();
+        auto start = std::chrono::steady_clock::now();
+        BeliefObserver::onAction(event);
+        if (!tracking()) {
+            return;
+        }
+        if (!joined) {
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            updates++;
+        }
+        const std::vector<Player*>& players = Game::getInstance().getPlayers();
+        for (size_t s = 1; s < players.size(); ++s) {
+            if (players[s]->isActive()) {
+                double miss = std::abs(_tracker.expectedCoins(static_cast<int>(s)) - players[s]->getCoins());
+                (joined ? priorError : error) += miss;
+                (joined ? priorSeats : seats)++;
+            }
+        }
+    }
+
+    uint64_t updates = 0;
+    double seconds = 0;
+    double error = 0;
+    uint64_t seats = 0;
+    double priorError = 0;
+    uint64_t priorSeats = 0;
+
+private:
+    BeliefTracker& _tracker;
+};
+
+/**
+ * @brief Plays random-policy games where seat 0 joins late and tracks the hidden coins, and
+ * reports how close its belief gets and how long an update takes.
+ */
+static void runBelief(const CampaignConfig& config, uint64_t games, int joinAt) {
+    RandomPolicy policy(0.5);
+    Simulator simulator(policy, config.maxActions);
+    BeliefTracker tracker(BeliefTracker::MAX_PARTICLES / 2, config.seed);
+    BeliefError belief(tracker, joinAt);
+    simulator.setObserver(&belief);
+    Rng rng(config.seed);
+    uint64_t redraws = 0;
+    for (uint64_t g = 0; g < games; ++g) {
+        simulator.playGame(config.lineups[g % config.lineups.size()], rng, g);
+        redraws += belief.tracking() ? tracker.redraws() : 0;
+    }
+    std::cout << games << " games, seat 0 joining after " << joinAt << " actions with " << tracker.particles()
+              << " particles\n"
+              << std::fixed << std::setprecision(2) << "mean error of the hidden coins: "
+              << belief.priorError / std::max<uint64_t>(1, belief.priorSeats) << " on joining, "
+              << belief.error / std::max<uint64_t>(1, belief.seats) << " after the updates\n"
+              << belief.updates << " updates, " << belief.seconds * 1e6 / std::max<uint64_t>(1, belief.updates)
+              << " us per update, " << redraws << " redraws from the prior" << std::endl;
+}
+
+/**
+ * @brief Builds an opening book of the lineups, times its lookups and compares the search bot
+ * with and without it.
+ */
+static void runBook(const CampaignConfig& config, const BookConfig& bookConfig, unsigned threads,
+                    const std::string& bookPath, const SearchConfig& searchConfig) {
+    WorkStealingPool pool(threads);
+    BookStats stats;
+    auto book = std::make_shared<const OpeningBook>(buildOpeningBook(bookConfig, config.lineups, pool, nullptr, &stats));
+    std::cout << stats.games << " games over " << config.lineups.size() << " lineups on " << pool.size()
+              << " threads in " << std::fixed << std::setprecision(2) << stats.seconds << "s ("
+              << std::setprecision(0) << stats.games / std::max(stats.seconds, 1e-9) << " games/sec)\n"
+              << stats.positions << " positions within " << bookConfig.plies << " moves, " << stats.entries
+              << " with a move of " << bookConfig.minVisits << "+ visits, " << book->fileSize() << " bytes ("
+              << std::setprecision(1) << static_cast<double>(book->fileSize()) / std::max<uint64_t>(1, book->size())
+              << " per entry)" << std::endl;
+    if (!bookPath.empty()) {
+        book->write(*openOutput(bookPath));
+        std::ifstream file(bookPath, std::ios::binary);
+        book = std::make_shared<const OpeningBook>(OpeningBook::read(file));
+        std::cout << "written to " << bookPath << " and read back" << std::endl;
+    }
+
+    std::vector<GameSnapshot> openings;
+    for (const Lineup& lineup : config.lineups) {
+        Simulator::seatLineup(Game::getInstance(), lineup);
+        openings.push_back(Game::getInstance().snapshot());
+    }
+    const int lookups = 1000000;
+    uint64_t found = 0;
+    Move move{ActionType::Gather, -1};
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < lookups; ++i) {
+        found += book->find(openings[i % openings.size()], move);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << std::setprecision(1) << seconds * 1e9 / lookups << " ns per lookup (hashing included), "
+              << 100.0 * found / lookups << "% of the starting positions in the book\n" << std::endl;
+
+    const uint64_t games = 200;
+    for (int withBook = 0; withBook < 2; ++withBook) {
+        auto owned = std::make_unique<SearchPolicy>(searchConfig);
+        SearchPolicy& search = *owned;
+        BookPolicy booked(book, std::move(owned));
+        RandomPolicy random(0.5);
+        Rng rng(config.seed);
+        uint64_t wins = 0;
+        for (uint64_t g = 0; g < games; ++g) {
+            const Lineup& lineup = config.lineups[g % config.lineups.size()];
+            std::vector<Policy*> seats(lineup.size(), &random);
+            seats[0] = withBook ? static_cast<Policy*>(&booked) : &search;
+            SeatPolicies policy(seats);
+            Simulator simulator(policy, config.maxActions);
+            wins += simulator.playGame(lineup, rng, g).winner == 0;
+        }
+        std::cout << (withBook ? "search bot with the book:    " : "search bot without the book: ") << std::setprecision(1)
+                  << 100.0 * wins / games << "% won, " << search.stats().decisions << " searches in "
+                  << std::setprecision(2) << search.stats().seconds << "s, " << booked.hits() << " book moves"
+                  << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    CampaignConfig config;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    bool scaling = false;
+    bool withStats = false;
+    bool csv = false;
+    std::string exportPrefix;
+    std::string archivePrefix;
+    uint64_t searchGames = 0;
+    uint64_t tuneGames = 0;
+    uint64_t beliefGames = 0;
+    BookConfig bookConfig;
+    bookConfig.gamesPerLineup = 0;
+    std::string bookPath;
+    int joinAt = 10;
+    TournamentConfig tournamentConfig;
+    tournamentConfig.maxGames = 0;
+    std::string weightsPath;
+    SearchConfig searchConfig;
+    int positional = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--scaling") == 0) {
+            scaling = true;
+        } else if (std::strcmp(argv[i], "--stats") == 0) {
+            withStats = true;
+        } else if (std::strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        } else if (std::strcmp(argv[i], "--export") == 0 && i + 1 < argc) {
+            exportPrefix = argv[++i];
+        } else if (std::strcmp(argv[i], "--archive") == 0 && i + 1 < argc) {
+            archivePrefix = argv[++i];
+        } else if (std::strcmp(argv[i], "--search") == 0 && i + 1 < argc) {
+            searchGames = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            searchConfig.maxDepth = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--nodes") == 0 && i + 1 < argc) {
+            searchConfig.nodeBudget = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--maxn") == 0) {
+            searchConfig.mode = SearchMode::MaxN;
+        } else if (std::strcmp(argv[i], "--tournament") == 0 && i + 1 < argc) {
+            tournamentConfig.maxGames = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--swiss") == 0) {
+            tournamentConfig.pairing = Pairing::Swiss;
+        } else if (std::strcmp(argv[i], "--tune") == 0 && i + 1 < argc) {
+            tuneGames = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--belief") == 0 && i + 1 < argc) {
+            beliefGames = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--join") == 0 && i + 1 < argc) {
+            joinAt = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--book") == 0 && i + 1 < argc) {
+            bookConfig.gamesPerLineup = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--plies") == 0 && i + 1 < argc) {
+            bookConfig.plies = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--book-file") == 0 && i + 1 < argc) {
+            bookPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--weights") == 0 && i + 1 < argc) {
+            weightsPath = argv[++i];
+        } else if (positional == 0) {
+            config.games = std::strtoull(argv[i], nullptr, 10);
+            positional++;
+        } else {
+            threads = static_cast<unsigned>(std::strtoul(argv[i], nullptr, 10));
+            positional++;
+        }
+    }
+    config.lineups = makeLineups(64, config.seed);
+
+    try {
+        if (tournamentConfig.maxGames > 0) {
+            runTournament(tournamentConfig, threads, searchConfig);
+            return 0;
+        }
+        if (bookConfig.gamesPerLineup > 0) {
+            runBook(config, bookConfig, threads, bookPath, searchConfig);
+            return 0;
+        }
+        if (beliefGames > 0) {
+            runBelief(config, beliefGames, joinAt);
+            return 0;
+        }
+        if (tuneGames > 0) {
+            runTune(config, tuneGames, threads, weightsPath);
+            return 0;
+        }
+        if (searchGames > 0) {
+            if (!weightsPath.empty()) {
+                std::ifstream file(weightsPath);
+                if (!file) {
+                    throw std::runtime_error("Cannot open " + weightsPath);
+                }
+                searchConfig.weights = readWeights(file);
+            }
+            runSearchBot(config, searchGames, searchConfig);
+            return 0;
+        }
+        CampaignTotals totals;
+        uint64_t steals = 0;
+        StatisticsAggregator stats;
+        if (scaling) {
+            double baseline = 0;
+            std::cout << "threads  seconds  games/sec  speedup  steals" << std::endl;
+            std::vector<unsigned> counts;
+            for (unsigned t = 1; t < threads; t *= 2) {
+                counts.push_back(t);
+            }
+            counts.push_back(threads);
+            for (unsigned t : counts) {
+                double seconds = timedRun(config, t, totals, steals, nullptr);
+                if (t == 1) baseline = seconds;
+                std::cout << std::setw(7) << t << std::setw(9) << std::fixed << std::setprecision(2) << seconds
+                          << std::setw(11) << static_cast<uint64_t>(totals.games / seconds)
+                          << std::setw(9) << baseline / seconds << std::setw(8) << steals << std::endl;
+            }
+        } else {
+            double seconds = timedRun(config, threads, totals, steals, withStats ? &stats : nullptr,
+                                      exportPrefix, csv, archivePrefix);
+            std::cout << totals.games << " games on " << threads << " threads in " << std::fixed
+                      << std::setprecision(2) << seconds << "s (" << static_cast<uint64_t>(totals.games / seconds)
+                      << " games/sec, " << steals << " steals)" << std::endl;
+        }
+
+        std::cout << "\nRole       seats      wins   win rate" << std::endl;
+        for (int r = 0; r < ROLE_COUNT; ++r) {
+            Role role = static_cast<Role>(r);
+            std::cout << std::left << std::setw(9) << roleName(role) << std::right
+                      << std::setw(8) << totals.seats[r] << std::setw(10) << totals.wins[r]
+                      << std::setw(10) << std::setprecision(4) << totals.winRate(role) << std::endl;
+        }
+        std::cout << "draws: " << totals.draws << ", average actions per game: "
+                  << std::setprecision(1) << static_cast<double>(totals.actions) / totals.games << std::endl;
+        if (!archivePrefix.empty() && !scaling) {
+            timeRandomReads(archivePrefix + ".0.cpr");
+        }
+        if (withStats && !scaling) {
+            std::cout << "\n";
+            stats.report(std::cout);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+// idocohen963@gmail.com
+#ifndef ENCODING_HPP
+#define ENCODING_HPP
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+/**
+ * @file encoding.hpp
+ * @brief Compact integer encodings shared by the binary file formats.
+ *
+ * Unsigned integers are written as LEB128 varints (7 bits per byte, high bit set on all but
+ * the last byte), and signed integers are zigzag mapped first so small negative values stay short.
+ */
+
+namespace coup {
+
+/**
+ * @brief Maps a signed integer to an unsigned one (0, -1, 1, -2, ... -> 0, 1, 2, 3, ...).
+ * @param value The signed value.
+ * @return The zigzag code.
+ */
+inline uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+/**
+ * @brief Inverse of zigzag().
+ * @param code The zigzag code.
+ * @return The signed value.
+ */
+inline int64_t unzigzag(uint64_t code) {
+    return static_cast<int64_t>(code >> 1) ^ -static_cast<int64_t>(code & 1);
+}
+
+/**
+ * @brief Appends a varint to a byte buffer.
+ * @param out The buffer.
+ * @param value The value.
+ */
+inline void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+/**
+ * @brief Reads a varint and advances the cursor.
+ * @param cursor Current read position, moved past the varint.
+ * @param end End of the buffer.
+ * @return The value.
+ * @throws std::runtime_error if the buffer ends inside the varint.
+ */
+inline uint64_t getVarint(const char*& cursor, const char* end) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (cursor == end) {
+            throw std::runtime_error("Truncated varint");
+        }
+        uint8_t byte = static_cast<uint8_t>(*cursor++);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Varint too long");
+}
+
+/**
+ * @brief Reads one byte and advances the cursor.
+ * @param cursor Current read position, moved past the byte.
+ * @param end End of the buffer.
+ * @return The byte.
+ * @throws std::runtime_error if the buffer is exhausted.
+ */
+inline uint8_t getByte(const char*& cursor, const char* end) {
+    if (cursor == end) {
+        throw std::runtime_error("Truncated buffer");
+    }
+    return static_cast<uint8_t>(*cursor++);
+}
+
+}
+#endif
@@ -0,0 +1,374 @@
+// idocohen963@gmail.com
+#include "evaluator.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "campaign.hpp"
+
+/**
+ * @file evaluator.cpp
+ * @brief Implementation of the position evaluator, the position batches and the weight fitting.
+ */
+
+namespace coup {
+
+namespace {
+
+const char* const FEATURE_NAMES[FEATURE_COUNT] = {
+    "Coins", "CoinLead", "NearCoup", "CanCoup", "MustCoup", "Threats", "Sanctioned", "ArrestBlocked",
+    "ArrestProof", "Bribed", "Spy", "Merchant", "General", "Governor", "Judge", "Baron",
+    "MerchantBonus", "BaronInvest", "GeneralGuard"};
+
+/**
+ * @brief Role features, in the order of the Role enum.
+ */
+const Feature ROLE_FEATURES[ROLE_COUNT] = {Feature::Spy, Feature::Merchant, Feature::General,
+                                           Feature::Governor, Feature::Judge, Feature::Baron};
+
+/**
+ * @brief Turns the scores of the active seats of a position into chances to win, in place.
+ * The largest score is subtracted first so the exponentials cannot overflow.
+ */
+template <typename T>
+void softmax(T* values, size_t count) {
+    T top = *std::max_element(values, values + count);
+    T sum = 0;
+    for (size_t i = 0; i < count; ++i) {
+        values[i] = std::exp(values[i] - top);
+        sum += values[i];
+    }
+    for (size_t i = 0; i < count; ++i) {
+        values[i] /= sum;
+    }
+}
+
+}
+
+const char* featureName(Feature feature) {
+    return FEATURE_NAMES[static_cast<int>(feature)];
+}
+
+EvalWeights defaultWeights() {
+    // Fitted with campaign_exec --tune 20000 (1.2M positions of random-policy games)
+    static const float FITTED[FEATURE_COUNT] = {
+        -0.045f, 0.048f, 0.006f, 0.159f, 0.396f, -0.036f,
+        -0.024f, 0.010f, 0.024f, 0.005f, -1.584f, 1.114f,
+        -0.174f, 1.057f, -0.587f, 0.621f, -0.047f, -0.039f,
+        -0.013f};
+    EvalWeights weights;
+    std::copy(FITTED, FITTED + FEATURE_COUNT, weights.weight);
+    return weights;
+}
+
+void writeWeights(std::ostream& out, const EvalWeights& weights) {
+    for (int f = 0; f < FEATURE_COUNT; ++f) {
+        out << FEATURE_NAMES[f] << ' ' << weights.weight[f] << '\n';
+    }
+}
+
+EvalWeights readWeights(std::istream& in) {
+    EvalWeights weights = defaultWeights();
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string name;
+        float value;
+        if (!(fields >> name)) {
+            continue; // Blank line
+        }
+        if (!(fields >> value)) {
+            throw std::runtime_error("Malformed weight line: " + line);
+        }
+        const char* const* found = std::find(FEATURE_NAMES, FEATURE_NAMES + FEATURE_COUNT, name);
+        if (found == FEATURE_NAMES + FEATURE_COUNT) {
+            throw std::runtime_error("Unknown feature: " + name);
+        }
+        weights.weight[found - FEATURE_NAMES] = value;
+    }
+    return weights;
+}
+
+void extractFeatures(const GameSnapshot& state, int seat, float out[FEATURE_COUNT]) {
+    const PlayerState& self = state.players[seat];
+    int richest = 0;
+    int threats = 0;
+    for (int i = 0; i < state.playerCount; ++i) {
+        if (i != seat && state.players[i].active) {
+            richest = std::max(richest, state.players[i].coins);
+            threats += state.players[i].coins >= 7;
+        }
+    }
+    const int coins = self.coins;
+    const Role role = state.roles[seat];
+    std::memset(out, 0, FEATURE_COUNT * sizeof(float));
+    out[static_cast<int>(Feature::Coins)] = static_cast<float>(coins);
+    out[static_cast<int>(Feature::CoinLead)] = static_cast<float>(coins - richest);
+    out[static_cast<int>(Feature::NearCoup)] = coins >= 5 && coins < 7;
+    out[static_cast<int>(Feature::CanCoup)] = coins >= 7;
+    out[static_cast<int>(Feature::MustCoup)] = coins >= 10;
+    out[static_cast<int>(Feature::Threats)] = static_cast<float>(threats);
+    out[static_cast<int>(Feature::Sanctioned)] = self.sanctioned;
+    out[static_cast<int>(Feature::ArrestBlocked)] = !self.canArrest;
+    out[static_cast<int>(Feature::ArrestProof)] = self.lastArrested;
+    out[static_cast<int>(Feature::Bribed)] = self.isBribed;
+    out[static_cast<int>(ROLE_FEATURES[static_cast<int>(role)])] = 1;
+    out[static_cast<int>(Feature::MerchantBonus)] = role == Role::Merchant && coins >= 3;
+    out[static_cast<int>(Feature::BaronInvest)] = role == Role::Baron && coins >= 3;
+    out[static_cast<int>(Feature::GeneralGuard)] = role == Role::General && coins >= 5;
+}
+
+void evaluatePosition(const GameSnapshot& state, const EvalWeights& weights, double values[MAX_PLAYERS]) {
+    double scores[MAX_PLAYERS];
+    int seats[MAX_PLAYERS];
+    size_t active = 0;
+    float features[FEATURE_COUNT];
+    for (int i = 0; i < MAX_PLAYERS; ++i) {
+        values[i] = 0;
+        if (i >= state.playerCount || !state.players[i].active) {
+            continue;
+        }
+        extractFeatures(state, i, features);
+        double score = 0;
+        for (int f = 0; f < FEATURE_COUNT; ++f) {
+            score += weights.weight[f] * features[f];
+        }
+        seats[active] = i;
+        scores[active++] = score;
+    }
+    if (active == 0) {
+        return;
+    }
+    softmax(scores, active);
+    for (size_t i = 0; i < active; ++i) {
+        values[seats[i]] = scores[i];
+    }
+}
+
+PositionBatch::PositionBatch() : _start(1, 0) {}
+
+void PositionBatch::add(const GameSnapshot& state, int winner) {
+    float features[FEATURE_COUNT];
+    int32_t winnerRow = -1;
+    size_t first = _seat.size();
+    for (int i = 0; i < state.playerCount; ++i) {
+        if (state.players[i].active) {
+            if (i == winner) {
+                winnerRow = static_cast<int32_t>(_seat.size());
+            }
+            extractFeatures(state, i, features);
+            for (int f = 0; f < FEATURE_COUNT; ++f) {
+                _features[f].push_back(features[f]);
+            }
+            _seat.push_back(static_cast<uint8_t>(i));
+        }
+    }
+    if (_seat.size() - first < 2) {
+        // Nothing to evaluate: the game is over
+        for (int f = 0; f < FEATURE_COUNT; ++f) {
+            _features[f].resize(first);
+        }
+        _seat.resize(first);
+        return;
+    }
+    _start.push_back(static_cast<uint32_t>(_seat.size()));
+    _winner.push_back(winnerRow);
+}
+
+void PositionBatch::append(const PositionBatch& other) {
+    const uint32_t offset = static_cast<uint32_t>(_seat.size());
+    for (int f = 0; f < FEATURE_COUNT; ++f) {
+        _features[f].insert(_features[f].end(), other._features[f].begin(), other._features[f].end());
+    }
+    _seat.insert(_seat.end(), other._seat.begin(), other._seat.end());
+    for (size_t p = 1; p < other._start.size(); ++p) {
+        _start.push_back(other._start[p] + offset);
+    }
+    for (int32_t row : other._winner) {
+        _winner.push_back(row >= 0 ? row + static_cast<int32_t>(offset) : -1);
+    }
+}
+
+void PositionBatch::clear() {
+    for (std::vector<float>& column : _features) {
+        column.clear();
+    }
+    _seat.clear();
+    _start.assign(1, 0);
+    _winner.clear();
+}
+
+/**
+ * @brief Scores rows feature by feature: every pass is a multiply-add over contiguous arrays.
+ */
+void PositionBatch::score(const EvalWeights& weights, size_t begin, size_t end, float* scores) const {
+    const size_t count = end - begin;
+    std::fill(scores, scores + count, 0.0f);
+    for (int f = 0; f < FEATURE_COUNT; ++f) {
+        const float weight = weights.weight[f];
+        if (weight == 0) {
+            continue;
+        }
+        const float* column = _features[f].data() + begin;
+        for (size_t r = 0; r < count; ++r) {
+            scores[r] += weight * column[r];
+        }
+    }
+}
+
+void PositionBatch::evaluate(const EvalWeights& weights, std::vector<float>& values) const {
+    values.resize(rows());
+    score(weights, 0, rows(), values.data());
+    for (size_t p = 0; p + 1 < _start.size(); ++p) {
+        softmax(values.data() + _start[p], _start[p + 1] - _start[p]);
+    }
+}
+
+/**
+ * @brief The loss of a position is -log of the chance given to its winner; its gradient with
+ * respect to a weight is the sum over the seats of (chance - won) times the feature.
+ */
+std::pair<double, uint64_t> PositionBatch::logLoss(const EvalWeights& weights, size_t first, size_t last,
+                                                   double gradient[FEATURE_COUNT]) const {
+    if (gradient) {
+        std::fill(gradient, gradient + FEATURE_COUNT, 0.0);
+    }
+    if (first >= last) {
+        return {0.0, 0};
+    }
+    const size_t begin = _start[first];
+    std::vector<float> values(_start[last] - begin);
+    score(weights, begin, _start[last], values.data());
+    double loss = 0;
+    uint64_t counted = 0;
+    for (size_t p = first; p < last; ++p) {
+        if (_winner[p] < 0) {
+            continue;
+        }
+        float* chances = values.data() + (_start[p] - begin);
+        const size_t seats = _start[p + 1] - _start[p];
+        softmax(chances, seats);
+        const size_t winner = _winner[p] - _start[p];
+        loss -= std::log(std::max(chances[winner], 1e-30f));
+        counted++;
+        if (!gradient) {
+            continue;
+        }
+        for (size_t s = 0; s < seats; ++s) {
+            const double error = chances[s] - (s == winner ? 1.0 : 0.0);
+            for (int f = 0; f < FEATURE_COUNT; ++f) {
+                gradient[f] += error * _features[f][_start[p] + s];
+            }
+        }
+    }
+    return {loss, counted};
+}
+
+double PositionBatch::accuracy(const EvalWeights& weights) const {
+    std::vector<float> scores(rows());
+    score(weights, 0, rows(), scores.data());
+    uint64_t right = 0;
+    uint64_t counted = 0;
+    for (size_t p = 0; p < _winner.size(); ++p) {
+        if (_winner[p] < 0) {
+            continue;
+        }
+        const float* best = std::max_element(scores.data() + _start[p], scores.data() + _start[p + 1]);
+        right += best - scores.data() == _winner[p];
+        counted++;
+    }
+    return counted > 0 ? static_cast<double>(right) / counted : 0.0;
+}
+
+PositionSampler::PositionSampler(int every) : _every(std::max(1, every)) {}
+
+void PositionSampler::onGameStart(uint64_t gameId, const Lineup& lineup) {
+    (void)gameId;
+    (void)lineup;
+    _pending.clear();
+}
+
+void PositionSampler::onAction(const ActionEvent& event) {
+    if (event.index % _every == _every - 1) {
+        _pending.emplace_back();
+        Game::getInstance().snapshot(_pending.back());
+    }
+}
+
+void PositionSampler::onGameEnd(const Lineup& lineup, const GameResult& result) {
+    (void)lineup;
+    if (result.winner < 0) {
+        return;
+    }
+    for (const GameSnapshot& state : _pending) {
+        _batch.add(state, result.winner);
+    }
+}
+
+/**
+ * @brief Full-batch Adam: every iteration sums the gradient of all chunks, in chunk order.
+ */
+TuneResult tuneWeights(const PositionBatch& batch, const EvalWeights& start, const TuneConfig& config,
+                       WorkStealingPool& pool) {
+    const size_t chunk = std::max<size_t>(1, config.chunk);
+    const size_t chunks = (batch.positions() + chunk - 1) / chunk;
+    std::vector<std::pair<double, uint64_t>> losses(chunks);
+    std::vector<double> gradients(chunks * FEATURE_COUNT);
+    double gradient[FEATURE_COUNT];
+    EvalWeights weights = start;
+
+    // Mean loss of the weights, and its gradient with the penalty
+    auto measure = [&]() {
+        pool.run(chunks, [&](unsigned worker, uint64_t c) {
+            (void)worker;
+            size_t first = c * chunk;
+            size_t last = std::min(batch.positions(), first + chunk);
+            losses[c] = batch.logLoss(weights, first, last, &gradients[c * FEATURE_COUNT]);
+        });
+        double loss = 0;
+        uint64_t counted = 0;
+        std::fill(gradient, gradient + FEATURE_COUNT, 0.0);
+        for (size_t c = 0; c < chunks; ++c) {
+            loss += losses[c].first;
+            counted += losses[c].second;
+            for (int f = 0; f < FEATURE_COUNT; ++f) {
+                gradient[f] += gradients[c * FEATURE_COUNT + f];
+            }
+        }
+        if (counted == 0) {
+            throw std::invalid_argument("No position with a known winner to tune on");
+        }
+        double penalty = 0;
+        for (int f = 0; f < FEATURE_COUNT; ++f) {
+            gradient[f] = gradient[f] / counted + 2 * config.l2 * weights.weight[f];
+            penalty += config.l2 * weights.weight[f] * weights.weight[f];
+        }
+        return loss / counted + penalty;
+    };
+
+    TuneResult result;
+    result.initialLoss = measure();
+    const double beta1 = 0.9;
+    const double beta2 = 0.999;
+    double moment[FEATURE_COUNT] = {};
+    double scale[FEATURE_COUNT] = {};
+    for (int t = 1; t <= config.iterations; ++t) {
+        if (t > 1) {
+            measure();
+        }
+        for (int f = 0; f < FEATURE_COUNT; ++f) {
+            moment[f] = beta1 * moment[f] + (1 - beta1) * gradient[f];
+            scale[f] = beta2 * scale[f] + (1 - beta2) * gradient[f] * gradient[f];
+            double m = moment[f] / (1 - std::pow(beta1, t));
+            double v = scale[f] / (1 - std::pow(beta2, t));
+            weights.weight[f] -= static_cast<float>(config.learningRate * m / (std::sqrt(v) + 1e-8));
+        }
+    }
+    result.finalLoss = measure();
+    result.weights = weights;
+    return result;
+}
+
+}
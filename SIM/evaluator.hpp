@@ -0,0 +1,259 @@
+// idocohen963@gmail.com
+#ifndef EVALUATOR_HPP
+#define EVALUATOR_HPP
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <utility>
+#include <vector>
+#include "simulator.hpp"
+
+/**
+ * @file evaluator.hpp
+ * @brief Static evaluation of positions with tunable weights, one at a time or in batches.
+ *
+ * Every active seat of a position is described by a few features (coins, coin lead, the 7 and
+ * 10 coin coup thresholds, sanction and arrest state, role and role synergies). A linear score
+ * of the features is turned into each seat's chance to win with a softmax over the active seats,
+ * so the weights can be fitted to the winners of simulated games by maximum likelihood.
+ */
+
+namespace coup {
+
+class WorkStealingPool;
+
+/**
+ * @enum Feature
+ * @brief What the evaluator looks at for every active seat.
+ */
+enum class Feature : uint8_t {
+    Coins,          ///< Coins of the seat
+    CoinLead,       ///< Coins over the richest other active player (negative when behind)
+    NearCoup,       ///< 5 or 6 coins: one tax away from a coup
+    CanCoup,        ///< 7 coins or more
+    MustCoup,       ///< 10 coins or more: checkMustCoup() allows nothing but a coup
+    Threats,        ///< Other active players able to coup
+    Sanctioned,     ///< Under sanction
+    ArrestBlocked,  ///< Cannot arrest this turn (spied on)
+    ArrestProof,    ///< Arrested last turn, cannot be arrested again
+    Bribed,         ///< Bought an extra action
+    Spy,            ///< Role of the seat, one feature per role
+    Merchant,
+    General,
+    Governor,
+    Judge,
+    Baron,
+    MerchantBonus,  ///< Merchant with 3 coins or more: an extra coin every turn
+    BaronInvest,    ///< Baron with 3 coins or more: can invest
+    GeneralGuard    ///< General with 5 coins or more: can stop a coup
+};
+
+/**
+ * @brief Number of features (size of the Feature enum).
+ */
+constexpr int FEATURE_COUNT = 19;
+
+/**
+ * @brief Returns the name of a feature, as written in weight files.
+ * @param feature The feature.
+ * @return The name ("Coins", "CoinLead", ...).
+ */
+const char* featureName(Feature feature);
+
+/**
+ * @struct EvalWeights
+ * @brief Weight of every feature in the score of a seat.
+ */
+struct EvalWeights {
+    float weight[FEATURE_COUNT];  ///< Indexed by Feature
+
+    float& operator[](Feature feature) { return weight[static_cast<int>(feature)]; }
+    float operator[](Feature feature) const { return weight[static_cast<int>(feature)]; }
+};
+
+/**
+ * @brief Returns the weights fitted on random-policy games by the campaign tool (--tune).
+ * @return The default weights.
+ */
+EvalWeights defaultWeights();
+
+/**
+ * @brief Writes weights as one "name value" line per feature.
+ * @param out The stream to write to.
+ * @param weights The weights.
+ */
+void writeWeights(std::ostream& out, const EvalWeights& weights);
+
+/**
+ * @brief Reads weights written by writeWeights(). Features missing from the stream keep their default weight.
+ * @param in The stream to read from.
+ * @return The weights.
+ * @throws std::runtime_error on an unknown feature name or a malformed line.
+ */
+EvalWeights readWeights(std::istream& in);
+
+/**
+ * @brief Computes the features of one seat.
+ * @param state The position.
+ * @param seat The seat, which must be active.
+ * @param out Receives FEATURE_COUNT values, indexed by Feature.
+ */
+void extractFeatures(const GameSnapshot& state, int seat, float out[FEATURE_COUNT]);
+
+/**
+ * @brief Evaluates one position.
+ * @param state The position.
+ * @param weights The weights.
+ * @param values Receives the chance to win of every seat: 0 for the players who are out,
+ *               1 for the last one standing, and the active seats sum to 1.
+ */
+void evaluatePosition(const GameSnapshot& state, const EvalWeights& weights, double values[MAX_PLAYERS]);
+
+/**
+ * @class PositionBatch
+ * @brief Many positions stored feature by feature, scored in one pass per feature.
+ *
+ * One row per active seat of every position; every feature is a contiguous column of floats,
+ * so scoring is a multiply-add of one weight over one array per feature, which the compiler
+ * vectorises. Positions may carry the seat that went on to win, for tuning.
+ */
+class PositionBatch {
+public:
+    PositionBatch();
+
+    /**
+     * @brief Adds a position.
+     * @param state The position; positions with fewer than two active players are ignored.
+     * @param winner Seat that won the game, or -1 if unknown.
+     */
+    void add(const GameSnapshot& state, int winner = -1);
+
+    /**
+     * @brief Adds the positions of another batch.
+     * @param other The batch to append.
+     */
+    void append(const PositionBatch& other);
+
+    /**
+     * @brief Removes every position.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the number of positions.
+     * @return The number of positions.
+     */
+    size_t positions() const { return _start.size() - 1; }
+
+    /**
+     * @brief Returns the number of rows (active seats over all positions).
+     * @return The number of rows.
+     */
+    size_t rows() const { return _seat.size(); }
+
+    /**
+     * @brief Evaluates every position.
+     * @param weights The weights.
+     * @param values Receives the chance to win of every row, in row order.
+     */
+    void evaluate(const EvalWeights& weights, std::vector<float>& values) const;
+
+    /**
+     * @brief Computes the log loss of the known winners over a range of positions, and its gradient.
+     * Positions without a known winner are skipped.
+     * @param weights The weights.
+     * @param first First position of the range.
+     * @param last One past the last position of the range.
+     * @param gradient Receives the gradient of the summed loss, indexed by Feature (may be nullptr).
+     * @return The summed loss and the number of positions with a known winner.
+     */
+    std::pair<double, uint64_t> logLoss(const EvalWeights& weights, size_t first, size_t last,
+                                        double gradient[FEATURE_COUNT]) const;
+
+    /**
+     * @brief Returns how often the seat with the best score went on to win.
+     * @param weights The weights.
+     * @return The fraction of positions with a known winner that the evaluation called right.
+     */
+    double accuracy(const EvalWeights& weights) const;
+
+private:
+    std::vector<float> _features[FEATURE_COUNT];  ///< One column per feature
+    std::vector<uint8_t> _seat;                   ///< Seat of every row
+    std::vector<uint32_t> _start;                 ///< First row of every position, and the end
+    std::vector<int32_t> _winner;                 ///< Row of the winner of every position, or -1
+
+    void score(const EvalWeights& weights, size_t begin, size_t end, float* scores) const;
+};
+
+/**
+ * @class PositionSampler
+ * @brief Observer that samples the positions of simulated games and labels them with the winner.
+ *
+ * Every few actions the position is copied from the Game bound to the worker thread; the copies
+ * of a game enter the batch when it ends with a winner, positions of drawn games are dropped.
+ */
+class PositionSampler : public GameObserver {
+public:
+    /**
+     * @brief Constructor.
+     * @param every Actions between two samples.
+     */
+    explicit PositionSampler(int every = 4);
+
+    void onGameStart(uint64_t gameId, const Lineup& lineup) override;
+    void onAction(const ActionEvent& event) override;
+    void onGameEnd(const Lineup& lineup, const GameResult& result) override;
+
+    /**
+     * @brief Returns the labelled positions sampled so far.
+     * @return The batch.
+     */
+    const PositionBatch& batch() const { return _batch; }
+
+private:
+    int _every;
+    std::vector<GameSnapshot> _pending;  ///< Samples of the game being played
+    PositionBatch _batch;
+};
+
+/**
+ * @struct TuneConfig
+ * @brief Parameters of the weight fitting.
+ */
+struct TuneConfig {
+    int iterations = 300;        ///< Full passes over the batch
+    double learningRate = 0.05;  ///< Step size of the Adam updates
+    double l2 = 1e-4;            ///< Penalty on the squared weights, added to the mean loss
+    size_t chunk = 4096;         ///< Positions per task
+};
+
+/**
+ * @struct TuneResult
+ * @brief Outcome of a weight fitting.
+ */
+struct TuneResult {
+    EvalWeights weights;      ///< The fitted weights
+    double initialLoss;       ///< Mean log loss of the starting weights, with the penalty
+    double finalLoss;         ///< Mean log loss of the fitted weights, with the penalty
+};
+
+/**
+ * @brief Fits the weights to the known winners of a batch by gradient descent (Adam) on the mean log loss.
+ *
+ * The gradient of every iteration is computed in chunks of positions on the pool, and the
+ * chunks are summed in order, so the result does not depend on the number of threads.
+ *
+ * @param batch The labelled positions.
+ * @param start The weights to start from.
+ * @param config The fitting parameters.
+ * @param pool The pool to run on.
+ * @return The fitted weights and the loss before and after.
+ * @throws std::invalid_argument if no position of the batch has a known winner.
+ */
+TuneResult tuneWeights(const PositionBatch& batch, const EvalWeights& start, const TuneConfig& config,
+                       WorkStealingPool& pool);
+
+}
+#endif
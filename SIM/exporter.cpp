@@ -0,0 +1,504 @@
+// idocohen963@gmail.com
+#include "exporter.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include "encoding.hpp"
+
+/**
+ * @file exporter.cpp
+ * @brief Implementation of the columnar and CSV exporters and of the columnar reader.
+ */
+
+namespace coup {
+
+namespace {
+
+const char COLUMNAR_MAGIC[4] = {'C', 'P', 'X', '1'};
+const uint8_t NONE = 255; ///< Seat code for "no target / no winner / no canceller"
+const uint64_t GAME_ROW_BYTES = 4;   ///< Fewest payload bytes of a game row (id, players, winner, actions)
+const uint64_t ACTION_ROW_BYTES = 9; ///< Fewest payload bytes of an action row (one per column)
+const uint64_t READ_CHUNK = 1 << 20; ///< Bytes of a block payload read at a time
+
+/**
+ * @brief Seat index to its byte code.
+ */
+uint8_t seatCode(int seat) {
+    return seat < 0 ? NONE : static_cast<uint8_t>(seat);
+}
+
+/**
+ * @brief Byte code back to a seat index.
+ */
+int seatFromCode(uint8_t code) {
+    return code == NONE ? -1 : code;
+}
+
+/**
+ * @brief Appends a length-prefixed dictionary of names.
+ */
+template <typename Name>
+void putDictionary(std::string& out, int count, Name name) {
+    putVarint(out, static_cast<uint64_t>(count));
+    for (int i = 0; i < count; ++i) {
+        const char* text = name(i);
+        size_t length = std::strlen(text);
+        putVarint(out, length);
+        out.append(text, length);
+    }
+}
+
+/**
+ * @brief Reads one varint from a stream.
+ */
+bool readStreamVarint(std::istream& in, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = in.get();
+        if (byte == std::char_traits<char>::eof()) {
+            return false;
+        }
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Reads a dictionary and maps every stored code to the enum value with the same name.
+ */
+template <typename Name>
+std::vector<uint8_t> readDictionary(std::istream& in, int known, Name name) {
+    uint64_t count;
+    if (!readStreamVarint(in, count)) {
+        throw std::runtime_error("Truncated dictionary");
+    }
+    std::vector<uint8_t> mapping;
+    std::string text;
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t length;
+        if (!readStreamVarint(in, length) || length > 64) {
+            throw std::runtime_error("Invalid dictionary entry");
+        }
+        text.resize(length);
+        if (!in.read(&text[0], static_cast<std::streamsize>(length))) {
+            throw std::runtime_error("Truncated dictionary");
+        }
+        int code = 0;
+        while (code < known && text != name(code)) {
+            code++;
+        }
+        if (code == known) {
+            throw std::runtime_error("Unknown dictionary entry: " + text);
+        }
+        mapping.push_back(static_cast<uint8_t>(code));
+    }
+    return mapping;
+}
+
+/**
+ * @brief Appends a decimal integer without allocating.
+ */
+void appendInt(std::string& out, int64_t value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+/**
+ * @brief Appends a seat, leaving the field empty for -1.
+ */
+void appendSeat(std::string& out, int seat) {
+    if (seat >= 0) {
+        appendInt(out, seat);
+    }
+}
+
+const char* roleAt(int code) { return roleName(static_cast<Role>(code)); }
+const char* actionAt(int code) { return actionName(static_cast<ActionType>(code)); }
+
+}
+
+// === ColumnarExporter ===
+
+/**
+ * @brief Constructor. Writes the magic and the enum dictionaries.
+ */
+ColumnarExporter::ColumnarExporter(std::ostream& out, size_t blockRows)
+    : _out(out), _blockRows(blockRows == 0 ? 1 : blockRows), _gameId(0), _bytesWritten(0) {
+    _block.assign(COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC));
+    putDictionary(_block, ROLE_COUNT, roleAt);
+    putDictionary(_block, ACTION_COUNT, actionAt);
+    _out.write(_block.data(), static_cast<std::streamsize>(_block.size()));
+    _bytesWritten += _block.size();
+}
+
+/**
+ * @brief Destructor. Errors cannot be reported from here, call finish() to see them.
+ */
+ColumnarExporter::~ColumnarExporter() {
+    try {
+        finish();
+    } catch (...) {
+    }
+}
+
+/**
+ * @brief Remembers the identifier of the game the following actions belong to.
+ */
+void ColumnarExporter::onGameStart(uint64_t gameId, const Lineup& lineup) {
+    (void)lineup; // The lineup is stored with the game row, at the end of the game
+    _gameId = gameId;
+}
+
+/**
+ * @brief Buffers one action row.
+ */
+void ColumnarExporter::onAction(const ActionEvent& event) {
+    _actions.ids.push_back(_gameId);
+    _actions.turns.push_back(event.index);
+    _actions.actors.push_back(seatCode(event.actor));
+    _actions.roles.push_back(static_cast<uint8_t>(event.actorRole));
+    _actions.types.push_back(static_cast<uint8_t>(event.action));
+    _actions.targets.push_back(seatCode(event.target));
+    _actions.actorDeltas.push_back(event.actorCoinsAfter - event.actorCoinsBefore);
+    _actions.targetDeltas.push_back(event.targetCoinsAfter - event.targetCoinsBefore);
+    _actions.cancellers.push_back(seatCode(event.canceller));
+    if (_actions.ids.size() >= _blockRows) {
+        writeActions();
+    }
+}
+
+/**
+ * @brief Buffers one game row.
+ */
+void ColumnarExporter::onGameEnd(const Lineup& lineup, const GameResult& result) {
+    _games.ids.push_back(_gameId);
+    _games.players.push_back(static_cast<uint8_t>(lineup.size()));
+    for (Role role : lineup) {
+        _games.roles.push_back(static_cast<uint8_t>(role));
+    }
+    _games.winners.push_back(seatCode(result.winner));
+    _games.actions.push_back(static_cast<uint32_t>(result.actions));
+    if (_games.ids.size() >= _blockRows) {
+        writeGames();
+    }
+}
+
+/**
+ * @brief Writes the remaining rows of both tables.
+ */
+void ColumnarExporter::finish() {
+    if (!_games.ids.empty()) {
+        writeGames();
+    }
+    if (!_actions.ids.empty()) {
+        writeActions();
+    }
+    _out.flush();
+    if (!_out) {
+        throw std::runtime_error("Failed to write columnar export");
+    }
+}
+
+/**
+ * @brief Encodes the buffered game rows column by column.
+ */
+void ColumnarExporter::writeGames() {
+    size_t rows = _games.ids.size();
+    _block.clear();
+    uint64_t previous = 0;
+    for (uint64_t id : _games.ids) {
+        putVarint(_block, zigzag(static_cast<int64_t>(id - previous)));
+        previous = id;
+    }
+    _block.append(reinterpret_cast<const char*>(_games.players.data()), rows);
+    _block.append(reinterpret_cast<const char*>(_games.roles.data()), _games.roles.size());
+    _block.append(reinterpret_cast<const char*>(_games.winners.data()), rows);
+    for (uint32_t actions : _games.actions) {
+        putVarint(_block, actions);
+    }
+    writeBlock('G', rows);
+
+    _games.ids.clear();
+    _games.players.clear();
+    _games.roles.clear();
+    _games.winners.clear();
+    _games.actions.clear();
+}
+
+/**
+ * @brief Encodes the buffered action rows column by column.
+ * Game ids and turns are delta encoded, so consecutive actions of a game cost one byte each.
+ */
+void ColumnarExporter::writeActions() {
+    size_t rows = _actions.ids.size();
+    _block.clear();
+    uint64_t previousId = 0;
+    for (uint64_t id : _actions.ids) {
+        putVarint(_block, zigzag(static_cast<int64_t>(id - previousId)));
+        previousId = id;
+    }
+    int32_t previousTurn = 0;
+    for (int32_t turn : _actions.turns) {
+        putVarint(_block, zigzag(turn - previousTurn));
+        previousTurn = turn;
+    }
+    _block.append(reinterpret_cast<const char*>(_actions.actors.data()), rows);
+    _block.append(reinterpret_cast<const char*>(_actions.roles.data()), rows);
+    _block.append(reinterpret_cast<const char*>(_actions.types.data()), rows);
+    _block.append(reinterpret_cast<const char*>(_actions.targets.data()), rows);
+    for (int32_t delta : _actions.actorDeltas) {
+        putVarint(_block, zigzag(delta));
+    }
+    for (int32_t delta : _actions.targetDeltas) {
+        putVarint(_block, zigzag(delta));
+    }
+    _block.append(reinterpret_cast<const char*>(_actions.cancellers.data()), rows);
+    writeBlock('A', rows);
+
+    _actions.ids.clear();
+    _actions.turns.clear();
+    _actions.actors.clear();
+    _actions.roles.clear();
+    _actions.types.clear();
+    _actions.targets.clear();
+    _actions.actorDeltas.clear();
+    _actions.targetDeltas.clear();
+    _actions.cancellers.clear();
+}
+
+/**
+ * @brief Writes the block header followed by the encoded payload in _block.
+ */
+void ColumnarExporter::writeBlock(char tag, size_t rows) {
+    std::string header(1, tag);
+    putVarint(header, rows);
+    putVarint(header, _block.size());
+    _out.write(header.data(), static_cast<std::streamsize>(header.size()));
+    _out.write(_block.data(), static_cast<std::streamsize>(_block.size()));
+    _bytesWritten += header.size() + _block.size();
+}
+
+// === CsvExporter ===
+
+/**
+ * @brief Constructor. Writes the header line of both files.
+ */
+CsvExporter::CsvExporter(std::ostream& games, std::ostream& actions, size_t bufferBytes)
+    : _gamesOut(games), _actionsOut(actions), _bufferBytes(bufferBytes), _gameId(0) {
+    _gamesText.reserve(_bufferBytes + 256);
+    _actionsText.reserve(_bufferBytes + 256);
+    _gamesText = "game_id,players,roles,winner,winner_role,actions\n";
+    _actionsText = "game_id,turn,actor,actor_role,action,target,actor_delta,target_delta,canceller\n";
+}
+
+/**
+ * @brief Destructor. Errors cannot be reported from here, call finish() to see them.
+ */
+CsvExporter::~CsvExporter() {
+    try {
+        finish();
+    } catch (...) {
+    }
+}
+
+/**
+ * @brief Remembers the identifier of the game the following actions belong to.
+ */
+void CsvExporter::onGameStart(uint64_t gameId, const Lineup& lineup) {
+    (void)lineup; // The lineup is written with the game row, at the end of the game
+    _gameId = gameId;
+}
+
+/**
+ * @brief Appends one action row.
+ */
+void CsvExporter::onAction(const ActionEvent& event) {
+    appendInt(_actionsText, static_cast<int64_t>(_gameId));
+    _actionsText += ',';
+    appendInt(_actionsText, event.index);
+    _actionsText += ',';
+    appendInt(_actionsText, event.actor);
+    _actionsText += ',';
+    _actionsText += roleName(event.actorRole);
+    _actionsText += ',';
+    _actionsText += actionName(event.action);
+    _actionsText += ',';
+    appendSeat(_actionsText, event.target);
+    _actionsText += ',';
+    appendInt(_actionsText, event.actorCoinsAfter - event.actorCoinsBefore);
+    _actionsText += ',';
+    appendInt(_actionsText, event.targetCoinsAfter - event.targetCoinsBefore);
+    _actionsText += ',';
+    appendSeat(_actionsText, event.canceller);
+    _actionsText += '\n';
+    if (_actionsText.size() >= _bufferBytes) {
+        _actionsOut.write(_actionsText.data(), static_cast<std::streamsize>(_actionsText.size()));
+        _actionsText.clear();
+    }
+}
+
+/**
+ * @brief Appends one game row. Roles are separated by ';'.
+ */
+void CsvExporter::onGameEnd(const Lineup& lineup, const GameResult& result) {
+    appendInt(_gamesText, static_cast<int64_t>(_gameId));
+    _gamesText += ',';
+    appendInt(_gamesText, static_cast<int64_t>(lineup.size()));
+    _gamesText += ',';
+    for (size_t i = 0; i < lineup.size(); ++i) {
+        if (i > 0) _gamesText += ';';
+        _gamesText += roleName(lineup[i]);
+    }
+    _gamesText += ',';
+    appendSeat(_gamesText, result.winner);
+    _gamesText += ',';
+    if (result.winner >= 0) {
+        _gamesText += roleName(lineup[result.winner]);
+    }
+    _gamesText += ',';
+    appendInt(_gamesText, result.actions);
+    _gamesText += '\n';
+    if (_gamesText.size() >= _bufferBytes) {
+        _gamesOut.write(_gamesText.data(), static_cast<std::streamsize>(_gamesText.size()));
+        _gamesText.clear();
+    }
+}
+
+/**
+ * @brief Writes the buffered text of both files.
+ */
+void CsvExporter::finish() {
+    _gamesOut.write(_gamesText.data(), static_cast<std::streamsize>(_gamesText.size()));
+    _actionsOut.write(_actionsText.data(), static_cast<std::streamsize>(_actionsText.size()));
+    _gamesText.clear();
+    _actionsText.clear();
+    _gamesOut.flush();
+    _actionsOut.flush();
+    if (!_gamesOut || !_actionsOut) {
+        throw std::runtime_error("Failed to write CSV export");
+    }
+}
+
+// === Reader ===
+
+/**
+ * @brief Reads the header and every block of a columnar file.
+ */
+void readColumnar(std::istream& in, std::vector<GameRecord>& games, std::vector<ActionRecord>& actions) {
+    char magic[4];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, COLUMNAR_MAGIC, sizeof(magic)) != 0) {
+        throw std::runtime_error("Not a columnar export file");
+    }
+    std::vector<uint8_t> roles = readDictionary(in, ROLE_COUNT, roleAt);
+    std::vector<uint8_t> types = readDictionary(in, ACTION_COUNT, actionAt);
+    auto role = [&roles](uint8_t code) {
+        if (code >= roles.size()) throw std::runtime_error("Invalid role code");
+        return static_cast<Role>(roles[code]);
+    };
+    auto type = [&types](uint8_t code) {
+        if (code >= types.size()) throw std::runtime_error("Invalid action code");
+        return static_cast<ActionType>(types[code]);
+    };
+
+    std::string payload;
+    while (true) {
+        int tag = in.get();
+        if (tag == std::char_traits<char>::eof()) {
+            return;
+        }
+        uint64_t rows;
+        uint64_t size;
+        if (!readStreamVarint(in, rows) || !readStreamVarint(in, size)) {
+            throw std::runtime_error("Truncated block header");
+        }
+        // Read in chunks, so a damaged size fails once the data runs out rather than on the allocation
+        payload.clear();
+        while (payload.size() < size) {
+            const uint64_t chunk = std::min<uint64_t>(size - payload.size(), READ_CHUNK);
+            const size_t read = payload.size();
+            payload.resize(read + chunk);
+            if (!in.read(&payload[read], static_cast<std::streamsize>(chunk))) {
+                throw std::runtime_error("Truncated block");
+            }
+        }
+        const uint64_t rowBytes = tag == 'G' ? GAME_ROW_BYTES : ACTION_ROW_BYTES;
+        if (rows > size / rowBytes) {
+            throw std::runtime_error("Truncated block"); // More rows than the payload can hold
+        }
+        const char* cursor = payload.data();
+        const char* end = payload.data() + payload.size();
+        auto bytes = [&](uint64_t count) {
+            if (static_cast<uint64_t>(end - cursor) < count) throw std::runtime_error("Truncated column");
+            const char* column = cursor;
+            cursor += count;
+            return reinterpret_cast<const uint8_t*>(column);
+        };
+
+        if (tag == 'G') {
+            size_t first = games.size();
+            games.resize(first + rows);
+            uint64_t id = 0;
+            for (uint64_t r = 0; r < rows; ++r) {
+                id += static_cast<uint64_t>(unzigzag(getVarint(cursor, end)));
+                games[first + r].gameId = id;
+            }
+            const uint8_t* players = bytes(rows);
+            for (uint64_t r = 0; r < rows; ++r) {
+                const uint8_t* seats = bytes(players[r]);
+                games[first + r].lineup.clear();
+                for (uint8_t s = 0; s < players[r]; ++s) {
+                    games[first + r].lineup.push_back(role(seats[s]));
+                }
+            }
+            const uint8_t* winners = bytes(rows);
+            for (uint64_t r = 0; r < rows; ++r) {
+                games[first + r].winner = seatFromCode(winners[r]);
+            }
+            for (uint64_t r = 0; r < rows; ++r) {
+                games[first + r].actions = static_cast<int>(getVarint(cursor, end));
+            }
+        } else if (tag == 'A') {
+            size_t first = actions.size();
+            actions.resize(first + rows);
+            uint64_t id = 0;
+            for (uint64_t r = 0; r < rows; ++r) {
+                id += static_cast<uint64_t>(unzigzag(getVarint(cursor, end)));
+                actions[first + r].gameId = id;
+            }
+            int64_t turn = 0;
+            for (uint64_t r = 0; r < rows; ++r) {
+                turn += unzigzag(getVarint(cursor, end));
+                actions[first + r].turn = static_cast<int>(turn);
+            }
+            const uint8_t* actors = bytes(rows);
+            const uint8_t* actorRoles = bytes(rows);
+            const uint8_t* actionTypes = bytes(rows);
+            const uint8_t* targets = bytes(rows);
+            for (uint64_t r = 0; r < rows; ++r) {
+                ActionRecord& record = actions[first + r];
+                record.actor = seatFromCode(actors[r]);
+                record.actorRole = role(actorRoles[r]);
+                record.action = type(actionTypes[r]);
+                record.target = seatFromCode(targets[r]);
+            }
+            for (uint64_t r = 0; r < rows; ++r) {
+                actions[first + r].actorDelta = static_cast<int>(unzigzag(getVarint(cursor, end)));
+            }
+            for (uint64_t r = 0; r < rows; ++r) {
+                actions[first + r].targetDelta = static_cast<int>(unzigzag(getVarint(cursor, end)));
+            }
+            const uint8_t* cancellers = bytes(rows);
+            for (uint64_t r = 0; r < rows; ++r) {
+                actions[first + r].canceller = seatFromCode(cancellers[r]);
+            }
+        } else {
+            throw std::runtime_error("Unknown block tag");
+        }
+    }
+}
+
+}
@@ -0,0 +1,187 @@
+// idocohen963@gmail.com
+#ifndef EXPORTER_HPP
+#define EXPORTER_HPP
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "simulator.hpp"
+
+/**
+ * @file exporter.hpp
+ * @brief Export of simulation results for analysis tools.
+ *
+ * This file declares two GameObserver exporters writing one record per game and one record
+ * per action: a columnar binary format (ColumnarExporter, read back by readColumnar) and a
+ * CSV fallback (CsvExporter). Both collect rows in memory and write them in large blocks,
+ * so each worker can export to its own file without slowing down the simulation.
+ *
+ * Columnar file layout (all integers are LEB128 varints unless noted, "zz" means zigzag encoded):
+ *   header:  "CPX1", role dictionary, action dictionary (count, then length-prefixed names)
+ *   block:   table tag (1 byte, 'G' or 'A'), row count, payload size, payload
+ *   'G' payload columns: game id (zz delta), player count (byte), roles (byte per seat, dictionary code),
+ *                        winner seat (byte, 255 = draw), action count
+ *   'A' payload columns: game id (zz delta), turn (zz delta), actor seat (byte), actor role (byte code),
+ *                        action (byte code), target seat (byte, 255 = none), actor coin delta (zz),
+ *                        target coin delta (zz), canceller seat (byte, 255 = none)
+ */
+
+namespace coup {
+
+/**
+ * @struct GameRecord
+ * @brief One exported game.
+ */
+struct GameRecord {
+    uint64_t gameId;  ///< Identifier of the game
+    Lineup lineup;    ///< Roles of the players, in seat order
+    int winner;       ///< Seat of the winner, or -1 for a draw
+    int actions;      ///< Number of actions played
+};
+
+/**
+ * @struct ActionRecord
+ * @brief One exported action.
+ */
+struct ActionRecord {
+    uint64_t gameId;    ///< Identifier of the game
+    int turn;           ///< Index of the action within the game
+    int actor;          ///< Seat of the player who acted
+    Role actorRole;     ///< Role of the player who acted
+    ActionType action;  ///< The action
+    int target;         ///< Seat of the target, or -1
+    int actorDelta;     ///< Change of the actor's coins
+    int targetDelta;    ///< Change of the target's coins (0 without target)
+    int canceller;      ///< Seat of the player who cancelled the action, or -1
+};
+
+/**
+ * @class ColumnarExporter
+ * @brief Writes games and actions in the columnar binary format described above.
+ *
+ * Rows are buffered column by column and encoded once a table reaches blockRows rows.
+ * finish() (also called by the destructor) writes the remaining rows.
+ */
+class ColumnarExporter : public GameObserver {
+public:
+    /**
+     * @brief Constructor. Writes the file header.
+     * @param out The stream to write to (opened in binary mode).
+     * @param blockRows Number of rows per block.
+     */
+    explicit ColumnarExporter(std::ostream& out, size_t blockRows = 65536);
+
+    /**
+     * @brief Destructor. Writes the rows that are still buffered.
+     */
+    ~ColumnarExporter() override;
+
+    void onGameStart(uint64_t gameId, const Lineup& lineup) override;
+    void onAction(const ActionEvent& event) override;
+    void onGameEnd(const Lineup& lineup, const GameResult& result) override;
+
+    /**
+     * @brief Writes all buffered rows and flushes the stream.
+     */
+    void finish();
+
+    /**
+     * @brief Returns the number of bytes written so far.
+     * @return Bytes written.
+     */
+    uint64_t bytesWritten() const { return _bytesWritten; }
+
+private:
+    /**
+     * @struct GameColumns
+     * @brief Buffered game rows, one vector per column.
+     */
+    struct GameColumns {
+        std::vector<uint64_t> ids;      ///< Game identifiers
+        std::vector<uint8_t> players;   ///< Player counts
+        std::vector<uint8_t> roles;     ///< Role codes of all seats, concatenated
+        std::vector<uint8_t> winners;   ///< Winner seats (255 = draw)
+        std::vector<uint32_t> actions;  ///< Action counts
+    };
+
+    /**
+     * @struct ActionColumns
+     * @brief Buffered action rows, one vector per column.
+     */
+    struct ActionColumns {
+        std::vector<uint64_t> ids;          ///< Game identifiers
+        std::vector<int32_t> turns;         ///< Action indices
+        std::vector<uint8_t> actors;        ///< Actor seats
+        std::vector<uint8_t> roles;         ///< Actor role codes
+        std::vector<uint8_t> types;         ///< Action codes
+        std::vector<uint8_t> targets;       ///< Target seats (255 = none)
+        std::vector<int32_t> actorDeltas;   ///< Actor coin changes
+        std::vector<int32_t> targetDeltas;  ///< Target coin changes
+        std::vector<uint8_t> cancellers;    ///< Canceller seats (255 = none)
+    };
+
+    std::ostream& _out;          ///< Destination stream
+    size_t _blockRows;           ///< Rows per block
+    uint64_t _gameId;            ///< Identifier of the game being played
+    uint64_t _bytesWritten;      ///< Bytes written so far
+    GameColumns _games;          ///< Buffered game rows
+    ActionColumns _actions;      ///< Buffered action rows
+    std::string _block;          ///< Reused encoding buffer
+
+    void writeGames();
+    void writeActions();
+    void writeBlock(char tag, size_t rows);
+};
+
+/**
+ * @class CsvExporter
+ * @brief Writes games and actions as two CSV files with a header line each.
+ *
+ * Enums are written by name and target/canceller/winner columns are empty when absent.
+ */
+class CsvExporter : public GameObserver {
+public:
+    /**
+     * @brief Constructor. Writes the header lines.
+     * @param games Stream receiving the game rows.
+     * @param actions Stream receiving the action rows.
+     * @param bufferBytes Size of the text buffered before each write.
+     */
+    CsvExporter(std::ostream& games, std::ostream& actions, size_t bufferBytes = 1 << 20);
+
+    /**
+     * @brief Destructor. Writes the text that is still buffered.
+     */
+    ~CsvExporter() override;
+
+    void onGameStart(uint64_t gameId, const Lineup& lineup) override;
+    void onAction(const ActionEvent& event) override;
+    void onGameEnd(const Lineup& lineup, const GameResult& result) override;
+
+    /**
+     * @brief Writes all buffered text and flushes the streams.
+     */
+    void finish();
+
+private:
+    std::ostream& _gamesOut;     ///< Game rows destination
+    std::ostream& _actionsOut;   ///< Action rows destination
+    size_t _bufferBytes;         ///< Buffered bytes before a write
+    uint64_t _gameId;            ///< Identifier of the game being played
+    std::string _gamesText;      ///< Buffered game rows
+    std::string _actionsText;    ///< Buffered action rows
+};
+
+/**
+ * @brief Reads a file written by ColumnarExporter.
+ * @param in The stream to read from (opened in binary mode).
+ * @param games Receives the game rows (appended).
+ * @param actions Receives the action rows (appended).
+ * @throws std::runtime_error if the stream is not a valid columnar file.
+ */
+void readColumnar(std::istream& in, std::vector<GameRecord>& games, std::vector<ActionRecord>& actions);
+
+}
+#endif
@@ -0,0 +1,389 @@
+// idocohen963@gmail.com
+#include "openingbook.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+/**
+ * @file openingbook.cpp
+ * @brief Implementation of the opening book, its file format and its simulation.
+ */
+
+namespace coup {
+
+namespace {
+
+const char BOOK_MAGIC[4] = {'C', 'P', 'B', '1'};
+const size_t HEADER_SIZE = sizeof(BOOK_MAGIC) + 12;
+const size_t SLOT_SIZE = 12;
+const size_t MIN_SLOTS = 16;
+const uint64_t READ_CHUNK_SLOTS = 4096;
+
+uint8_t packMove(const Move& move) {
+    return static_cast<uint8_t>(static_cast<int>(move.action) | ((move.target + 1) << 4));
+}
+
+Move unpackMove(uint8_t packed) {
+    return Move{static_cast<ActionType>(packed & 0x0F), ((packed >> 4) & 0x07) - 1};
+}
+
+void putFixed(std::string& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+uint64_t getFixed(const char* in, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(in[i])) << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * @brief Games and wins of one opening move.
+ */
+struct Tally {
+    uint8_t move;
+    uint64_t visits;
+    uint64_t wins;
+};
+
+using TallyTable = std::unordered_map<uint64_t, std::vector<Tally>>;
+
+/**
+ * @brief Policy of a worker while building a book: uniform opening moves, remembered with their
+ * position and mover, then the rollout policy. As the observer of the same games it credits the
+ * opening moves when the game ends.
+ */
+class OpeningRecorder : public Policy, public GameObserver {
+public:
+    OpeningRecorder(int plies, std::unique_ptr<Policy> rollout)
+        : _plies(plies), _rollout(std::move(rollout)), _ply(0), _state() {}
+
+    size_t chooseMove(const Game& game, const std::vector<Move>& moves, Rng& rng) override {
+        if (_ply >= _plies) {
+            return _rollout->chooseMove(game, moves, rng);
+        }
+        _ply++;
+        std::uniform_int_distribution<size_t> pick(0, moves.size() - 1);
+        size_t chosen = pick(rng);
+        game.snapshot(_state);
+        _opening.push_back(Opening{positionKey(_state), packMove(moves[chosen]), game.getCurrentPlayerIndex()});
+        return chosen;
+    }
+
+    bool chooseCancel(const Game& game, const Player& canceller, int actor, const Move& move, Rng& rng) override {
+        return _rollout->chooseCancel(game, canceller, actor, move, rng);
+    }
+
+    void onGameStart(uint64_t gameId, const Lineup& lineup) override {
+        (void)gameId;
+        (void)lineup;
+        _ply = 0;
+        _opening.clear();
+    }
+
+    void onGameEnd(const Lineup& lineup, const GameResult& result) override {
+        (void)lineup;
+        for (const Opening& opening : _opening) {
+            std::vector<Tally>& known = tallies[opening.key];
+            auto it = std::find_if(known.begin(), known.end(),
+                                   [&opening](const Tally& t) { return t.move == opening.move; });
+            if (it == known.end()) {
+                known.push_back(Tally{opening.move, 0, 0});
+                it = known.end() - 1;
+            }
+            it->visits++;
+            it->wins += result.winner == opening.seat;
+        }
+    }
+
+    TallyTable tallies;  ///< Opening moves of every position met, merged after the build
+
+private:
+    /**
+     * @brief An opening move of the current game.
+     */
+    struct Opening {
+        uint64_t key;
+        uint8_t move;
+        int seat;
+    };
+
+    int _plies;
+    std::unique_ptr<Policy> _rollout;
+    int _ply;               ///< Moves played in the current game
+    GameSnapshot _state;
+    std::vector<Opening> _opening;
+};
+
+}
+
+/**
+ * @brief Every seat is folded into the key with the SplitMix64 finalizer of deriveSeed().
+ */
+uint64_t positionKey(const GameSnapshot& state) {
+    uint64_t key = deriveSeed(static_cast<uint64_t>(state.playerCount),
+                              static_cast<uint64_t>(state.currentPlayerIndex) << 8 |
+                                  static_cast<uint64_t>(state.lastStep));
+    for (int s = 0; s < state.playerCount; ++s) {
+        const PlayerState& player = state.players[s];
+        uint64_t seat = static_cast<uint64_t>(player.coins & 0xFF) | static_cast<uint64_t>(player.active) << 8 |
+                        static_cast<uint64_t>(player.sanctioned) << 9 |
+                        static_cast<uint64_t>(player.lastArrested) << 10 |
+                        static_cast<uint64_t>(player.canArrest) << 11 | static_cast<uint64_t>(player.isBribed) << 12 |
+                        static_cast<uint64_t>(state.roles[s]) << 16;
+        key = deriveSeed(key, seat);
+    }
+    return key == 0 ? 1 : key;
+}
+
+OpeningBook::OpeningBook(int plies) : _slots(MIN_SLOTS, Slot{0, 0, 0, 0}), _size(0), _plies(plies) {}
+
+/**
+ * @brief Returns the slot holding the key, or the empty slot where it would go.
+ */
+size_t OpeningBook::probe(uint64_t key) const {
+    const size_t mask = _slots.size() - 1;
+    size_t slot = key & mask;
+    while (_slots[slot].key != 0 && _slots[slot].key != key) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void OpeningBook::grow() {
+    std::vector<Slot> old(_slots.size() * 2, Slot{0, 0, 0, 0});
+    old.swap(_slots);
+    for (const Slot& slot : old) {
+        if (slot.key != 0) {
+            _slots[probe(slot.key)] = slot;
+        }
+    }
+}
+
+void OpeningBook::insert(const BookEntry& entry) {
+    if (entry.key == 0) {
+        throw std::invalid_argument("Position key 0 marks an empty slot");
+    }
+    if (2 * (_size + 1) > _slots.size()) {
+        grow();
+    }
+    Slot& slot = _slots[probe(entry.key)];
+    _size += slot.key == 0;
+    const double score = std::min(1.0, std::max(0.0, entry.score));
+    slot = Slot{entry.key, packMove(entry.move), static_cast<uint8_t>(score * 255 + 0.5),
+                static_cast<uint16_t>(std::min<uint32_t>(entry.visits, 0xFFFF))};
+}
+
+bool OpeningBook::find(uint64_t key, BookEntry& out) const {
+    const Slot& slot = _slots[probe(key)];
+    if (slot.key == 0) {
+        return false;
+    }
+    out = BookEntry{slot.key, unpackMove(slot.move), slot.score / 255.0, slot.visits};
+    return true;
+}
+
+bool OpeningBook::find(const GameSnapshot& state, Move& move) const {
+    const Slot& slot = _slots[probe(positionKey(state))];
+    if (slot.key == 0) {
+        return false;
+    }
+    move = unpackMove(slot.move);
+    return true;
+}
+
+uint64_t OpeningBook::fileSize() const {
+    return HEADER_SIZE + SLOT_SIZE * _slots.size();
+}
+
+void OpeningBook::write(std::ostream& out) const {
+    std::string bytes(BOOK_MAGIC, sizeof(BOOK_MAGIC));
+    bytes.reserve(fileSize());
+    putFixed(bytes, _slots.size(), 4);
+    putFixed(bytes, _size, 4);
+    putFixed(bytes, static_cast<uint64_t>(_plies), 4);
+    for (const Slot& slot : _slots) {
+        putFixed(bytes, slot.key, 8);
+        putFixed(bytes, slot.move, 1);
+        putFixed(bytes, slot.score, 1);
+        putFixed(bytes, slot.visits, 2);
+    }
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("Failed to write opening book");
+    }
+}
+
+/**
+ * @brief Checks the header, then takes the slots in file order; the entry count must match the
+ * occupied slots and every key must be reachable from its home slot.
+ */
+OpeningBook OpeningBook::read(std::istream& in) {
+    char header[HEADER_SIZE];
+    in.read(header, sizeof(header));
+    if (!in || std::memcmp(header, BOOK_MAGIC, sizeof(BOOK_MAGIC)) != 0) {
+        throw std::runtime_error("Not an opening book");
+    }
+    const uint64_t slots = getFixed(header + 4, 4);
+    const uint64_t size = getFixed(header + 8, 4);
+    if (slots < MIN_SLOTS || (slots & (slots - 1)) != 0 || 2 * size > slots) {
+        throw std::runtime_error("Corrupted opening book header");
+    }
+    // The slots are read in chunks, so a header claiming more slots than the stream holds fails
+    // as truncated once the data runs out instead of sizing the table from it up front
+    OpeningBook book(static_cast<int>(getFixed(header + 12, 4)));
+    book._slots.clear();
+    std::string bytes(SLOT_SIZE * std::min<uint64_t>(slots, READ_CHUNK_SLOTS), '\0');
+    for (uint64_t first = 0; first < slots; first += READ_CHUNK_SLOTS) {
+        const uint64_t count = std::min<uint64_t>(slots - first, READ_CHUNK_SLOTS);
+        in.read(&bytes[0], static_cast<std::streamsize>(SLOT_SIZE * count));
+        if (!in) {
+            throw std::runtime_error("Truncated opening book");
+        }
+        for (uint64_t i = 0; i < count; ++i) {
+            const char* slot = bytes.data() + SLOT_SIZE * i;
+            book._slots.push_back(Slot{getFixed(slot, 8), static_cast<uint8_t>(slot[8]),
+                                       static_cast<uint8_t>(slot[9]), static_cast<uint16_t>(getFixed(slot + 10, 2))});
+            book._size += book._slots.back().key != 0;
+        }
+    }
+    if (book._size != size) {
+        throw std::runtime_error("Corrupted opening book: wrong entry count");
+    }
+    for (uint64_t i = 0; i < slots; ++i) {
+        if (book._slots[i].key != 0 && book.probe(book._slots[i].key) != i) {
+            throw std::runtime_error("Corrupted opening book: misplaced entry");
+        }
+    }
+    return book;
+}
+
+/**
+ * @brief Plays the shards on the pool with one recorder per worker, merges the tallies in
+ * worker order and fills the table in key order.
+ */
+OpeningBook buildOpeningBook(const BookConfig& config, const std::vector<Lineup>& lineups, WorkStealingPool& pool,
+                             const PolicyFactory& makeRollout, BookStats* stats) {
+    if (lineups.empty()) {
+        throw std::invalid_argument("An opening book needs at least one lineup");
+    }
+    if (config.plies < 1) {
+        throw std::invalid_argument("An opening book needs at least one ply");
+    }
+    auto start = std::chrono::steady_clock::now();
+    const uint64_t games = config.gamesPerLineup * lineups.size();
+    const uint64_t shardSize = std::max<uint64_t>(1, config.shardSize);
+    const uint64_t shards = (games + shardSize - 1) / shardSize;
+
+    // Per-worker state, created lazily on the worker's own thread
+    struct WorkerState {
+        std::unique_ptr<OpeningRecorder> recorder;
+        std::unique_ptr<Simulator> simulator;
+        Rng rng;
+    };
+    std::vector<WorkerState> workers(pool.size());
+
+    pool.run(shards, [&](unsigned id, uint64_t shard) {
+        WorkerState& state = workers[id];
+        if (!state.simulator) {
+            std::unique_ptr<Policy> rollout =
+                makeRollout ? makeRollout() : std::make_unique<RandomPolicy>(0.5);
+            state.recorder = std::make_unique<OpeningRecorder>(config.plies, std::move(rollout));
+            state.simulator = std::make_unique<Simulator>(*state.recorder, config.maxActions);
+            state.simulator->setObserver(state.recorder.get());
+        }
+        state.rng.seed(deriveSeed(config.seed, shard));
+        uint64_t end = std::min(games, (shard + 1) * shardSize);
+        for (uint64_t gameIndex = shard * shardSize; gameIndex < end; ++gameIndex) {
+            state.simulator->playGame(lineups[gameIndex % lineups.size()], state.rng, gameIndex);
+        }
+    });
+
+    TallyTable merged;
+    for (WorkerState& state : workers) {
+        if (!state.recorder) {
+            continue;
+        }
+        for (auto& position : state.recorder->tallies) {
+            std::vector<Tally>& into = merged[position.first];
+            for (const Tally& tally : position.second) {
+                auto it = std::find_if(into.begin(), into.end(),
+                                       [&tally](const Tally& t) { return t.move == tally.move; });
+                if (it == into.end()) {
+                    into.push_back(tally);
+                } else {
+                    it->visits += tally.visits;
+                    it->wins += tally.wins;
+                }
+            }
+        }
+        state.recorder->tallies.clear();
+    }
+
+    std::vector<BookEntry> entries;
+    for (const auto& position : merged) {
+        const Tally* best = nullptr;
+        for (const Tally& tally : position.second) {
+            if (tally.visits < config.minVisits) {
+                continue;
+            }
+            // Compare wins / visits without rounding; the lower move code breaks ties
+            if (!best || tally.wins * best->visits > best->wins * tally.visits ||
+                (tally.wins * best->visits == best->wins * tally.visits && tally.move < best->move)) {
+                best = &tally;
+            }
+        }
+        if (best) {
+            entries.push_back(BookEntry{position.first, unpackMove(best->move),
+                                        static_cast<double>(best->wins) / best->visits,
+                                        static_cast<uint32_t>(std::min<uint64_t>(best->visits, UINT32_MAX))});
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const BookEntry& a, const BookEntry& b) { return a.key < b.key; });
+    OpeningBook book(config.plies);
+    for (const BookEntry& entry : entries) {
+        book.insert(entry);
+    }
+    if (stats) {
+        stats->games = games;
+        stats->positions = merged.size();
+        stats->entries = entries.size();
+        stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return book;
+}
+
+BookPolicy::BookPolicy(std::shared_ptr<const OpeningBook> book, std::unique_ptr<Policy> fallback)
+    : _book(std::move(book)), _fallback(std::move(fallback)), _state(), _hits(0), _misses(0) {}
+
+/**
+ * @brief The book move is only played if it is legal here, which also guards against a hash
+ * collision with a position of another lineup.
+ */
+size_t BookPolicy::chooseMove(const Game& game, const std::vector<Move>& moves, Rng& rng) {
+    game.snapshot(_state);
+    Move move{ActionType::Gather, -1};
+    if (_book->find(_state, move)) {
+        for (size_t i = 0; i < moves.size(); ++i) {
+            if (moves[i].action == move.action && moves[i].target == move.target) {
+                _hits++;
+                return i;
+            }
+        }
+    }
+    _misses++;
+    return _fallback->chooseMove(game, moves, rng);
+}
+
+bool BookPolicy::chooseCancel(const Game& game, const Player& canceller, int actor, const Move& move, Rng& rng) {
+    return _fallback->chooseCancel(game, canceller, actor, move, rng);
+}
+
+}
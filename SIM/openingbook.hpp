@@ -0,0 +1,227 @@
+// idocohen963@gmail.com
+#ifndef OPENINGBOOK_HPP
+#define OPENINGBOOK_HPP
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <vector>
+#include "campaign.hpp"
+
+/**
+ * @file openingbook.hpp
+ * @brief Opening book: the best first moves of every lineup, found by simulation and stored in
+ * a hash table that is read back as is.
+ *
+ * File layout (fixed width little endian integers):
+ *   header:  "CPB1", slot count (4 bytes, a power of two), entry count (4 bytes), plies (4 bytes)
+ *   slots:   per slot, position key (8 bytes, 0 = empty), move (1 byte, action in bits 0-3 and
+ *            target seat + 1 in bits 4-6), score (1 byte, wins of the move out of 255),
+ *            visits (2 bytes, saturated)
+ * Slots are in table order (linear probing from the low bits of the key), so a reader loads the
+ * table with one read and looks positions up without rebuilding it.
+ */
+
+namespace coup {
+
+/**
+ * @brief Returns a 64 bit hash of a position: roles, coins and flags of every seat, the player
+ * to move and the last action. Never 0.
+ * @param state The position.
+ * @return The key.
+ */
+uint64_t positionKey(const GameSnapshot& state);
+
+/**
+ * @struct BookEntry
+ * @brief The book move of one position.
+ */
+struct BookEntry {
+    uint64_t key;     ///< Position key, 0 for an empty slot
+    Move move;        ///< The move with the best score
+    double score;     ///< Share of the games won by the player who made the move
+    uint32_t visits;  ///< Games that played the move from this position (saturated at 65535)
+};
+
+/**
+ * @class OpeningBook
+ * @brief Hash table from position keys to book moves, with open addressing and linear probing.
+ *
+ * The table is at most half full, so a lookup (hit or miss) probes about two slots. A key is
+ * 64 bits and the full key is compared, so two positions share an entry only on a hash collision.
+ */
+class OpeningBook {
+public:
+    /**
+     * @brief Constructor. An empty book.
+     * @param plies Moves from the start of a game the book was built for.
+     */
+    explicit OpeningBook(int plies = 0);
+
+    /**
+     * @brief Adds or replaces the move of a position, growing the table as needed.
+     * @param entry The position and its move.
+     */
+    void insert(const BookEntry& entry);
+
+    /**
+     * @brief Looks a position up.
+     * @param key The position key.
+     * @param out Receives the entry, if found.
+     * @return true if the position is in the book.
+     */
+    bool find(uint64_t key, BookEntry& out) const;
+
+    /**
+     * @brief Looks the move of a game position up.
+     * @param state The position.
+     * @param move Receives the book move, if found.
+     * @return true if the position is in the book.
+     */
+    bool find(const GameSnapshot& state, Move& move) const;
+
+    /**
+     * @brief Returns the number of positions in the book.
+     * @return The number of entries.
+     */
+    size_t size() const { return _size; }
+
+    /**
+     * @brief Returns the number of slots of the table.
+     * @return A power of two, at least twice size().
+     */
+    size_t slots() const { return _slots.size(); }
+
+    /**
+     * @brief Returns the moves per game the book was built for.
+     * @return The plies.
+     */
+    int plies() const { return _plies; }
+
+    /**
+     * @brief Returns the size of the book file.
+     * @return Bytes written by write().
+     */
+    uint64_t fileSize() const;
+
+    /**
+     * @brief Writes the book.
+     * @param out The stream to write to (opened in binary mode).
+     * @throws std::runtime_error if the stream failed.
+     */
+    void write(std::ostream& out) const;
+
+    /**
+     * @brief Reads a book written by write().
+     * @param in The stream to read from (opened in binary mode).
+     * @return The book.
+     * @throws std::runtime_error if the stream is not a valid book.
+     */
+    static OpeningBook read(std::istream& in);
+
+private:
+    /**
+     * @brief One slot of the table, as stored in the file.
+     */
+    struct Slot {
+        uint64_t key;
+        uint8_t move;
+        uint8_t score;
+        uint16_t visits;
+    };
+
+    std::vector<Slot> _slots;
+    size_t _size;
+    int _plies;
+
+    size_t probe(uint64_t key) const;
+    void grow();
+};
+
+/**
+ * @struct BookConfig
+ * @brief Parameters of the simulation that builds a book.
+ */
+struct BookConfig {
+    int plies = 4;                      ///< Moves from the start of a game covered by the book
+    uint64_t gamesPerLineup = 1000000;  ///< Simulated games of every lineup
+    uint32_t minVisits = 64;            ///< Games a move needs before it can be a book move
+    uint64_t seed = 1;                  ///< Base seed of the games
+    uint64_t shardSize = 4096;          ///< Games per task
+    int maxActions = 1000;              ///< Action limit per game, a draw when reached
+};
+
+/**
+ * @struct BookStats
+ * @brief Work done while building a book.
+ */
+struct BookStats {
+    uint64_t games = 0;      ///< Games simulated
+    uint64_t positions = 0;  ///< Distinct positions met within the plies
+    uint64_t entries = 0;    ///< Positions with a move of enough visits, stored in the book
+    double seconds = 0;      ///< Time spent
+};
+
+/**
+ * @brief Builds a book by simulation.
+ *
+ * Every game of every lineup picks its first moves uniformly, so every move of the positions
+ * met gets visits, then the rollout policy plays the game out. Every opening move is credited
+ * with a win if the player who made it won the game. The book move of a position is the move
+ * with the best share of wins among those with enough visits. Games are split in shards seeded
+ * from (seed, shard) and the counts are merged and sorted before the table is filled, so the
+ * book (and its file) depends only on the configuration, not on the number of threads.
+ *
+ * @param config The build parameters.
+ * @param lineups The lineups to cover.
+ * @param pool The pool to run on.
+ * @param makeRollout Creates the policy playing after the opening, once per worker (random if null).
+ * @param stats Receives the work done, if not null.
+ * @return The book.
+ * @throws std::invalid_argument if no lineup is given or the plies are not positive.
+ */
+OpeningBook buildOpeningBook(const BookConfig& config, const std::vector<Lineup>& lineups, WorkStealingPool& pool,
+                             const PolicyFactory& makeRollout = nullptr, BookStats* stats = nullptr);
+
+/**
+ * @class BookPolicy
+ * @brief Plays the book move while the position is in the book, and asks another policy otherwise.
+ *
+ * A lookup hashes the position and probes the table, so the opening costs no search; cancel
+ * answers are always left to the other policy.
+ */
+class BookPolicy : public Policy {
+public:
+    /**
+     * @brief Constructor.
+     * @param book The book, shared between the workers.
+     * @param fallback Policy used outside the book.
+     */
+    BookPolicy(std::shared_ptr<const OpeningBook> book, std::unique_ptr<Policy> fallback);
+
+    size_t chooseMove(const Game& game, const std::vector<Move>& moves, Rng& rng) override;
+    bool chooseCancel(const Game& game, const Player& canceller, int actor, const Move& move, Rng& rng) override;
+
+    /**
+     * @brief Returns the number of moves taken from the book.
+     * @return The hits.
+     */
+    uint64_t hits() const { return _hits; }
+
+    /**
+     * @brief Returns the number of moves the fallback policy was asked for.
+     * @return The misses.
+     */
+    uint64_t misses() const { return _misses; }
+
+private:
+    std::shared_ptr<const OpeningBook> _book;
+    std::unique_ptr<Policy> _fallback;
+    GameSnapshot _state;  ///< The position being looked up
+    uint64_t _hits;
+    uint64_t _misses;
+};
+
+}
+#endif
@@ -0,0 +1,316 @@
+// idocohen963@gmail.com
+#include "search.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+/**
+ * @file search.cpp
+ * @brief Implementation of the search bot: iterative deepening over paranoid alpha-beta or max-n.
+ */
+
+namespace coup {
+
+namespace {
+
+const double INF = std::numeric_limits<double>::infinity();
+
+/**
+ * @brief Rank of an action in the move ordering, higher first.
+ */
+int actionRank(ActionType action) {
+    switch (action) {
+        case ActionType::Coup: return 7;
+        case ActionType::Arrest: return 6;
+        case ActionType::Tax: return 5;
+        case ActionType::Sanction: return 4;
+        case ActionType::Invest: return 3;
+        case ActionType::Bribe: return 2;
+        case ActionType::Gather: return 1;
+        default: return 0;
+    }
+}
+
+}
+
+SearchPolicy::SearchPolicy(const SearchConfig& config)
+    : _config(config), _scratch(Game::create()), _root(0), _nodes(0), _abortable(false), _aborted(false) {
+    _config.maxDepth = std::max(1, _config.maxDepth);
+    _moves.resize(_config.maxDepth + 1);
+    for (std::vector<Move>& moves : _moves) {
+        moves.reserve(4 + 4 * MAX_PLAYERS);
+    }
+    _rootMoves.reserve(4 + 4 * MAX_PLAYERS);
+}
+
+/**
+ * @brief Searches every root move one more turn ahead per iteration, the best one so far first,
+ * and keeps the choice of the deepest iteration the budget let finish.
+ */
+size_t SearchPolicy::chooseMove(const Game& game, const std::vector<Move>& moves, Rng& rng) {
+    (void)rng; // The search is deterministic
+    if (moves.size() == 1) {
+        return 0;
+    }
+    auto start = std::chrono::steady_clock::now();
+    Game::Binding binding(*_scratch); // The Player actions of the search reach the scratch game
+    load(game);
+    _rootMoves.assign(moves.begin(), moves.end());
+    order(_rootMoves);
+
+    int completed = 0;
+    for (int depth = 1; depth <= _config.maxDepth; ++depth) {
+        _abortable = depth > 1;
+        double alpha = -INF;
+        size_t best = 0;
+        for (size_t i = 0; i < _rootMoves.size() && !_aborted; ++i) {
+            _scratch->restore(_rootState);
+            Simulator::applyMove(*_scratch, _rootMoves[i]);
+            Values value = window(0, _root, _rootMoves[i], depth, alpha, INF);
+            if (!_aborted && value.seat[_root] > alpha) {
+                alpha = value.seat[_root];
+                best = i;
+            }
+        }
+        if (_aborted) {
+            break;
+        }
+        std::rotate(_rootMoves.begin(), _rootMoves.begin() + best, _rootMoves.begin() + best + 1);
+        completed = depth;
+    }
+    finish(start, completed);
+
+    const Move& chosen = _rootMoves.front();
+    for (size_t i = 0; i < moves.size(); ++i) {
+        if (moves[i].action == chosen.action && moves[i].target == chosen.target) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Compares cancelling with letting the window go on, searched to the same depth.
+ * Ties keep the action, so a General never pays for a cancel that changes nothing.
+ */
+bool SearchPolicy::chooseCancel(const Game& game, const Player& canceller, int actor, const Move& move, Rng& rng) {
+    (void)rng;
+    const std::vector<Player*>& players = game.getPlayers();
+    size_t seat = std::find(players.begin(), players.end(), &canceller) - players.begin();
+    if (seat == players.size()) {
+        throw std::runtime_error("The canceller is not seated in the game");
+    }
+    auto start = std::chrono::steady_clock::now();
+    Game::Binding binding(*_scratch);
+    load(game);
+    _root = static_cast<int>(seat);
+
+    bool cancel = false;
+    int completed = 0;
+    for (int depth = 1; depth <= _config.maxDepth; ++depth) {
+        _abortable = depth > 1;
+        _scratch->restore(_rootState);
+        Values pass = window(seat + 1, actor, move, depth, -INF, INF);
+        if (_aborted) {
+            break;
+        }
+        _scratch->restore(_rootState);
+        try {
+            Simulator::applyCancel(*_scratch, _root, actor, move);
+        } catch (const std::runtime_error&) {
+            break; // The rules refuse it, the answer does not matter
+        }
+        Values cancelled = turn(depth - 1, pass.seat[_root], INF);
+        if (_aborted) {
+            break;
+        }
+        cancel = cancelled.seat[_root] > pass.seat[_root];
+        completed = depth;
+    }
+    finish(start, completed);
+    return cancel;
+}
+
+/**
+ * @brief Seats the roles of the game on the scratch game if they changed, and copies the position.
+ * The searching player is the current one; chooseCancel() changes it after.
+ */
+void SearchPolicy::load(const Game& game) {
+    const std::vector<Player*>& players = game.getPlayers();
+    bool seated = players.size() == _lineup.size();
+    for (size_t i = 0; seated && i < players.size(); ++i) {
+        seated = players[i]->getRole() == _lineup[i];
+    }
+    if (!seated) {
+        _lineup.clear();
+        for (const Player* player : players) {
+            _lineup.push_back(player->getRole());
+        }
+        Simulator::seatLineup(*_scratch, _lineup);
+    }
+    game.snapshot(_rootState);
+    _scratch->restore(_rootState);
+    _root = game.getCurrentPlayerIndex();
+    _nodes = 0;
+    _aborted = false;
+}
+
+void SearchPolicy::finish(std::chrono::steady_clock::time_point start, int depth) {
+    _stats.decisions++;
+    _stats.nodes += _nodes;
+    _stats.depths += depth;
+    _stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Searches the turn of the current player: a leaf at depth 0 or when the game is over,
+ * a pass when the player has no legal move, otherwise the best of the moves for the mover.
+ */
+SearchPolicy::Values SearchPolicy::turn(int depth, double alpha, double beta) {
+    Game& game = *_scratch;
+    if (outOfBudget()) {
+        return Values();
+    }
+    if (depth == 0 || Simulator::countActive(game) <= 1) {
+        return evaluate();
+    }
+    if (!game.getCurrentPlayer()->isActive()) {
+        game.nextTurn();
+    }
+    std::vector<Move>& moves = _moves[depth];
+    Simulator::legalMoves(game, moves);
+    if (moves.empty()) {
+        Simulator::passTurn(game);
+        return turn(depth - 1, alpha, beta);
+    }
+    order(moves);
+    const int mover = game.getCurrentPlayerIndex();
+    GameSnapshot before;
+    game.snapshot(before);
+    Values best = Values();
+    for (size_t i = 0; i < moves.size(); ++i) {
+        if (i > 0) {
+            game.restore(before);
+        }
+        Simulator::applyMove(game, moves[i]);
+        Values value = window(0, mover, moves[i], depth, alpha, beta);
+        if (_aborted) {
+            return best;
+        }
+        if (i == 0 || prefers(mover, value, best)) {
+            best = value;
+        }
+        bound(mover, best, alpha, beta);
+        if (alpha >= beta) {
+            break;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Searches the cancel window of a move from a seat on: the next player able to cancel
+ * picks the better of cancelling (which ends the window) and letting the next ones decide.
+ */
+SearchPolicy::Values SearchPolicy::window(size_t from, int actor, const Move& move, int depth, double alpha, double beta) {
+    Game& game = *_scratch;
+    const std::vector<Player*>& players = game.getPlayers();
+    for (size_t i = from; i < players.size(); ++i) {
+        const Player* p = players[i];
+        if (static_cast<int>(i) == actor || !p->isActive() || !p->canCancel(move.action)) {
+            continue;
+        }
+        if (p->getRole() == Role::General && p->getCoins() < 5) {
+            continue;
+        }
+        const int canceller = static_cast<int>(i);
+        GameSnapshot before;
+        game.snapshot(before);
+        Values pass = window(i + 1, actor, move, depth, alpha, beta);
+        if (_aborted) {
+            return pass;
+        }
+        bound(canceller, pass, alpha, beta);
+        if (alpha >= beta) {
+            return pass;
+        }
+        game.restore(before);
+        try {
+            Simulator::applyCancel(game, canceller, actor, move);
+        } catch (const std::runtime_error&) {
+            return pass;
+        }
+        Values cancelled = turn(depth - 1, alpha, beta);
+        if (_aborted) {
+            return pass;
+        }
+        return prefers(canceller, cancelled, pass) ? cancelled : pass;
+    }
+    return turn(depth - 1, alpha, beta);
+}
+
+SearchPolicy::Values SearchPolicy::evaluate() {
+    Values values;
+    _scratch->snapshot(_leaf);
+    evaluatePosition(_leaf, _config.weights, values.seat);
+    return values;
+}
+
+/**
+ * @brief Returns whether a player choosing between two outcomes takes the first one.
+ * In paranoid mode the searching player maximises their value and everyone else minimises it.
+ */
+bool SearchPolicy::prefers(int seat, const Values& a, const Values& b) const {
+    if (_config.mode == SearchMode::MaxN) {
+        return a.seat[seat] > b.seat[seat];
+    }
+    return seat == _root ? a.seat[_root] > b.seat[_root] : a.seat[_root] < b.seat[_root];
+}
+
+/**
+ * @brief Narrows the alpha-beta window with the outcome a player can already reach.
+ * Max-n keeps the window open, nothing can be pruned there.
+ */
+void SearchPolicy::bound(int seat, const Values& value, double& alpha, double& beta) const {
+    if (_config.mode == SearchMode::MaxN) {
+        return;
+    }
+    if (seat == _root) {
+        alpha = std::max(alpha, value.seat[_root]);
+    } else {
+        beta = std::min(beta, value.seat[_root]);
+    }
+}
+
+/**
+ * @brief Counts a node, and stops the current depth once it goes over the budget.
+ */
+bool SearchPolicy::outOfBudget() {
+    if (++_nodes > _config.nodeBudget && _abortable) {
+        _aborted = true;
+    }
+    return _aborted;
+}
+
+/**
+ * @brief Sorts moves by action rank, then by coins of the target, with an insertion sort:
+ * the lists are short and the search must not allocate.
+ */
+void SearchPolicy::order(std::vector<Move>& moves) const {
+    const std::vector<Player*>& players = _scratch->getPlayers();
+    auto key = [&players](const Move& move) {
+        int coins = move.target >= 0 ? std::min(15, players[move.target]->getCoins()) : 0;
+        return actionRank(move.action) * 16 + coins;
+    };
+    for (size_t i = 1; i < moves.size(); ++i) {
+        Move move = moves[i];
+        int rank = key(move);
+        size_t j = i;
+        for (; j > 0 && key(moves[j - 1]) < rank; --j) {
+            moves[j] = moves[j - 1];
+        }
+        moves[j] = move;
+    }
+}
+
+}
@@ -0,0 +1,128 @@
+// idocohen963@gmail.com
+#ifndef SEARCH_HPP
+#define SEARCH_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "evaluator.hpp"
+#include "simulator.hpp"
+
+/**
+ * @file search.hpp
+ * @brief Deterministic game tree search bot.
+ */
+
+namespace coup {
+
+/**
+ * @enum SearchMode
+ * @brief How the opponents are assumed to play.
+ */
+enum class SearchMode : uint8_t {
+    Paranoid,  ///< Every opponent plays against the searching player (alpha-beta pruning applies)
+    MaxN       ///< Every player plays for themselves (no pruning, the node budget bounds the search)
+};
+
+/**
+ * @struct SearchConfig
+ * @brief Parameters of the search bot.
+ */
+struct SearchConfig {
+    SearchMode mode = SearchMode::Paranoid;
+    int maxDepth = 4;             ///< Turns searched ahead at most
+    uint64_t nodeBudget = 20000;  ///< Nodes per decision; depth 1 is always completed
+    EvalWeights weights = defaultWeights();  ///< Weights of the leaf evaluation
+};
+
+/**
+ * @struct SearchStats
+ * @brief Work done by a search bot so far.
+ */
+struct SearchStats {
+    uint64_t decisions = 0;  ///< Moves and cancel answers searched
+    uint64_t nodes = 0;      ///< Nodes visited
+    uint64_t depths = 0;     ///< Sum over the decisions of the deepest completed depth
+    double seconds = 0;      ///< Time spent searching
+
+    /**
+     * @brief Returns the search speed.
+     * @return Nodes per second, or 0 before the first search.
+     */
+    double nodesPerSecond() const { return seconds > 0 ? nodes / seconds : 0; }
+
+    /**
+     * @brief Returns the average depth reached.
+     * @return Completed depth per decision, or 0 before the first search.
+     */
+    double averageDepth() const { return decisions > 0 ? static_cast<double>(depths) / decisions : 0; }
+};
+
+/**
+ * @class SearchPolicy
+ * @brief Policy that searches the game tree a few turns ahead instead of sampling.
+ *
+ * A turn of the tree is the move of the current player followed by its cancel window, where
+ * every player able to cancel (Judge, Governor, General with 5 coins...) decides in seat order,
+ * like Simulator::step() asks them; a cancel refused by the rules moves on to the next one.
+ * Positions are played on a private Game through the Player rules and rewound with
+ * Game::snapshot() and Game::restore(), so the game being played is never touched.
+ *
+ * The search deepens one turn at a time until maxDepth or until the node budget runs out; the
+ * deepest completed depth decides, and its best move is searched first at the next depth. Moves
+ * are ordered coup, arrest, tax, sanction, invest, bribe, gather, spy, the richest targets first,
+ * so alpha-beta cuts early. Leaves are scored by evaluatePosition() with the configured weights.
+ * The search draws no random numbers: the same position gets the same answer.
+ */
+class SearchPolicy : public Policy {
+public:
+    /**
+     * @brief Constructor.
+     * @param config The search parameters.
+     */
+    explicit SearchPolicy(const SearchConfig& config = SearchConfig());
+
+    size_t chooseMove(const Game& game, const std::vector<Move>& moves, Rng& rng) override;
+    bool chooseCancel(const Game& game, const Player& canceller, int actor, const Move& move, Rng& rng) override;
+
+    /**
+     * @brief Returns the work done so far.
+     * @return The counters of all the searches.
+     */
+    const SearchStats& stats() const { return _stats; }
+
+private:
+    /**
+     * @brief The value of a position for every seat, between 0 (out) and 1 (won).
+     */
+    struct Values {
+        double seat[MAX_PLAYERS];
+    };
+
+    SearchConfig _config;
+    SearchStats _stats;
+    std::unique_ptr<Game> _scratch;          ///< The game the search plays on
+    Lineup _lineup;                          ///< Roles seated on _scratch
+    std::vector<std::vector<Move>> _moves;   ///< Move buffer of every remaining depth
+    std::vector<Move> _rootMoves;            ///< The root moves, best first
+    GameSnapshot _rootState;
+    GameSnapshot _leaf;                      ///< The position being evaluated
+    int _root;                               ///< Seat of the searching player
+    uint64_t _nodes;                         ///< Nodes of the current decision
+    bool _abortable;                         ///< Whether the budget may stop the current depth
+    bool _aborted;                           ///< Whether the budget stopped the current depth
+
+    void load(const Game& game);
+    void finish(std::chrono::steady_clock::time_point start, int depth);
+    Values turn(int depth, double alpha, double beta);
+    Values window(size_t from, int actor, const Move& move, int depth, double alpha, double beta);
+    Values evaluate();
+    bool prefers(int seat, const Values& a, const Values& b) const;
+    void bound(int seat, const Values& value, double& alpha, double& beta) const;
+    bool outOfBudget();
+    void order(std::vector<Move>& moves) const;
+};
+
+}
+#endif
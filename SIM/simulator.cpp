@@ -0,0 +1,313 @@
+// idocohen963@gmail.com
+#include "simulator.hpp"
+#include <algorithm>
+#include <string>
+
+/**
+ * @file simulator.cpp
+ * @brief Implementation of headless game simulation.
+ *
+ * This file contains the legal move generator, the move application logic
+ * (which delegates to the Player actions so the rules live in one place),
+ * the cancel window handling and the game loop used by simulation tools.
+ */
+
+namespace coup {
+
+/**
+ * @brief Returns the role name as accepted by the PlayerFactory.
+ */
+const char* roleName(Role role) {
+    switch (role) {
+        case Role::Spy: return "Spy";
+        case Role::Merchant: return "Merchant";
+        case Role::General: return "General";
+        case Role::Governor: return "Governor";
+        case Role::Judge: return "Judge";
+        case Role::Baron: return "Baron";
+    }
+    return "Unknown";
+}
+
+/**
+ * @brief Returns the name of an action type.
+ */
+const char* actionName(ActionType action) {
+    switch (action) {
+        case ActionType::Gather: return "Gather";
+        case ActionType::Tax: return "Tax";
+        case ActionType::Bribe: return "Bribe";
+        case ActionType::Arrest: return "Arrest";
+        case ActionType::Coup: return "Coup";
+        case ActionType::Sanction: return "Sanction";
+        case ActionType::Invest: return "Invest";
+        case ActionType::SpyOn: return "SpyOn";
+        case ActionType::cancel: return "Cancel";
+    }
+    return "Unknown";
+}
+
+/**
+ * @brief Picks a uniformly random legal move.
+ */
+size_t RandomPolicy::chooseMove(const Game& game, const std::vector<Move>& moves, Rng& rng) {
+    (void)game; // Avoid unused parameter warning
+    return std::uniform_int_distribution<size_t>(0, moves.size() - 1)(rng);
+}
+
+/**
+ * @brief Cancels with the configured probability.
+ */
+bool RandomPolicy::chooseCancel(const Game& game, const Player& canceller, int actor, const Move& move, Rng& rng) {
+    (void)game;      // Avoid unused parameter warning
+    (void)canceller; // Avoid unused parameter warning
+    (void)actor;     // Avoid unused parameter warning
+    (void)move;      // Avoid unused parameter warning
+    return std::bernoulli_distribution(_cancelProbability)(rng);
+}
+
+/**
+ * @brief Asks the policy of the current player.
+ */
+size_t SeatPolicies::chooseMove(const Game& game, const std::vector<Move>& moves, Rng& rng) {
+    return _seats.at(game.getCurrentPlayerIndex())->chooseMove(game, moves, rng);
+}
+
+/**
+ * @brief Asks the policy of the seat of the canceller.
+ */
+bool SeatPolicies::chooseCancel(const Game& game, const Player& canceller, int actor, const Move& move, Rng& rng) {
+    const std::vector<Player*>& players = game.getPlayers();
+    size_t seat = std::find(players.begin(), players.end(), &canceller) - players.begin();
+    return _seats.at(seat)->chooseCancel(game, canceller, actor, move, rng);
+}
+
+/**
+ * @brief Constructor. Reserves the move buffer for the largest possible move list.
+ */
+Simulator::Simulator(Policy& policy, int maxActions)
+    : _policy(policy), _maxActions(maxActions), _observer(nullptr), _actionIndex(0) {
+    _moves.reserve(4 + 4 * MAX_PLAYERS);
+}
+
+/**
+ * @brief Counts the players still in the game.
+ */
+int Simulator::countActive(const Game& game) {
+    int active = 0;
+    for (const Player* player : game.getPlayers()) {
+        if (player->isActive()) {
+            active++;
+        }
+    }
+    return active;
+}
+
+/**
+ * @brief Lists the legal moves of the current player.
+ *
+ * The conditions are the same ones checked (in the same order of priority) by
+ * Player::gather, tax, bribe, arrest, sanction, coup and the role specific actions.
+ */
+void Simulator::legalMoves(const Game& game, std::vector<Move>& out) {
+    out.clear();
+    const std::vector<Player*>& players = game.getPlayers();
+    const Player* self = game.getCurrentPlayer();
+    if (!self->isActive()) {
+        return;
+    }
+    const int coins = self->getCoins();
+    const bool mustCoup = coins >= 10;
+    const bool sanctioned = self->isSanctioned();
+
+    if (!mustCoup) {
+        if (!sanctioned) {
+            out.push_back({ActionType::Gather, -1});
+            out.push_back({ActionType::Tax, -1});
+            if (self->getRole() == Role::Baron && coins >= 3) {
+                out.push_back({ActionType::Invest, -1});
+            }
+        }
+        if (coins >= 4) {
+            out.push_back({ActionType::Bribe, -1});
+        }
+    }
+
+    for (size_t i = 0; i < players.size(); ++i) {
+        const Player* other = players[i];
+        if (other == self || !other->isActive()) {
+            continue;
+        }
+        const int target = static_cast<int>(i);
+        if (coins >= 7) {
+            out.push_back({ActionType::Coup, target});
+        }
+        if (mustCoup) {
+            continue;
+        }
+        // Arrest: the target must be able to lose coins and must not have been the last one arrested
+        int minCoins = (other->getRole() == Role::Merchant) ? 2 : 1;
+        if (self->isCanArrest() && !other->isLastArrested() && other->getCoins() >= minCoins) {
+            out.push_back({ActionType::Arrest, target});
+        }
+        // Sanction: sanctioning a Judge costs one extra coin
+        int sanctionCost = (other->getRole() == Role::Judge) ? 4 : 3;
+        if (coins >= sanctionCost && !other->isSanctioned()) {
+            out.push_back({ActionType::Sanction, target});
+        }
+        if (self->getRole() == Role::Spy && !sanctioned && other->isCanArrest()) {
+            out.push_back({ActionType::SpyOn, target});
+        }
+    }
+}
+
+/**
+ * @brief Applies a move for the current player through the Player interface.
+ */
+void Simulator::applyMove(Game& game, const Move& move) {
+    Player* self = game.getCurrentPlayer();
+    Player* target = (move.target >= 0) ? game.getPlayers()[move.target] : nullptr;
+    switch (move.action) {
+        case ActionType::Gather: self->gather(); break;
+        case ActionType::Tax: self->tax(); break;
+        case ActionType::Bribe: self->bribe(); break;
+        case ActionType::Invest: self->invest(); break;
+        case ActionType::Arrest: self->arrest(*target); break;
+        case ActionType::Sanction: self->sanction(*target); break;
+        case ActionType::Coup: self->coup(*target); break;
+        case ActionType::SpyOn: self->spyOn(*target); break;
+        case ActionType::cancel: throw std::runtime_error("cancel is not a turn action");
+    }
+}
+
+/**
+ * @brief Cancels a move on behalf of another player.
+ */
+void Simulator::applyCancel(Game& game, int canceller, int actor, const Move& move) {
+    const std::vector<Player*>& players = game.getPlayers();
+    // The target of the cancel depends on the original action
+    Player* cancelled = (move.action == ActionType::Coup) ? players[move.target] : players[actor];
+    players[canceller]->cancel(*cancelled);
+}
+
+/**
+ * @brief Seats a lineup on a fresh table.
+ */
+void Simulator::seatLineup(Game& game, const Lineup& lineup) {
+    static const char* const SEAT_NAMES[MAX_PLAYERS] = {"P0", "P1", "P2", "P3", "P4", "P5"};
+    if (lineup.size() < 2 || lineup.size() > MAX_PLAYERS) {
+        throw std::runtime_error("Illegal number of players to start the game");
+    }
+    game.reset();
+    game.setVerbose(false);
+    for (size_t i = 0; i < lineup.size(); ++i) {
+        game.addPlayer(SEAT_NAMES[i], roleName(lineup[i]));
+    }
+    game.startGame();
+}
+
+/**
+ * @brief Passes the turn of a player without legal moves.
+ * A pending bribe is forfeited so the next player's action advances the turn normally.
+ */
+void Simulator::passTurn(Game& game) {
+    Player* self = game.getCurrentPlayer();
+    game.nextTurn();
+    self->setSanctioned(false); // The sanction only lasts for one turn
+    self->setCanArrest(true);   // So does the Spy's arrest block
+    if (game.getLastStep() == ActionType::Bribe) {
+        game.setLastStep(ActionType::Gather);
+    }
+}
+
+/**
+ * @brief Plays one move of the current player followed by the cancel window.
+ *
+ * Players able to cancel the action are asked in seat order, the first one who accepts cancels it,
+ * exactly like the GUI does. A General is only asked if they can afford the 5 coin cancel.
+ * A cancel rejected by the rules counts as a failed attempt and the next player is asked.
+ */
+void Simulator::step(Game& game, Rng& rng) {
+    const int index = _actionIndex++;
+    if (!game.getCurrentPlayer()->isActive()) {
+        game.nextTurn();
+    }
+    legalMoves(game, _moves);
+    if (_moves.empty()) {
+        passTurn(game);
+        return;
+    }
+    const Move move = _moves[_policy.chooseMove(game, _moves, rng)];
+    const std::vector<Player*>& players = game.getPlayers();
+    Player* self = game.getCurrentPlayer();
+    Player* target = (move.target >= 0) ? players[move.target] : nullptr;
+    const int actor = game.getCurrentPlayerIndex();
+    ActionEvent event{index, actor, self->getRole(), move.action, move.target,
+                      self->getCoins(), 0, target ? target->getCoins() : 0, 0, -1};
+    applyMove(game, move);
+
+    for (size_t i = 0; i < players.size(); ++i) {
+        Player* other = players[i];
+        if (other == self || !other->isActive() || !other->canCancel(move.action)) {
+            continue;
+        }
+        if (other->getRole() == Role::General && other->getCoins() < 5) {
+            continue;
+        }
+        CancelEvent cancel{index, static_cast<int>(i), other->getRole(), move.action, false, false};
+        cancel.attempted = _policy.chooseCancel(game, *other, actor, move, rng);
+        if (cancel.attempted) {
+            try {
+                applyCancel(game, cancel.canceller, actor, move);
+                cancel.succeeded = true;
+                event.canceller = cancel.canceller;
+            } catch (const std::runtime_error&) {
+                cancel.succeeded = false;
+            }
+        }
+        if (_observer) {
+            _observer->onCancel(cancel);
+        }
+        if (cancel.succeeded) {
+            break; // Only one player can cancel
+        }
+    }
+
+    if (_observer) {
+        event.actorCoinsAfter = self->getCoins();
+        event.targetCoinsAfter = target ? target->getCoins() : 0;
+        _observer->onAction(event);
+    }
+}
+
+/**
+ * @brief Plays a complete game from a fresh table on the calling thread's Game.
+ */
+GameResult Simulator::playGame(const Lineup& lineup, Rng& rng, uint64_t gameId) {
+    Game& game = Game::getInstance();
+    seatLineup(game, lineup);
+    _actionIndex = 0;
+    if (_observer) {
+        _observer->onGameStart(gameId, lineup);
+    }
+
+    GameResult result{-1, 0};
+    while (_actionIndex < _maxActions && countActive(game) > 1) {
+        step(game, rng);
+    }
+    result.actions = _actionIndex;
+    if (countActive(game) == 1) {
+        const std::vector<Player*>& players = game.getPlayers();
+        for (size_t i = 0; i < players.size(); ++i) {
+            if (players[i]->isActive()) {
+                result.winner = static_cast<int>(i);
+            }
+        }
+    }
+    if (_observer) {
+        _observer->onGameEnd(lineup, result);
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,332 @@
+// idocohen963@gmail.com
+#ifndef SIMULATOR_HPP
+#define SIMULATOR_HPP
+
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+#include "GAME/game.hpp"
+#include "PLAYER/player.hpp"
+
+/**
+ * @file simulator.hpp
+ * @brief Headless game simulation on top of the Game/Player rules.
+ *
+ * This file declares the building blocks used by every simulation tool:
+ * a Move representation, the enumeration of legal moves for the current player,
+ * the Policy interface used by bots to pick moves and cancel responses,
+ * and the Simulator class that plays a full game on the calling thread's Game instance.
+ */
+
+namespace coup {
+
+/**
+ * @brief Number of different roles in the game (size of the Role enum).
+ */
+constexpr int ROLE_COUNT = 6;
+
+/**
+ * @brief Number of different action types in the game (size of the ActionType enum).
+ */
+constexpr int ACTION_COUNT = 9;
+
+/**
+ * @brief Maximum number of players in a game.
+ */
+constexpr int MAX_PLAYERS = 6;
+
+/**
+ * @brief The list of roles seated at a table, in turn order.
+ */
+using Lineup = std::vector<Role>;
+
+/**
+ * @brief Random engine used by all simulation code.
+ */
+using Rng = std::mt19937_64;
+
+/**
+ * @struct Move
+ * @brief A single action the current player can take.
+ */
+struct Move {
+    ActionType action;  ///< The action to perform
+    int target;         ///< Index of the target in Game::getPlayers(), or -1 for untargeted actions
+};
+
+/**
+ * @brief Returns the role name as accepted by the PlayerFactory ("Spy", "Governor", ...).
+ * @param role The role.
+ * @return The role name.
+ */
+const char* roleName(Role role);
+
+/**
+ * @brief Returns the name of an action type ("Gather", "Tax", ...).
+ * @param action The action type.
+ * @return The action name.
+ */
+const char* actionName(ActionType action);
+
+/**
+ * @class Policy
+ * @brief Decision interface for simulated players.
+ *
+ * A policy is asked to pick one of the legal moves on the current player's turn,
+ * and to decide whether a player able to cancel the announced action does so.
+ */
+class Policy {
+public:
+    /**
+     * @brief Virtual destructor.
+     */
+    virtual ~Policy() = default;
+
+    /**
+     * @brief Chooses a move for the current player.
+     * @param game The game being played.
+     * @param moves The legal moves (never empty).
+     * @param rng Random engine of the calling worker.
+     * @return Index of the chosen move in moves.
+     */
+    virtual size_t chooseMove(const Game& game, const std::vector<Move>& moves, Rng& rng) = 0;
+
+    /**
+     * @brief Decides whether a player cancels the action that was just performed.
+     * @param game The game being played (after the action was applied).
+     * @param canceller The player that is able to cancel.
+     * @param actor Index of the player who performed the action.
+     * @param move The action that was performed.
+     * @param rng Random engine of the calling worker.
+     * @return true to cancel the action.
+     */
+    virtual bool chooseCancel(const Game& game, const Player& canceller, int actor, const Move& move, Rng& rng) = 0;
+};
+
+/**
+ * @class RandomPolicy
+ * @brief Policy that picks a uniformly random legal move and cancels with a fixed probability.
+ */
+class RandomPolicy : public Policy {
+private:
+    double _cancelProbability;  ///< Probability of cancelling when possible
+
+public:
+    /**
+     * @brief Constructor.
+     * @param cancelProbability Probability that a player able to cancel does so.
+     */
+    explicit RandomPolicy(double cancelProbability = 0.5) : _cancelProbability(cancelProbability) {}
+
+    size_t chooseMove(const Game& game, const std::vector<Move>& moves, Rng& rng) override;
+    bool chooseCancel(const Game& game, const Player& canceller, int actor, const Move& move, Rng& rng) override;
+};
+
+/**
+ * @class SeatPolicies
+ * @brief Policy that hands every decision to the policy of the deciding seat, so different bots
+ * can play at one table.
+ */
+class SeatPolicies : public Policy {
+private:
+    std::vector<Policy*> _seats;  ///< Policy of every seat, not owned
+
+public:
+    /**
+     * @brief Constructor.
+     * @param seats Policy of every seat, in seat order; the policies outlive this one.
+     */
+    explicit SeatPolicies(std::vector<Policy*> seats) : _seats(std::move(seats)) {}
+
+    size_t chooseMove(const Game& game, const std::vector<Move>& moves, Rng& rng) override;
+    bool chooseCancel(const Game& game, const Player& canceller, int actor, const Move& move, Rng& rng) override;
+};
+
+/**
+ * @struct GameResult
+ * @brief Outcome of a simulated game.
+ */
+struct GameResult {
+    int winner;   ///< Seat index of the winner, or -1 if the action limit was reached
+    int actions;  ///< Number of actions performed (passes included)
+};
+
+/**
+ * @struct ActionEvent
+ * @brief Description of one action, reported after its cancel window was resolved.
+ */
+struct ActionEvent {
+    int index;              ///< Number of the action within the game, starting at 0 (passes included)
+    int actor;              ///< Seat index of the player who acted
+    Role actorRole;         ///< Role of the player who acted
+    ActionType action;      ///< The action performed
+    int target;             ///< Seat index of the target, or -1
+    int actorCoinsBefore;   ///< Actor's coins before the action
+    int actorCoinsAfter;    ///< Actor's coins after the action and a possible cancel
+    int targetCoinsBefore;  ///< Target's coins before the action (0 without target)
+    int targetCoinsAfter;   ///< Target's coins after the action and a possible cancel (0 without target)
+    int canceller;          ///< Seat index of the player who cancelled the action, or -1
+};
+
+/**
+ * @struct CancelEvent
+ * @brief A player who could cancel an action was asked whether to do so.
+ */
+struct CancelEvent {
+    int index;            ///< Number of the action within the game
+    int canceller;        ///< Seat index of the player who was asked
+    Role cancellerRole;   ///< Role of the player who was asked
+    ActionType action;    ///< The action that could be cancelled
+    bool attempted;       ///< Whether the player chose to cancel
+    bool succeeded;       ///< Whether the cancel was applied
+};
+
+/**
+ * @class GameObserver
+ * @brief Receives the events of simulated games.
+ *
+ * All callbacks have empty default implementations, so observers only override what they need.
+ * An observer is used by a single worker thread and needs no synchronization.
+ */
+class GameObserver {
+public:
+    /**
+     * @brief Virtual destructor.
+     */
+    virtual ~GameObserver() = default;
+
+    /**
+     * @brief Called when a new game starts.
+     * @param gameId Identifier of the game (its index in the campaign).
+     * @param lineup Roles of the players, in seat order.
+     */
+    virtual void onGameStart(uint64_t gameId, const Lineup& lineup) {
+        (void)gameId;
+        (void)lineup;
+    }
+
+    /**
+     * @brief Called after every action and its cancel window.
+     * @param event The action.
+     */
+    virtual void onAction(const ActionEvent& event) { (void)event; }
+
+    /**
+     * @brief Called every time a player is given the chance to cancel an action.
+     * @param event The cancel decision.
+     */
+    virtual void onCancel(const CancelEvent& event) { (void)event; }
+
+    /**
+     * @brief Called when a game ends.
+     * @param lineup Roles of the players, in seat order.
+     * @param result Outcome of the game.
+     */
+    virtual void onGameEnd(const Lineup& lineup, const GameResult& result) {
+        (void)lineup;
+        (void)result;
+    }
+};
+
+/**
+ * @class Simulator
+ * @brief Plays complete games on the calling thread's Game instance.
+ *
+ * The simulator owns its move buffer so that playing a game performs no allocation
+ * beyond the players created by the factory. Game output is silenced while playing.
+ */
+class Simulator {
+private:
+    Policy& _policy;            ///< Policy deciding moves and cancels for all seats
+    int _maxActions;            ///< Actions after which the game is declared a draw
+    std::vector<Move> _moves;   ///< Reused legal move buffer
+    GameObserver* _observer;    ///< Receives the game events, or nullptr
+    int _actionIndex;           ///< Number of actions played in the current game
+
+public:
+    /**
+     * @brief Constructor.
+     * @param policy Policy used for every seat.
+     * @param maxActions Maximum number of actions before a game is declared a draw.
+     */
+    explicit Simulator(Policy& policy, int maxActions = 1000);
+
+    /**
+     * @brief Sets the observer that receives the events of the following games.
+     * @param observer The observer, or nullptr to stop reporting.
+     */
+    void setObserver(GameObserver* observer) { _observer = observer; }
+
+    /**
+     * @brief Plays a complete game from a fresh table.
+     * Resets the calling thread's Game, seats the lineup and plays until one player remains.
+     * @param lineup Roles of the players, in turn order (2-6 roles).
+     * @param rng Random engine used by the policy.
+     * @param gameId Identifier reported to the observer.
+     * @return The outcome of the game.
+     * @throws std::runtime_error if the lineup size is illegal.
+     */
+    GameResult playGame(const Lineup& lineup, Rng& rng, uint64_t gameId = 0);
+
+    /**
+     * @brief Plays a single turn step: one move of the current player and the cancel window after it.
+     * If the current player has no legal move, their turn passes.
+     * @param game The game being played.
+     * @param rng Random engine used by the policy.
+     */
+    void step(Game& game, Rng& rng);
+
+    /**
+     * @brief Lists the legal moves of the current player.
+     * Mirrors the checks performed by the Player actions, so every listed move can be applied without throwing.
+     * @param game The game being played.
+     * @param out Vector that receives the moves (cleared first).
+     */
+    static void legalMoves(const Game& game, std::vector<Move>& out);
+
+    /**
+     * @brief Applies a move for the current player.
+     * @param game The game being played.
+     * @param move The move to apply.
+     * @throws std::runtime_error if the move is illegal.
+     */
+    static void applyMove(Game& game, const Move& move);
+
+    /**
+     * @brief Cancels the move that was just applied, on behalf of another player.
+     * The cancel is aimed at the coup target for a coup and at the actor otherwise.
+     * @param game The game being played.
+     * @param canceller Seat index of the cancelling player.
+     * @param actor Seat index of the player who made the move.
+     * @param move The move to cancel.
+     * @throws std::runtime_error if the cancel is not allowed.
+     */
+    static void applyCancel(Game& game, int canceller, int actor, const Move& move);
+
+    /**
+     * @brief Resets the game and seats a lineup on it, with output silenced.
+     * Seats are named "P0" to "P5".
+     * @param game The game to set up.
+     * @param lineup Roles of the players, in turn order (2-6 roles).
+     * @throws std::runtime_error if the lineup size is illegal.
+     */
+    static void seatLineup(Game& game, const Lineup& lineup);
+
+    /**
+     * @brief Passes the turn of a player that has no legal move.
+     * The turn-scoped flags (sanction, arrest block) expire as they would after an action.
+     * @param game The game being played.
+     */
+    static void passTurn(Game& game);
+
+    /**
+     * @brief Returns the number of active players.
+     * @param game The game.
+     * @return Number of players still in the game.
+     */
+    static int countActive(const Game& game);
+};
+
+}
+#endif
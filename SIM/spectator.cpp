@@ -0,0 +1,188 @@
+// idocohen963@gmail.com
+#include "spectator.hpp"
+#include "campaign.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace coup {
+
+namespace {
+const int PAUSE_STEPS = 10;  ///< Steps a finished game stays on screen before the next one
+}
+
+LiveTables::LiveTables(size_t tables, unsigned threads, std::chrono::milliseconds stepPeriod, uint64_t seed,
+                       int maxActions)
+    : _stepPeriod(stepPeriod), _maxActions(maxActions), _tables(tables), _stopping(false) {
+    if (tables == 0) {
+        throw std::invalid_argument("Live tables need at least one table");
+    }
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(std::min<size_t>(threads, tables));
+
+    // Moves are spread over the step period, so the tables do not all change in the same frame
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < tables; ++i) {
+        _slots.push_back(std::make_unique<Slot>());
+        _tables[i].rng.seed(deriveSeed(seed, i));
+        _tables[i].pauseSteps = 0;
+        _tables[i].due = start + stepPeriod * i / tables;
+    }
+    for (unsigned w = 0; w < threads; ++w) {
+        _workers.emplace_back(&LiveTables::work, this, w, threads);
+    }
+}
+
+LiveTables::~LiveTables() {
+    stop();
+}
+
+void LiveTables::stop() {
+    {
+        std::lock_guard<std::mutex> lock(_stopMutex);
+        _stopping = true;
+    }
+    _stopped.notify_all();
+    for (std::thread& worker : _workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+uint64_t LiveTables::version(size_t table) const {
+    return _slots[table]->version.load(std::memory_order_acquire);
+}
+
+uint64_t LiveTables::read(size_t table, LiveTableState& out) const {
+    const Slot& slot = *_slots[table];
+    std::lock_guard<std::mutex> lock(slot.mutex);
+    out = slot.state;
+    return slot.version.load(std::memory_order_relaxed);
+}
+
+void LiveTables::work(unsigned worker, unsigned workers) {
+    Game& game = Game::getInstance(); // This thread's own game, shared by all its tables
+    RandomPolicy policy(0.3);
+    Simulator simulator(policy, _maxActions);
+    MoveRecorder recorder;
+    simulator.setObserver(&recorder);
+    Lineup seated;
+
+    for (size_t i = worker; i < _tables.size(); i += workers) {
+        _tables[i].view.gamesPlayed = 0;
+        startGame(game, seated, _tables[i]);
+        publish(i);
+    }
+
+    std::unique_lock<std::mutex> lock(_stopMutex);
+    while (!_stopping) {
+        lock.unlock();
+        auto now = std::chrono::steady_clock::now();
+        auto next = now + _stepPeriod;
+        for (size_t i = worker; i < _tables.size(); i += workers) {
+            Table& table = _tables[i];
+            if (table.due <= now) {
+                advance(game, simulator, recorder, seated, table);
+                publish(i);
+                table.due += _stepPeriod;
+                if (table.due <= now) {
+                    table.due = now + _stepPeriod; // Fell behind: skip the missed moves rather than rush them
+                }
+            }
+            next = std::min(next, table.due);
+        }
+        lock.lock();
+        _stopped.wait_until(lock, next, [this] { return _stopping; });
+    }
+}
+
+void LiveTables::startGame(Game& game, Lineup& seated, Table& table) {
+    std::uniform_int_distribution<int> seatCount(2, MAX_PLAYERS);
+    std::uniform_int_distribution<int> roleIndex(0, ROLE_COUNT - 1);
+    table.lineup.resize(seatCount(table.rng));
+    for (Role& role : table.lineup) {
+        role = static_cast<Role>(roleIndex(table.rng));
+    }
+    Simulator::seatLineup(game, table.lineup);
+    seated = table.lineup;
+    game.snapshot(table.game);
+
+    LiveTableState& view = table.view;
+    view.actions = 0;
+    view.lastActor = -1;
+    view.lastAction = ActionType::Gather;
+    view.lastTarget = -1;
+    view.lastCancelled = false;
+    view.finished = false;
+    view.winner = -1;
+    capture(table);
+}
+
+void LiveTables::advance(Game& game, Simulator& simulator, MoveRecorder& recorder, Lineup& seated, Table& table) {
+    LiveTableState& view = table.view;
+    if (view.finished) {
+        if (--table.pauseSteps <= 0) {
+            startGame(game, seated, table);
+        }
+        return;
+    }
+
+    // The players are only reseated when the previous table had another lineup
+    if (seated != table.lineup) {
+        Simulator::seatLineup(game, table.lineup);
+        seated = table.lineup;
+    }
+    game.restore(table.game);
+    recorder.acted = false;
+    try {
+        simulator.step(game, table.rng);
+    } catch (const std::runtime_error&) {
+        view.actions = _maxActions; // Ends the game as a draw rather than the worker
+    }
+    ++view.actions;
+    game.snapshot(table.game);
+    if (recorder.acted) { // Otherwise the player had no legal move and passed
+        view.lastActor = recorder.last.actor;
+        view.lastAction = recorder.last.action;
+        view.lastTarget = recorder.last.target;
+        view.lastCancelled = recorder.last.canceller >= 0;
+    }
+    capture(table);
+
+    int active = Simulator::countActive(game);
+    if (active <= 1 || view.actions >= _maxActions) {
+        view.finished = true;
+        view.winner = -1;
+        if (active == 1) {
+            for (int i = 0; i < view.playerCount; ++i) {
+                if (view.active[i]) {
+                    view.winner = i;
+                }
+            }
+        }
+        ++view.gamesPlayed;
+        table.pauseSteps = PAUSE_STEPS;
+    }
+}
+
+void LiveTables::capture(Table& table) {
+    LiveTableState& view = table.view;
+    view.playerCount = table.game.playerCount;
+    for (int i = 0; i < view.playerCount; ++i) {
+        view.roles[i] = table.lineup[i];
+        view.coins[i] = table.game.players[i].coins;
+        view.active[i] = table.game.players[i].active;
+    }
+    view.current = table.game.currentPlayerIndex;
+}
+
+void LiveTables::publish(size_t index) {
+    Slot& slot = *_slots[index];
+    std::lock_guard<std::mutex> lock(slot.mutex);
+    slot.state = _tables[index].view;
+    slot.version.fetch_add(1, std::memory_order_release);
+}
+
+}
@@ -0,0 +1,160 @@
+// idocohen963@gmail.com
+#ifndef SPECTATOR_HPP
+#define SPECTATOR_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "simulator.hpp"
+
+/**
+ * @file spectator.hpp
+ * @brief Bot games played live at a fixed pace, for spectators.
+ *
+ * This file declares the flat state record of a live table and the LiveTables runner,
+ * which plays many independent bot-vs-bot games on a few worker threads and publishes
+ * the state of every table after each of its moves.
+ */
+
+namespace coup {
+
+/**
+ * @struct LiveTableState
+ * @brief State of one live table, stored in a flat fixed-size record.
+ */
+struct LiveTableState {
+    uint64_t gamesPlayed;        ///< Games finished on this table
+    int playerCount;             ///< Number of seats of the current game
+    Role roles[MAX_PLAYERS];     ///< Role of every seat
+    int coins[MAX_PLAYERS];      ///< Coins of every seat
+    bool active[MAX_PLAYERS];    ///< Whether every seat is still in the game
+    int current;                 ///< Seat whose turn it is
+    int actions;                 ///< Actions played in the current game
+    int lastActor;               ///< Seat of the last player who acted, or -1 at the start of a game
+    ActionType lastAction;       ///< The last action
+    int lastTarget;              ///< Target seat of the last action, or -1
+    bool lastCancelled;          ///< Whether the last action was cancelled
+    bool finished;               ///< The game ended; a new one starts after a pause
+    int winner;                  ///< Finished: seat of the winner, or -1 if the action limit was reached
+};
+
+/**
+ * @class LiveTables
+ * @brief Plays bot games on many tables at once, one move per table per step period.
+ *
+ * Tables are dealt round-robin to the worker threads. A Game is thread-local, so every worker
+ * keeps the state of its tables as GameSnapshot records and restores the one it moves next; the
+ * players are only reseated when the next table has a different lineup. After each move the
+ * worker publishes the table state with a version number, so a reader can skip the tables that
+ * did not move since it last looked without taking any lock.
+ */
+class LiveTables {
+public:
+    /**
+     * @brief Constructor. Seats a random lineup on every table and starts the workers.
+     * @param tables Number of tables.
+     * @param threads Number of worker threads (0 uses all hardware threads, never more than tables).
+     * @param stepPeriod Time between two moves of a table.
+     * @param seed Seed of the lineups and of the bots.
+     * @param maxActions Actions after which a game is declared a draw.
+     * @throws std::invalid_argument if there are no tables.
+     */
+    LiveTables(size_t tables, unsigned threads, std::chrono::milliseconds stepPeriod, uint64_t seed,
+               int maxActions = 300);
+
+    /**
+     * @brief Destructor. Stops and joins the workers.
+     */
+    ~LiveTables();
+
+    LiveTables(const LiveTables&) = delete;
+    LiveTables& operator=(const LiveTables&) = delete;
+
+    /**
+     * @brief Returns the number of tables.
+     * @return Number of tables.
+     */
+    size_t size() const { return _slots.size(); }
+
+    /**
+     * @brief Returns the version of a table, which changes every time its state is published.
+     * Does not lock.
+     * @param table Index of the table.
+     * @return The version, 0 before the first publication.
+     */
+    uint64_t version(size_t table) const;
+
+    /**
+     * @brief Copies the state of a table.
+     * @param table Index of the table.
+     * @param out Receives the state.
+     * @return The version of the copied state.
+     */
+    uint64_t read(size_t table, LiveTableState& out) const;
+
+    /**
+     * @brief Stops the workers; the tables keep their last state. Called by the destructor.
+     */
+    void stop();
+
+private:
+    /**
+     * @struct Slot
+     * @brief Published state of a table.
+     */
+    struct Slot {
+        std::atomic<uint64_t> version{0};
+        mutable std::mutex mutex;  ///< Guards state; held only for a copy
+        LiveTableState state;
+    };
+
+    /**
+     * @struct Table
+     * @brief Worker-side state of a table.
+     */
+    struct Table {
+        Lineup lineup;                          ///< Roles of the current game
+        GameSnapshot game;                      ///< State of the current game
+        LiveTableState view;                    ///< Next state to publish
+        Rng rng;                                ///< Random engine of the lineups and bots of the table
+        int pauseSteps;                         ///< Finished: steps left before the next game
+        std::chrono::steady_clock::time_point due;  ///< Time of the next move
+    };
+
+    /**
+     * @class MoveRecorder
+     * @brief Keeps the last action reported by the simulator.
+     */
+    class MoveRecorder : public GameObserver {
+    public:
+        ActionEvent last{};
+        bool acted = false;
+        void onAction(const ActionEvent& event) override {
+            last = event;
+            acted = true;
+        }
+    };
+
+    std::chrono::milliseconds _stepPeriod;
+    int _maxActions;
+    std::vector<std::unique_ptr<Slot>> _slots;
+    std::vector<Table> _tables;
+    std::vector<std::thread> _workers;
+    std::mutex _stopMutex;
+    std::condition_variable _stopped;
+    bool _stopping;
+
+    void work(unsigned worker, unsigned workers);
+    void startGame(Game& game, Lineup& seated, Table& table);
+    void advance(Game& game, Simulator& simulator, MoveRecorder& recorder, Lineup& seated, Table& table);
+    static void capture(Table& table);
+    void publish(size_t index);
+};
+
+}
+#endif
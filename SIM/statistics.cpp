@@ -0,0 +1,194 @@
+// idocohen963@gmail.com
+#include "statistics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+/**
+ * @file statistics.cpp
+ * @brief Implementation of the streaming statistics aggregator.
+ */
+
+namespace coup {
+
+/**
+ * @brief Population variance from the running sums.
+ */
+double RunningMoments::variance() const {
+    if (count == 0) {
+        return 0.0;
+    }
+    double m = mean();
+    double v = sumSq / count - m * m;
+    return v > 0 ? v : 0.0; // Guard against rounding below zero
+}
+
+/**
+ * @brief Counts the seats of the new game.
+ */
+void StatisticsAggregator::onGameStart(uint64_t gameId, const Lineup& lineup) {
+    (void)gameId; // Avoid unused parameter warning
+    for (Role role : lineup) {
+        _seats[static_cast<int>(role)]++;
+    }
+}
+
+/**
+ * @brief Updates the action histogram and the coin trajectory of the actor's role.
+ */
+void StatisticsAggregator::onAction(const ActionEvent& event) {
+    int role = static_cast<int>(event.actorRole);
+    int bucket = turnBucket(event.index);
+    _actionsByTurn[role][bucket][static_cast<int>(event.action)]++;
+    _coins[role][bucket].add(event.actorCoinsAfter);
+}
+
+/**
+ * @brief Updates the cancel counts of the asked player's role.
+ */
+void StatisticsAggregator::onCancel(const CancelEvent& event) {
+    CancelCounts& counts = _cancels[static_cast<int>(event.cancellerRole)];
+    counts.offered++;
+    if (event.attempted) counts.attempted++;
+    if (event.succeeded) counts.succeeded++;
+}
+
+/**
+ * @brief Records the winner and the game length.
+ */
+void StatisticsAggregator::onGameEnd(const Lineup& lineup, const GameResult& result) {
+    _games++;
+    if (result.winner < 0) {
+        _draws++;
+    } else {
+        _wins[static_cast<int>(lineup[result.winner])]++;
+    }
+    int bucket = result.actions / LENGTH_BUCKET_WIDTH;
+    _lengthHistogram[bucket < LENGTH_BUCKETS ? bucket : LENGTH_BUCKETS - 1]++;
+    _lengths.add(result.actions);
+}
+
+/**
+ * @brief Adds all counters of another aggregator.
+ */
+void StatisticsAggregator::merge(const StatisticsAggregator& other) {
+    _games += other._games;
+    _draws += other._draws;
+    for (int r = 0; r < ROLE_COUNT; ++r) {
+        _seats[r] += other._seats[r];
+        _wins[r] += other._wins[r];
+        _cancels[r].offered += other._cancels[r].offered;
+        _cancels[r].attempted += other._cancels[r].attempted;
+        _cancels[r].succeeded += other._cancels[r].succeeded;
+        for (int t = 0; t < TURN_BUCKETS; ++t) {
+            for (int a = 0; a < ACTION_COUNT; ++a) {
+                _actionsByTurn[r][t][a] += other._actionsByTurn[r][t][a];
+            }
+            _coins[r][t].merge(other._coins[r][t]);
+        }
+    }
+    for (int b = 0; b < LENGTH_BUCKETS; ++b) {
+        _lengthHistogram[b] += other._lengthHistogram[b];
+    }
+    _lengths.merge(other._lengths);
+}
+
+/**
+ * @brief Wins per seat of a role.
+ */
+double StatisticsAggregator::winRate(Role role) const {
+    uint64_t n = seats(role);
+    return n == 0 ? 0.0 : static_cast<double>(wins(role)) / n;
+}
+
+/**
+ * @brief Wilson score interval, which stays inside [0, 1] even for small samples and extreme rates.
+ */
+Interval StatisticsAggregator::winRateInterval(Role role, double z) const {
+    double n = static_cast<double>(seats(role));
+    if (n == 0) {
+        return {0.0, 1.0};
+    }
+    double p = winRate(role);
+    double z2 = z * z;
+    double center = (p + z2 / (2 * n)) / (1 + z2 / n);
+    double margin = z * std::sqrt(p * (1 - p) / n + z2 / (4 * n * n)) / (1 + z2 / n);
+    return {std::max(0.0, center - margin), std::min(1.0, center + margin)};
+}
+
+/**
+ * @brief Sums the turn buckets of a role and action.
+ */
+uint64_t StatisticsAggregator::actionCount(Role role, ActionType action) const {
+    uint64_t total = 0;
+    for (int t = 0; t < TURN_BUCKETS; ++t) {
+        total += actionCount(role, t, action);
+    }
+    return total;
+}
+
+/**
+ * @brief Walks the length histogram until the requested fraction of games is covered.
+ */
+int StatisticsAggregator::lengthQuantile(double q) const {
+    if (_games == 0) {
+        return 0;
+    }
+    double needed = q * static_cast<double>(_games);
+    uint64_t seen = 0;
+    for (int b = 0; b < LENGTH_BUCKETS; ++b) {
+        seen += _lengthHistogram[b];
+        if (static_cast<double>(seen) >= needed) {
+            return (b + 1) * LENGTH_BUCKET_WIDTH;
+        }
+    }
+    return LENGTH_BUCKETS * LENGTH_BUCKET_WIDTH;
+}
+
+/**
+ * @brief Writes win rates, action frequencies, cancel rates and game lengths.
+ */
+void StatisticsAggregator::report(std::ostream& out) const {
+    out << std::fixed << std::setprecision(4);
+    out << "Games: " << _games << " (draws: " << _draws << ")\n\n";
+    out << "Role      win rate   95% interval\n";
+    for (int r = 0; r < ROLE_COUNT; ++r) {
+        Role role = static_cast<Role>(r);
+        Interval ci = winRateInterval(role);
+        out << std::left << std::setw(9) << roleName(role) << std::right << std::setw(9) << winRate(role)
+            << "   [" << ci.low << ", " << ci.high << "]\n";
+    }
+
+    out << "\nAction frequencies by role\n" << std::setw(9) << "";
+    for (int a = 0; a < ACTION_COUNT - 1; ++a) { // cancel is never a turn action
+        out << std::setw(10) << actionName(static_cast<ActionType>(a));
+    }
+    out << "\n";
+    for (int r = 0; r < ROLE_COUNT; ++r) {
+        Role role = static_cast<Role>(r);
+        uint64_t total = 0;
+        for (int a = 0; a < ACTION_COUNT; ++a) {
+            total += actionCount(role, static_cast<ActionType>(a));
+        }
+        out << std::left << std::setw(9) << roleName(role) << std::right;
+        for (int a = 0; a < ACTION_COUNT - 1; ++a) {
+            double share = total ? static_cast<double>(actionCount(role, static_cast<ActionType>(a))) / total : 0.0;
+            out << std::setw(10) << share;
+        }
+        out << "\n";
+    }
+
+    out << "\nCancels   offered  attempted  success rate\n";
+    for (Role role : {Role::Judge, Role::Governor, Role::General}) {
+        const CancelCounts& c = cancels(role);
+        double rate = c.attempted ? static_cast<double>(c.succeeded) / c.attempted : 0.0;
+        out << std::left << std::setw(9) << roleName(role) << std::right << std::setw(8) << c.offered
+            << std::setw(11) << c.attempted << std::setw(14) << rate << "\n";
+    }
+
+    out << std::setprecision(1);
+    out << "\nGame length: mean " << _lengths.mean() << ", stddev " << std::sqrt(_lengths.variance())
+        << ", median <= " << lengthQuantile(0.5) << ", p90 <= " << lengthQuantile(0.9) << "\n";
+}
+
+}
@@ -0,0 +1,233 @@
+// idocohen963@gmail.com
+#ifndef STATISTICS_HPP
+#define STATISTICS_HPP
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include "simulator.hpp"
+
+/**
+ * @file statistics.hpp
+ * @brief Streaming statistics over simulated games.
+ *
+ * This file declares the StatisticsAggregator, a GameObserver that keeps fixed-size
+ * counters (role win rates, action histograms, coin trajectories, cancel rates and
+ * game lengths), so its memory does not grow with the number of games streamed through it.
+ * Per-thread partials are combined with merge().
+ */
+
+namespace coup {
+
+/**
+ * @struct Interval
+ * @brief A confidence interval around a proportion.
+ */
+struct Interval {
+    double low;   ///< Lower bound
+    double high;  ///< Upper bound
+};
+
+/**
+ * @struct RunningMoments
+ * @brief Count, sum and sum of squares of a series, enough for mean and variance and trivially mergeable.
+ */
+struct RunningMoments {
+    uint64_t count = 0;  ///< Number of samples
+    double sum = 0;      ///< Sum of the samples
+    double sumSq = 0;    ///< Sum of the squared samples
+
+    /**
+     * @brief Adds a sample.
+     * @param value The sample.
+     */
+    void add(double value) {
+        count++;
+        sum += value;
+        sumSq += value * value;
+    }
+
+    /**
+     * @brief Adds the samples of another series.
+     * @param other The series to merge.
+     */
+    void merge(const RunningMoments& other) {
+        count += other.count;
+        sum += other.sum;
+        sumSq += other.sumSq;
+    }
+
+    /**
+     * @brief Returns the mean of the samples (0 without samples).
+     * @return The mean.
+     */
+    double mean() const { return count ? sum / count : 0.0; }
+
+    /**
+     * @brief Returns the population variance of the samples (0 without samples).
+     * @return The variance.
+     */
+    double variance() const;
+};
+
+/**
+ * @class StatisticsAggregator
+ * @brief Online, constant memory statistics over a stream of simulated games.
+ *
+ * Turn-indexed statistics use buckets of TURN_BUCKET_WIDTH actions; everything from
+ * TURN_BUCKETS * TURN_BUCKET_WIDTH actions on falls into the last bucket.
+ * Game lengths use LENGTH_BUCKETS buckets of LENGTH_BUCKET_WIDTH actions with the same overflow rule.
+ */
+class StatisticsAggregator : public GameObserver {
+public:
+    static constexpr int TURN_BUCKETS = 50;          ///< Number of turn buckets
+    static constexpr int TURN_BUCKET_WIDTH = 4;      ///< Actions per turn bucket
+    static constexpr int LENGTH_BUCKETS = 64;        ///< Number of game length buckets
+    static constexpr int LENGTH_BUCKET_WIDTH = 16;   ///< Actions per game length bucket
+
+    /**
+     * @struct CancelCounts
+     * @brief Cancel opportunities of one role.
+     */
+    struct CancelCounts {
+        uint64_t offered = 0;    ///< Times a player of the role could cancel
+        uint64_t attempted = 0;  ///< Times the player chose to cancel
+        uint64_t succeeded = 0;  ///< Times the cancel was applied
+    };
+
+    void onGameStart(uint64_t gameId, const Lineup& lineup) override;
+    void onAction(const ActionEvent& event) override;
+    void onCancel(const CancelEvent& event) override;
+    void onGameEnd(const Lineup& lineup, const GameResult& result) override;
+
+    /**
+     * @brief Adds the counts of another aggregator (for example another worker's partial).
+     * @param other The aggregator to merge.
+     */
+    void merge(const StatisticsAggregator& other);
+
+    /**
+     * @brief Returns the number of games seen.
+     * @return Number of games.
+     */
+    uint64_t games() const { return _games; }
+
+    /**
+     * @brief Returns the number of games that hit the action limit.
+     * @return Number of draws.
+     */
+    uint64_t draws() const { return _draws; }
+
+    /**
+     * @brief Returns how many seats a role occupied.
+     * @param role The role.
+     * @return Number of seats.
+     */
+    uint64_t seats(Role role) const { return _seats[static_cast<int>(role)]; }
+
+    /**
+     * @brief Returns how many games a role won.
+     * @param role The role.
+     * @return Number of wins.
+     */
+    uint64_t wins(Role role) const { return _wins[static_cast<int>(role)]; }
+
+    /**
+     * @brief Returns the win rate of a role per seat it occupied.
+     * @param role The role.
+     * @return The win rate, or 0 if the role never played.
+     */
+    double winRate(Role role) const;
+
+    /**
+     * @brief Returns the Wilson score interval of a role's win rate.
+     * @param role The role.
+     * @param z Standard score of the confidence level (1.96 for 95%).
+     * @return The interval ([0, 1] if the role never played).
+     */
+    Interval winRateInterval(Role role, double z = 1.96) const;
+
+    /**
+     * @brief Returns how many times a role performed an action.
+     * @param role The role.
+     * @param action The action.
+     * @return Number of actions.
+     */
+    uint64_t actionCount(Role role, ActionType action) const;
+
+    /**
+     * @brief Returns how many times a role performed an action in a turn bucket.
+     * @param role The role.
+     * @param bucket The turn bucket.
+     * @param action The action.
+     * @return Number of actions.
+     */
+    uint64_t actionCount(Role role, int bucket, ActionType action) const {
+        return _actionsByTurn[static_cast<int>(role)][bucket][static_cast<int>(action)];
+    }
+
+    /**
+     * @brief Returns the coins held by players of a role after their actions in a turn bucket.
+     * @param role The role.
+     * @param bucket The turn bucket.
+     * @return The coin moments.
+     */
+    const RunningMoments& coins(Role role, int bucket) const { return _coins[static_cast<int>(role)][bucket]; }
+
+    /**
+     * @brief Returns the cancel counts of a role.
+     * @param role The role (Judge, Governor and General are the ones able to cancel).
+     * @return The cancel counts.
+     */
+    const CancelCounts& cancels(Role role) const { return _cancels[static_cast<int>(role)]; }
+
+    /**
+     * @brief Returns the number of games whose length fell into a bucket.
+     * @param bucket The length bucket.
+     * @return Number of games.
+     */
+    uint64_t lengthCount(int bucket) const { return _lengthHistogram[bucket]; }
+
+    /**
+     * @brief Returns the moments of the game lengths.
+     * @return The length moments.
+     */
+    const RunningMoments& lengths() const { return _lengths; }
+
+    /**
+     * @brief Returns the approximate length quantile, from the length histogram.
+     * @param q The quantile in [0, 1].
+     * @return Upper edge of the bucket holding the quantile.
+     */
+    int lengthQuantile(double q) const;
+
+    /**
+     * @brief Writes a human readable summary.
+     * @param out The stream to write to.
+     */
+    void report(std::ostream& out) const;
+
+    /**
+     * @brief Returns the turn bucket of an action index.
+     * @param index The action index.
+     * @return The bucket.
+     */
+    static int turnBucket(int index) {
+        int bucket = index / TURN_BUCKET_WIDTH;
+        return bucket < TURN_BUCKETS ? bucket : TURN_BUCKETS - 1;
+    }
+
+private:
+    uint64_t _games = 0;                             ///< Games seen
+    uint64_t _draws = 0;                             ///< Games that hit the action limit
+    std::array<uint64_t, ROLE_COUNT> _seats{};       ///< Seats taken, by role
+    std::array<uint64_t, ROLE_COUNT> _wins{};        ///< Wins, by role
+    std::array<std::array<std::array<uint64_t, ACTION_COUNT>, TURN_BUCKETS>, ROLE_COUNT> _actionsByTurn{}; ///< [role][turn][action]
+    std::array<std::array<RunningMoments, TURN_BUCKETS>, ROLE_COUNT> _coins{};  ///< Actor's coins, [role][turn]
+    std::array<CancelCounts, ROLE_COUNT> _cancels{};                             ///< Cancel counts, by role
+    std::array<uint64_t, LENGTH_BUCKETS> _lengthHistogram{};                     ///< Games by length bucket
+    RunningMoments _lengths;                                                     ///< Game length moments
+};
+
+}
+#endif
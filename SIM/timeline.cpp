@@ -0,0 +1,157 @@
+// idocohen963@gmail.com
+#include "timeline.hpp"
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace coup {
+
+// === Recording file ===
+
+/**
+ * @brief Writes the seats, the moves and the winner, one per line.
+ */
+void saveRecording(const GameRecording& recording, std::ostream& out) {
+    const ReplayRecord& record = recording.record;
+    out << "# Coup game recording\n";
+    for (size_t i = 0; i < record.lineup.size(); ++i) {
+        out << "player " << roleName(record.lineup[i]) << ' ' << recording.names[i] << '\n';
+    }
+    for (const ReplayMove& move : record.moves) {
+        out << "move " << actionName(move.action) << ' ' << move.target << ' ' << move.canceller << '\n';
+    }
+    out << "winner " << record.winner << '\n';
+    if (!out) {
+        throw std::runtime_error("Failed to write the recording");
+    }
+}
+
+namespace {
+
+/**
+ * @brief Reads a seat number, -1 included.
+ */
+int parseSeat(std::istringstream& in, size_t players, int lineNumber) {
+    int seat;
+    if (!(in >> seat) || seat < -1 || seat >= static_cast<int>(players)) {
+        throw std::runtime_error("Invalid seat in recording line " + std::to_string(lineNumber));
+    }
+    return seat;
+}
+
+}
+
+/**
+ * @brief Parses the recording line by line, checking names and seats.
+ */
+GameRecording loadRecording(std::istream& in) {
+    GameRecording recording;
+    ReplayRecord& record = recording.record;
+    record.gameId = 0;
+    record.winner = -1;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string kind;
+        fields >> kind;
+        if (kind == "player") {
+            std::string role;
+            std::string name;
+            fields >> role;
+            std::getline(fields >> std::ws, name);
+            int index = 0;
+            while (index < ROLE_COUNT && role != roleName(static_cast<Role>(index))) {
+                ++index;
+            }
+            if (index == ROLE_COUNT || name.empty() || !record.moves.empty() || record.lineup.size() == MAX_PLAYERS) {
+                throw std::runtime_error("Invalid player in recording line " + std::to_string(lineNumber));
+            }
+            record.lineup.push_back(static_cast<Role>(index));
+            recording.names.push_back(name);
+        } else if (kind == "move") {
+            std::string action;
+            fields >> action;
+            int index = 0;
+            while (index < ACTION_COUNT && action != actionName(static_cast<ActionType>(index))) {
+                ++index;
+            }
+            if (index == ACTION_COUNT) {
+                throw std::runtime_error("Invalid action in recording line " + std::to_string(lineNumber));
+            }
+            ReplayMove move;
+            move.action = static_cast<ActionType>(index);
+            move.target = parseSeat(fields, record.lineup.size(), lineNumber);
+            move.canceller = parseSeat(fields, record.lineup.size(), lineNumber);
+            record.moves.push_back(move);
+        } else if (kind == "winner") {
+            record.winner = parseSeat(fields, record.lineup.size(), lineNumber);
+        } else {
+            throw std::runtime_error("Unknown entry in recording line " + std::to_string(lineNumber));
+        }
+    }
+    if (record.lineup.size() < 2) {
+        throw std::runtime_error("Recording has fewer than two players");
+    }
+    return recording;
+}
+
+// === Timeline ===
+
+ReplayTimeline::ReplayTimeline(const GameRecording& recording, size_t interval)
+    : _recording(recording), _interval(std::max<size_t>(1, interval)), _position(0) {
+    _legal.reserve(4 + 4 * MAX_PLAYERS);
+    seat();
+    Game& game = Game::getInstance();
+    const std::vector<ReplayMove>& moves = _recording.record.moves;
+    _checkpoints.reserve(moves.size() / _interval + 1);
+    _actors.resize(moves.size());
+    for (size_t m = 0; m < moves.size(); ++m) {
+        if (m % _interval == 0) {
+            _checkpoints.push_back(game.snapshot());
+        }
+        replayMove(game, moves[m], _legal, &_actors[m]);
+    }
+    if (moves.size() % _interval == 0) {
+        _checkpoints.push_back(game.snapshot()); // The end of the game is a checkpoint position too
+    }
+    game.restore(_checkpoints.front());
+}
+
+/**
+ * @brief Seats the recorded players under their own names, with output silenced.
+ */
+void ReplayTimeline::seat() {
+    Game& game = Game::getInstance();
+    game.reset();
+    game.setVerbose(false);
+    for (size_t i = 0; i < _recording.record.lineup.size(); ++i) {
+        game.addPlayer(_recording.names[i], roleName(_recording.record.lineup[i]));
+    }
+    game.startGame();
+}
+
+/**
+ * @brief Restores the closest checkpoint unless the current position is closer, then replays.
+ */
+size_t ReplayTimeline::seek(size_t position) {
+    position = std::min(position, length());
+    Game& game = Game::getInstance();
+    size_t checkpoint = position / _interval;
+    if (position < _position || position - _position > position - checkpoint * _interval) {
+        game.restore(_checkpoints[checkpoint]);
+        _position = checkpoint * _interval;
+    }
+    size_t replayed = 0;
+    for (; _position < position; ++_position) {
+        replayMove(game, _recording.record.moves[_position], _legal);
+        ++replayed;
+    }
+    return replayed;
+}
+
+}
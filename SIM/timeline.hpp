@@ -0,0 +1,122 @@
+// idocohen963@gmail.com
+#ifndef TIMELINE_HPP
+#define TIMELINE_HPP
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "archive.hpp"
+
+/**
+ * @file timeline.hpp
+ * @brief Recordings of played games and random access to their positions.
+ *
+ * A recording is a replay record plus the names of the players, saved as a small text file:
+ *   player <role> <name>              one line per seat, in seat order (the name may hold spaces)
+ *   move <action> <target> <canceller>  one line per move, seats or -1
+ *   winner <seat>                     -1 if the game did not end
+ * Empty lines and lines starting with '#' are ignored.
+ */
+
+namespace coup {
+
+/**
+ * @struct GameRecording
+ * @brief A game as played in the GUI: the seats and every decision.
+ */
+struct GameRecording {
+    std::vector<std::string> names;  ///< Name of every seat
+    ReplayRecord record;             ///< Lineup, moves and winner
+};
+
+/**
+ * @brief Writes a recording.
+ * @param recording The recording.
+ * @param out The stream to write to.
+ * @throws std::runtime_error if the stream failed.
+ */
+void saveRecording(const GameRecording& recording, std::ostream& out);
+
+/**
+ * @brief Reads a recording.
+ * @param in The stream to read from.
+ * @return The recording.
+ * @throws std::runtime_error if the text is not a valid recording.
+ */
+GameRecording loadRecording(std::istream& in);
+
+/**
+ * @class ReplayTimeline
+ * @brief Seeks a recorded game to any move on the calling thread's Game.
+ *
+ * The game is replayed once on construction, and a GameSnapshot is kept every few moves.
+ * Seeking restores the closest checkpoint before the position and replays the moves after it,
+ * or continues from the current position when that is closer, so a seek never replays more than
+ * interval - 1 moves whatever the length of the game. Restoring a snapshot allocates nothing.
+ */
+class ReplayTimeline {
+public:
+    static const size_t CHECKPOINT_INTERVAL = 8;  ///< Default moves between two checkpoints
+
+    /**
+     * @brief Constructor. Seats the players on the calling thread's Game, replays the whole game
+     * to take the checkpoints and find the actors, and seeks back to the start.
+     * @param recording The game (copied).
+     * @param interval Moves between two checkpoints (at least 1).
+     * @throws std::runtime_error if the recording cannot be replayed.
+     */
+    explicit ReplayTimeline(const GameRecording& recording, size_t interval = CHECKPOINT_INTERVAL);
+
+    /**
+     * @brief Returns the number of moves of the game.
+     * @return Number of moves; positions go from 0 to length().
+     */
+    size_t length() const { return _recording.record.moves.size(); }
+
+    /**
+     * @brief Returns the position the game is at.
+     * @return Number of moves applied.
+     */
+    size_t position() const { return _position; }
+
+    /**
+     * @brief Brings the game to a position.
+     * @param position Number of moves to apply; clamped to length().
+     * @return Number of moves replayed to get there.
+     */
+    size_t seek(size_t position);
+
+    /**
+     * @brief Returns who made a move; the recording only has the moves, the actor follows from the rules.
+     * @param move Index of the move, below length().
+     * @return Seat of the player who made the move.
+     */
+    int actor(size_t move) const { return _actors[move]; }
+
+    /**
+     * @brief Returns the number of checkpoints taken.
+     * @return Number of snapshots kept.
+     */
+    size_t checkpoints() const { return _checkpoints.size(); }
+
+    /**
+     * @brief Returns the recorded game.
+     * @return The recording.
+     */
+    const GameRecording& recording() const { return _recording; }
+
+private:
+    GameRecording _recording;
+    size_t _interval;
+    std::vector<GameSnapshot> _checkpoints;  ///< State before move i * interval
+    std::vector<int> _actors;                ///< Seat of the player who made every move
+    std::vector<Move> _legal;                ///< Reused buffer of legal moves
+    size_t _position;
+
+    void seat();
+};
+
+}
+#endif
@@ -0,0 +1,302 @@
+// idocohen963@gmail.com
+#include "tournament.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+
+/**
+ * @file tournament.cpp
+ * @brief Implementation of the tournament runner, its ratings and its sequential test.
+ */
+
+namespace coup {
+
+namespace {
+
+const double TRUESKILL_BETA = 25.0 / 6;   ///< Spread of the performance around the skill
+const double TRUESKILL_TAU = 25.0 / 300;  ///< Drift of the skill between two games
+const double SQRT_2PI = 2.5066282746310002;
+
+/**
+ * @brief Expected score of a side this many Elo points stronger.
+ */
+double expectedScore(double elo) {
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400));
+}
+
+/**
+ * @brief Updates the TrueSkill of both sides of a decided game (two players, no draw margin).
+ */
+void trueSkill(Standing& winner, Standing& loser) {
+    const double winnerVar = winner.sigma * winner.sigma + TRUESKILL_TAU * TRUESKILL_TAU;
+    const double loserVar = loser.sigma * loser.sigma + TRUESKILL_TAU * TRUESKILL_TAU;
+    const double c2 = 2 * TRUESKILL_BETA * TRUESKILL_BETA + winnerVar + loserVar;
+    const double c = std::sqrt(c2);
+    const double t = (winner.mu - loser.mu) / c;
+    const double cdf = 0.5 * std::erfc(-t / std::sqrt(2.0));
+    const double pdf = std::exp(-t * t / 2) / SQRT_2PI;
+    const double v = cdf > 1e-300 ? pdf / cdf : -t; // The limit of pdf / cdf far in the tail
+    const double w = v * (v + t);
+    winner.mu += winnerVar / c * v;
+    loser.mu -= loserVar / c * v;
+    winner.sigma = std::sqrt(winnerVar * (1 - winnerVar / c2 * w));
+    loser.sigma = std::sqrt(loserVar * (1 - loserVar / c2 * w));
+}
+
+}
+
+/**
+ * @brief Half a win and half a loss are added to the results, so a short run of wins only
+ * (zero variance) does not end the test at once.
+ */
+double sprtLlr(uint64_t wins, uint64_t draws, uint64_t losses, double margin) {
+    const double w = wins + 0.5;
+    const double d = static_cast<double>(draws);
+    const double l = losses + 0.5;
+    const double n = w + d + l;
+    const double mean = (w + 0.5 * d) / n;
+    const double var = (w * (1 - mean) * (1 - mean) + d * (0.5 - mean) * (0.5 - mean) + l * mean * mean) / n;
+    const double s0 = expectedScore(-margin);
+    const double s1 = expectedScore(margin);
+    return n * (s1 - s0) * (2 * mean - s0 - s1) / (2 * var);
+}
+
+Tournament::Tournament(const TournamentConfig& config)
+    : _config(config), _games(0), _rounds(0), _finished(false) {
+    if (config.minSeats < 2 || config.maxSeats > MAX_PLAYERS || config.minSeats > config.maxSeats) {
+        throw std::invalid_argument("Illegal table size for the tournament");
+    }
+    _config.gamesPerMatch = std::max<uint64_t>(2, config.gamesPerMatch + config.gamesPerMatch % 2);
+}
+
+void Tournament::add(const std::string& name, PolicyFactory makePolicy) {
+    _entrants.push_back(Entrant{name, std::move(makePolicy)});
+    Standing standing;
+    standing.name = name;
+    _standings.push_back(standing);
+}
+
+/**
+ * @brief Every round schedules the undecided pairs, plays their games on the pool and rates
+ * them in game order. A pair of games shares its lineup and its random stream, only the sides
+ * are swapped.
+ */
+void Tournament::run(WorkStealingPool& pool) {
+    if (_entrants.size() < 2) {
+        throw std::invalid_argument("A tournament needs at least two entrants");
+    }
+    // Policies of every entrant, per worker, created lazily on the worker's own thread
+    std::vector<std::vector<std::unique_ptr<Policy>>> policies(pool.size());
+    std::vector<Played> results;
+
+    while (_games + 2 <= _config.maxGames) {
+        std::vector<size_t> matches = schedule();
+        if (matches.empty()) {
+            _finished = true;
+            return;
+        }
+        const uint64_t pairsPerMatch = _config.gamesPerMatch / 2;
+        const uint64_t tasks = std::min<uint64_t>(matches.size() * pairsPerMatch, (_config.maxGames - _games) / 2);
+        const uint64_t firstTask = _games / 2;
+        results.assign(2 * tasks, Played{0, 0});
+
+        pool.run(tasks, [&](unsigned id, uint64_t task) {
+            std::vector<std::unique_ptr<Policy>>& mine = policies[id];
+            if (mine.empty()) {
+                for (const Entrant& entrant : _entrants) {
+                    mine.push_back(entrant.makePolicy());
+                }
+            }
+            const size_t pair = matches[task / pairsPerMatch];
+            const PairRecord& record = _pairs[pair];
+            Rng rng(deriveSeed(_config.seed, firstTask + task));
+            std::uniform_int_distribution<int> seatCount(_config.minSeats, _config.maxSeats);
+            std::uniform_int_distribution<int> roleIndex(0, ROLE_COUNT - 1);
+            Lineup lineup(seatCount(rng));
+            for (Role& role : lineup) {
+                role = static_cast<Role>(roleIndex(rng));
+            }
+            // The first half of the shuffled seats plays for one side, the rest for the other
+            std::vector<int> order(lineup.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::shuffle(order.begin(), order.end(), rng);
+
+            for (int swap = 0; swap < 2; ++swap) {
+                std::vector<int> side(lineup.size());
+                std::vector<Policy*> seats(lineup.size());
+                for (size_t k = 0; k < order.size(); ++k) {
+                    side[order[k]] = (k < order.size() / 2) != (swap == 1) ? 1 : -1;
+                    seats[order[k]] = mine[side[order[k]] == 1 ? record.first : record.second].get();
+                }
+                SeatPolicies policy(seats);
+                Simulator simulator(policy, _config.maxActions);
+                Rng gameRng = rng;
+                GameResult result = simulator.playGame(lineup, gameRng, firstTask + task);
+                results[2 * task + swap] = Played{pair, result.winner < 0 ? 0 : side[result.winner]};
+            }
+        });
+
+        for (const Played& played : results) {
+            rate(played);
+        }
+        _games += results.size();
+        ++_rounds;
+    }
+    _finished = schedule().empty();
+}
+
+bool Tournament::decided() const {
+    return std::all_of(_pairs.begin(), _pairs.end(), [](const PairRecord& pair) { return pair.verdict != 0; });
+}
+
+/**
+ * @brief Returns the index of the record of a pair, adding it on its first match.
+ */
+size_t Tournament::record(int first, int second) {
+    for (size_t i = 0; i < _pairs.size(); ++i) {
+        if (_pairs[i].first == first && _pairs[i].second == second) {
+            return i;
+        }
+    }
+    PairRecord record;
+    record.first = first;
+    record.second = second;
+    _pairs.push_back(record);
+    return _pairs.size() - 1;
+}
+
+/**
+ * @brief Returns the undecided pairs to play this round. In a round robin every pair plays;
+ * in a Swiss round the entrants are sorted by Elo and every undecided pair of neighbours plays,
+ * each entrant at most once.
+ */
+std::vector<size_t> Tournament::schedule() {
+    std::vector<size_t> matches;
+    const int count = static_cast<int>(_entrants.size());
+    if (_config.pairing == Pairing::RoundRobin) {
+        for (int i = 0; i < count; ++i) {
+            for (int j = i + 1; j < count; ++j) {
+                size_t pair = record(i, j);
+                if (_pairs[pair].verdict == 0) {
+                    matches.push_back(pair);
+                }
+            }
+        }
+        return matches;
+    }
+    std::vector<int> order = ranking();
+    std::vector<bool> busy(count, false);
+    for (int k = 0; k + 1 < count; ++k) {
+        int a = std::min(order[k], order[k + 1]);
+        int b = std::max(order[k], order[k + 1]);
+        size_t pair = record(a, b);
+        if (_pairs[pair].verdict == 0 && !busy[a] && !busy[b]) {
+            busy[a] = busy[b] = true;
+            matches.push_back(pair);
+        }
+    }
+    return matches;
+}
+
+/**
+ * @brief Sorts by Elo, then lets the decided pairs of neighbours overrule the Elo order, since
+ * the Elo of a few games can contradict a head to head verdict. Verdicts can form a cycle, so
+ * the corrections stop after a bounded number of passes.
+ */
+std::vector<int> Tournament::ranking() const {
+    const int count = static_cast<int>(_standings.size());
+    std::vector<int> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [this](int a, int b) { return _standings[a].elo > _standings[b].elo; });
+    bool swapped = true;
+    for (int pass = 0; swapped && pass < count; ++pass) {
+        swapped = false;
+        for (int k = 0; k + 1 < count; ++k) {
+            int a = std::min(order[k], order[k + 1]);
+            int b = std::max(order[k], order[k + 1]);
+            for (const PairRecord& pair : _pairs) {
+                if (pair.first == a && pair.second == b && pair.verdict != 0 &&
+                    (pair.verdict > 0) != (order[k] == a)) {
+                    std::swap(order[k], order[k + 1]);
+                    swapped = true;
+                }
+            }
+        }
+    }
+    return order;
+}
+
+/**
+ * @brief Applies one game: results, Elo and TrueSkill of both sides, and the sequential test.
+ * A decided pair keeps its verdict if it plays again.
+ */
+void Tournament::rate(const Played& game) {
+    PairRecord& pair = _pairs[game.pair];
+    Standing& first = _standings[pair.first];
+    Standing& second = _standings[pair.second];
+    first.games++;
+    second.games++;
+    if (game.outcome > 0) {
+        pair.wins++;
+        first.wins++;
+        second.losses++;
+        trueSkill(first, second);
+    } else if (game.outcome < 0) {
+        pair.losses++;
+        first.losses++;
+        second.wins++;
+        trueSkill(second, first);
+    } else {
+        pair.draws++;
+        first.draws++;
+        second.draws++;
+    }
+    const double score = game.outcome > 0 ? 1.0 : (game.outcome < 0 ? 0.0 : 0.5);
+    const double delta = _config.eloK * (score - expectedScore(first.elo - second.elo));
+    first.elo += delta;
+    second.elo -= delta;
+
+    pair.llr = sprtLlr(pair.wins, pair.draws, pair.losses, _config.margin);
+    if (pair.verdict == 0) {
+        if (pair.llr >= std::log((1 - _config.beta) / _config.alpha)) {
+            pair.verdict = 1;
+        } else if (pair.llr <= std::log(_config.beta / (1 - _config.alpha))) {
+            pair.verdict = -1;
+        }
+    }
+}
+
+void Tournament::report(std::ostream& out) const {
+    std::vector<int> order = ranking();
+    out << _games << " games in " << _rounds << " rounds, "
+        << (!_finished ? "game budget spent before every comparison was decided"
+                       : (decided() ? "every comparison decided" : "all neighbour pairings decided"))
+        << "\n\nEntrant          games   wins  draws losses  score     Elo   TrueSkill\n";
+    for (int i : order) {
+        const Standing& s = _standings[i];
+        double score = s.games > 0 ? (s.wins + 0.5 * s.draws) / s.games : 0.0;
+        out << std::left << std::setw(14) << s.name << std::right << std::setw(8) << s.games << std::setw(7)
+            << s.wins << std::setw(7) << s.draws << std::setw(7) << s.losses << std::fixed << std::setprecision(3)
+            << std::setw(7) << score << std::setprecision(0) << std::setw(8) << s.elo << std::setprecision(2)
+            << std::setw(8) << s.mu << " +- " << s.sigma << "\n";
+    }
+    out << "\nHead to head                     games   W-D-L         LLR  verdict\n";
+    for (const PairRecord& pair : _pairs) {
+        if (pair.games() == 0) {
+            continue;
+        }
+        std::string names = _standings[pair.first].name + " vs " + _standings[pair.second].name;
+        std::string wdl = std::to_string(pair.wins) + "-" + std::to_string(pair.draws) + "-" +
+                          std::to_string(pair.losses);
+        const char* verdict = pair.verdict > 0 ? "first stronger" : (pair.verdict < 0 ? "second stronger" : "open");
+        out << std::left << std::setw(30) << names << std::right << std::setw(8) << pair.games() << "   "
+            << std::left << std::setw(12) << wdl << std::right << std::setprecision(2) << std::setw(6) << pair.llr
+            << "  " << verdict << "\n";
+    }
+}
+
+}
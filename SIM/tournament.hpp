@@ -0,0 +1,220 @@
+// idocohen963@gmail.com
+#ifndef TOURNAMENT_HPP
+#define TOURNAMENT_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "campaign.hpp"
+
+/**
+ * @file tournament.hpp
+ * @brief Self-play tournaments between bot policies, with Elo and TrueSkill ratings and
+ * sequential tests that stop a comparison as soon as it is decided.
+ */
+
+namespace coup {
+
+/**
+ * @enum Pairing
+ * @brief How the matches of a round are drawn.
+ */
+enum class Pairing : uint8_t {
+    RoundRobin,  ///< Every undecided pair of entrants plays every round
+    Swiss        ///< Entrants are sorted by rating and neighbours play each other
+};
+
+/**
+ * @struct Entrant
+ * @brief A policy taking part in a tournament.
+ */
+struct Entrant {
+    std::string name;         ///< Name shown in the standings
+    PolicyFactory makePolicy; ///< Creates the policy, once per worker thread
+};
+
+/**
+ * @struct TournamentConfig
+ * @brief Parameters of a tournament.
+ */
+struct TournamentConfig {
+    Pairing pairing = Pairing::RoundRobin;
+    uint64_t maxGames = 20000;     ///< Games over the whole tournament
+    uint64_t gamesPerMatch = 64;   ///< Games of a pair per round (played in pairs with the sides swapped)
+    int minSeats = 2;              ///< Smallest table
+    int maxSeats = 6;              ///< Largest table
+    uint64_t seed = 1;             ///< Base seed of the lineups and the games
+    int maxActions = 1000;         ///< Action limit per game, a draw when reached
+    double eloK = 16;              ///< Elo update factor
+    double margin = 20;            ///< The test decides which side is this many Elo points stronger
+    double alpha = 0.05;           ///< Chance to call the weaker side stronger
+    double beta = 0.05;            ///< Chance to call the stronger side weaker
+};
+
+/**
+ * @struct Standing
+ * @brief Results and ratings of one entrant.
+ */
+struct Standing {
+    std::string name;
+    uint64_t games = 0;
+    uint64_t wins = 0;
+    uint64_t draws = 0;
+    uint64_t losses = 0;
+    double elo = 1500;        ///< Elo rating, updated after every game
+    double mu = 25;           ///< TrueSkill mean skill
+    double sigma = 25.0 / 3;  ///< TrueSkill uncertainty
+
+    /**
+     * @brief Returns the conservative TrueSkill estimate.
+     * @return mu - 3 sigma.
+     */
+    double conservative() const { return mu - 3 * sigma; }
+};
+
+/**
+ * @struct PairRecord
+ * @brief Head to head results of two entrants and the state of their sequential test.
+ */
+struct PairRecord {
+    int first;            ///< Index of the first entrant
+    int second;           ///< Index of the second entrant
+    uint64_t wins = 0;    ///< Games won by the first entrant
+    uint64_t draws = 0;
+    uint64_t losses = 0;  ///< Games won by the second entrant
+    double llr = 0;       ///< Log likelihood ratio of "first stronger" over "second stronger"
+    int verdict = 0;      ///< 1 if the first is stronger, -1 if the second is, 0 while undecided
+
+    /**
+     * @brief Returns the number of games the pair played.
+     * @return The number of games.
+     */
+    uint64_t games() const { return wins + draws + losses; }
+};
+
+/**
+ * @brief Returns the log likelihood ratio of a score between a margin above and a margin below
+ * even strength (generalised SPRT with the normal approximation of the trinomial results).
+ * @param wins Games won.
+ * @param draws Games drawn.
+ * @param losses Games lost.
+ * @param margin The Elo difference tested either side of zero.
+ * @return The ratio: positive when the results favour the winning side.
+ */
+double sprtLlr(uint64_t wins, uint64_t draws, uint64_t losses, double margin);
+
+/**
+ * @class Tournament
+ * @brief Plays head to head matches between registered policies and rates them.
+ *
+ * A match game seats two entrants on a random lineup: random roles (created through the
+ * PlayerFactory like every simulated table) and a random split of the seats between the two.
+ * Every lineup is played twice with the sides swapped, so neither side keeps the lucky seats.
+ * A game is won by the side of the last player standing.
+ *
+ * The games of a round run on the work-stealing pool; their results are applied in game order,
+ * so ratings and verdicts only depend on the configuration, not on the thread count. After every
+ * game the Elo and TrueSkill ratings of both sides are updated and the sequential test of the
+ * pair moves on; a pair whose test crosses a bound is decided and no longer scheduled. The
+ * tournament stops when every pair that matters is decided (every pair in a round robin, the
+ * neighbours in the rating order in a Swiss tournament) or when the game budget is spent.
+ */
+class Tournament {
+public:
+    /**
+     * @brief Constructor.
+     * @param config The tournament parameters.
+     * @throws std::invalid_argument on an illegal table size.
+     */
+    explicit Tournament(const TournamentConfig& config);
+
+    /**
+     * @brief Registers an entrant.
+     * @param name Name of the entrant.
+     * @param makePolicy Creates the policy of the entrant.
+     */
+    void add(const std::string& name, PolicyFactory makePolicy);
+
+    /**
+     * @brief Plays rounds until every relevant pair is decided or the game budget is spent.
+     * @param pool The pool to run on.
+     * @throws std::invalid_argument with fewer than two entrants.
+     */
+    void run(WorkStealingPool& pool);
+
+    /**
+     * @brief Returns the standings, in order of registration.
+     * @return One standing per entrant.
+     */
+    const std::vector<Standing>& standings() const { return _standings; }
+
+    /**
+     * @brief Returns the head to head records of every pair that played.
+     * @return The records, in the order the pairs first played.
+     */
+    const std::vector<PairRecord>& pairs() const { return _pairs; }
+
+    /**
+     * @brief Returns the number of games played.
+     * @return The number of games.
+     */
+    uint64_t games() const { return _games; }
+
+    /**
+     * @brief Returns the number of rounds played.
+     * @return The number of rounds.
+     */
+    int rounds() const { return _rounds; }
+
+    /**
+     * @brief Returns whether the tournament stopped because no undecided pair was left to schedule
+     * (every pair in a round robin, the neighbours in a Swiss tournament), not because of the budget.
+     * @return Whether the tournament stopped early.
+     */
+    bool finished() const { return _finished; }
+
+    /**
+     * @brief Returns whether every pair that played has a verdict. A finished Swiss tournament
+     * may leave pairs that stopped being neighbours undecided.
+     * @return Whether every comparison is decided.
+     */
+    bool decided() const;
+
+    /**
+     * @brief Returns the entrants from the strongest: by Elo, except where a decided head to
+     * head test between neighbours says otherwise.
+     * @return Entrant indices.
+     */
+    std::vector<int> ranking() const;
+
+    /**
+     * @brief Prints the standings in ranking order, and the head to head records.
+     * @param out The stream to write to.
+     */
+    void report(std::ostream& out) const;
+
+private:
+    /**
+     * @brief One game of a round: the pair, and the side that won (1 first, -1 second, 0 draw).
+     */
+    struct Played {
+        size_t pair;
+        int outcome;
+    };
+
+    TournamentConfig _config;
+    std::vector<Entrant> _entrants;
+    std::vector<Standing> _standings;
+    std::vector<PairRecord> _pairs;
+    uint64_t _games;
+    int _rounds;
+    bool _finished;
+
+    size_t record(int first, int second);
+    std::vector<size_t> schedule();
+    void rate(const Played& game);
+};
+
+}
+#endif
@@ -0,0 +1,155 @@
+// idocohen963@gmail.com
+#include "turnflow.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace coup {
+
+TurnFlow::TurnFlow(Game& game)
+    : _game(game), _await(Await::Nothing), _asked(-1), _actor(-1), _canceller(-1), _winner(-1),
+      _announced{ActionType::Gather, -1} {
+    _moves.reserve(4 + 4 * MAX_PLAYERS);
+}
+
+void TurnFlow::start() {
+    Game::Binding binding(_game);
+    beginTurn();
+}
+
+void TurnFlow::act(Move move) {
+    if (_await != Await::Action) {
+        throw std::runtime_error("No action is awaited");
+    }
+    bool needsTarget = move.action == ActionType::Coup || move.action == ActionType::Arrest ||
+                       move.action == ActionType::Sanction || move.action == ActionType::SpyOn;
+    const std::vector<Player*>& players = _game.getPlayers();
+    int seat = _game.getCurrentPlayerIndex();
+    if (!needsTarget) {
+        move.target = -1;
+    } else if (move.target < 0 || move.target >= static_cast<int>(players.size()) || move.target == seat ||
+               !players[move.target]->isActive()) {
+        throw std::runtime_error("This action needs another active player as target");
+    }
+
+    // Some rules are only checked by the player after it changed state (an Arrest clears the last
+    // arrest before checking the coins of a Merchant), so refuse what is not legal up front
+    bool legal = std::any_of(_moves.begin(), _moves.end(), [&move](const Move& m) {
+        return m.action == move.action && m.target == move.target;
+    });
+    if (!legal) {
+        throw std::runtime_error("The rules refuse this action");
+    }
+
+    Game::Binding binding(_game);
+    Simulator::applyMove(_game, move);
+    _actor = seat;
+    _announced = move;
+    _canceller = -1;
+    askCancels(0);
+}
+
+bool TurnFlow::answer(bool cancel) {
+    if (_await != Await::Cancel) {
+        throw std::runtime_error("No cancel answer is awaited");
+    }
+    Game::Binding binding(_game);
+    if (!cancel) {
+        askCancels(static_cast<size_t>(_asked) + 1);
+        return false;
+    }
+    try {
+        Simulator::applyCancel(_game, _asked, _actor, _announced);
+    } catch (const std::runtime_error&) {
+        askCancels(static_cast<size_t>(_asked) + 1);
+        throw;
+    }
+    _canceller = _asked; // Only one player can cancel
+    beginTurn();
+    return true;
+}
+
+void TurnFlow::expire(Timeout policy) {
+    Game::Binding binding(_game);
+    if (_await == Await::Cancel) {
+        askCancels(static_cast<size_t>(_asked) + 1);
+        return;
+    }
+    if (_await != Await::Action) {
+        return;
+    }
+    bool canGather = std::any_of(_moves.begin(), _moves.end(),
+                                 [](const Move& move) { return move.action == ActionType::Gather; });
+    if (policy == Timeout::Gather && canGather) {
+        _actor = _game.getCurrentPlayerIndex();
+        _announced = Move{ActionType::Gather, -1};
+        _canceller = -1;
+        Simulator::applyMove(_game, _announced);
+        askCancels(0);
+    } else if (policy == Timeout::Forfeit) {
+        // Leaves like a couped player; the turn goes on with the next active player
+        _game.getCurrentPlayer()->setActive(false);
+        _game.setNumPlayers(_game.getNumPlayers() - 1);
+        if (_game.getLastStep() == ActionType::Bribe) {
+            _game.setLastStep(ActionType::Gather);
+        }
+        beginTurn();
+    } else {
+        Simulator::passTurn(_game);
+        beginTurn();
+    }
+}
+
+/**
+ * @brief Ends the game if one player remains, otherwise suspends for the action of the next
+ * player with legal moves.
+ * Passing clears the turn-scoped flags of the player, so some player can always move after a few passes.
+ */
+void TurnFlow::beginTurn() {
+    _asked = -1;
+    _moves.clear();
+    if (Simulator::countActive(_game) <= 1) {
+        _await = Await::Nothing;
+        const std::vector<Player*>& players = _game.getPlayers();
+        for (size_t i = 0; i < players.size(); ++i) {
+            if (players[i]->isActive()) {
+                _winner = static_cast<int>(i);
+            }
+        }
+        return;
+    }
+    for (int passes = 0; passes <= 2 * MAX_PLAYERS; ++passes) {
+        if (!_game.getCurrentPlayer()->isActive()) {
+            _game.nextTurn();
+        }
+        Simulator::legalMoves(_game, _moves);
+        if (!_moves.empty()) {
+            _await = Await::Action;
+            return;
+        }
+        Simulator::passTurn(_game);
+    }
+    _await = Await::Nothing; // No one can move any more, the game cannot go on
+}
+
+/**
+ * @brief Suspends for the answer of the next player able to cancel, in seat order, or begins
+ * the next turn.
+ */
+void TurnFlow::askCancels(size_t from) {
+    const std::vector<Player*>& players = _game.getPlayers();
+    for (size_t i = from; i < players.size(); ++i) {
+        const Player* p = players[i];
+        if (static_cast<int>(i) == _actor || !p->isActive() || !p->canCancel(_announced.action)) {
+            continue;
+        }
+        if (p->getRole() == Role::General && p->getCoins() < 5) {
+            continue;
+        }
+        _await = Await::Cancel;
+        _asked = static_cast<int>(i);
+        return;
+    }
+    beginTurn();
+}
+
+}
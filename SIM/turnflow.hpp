@@ -0,0 +1,148 @@
+// idocohen963@gmail.com
+#ifndef TURNFLOW_HPP
+#define TURNFLOW_HPP
+
+#include <cstdint>
+#include <vector>
+#include "simulator.hpp"
+
+/**
+ * @file turnflow.hpp
+ * @brief The turn of a game as a procedure that suspends while it waits for a player.
+ */
+
+namespace coup {
+
+/**
+ * @class TurnFlow
+ * @brief Plays the turns of a started game, one decision of a player at a time.
+ *
+ * A turn runs until it needs a decision, then suspends: first for the action of the current
+ * player, then, once the action is announced, for the answer of every player able to cancel it,
+ * in seat order, until one cancels. The decision resumes the turn where it stopped (act() or
+ * answer()), and so does a timeout (expire()), which takes the default decision instead.
+ *
+ * A suspended turn is nothing but the fields of the flow: no thread and no stack wait for the
+ * player, so one thread can drive thousands of tables, each resumed by the event that concerns
+ * it. The server tables and the GUI logic thread both play their games through a TurnFlow.
+ *
+ * The rules of the window are the ones of the simulator: a General is only asked if they can
+ * afford the 5 coin cancel, a cancel refused by the rules counts as a no, and a player without
+ * legal moves passes. Every call binds the game to the calling thread (see Game::Binding).
+ */
+class TurnFlow {
+public:
+    /**
+     * @enum Await
+     * @brief Where the turn is suspended.
+     */
+    enum class Await : uint8_t {
+        Action,   ///< The action of the current player
+        Cancel,   ///< The answer of the asked player about the announced action
+        Nothing   ///< The game is over
+    };
+
+    /**
+     * @enum Timeout
+     * @brief What a player who let their turn expire does.
+     */
+    enum class Timeout : uint8_t {
+        Pass,     ///< Nothing, the turn passes
+        Gather,   ///< Gathers if they can, otherwise passes
+        Forfeit   ///< Leaves the game
+    };
+
+    /**
+     * @brief Constructor. The flow waits for nothing until start().
+     * @param game The game to play, which outlives the flow.
+     */
+    explicit TurnFlow(Game& game);
+
+    /**
+     * @brief Starts the first turn of a started game.
+     */
+    void start();
+
+    /**
+     * @brief Returns where the turn is suspended.
+     * @return What the flow waits for.
+     */
+    Await awaiting() const { return _await; }
+
+    /**
+     * @brief Returns the seat asked whether to cancel.
+     * @return The seat while awaiting a Cancel answer, -1 otherwise.
+     */
+    int asked() const { return _asked; }
+
+    /**
+     * @brief Returns the seat of the player whose action was announced last.
+     * @return The seat, or -1 before the first action.
+     */
+    int actor() const { return _actor; }
+
+    /**
+     * @brief Returns the action announced last, the one a Cancel answer is about.
+     * @return The move.
+     */
+    const Move& announced() const { return _announced; }
+
+    /**
+     * @brief Returns the seat that cancelled the action announced last.
+     * @return The seat, or -1 if no one cancelled it (yet).
+     */
+    int canceller() const { return _canceller; }
+
+    /**
+     * @brief Returns the winner once the game is over.
+     * @return The seat of the last active player, or -1 (game not over, or no one could move).
+     */
+    int winner() const { return _winner; }
+
+    /**
+     * @brief Returns the legal moves of the current player while awaiting an Action.
+     * @return The moves.
+     */
+    const std::vector<Move>& legalMoves() const { return _moves; }
+
+    /**
+     * @brief Resumes a turn awaiting an Action with the action of the current player.
+     * @param move The action and its target (ignored for untargeted actions).
+     * @throws std::runtime_error if no action is awaited, the target is not another active player,
+     * or the rules refuse the action. The turn stays suspended where it was.
+     */
+    void act(Move move);
+
+    /**
+     * @brief Resumes a turn awaiting a Cancel with the answer of the asked player.
+     * @param cancel Whether the asked player cancels the action.
+     * @return Whether the action was cancelled.
+     * @throws std::runtime_error if no answer is awaited. A cancel refused by the rules throws
+     * too, after the turn moved on as if the player had answered no.
+     */
+    bool answer(bool cancel);
+
+    /**
+     * @brief Resumes the turn with the default decision of the awaited player: a cancel window
+     * moves on as if the asked player answered no, and a turn ends as the policy says.
+     * Does nothing once the game is over.
+     * @param policy What the current player does when their turn expires.
+     */
+    void expire(Timeout policy = Timeout::Pass);
+
+private:
+    Game& _game;
+    Await _await;
+    int _asked;
+    int _actor;
+    int _canceller;
+    int _winner;
+    Move _announced;
+    std::vector<Move> _moves;  ///< Legal moves of the awaited turn
+
+    void beginTurn();
+    void askCancels(size_t from);
+};
+
+}
+#endif
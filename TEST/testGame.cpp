@@ -3,6 +3,7 @@
 #include "doctest.h"
 #include <vector>
 #include <string>
+#include <thread>
 #include "GAME/game.hpp"
 #include "PLAYER/player.hpp"
 #include "PLAYER/governor.hpp"
@@ -422,3 +423,137 @@ TEST_CASE("Last action tracking") {
 }
 
 
+
+// ============================================================
+// SNAPSHOT TESTS
+// ============================================================
+
+TEST_CASE("Restoring a snapshot undoes the following actions") {
+    resetGame(); // Reset game state before test
+    Game& game = Game::getInstance();
+
+    createFullGame(game);
+    std::vector<Player*> players = game.getPlayers();
+    players[0]->setCoins(8);
+    players[0]->tax();
+    GameSnapshot saved = game.snapshot();
+
+    // Play a different line: arrest, sanction and a coup
+    players[1]->setCoins(3);
+    players[1]->arrest(*players[0]);
+    players[2]->setCoins(7);
+    players[2]->coup(*players[3]);
+    CHECK_FALSE(players[3]->isActive());
+    CHECK_EQ(game.getCurrentPlayerIndex(), 4);
+
+    game.restore(saved);
+    CHECK_EQ(game.getPlayers(), players); // Same player objects
+    CHECK_EQ(game.getCurrentPlayerIndex(), 1);
+    CHECK_EQ(game.getNumPlayers(), 6);
+    CHECK_EQ(game.getLastStep(), ActionType::Tax);
+    CHECK_EQ(players[0]->getCoins(), 11);
+    CHECK_FALSE(players[0]->isLastArrested());
+    CHECK_EQ(players[1]->getCoins(), 0);
+    CHECK_EQ(players[2]->getCoins(), 0);
+    CHECK(players[3]->isActive());
+
+    // The restored position plays on normally
+    players[1]->gather();
+    CHECK_EQ(game.getCurrentPlayerIndex(), 2);
+}
+
+TEST_CASE("Snapshot keeps the turn flags") {
+    resetGame(); // Reset game state before test
+    Game& game = Game::getInstance();
+
+    createSimpleGame(game);
+    Player* alice = game.getPlayers()[0];
+    alice->setCoins(5);
+    alice->bribe();
+    alice->setSanctioned(true);
+    GameSnapshot saved = game.snapshot();
+
+    game.setLastStep(ActionType::Gather);
+    alice->setIsBribed(false);
+    alice->setSanctioned(false);
+    alice->setCanArrest(false);
+
+    game.restore(saved);
+    CHECK_EQ(game.getLastStep(), ActionType::Bribe);
+    CHECK(alice->getIsBribed());
+    CHECK(alice->isSanctioned());
+    CHECK(alice->isCanArrest());
+    CHECK_EQ(alice->getCoins(), 1);
+}
+
+TEST_CASE("Restoring a snapshot of other players should throw exception") {
+    resetGame(); // Reset game state before test
+    Game& game = Game::getInstance();
+
+    createSimpleGame(game);
+    GameSnapshot twoPlayers = game.snapshot();
+    resetGame();
+    createFullGame(game);
+    CHECK_THROWS_AS(game.restore(twoPlayers), std::runtime_error);
+
+    GameSnapshot swapped = game.snapshot();
+    swapped.roles[0] = Role::Baron;
+    CHECK_THROWS_AS(game.restore(swapped), std::runtime_error);
+    CHECK(game.getPlayers()[0]->isActive());
+}
+
+// ============================================================
+// THREAD BINDING TESTS
+// ============================================================
+
+TEST_CASE("A bound game is played from another thread") {
+    resetGame(); // Reset game state before test
+    Game& game = Game::getInstance();
+    createSimpleGame(game);
+    Player* alice = game.getPlayers()[0];
+
+    std::thread logic([&game, alice] {
+        CHECK(Game::getInstance().getPlayers().empty()); // The thread's own game
+        Game::Binding binding(game);
+        CHECK_EQ(&Game::getInstance(), &game);
+        alice->tax();
+    });
+    logic.join();
+
+    CHECK_EQ(alice->getCoins(), 3);
+    CHECK_EQ(game.getCurrentPlayerIndex(), 1);
+    CHECK_EQ(game.getLastStep(), ActionType::Tax);
+}
+
+TEST_CASE("Bindings are undone in reverse order") {
+    resetGame(); // Reset game state before test
+    Game& game = Game::getInstance();
+
+    std::thread worker([&game] {
+        Game& own = Game::getInstance();
+        {
+            Game::Binding outer(game);
+            {
+                Game::Binding inner(own);
+                CHECK_EQ(&Game::getInstance(), &own);
+            }
+            CHECK_EQ(&Game::getInstance(), &game);
+        }
+        CHECK_EQ(&Game::getInstance(), &own);
+    });
+    worker.join();
+}
+
+TEST_CASE("Created games are independent of the thread's game") {
+    resetGame(); // Reset game state before test
+    std::unique_ptr<Game> table = Game::create();
+    CHECK_NE(table.get(), &Game::getInstance());
+    {
+        Game::Binding binding(*table);
+        createSimpleGame(*table);
+        table->getPlayers()[0]->gather();
+    }
+    CHECK(Game::getInstance().getPlayers().empty());
+    CHECK_EQ(table->getPlayers()[0]->getCoins(), 1);
+    CHECK_EQ(table->getCurrentPlayerIndex(), 1);
+}
@@ -0,0 +1,818 @@
+// idocohen963@gmail.com
+#include "doctest.h"
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "GAME/game.hpp"
+#include "SERVER/protocol.hpp"
+#include "SERVER/table.hpp"
+#include "SERVER/server.hpp"
+#include "SERVER/timerwheel.hpp"
+
+using namespace coup;
+
+/**
+ * Test suite for the game server: wire protocol, tables and the event loop
+ */
+
+extern void resetGame();
+
+namespace {
+
+/**
+ * @brief Reads frames from a blocking socket until a reply arrives, keeping the state up to date.
+ */
+Reply readReply(int fd, std::string& input, TableState* state = nullptr) {
+    char buffer[4096];
+    while (true) {
+        const char* body;
+        size_t size;
+        size_t frame = nextFrame(input.data(), input.size(), body, size);
+        if (frame > 0) {
+            MessageType type = frameType(body);
+            Reply reply;
+            if (type == MessageType::State) {
+                if (state) decodeState(body, size, *state);
+            } else if (type == MessageType::Delta) {
+                if (state) {
+                    StateDelta delta;
+                    decodeDelta(body, size, delta);
+                    applyDelta(delta, *state);
+                }
+            } else {
+                decodeReply(body, size, reply);
+            }
+            input.erase(0, frame);
+            if (type != MessageType::State && type != MessageType::Delta) {
+                return reply;
+            }
+            continue;
+        }
+        ssize_t received = read(fd, buffer, sizeof(buffer));
+        REQUIRE(received > 0);
+        input.append(buffer, static_cast<size_t>(received));
+    }
+}
+
+}
+
+TEST_SUITE("Server Tests") {
+
+    TEST_CASE("Protocol messages round trip") {
+        std::string bytes;
+        Request act;
+        act.type = MessageType::Act;
+        act.seq = 300000;
+        act.table = 42;
+        act.seat = 3;
+        act.action = ActionType::Coup;
+        act.target = 5;
+        encodeRequest(act, bytes);
+        Request add;
+        add.type = MessageType::AddPlayer;
+        add.seq = 1;
+        add.table = 42;
+        add.role = Role::Judge;
+        add.name = "Alice";
+        encodeRequest(add, bytes);
+
+        const char* body;
+        size_t size;
+        size_t frame = nextFrame(bytes.data(), bytes.size(), body, size);
+        REQUIRE(frame > 0);
+        CHECK_EQ(nextFrame(bytes.data(), frame - 1, body, size), 0); // Incomplete
+        Request decoded;
+        decodeRequest(body, size, decoded);
+        CHECK(decoded.type == MessageType::Act);
+        CHECK_EQ(decoded.seq, 300000u);
+        CHECK_EQ(decoded.table, 42u);
+        CHECK_EQ(decoded.seat, 3);
+        CHECK(decoded.action == ActionType::Coup);
+        CHECK_EQ(decoded.target, 5);
+        CHECK(frame < 12); // Varints keep an action small
+
+        REQUIRE(nextFrame(bytes.data() + frame, bytes.size() - frame, body, size) > 0);
+        decodeRequest(body, size, decoded);
+        CHECK(decoded.role == Role::Judge);
+        CHECK_EQ(decoded.name, "Alice");
+
+        TableState state;
+        state.table = 7;
+        state.version = 9;
+        state.phase = ServerPhase::CancelWindow;
+        state.current = 1;
+        state.asked = 0;
+        state.playerCount = 2;
+        state.roles[0] = Role::Governor;
+        state.roles[1] = Role::Baron;
+        state.coins[1] = 12;
+        state.active[0] = state.active[1] = true;
+        state.sanctioned[1] = true;
+        bytes.clear();
+        encodeState(state, bytes);
+        REQUIRE(nextFrame(bytes.data(), bytes.size(), body, size) == bytes.size());
+        TableState copy;
+        decodeState(body, size, copy);
+        CHECK_EQ(copy.version, 9u);
+        CHECK(copy.phase == ServerPhase::CancelWindow);
+        CHECK_EQ(copy.asked, 0);
+        CHECK_EQ(copy.winner, -1);
+        CHECK(copy.roles[1] == Role::Baron);
+        CHECK_EQ(copy.coins[1], 12);
+        CHECK(copy.sanctioned[1]);
+        CHECK_FALSE(copy.sanctioned[0]);
+    }
+
+    TEST_CASE("State deltas carry only the changes") {
+        TableState before;
+        before.table = 70000;
+        before.version = 40;
+        before.phase = ServerPhase::Turn;
+        before.current = 2;
+        before.playerCount = 6;
+        for (int i = 0; i < 6; ++i) {
+            before.roles[i] = static_cast<Role>(i);
+            before.coins[i] = 2 + i;
+            before.active[i] = true;
+        }
+        TableState after = before;
+        after.version = 42;
+        after.current = 3;
+        after.coins[2] += 3;
+        after.active[5] = false;
+
+        std::string full;
+        encodeState(after, full);
+        std::string bytes;
+        REQUIRE(encodeDelta(before, after, bytes));
+        CHECK(bytes.size() * 2 < full.size());
+        const char* body;
+        size_t size;
+        REQUIRE(nextFrame(bytes.data(), bytes.size(), body, size) == bytes.size());
+        CHECK(frameType(body) == MessageType::Delta);
+        StateDelta delta;
+        decodeDelta(body, size, delta);
+        CHECK_EQ(delta.step, 2u);
+        CHECK_EQ(delta.changes, DeltaChange::Current | DeltaChange::Coins | DeltaChange::Flags);
+        TableState applied = before;
+        applyDelta(delta, applied);
+        std::string reencoded;
+        encodeState(applied, reencoded);
+        CHECK_EQ(reencoded, full);
+
+        bytes.clear();
+        TableState other = before;
+        other.table = 1;
+        CHECK_THROWS_AS(applyDelta(delta, other), std::runtime_error);
+        TableState seated = after;
+        seated.playerCount = 5; // A change of players needs a full state
+        CHECK_FALSE(encodeDelta(seated, after, bytes));
+        CHECK(bytes.empty());
+        std::string badChanges("\x85\x01\x01\x40", 4);
+        CHECK_THROWS_AS(decodeDelta(badChanges.data(), badChanges.size(), delta), std::runtime_error);
+        std::string seventhSeat("\x85\x01\x01\x10\x40\x05", 6); // Coins of seat 6
+        CHECK_THROWS_AS(decodeDelta(seventhSeat.data(), seventhSeat.size(), delta), std::runtime_error);
+    }
+
+    TEST_CASE("Malformed frames are rejected") {
+        const char* body;
+        size_t size;
+        std::string empty("\0\0", 2);
+        CHECK_THROWS_AS(nextFrame(empty.data(), empty.size(), body, size), std::runtime_error);
+        std::string huge("\xff\xff", 2);
+        CHECK_THROWS_AS(nextFrame(huge.data(), huge.size(), body, size), std::runtime_error);
+
+        Request request;
+        std::string unknown("\x7f\x01", 2);
+        CHECK_THROWS_AS(decodeRequest(unknown.data(), unknown.size(), request), std::runtime_error);
+        std::string badRole("\x02\x01\x01\x09", 4); // AddPlayer with role 9
+        CHECK_THROWS_AS(decodeRequest(badRole.data(), badRole.size(), request), std::runtime_error);
+        std::string trailing("\x01\x01\x00", 3); // CreateTable with an extra byte
+        CHECK_THROWS_AS(decodeRequest(trailing.data(), trailing.size(), request), std::runtime_error);
+    }
+
+    TEST_CASE("Server tables follow the turn and cancel flow") {
+        resetGame();
+        Game::getInstance().addPlayer("Bystander", "Spy");
+
+        ServerTable table(1);
+        table.addPlayer("Alice", Role::Spy);
+        table.addPlayer("Bob", Role::Governor);
+        CHECK_THROWS_AS(table.act(0, ActionType::Tax, -1), std::runtime_error); // Not started
+        table.start();
+        CHECK(table.phase() == ServerPhase::Turn);
+        CHECK_THROWS_AS(table.addPlayer("Carol", Role::Judge), std::runtime_error);
+        CHECK_THROWS_AS(table.act(1, ActionType::Gather, -1), std::runtime_error); // Not Bob's turn
+
+        table.act(0, ActionType::Tax, -1);
+        TableState state;
+        table.capture(state);
+        CHECK(state.phase == ServerPhase::CancelWindow);
+        CHECK_EQ(state.asked, 1);
+        CHECK_EQ(state.coins[0], 2);
+        CHECK_THROWS_AS(table.answer(0, true), std::runtime_error); // Alice was not asked
+        uint32_t version = table.version();
+        table.answer(1, true);
+        CHECK(table.version() > version);
+        table.capture(state);
+        CHECK(state.phase == ServerPhase::Turn);
+        CHECK_EQ(state.current, 1);
+        CHECK_EQ(state.coins[0], 0);
+
+        // A Gather cannot be cancelled, the turn goes on without a cancel window
+        table.act(1, ActionType::Gather, -1);
+        CHECK(table.phase() == ServerPhase::Turn);
+        CHECK_THROWS_AS(table.act(0, ActionType::Coup, -1), std::runtime_error); // Needs a target
+
+        // The table never touched the game of the thread
+        CHECK_EQ(Game::getInstance().getNumPlayers(), 1);
+        resetGame();
+    }
+
+    TEST_CASE("Server tables change nothing when they refuse an action") {
+        ServerTable table(1);
+        table.addPlayer("Alice", Role::Baron);
+        table.addPlayer("Bob", Role::Governor);
+        table.addPlayer("Carol", Role::Merchant);
+        table.start();
+        for (int seat = 0; seat < 3; ++seat) {
+            table.act(seat, ActionType::Gather, -1);
+        }
+        table.act(0, ActionType::Arrest, 1);
+        REQUIRE(table.snapshot().players[1].lastArrested);
+
+        // Carol is a Merchant with one coin: the arrest is refused, and Bob stays the last arrested
+        GameSnapshot before = table.snapshot();
+        uint32_t version = table.version();
+        CHECK_THROWS_AS(table.act(1, ActionType::Arrest, 2), std::runtime_error);
+        CHECK_THROWS_AS(table.act(1, ActionType::Invest, -1), std::runtime_error); // Not a Baron
+        GameSnapshot after = table.snapshot();
+        CHECK_EQ(table.version(), version);
+        CHECK_EQ(after.currentPlayerIndex, before.currentPlayerIndex);
+        CHECK_EQ(after.lastStep, before.lastStep);
+        for (int seat = 0; seat < 3; ++seat) {
+            CHECK_EQ(after.players[seat].coins, before.players[seat].coins);
+            CHECK_EQ(after.players[seat].lastArrested, before.players[seat].lastArrested);
+            CHECK_EQ(after.players[seat].canArrest, before.players[seat].canArrest);
+            CHECK_EQ(after.players[seat].sanctioned, before.players[seat].sanctioned);
+        }
+    }
+
+    TEST_CASE("Server tables end with a winner") {
+        ServerTable table(1);
+        table.addPlayer("Alice", Role::Baron);
+        table.addPlayer("Bob", Role::Baron);
+        table.start();
+        TableState state;
+        while (table.phase() != ServerPhase::GameOver) {
+            table.capture(state);
+            int self = state.current;
+            if (state.coins[self] >= 7) {
+                table.act(self, ActionType::Coup, 1 - self);
+            } else {
+                table.act(self, ActionType::Tax, -1);
+            }
+        }
+        table.capture(state);
+        CHECK_EQ(state.winner, 0); // Alice taxes first, so she reaches 7 coins first
+        CHECK_FALSE(state.active[1]);
+    }
+
+    TEST_CASE("Expired turns pass, gather or forfeit") {
+        ServerTable table(1);
+        table.addPlayer("Alice", Role::Spy);
+        table.addPlayer("Bob", Role::Governor);
+        table.addPlayer("Carol", Role::Merchant);
+        table.expire(TurnFlow::Timeout::Forfeit); // Seating, nothing to expire
+        CHECK(table.phase() == ServerPhase::Seating);
+        table.start();
+
+        TableState state;
+        table.expire(TurnFlow::Timeout::Pass);
+        table.capture(state);
+        CHECK_EQ(state.current, 1);
+        CHECK_EQ(state.coins[0], 0);
+
+        table.expire(TurnFlow::Timeout::Gather);
+        table.capture(state);
+        CHECK(state.phase == ServerPhase::Turn); // Nobody can cancel a Gather
+        CHECK_EQ(state.current, 2);
+        CHECK_EQ(state.coins[1], 1);
+
+        table.act(2, ActionType::Tax, -1);
+        table.capture(state);
+        REQUIRE(state.phase == ServerPhase::CancelWindow);
+        CHECK_EQ(state.asked, 1); // The Governor
+        table.expire(TurnFlow::Timeout::Forfeit); // An unanswered cancel question is a no
+        table.capture(state);
+        CHECK(state.phase == ServerPhase::Turn);
+        CHECK_EQ(state.current, 0);
+        CHECK_EQ(state.coins[2], 2);
+
+        table.expire(TurnFlow::Timeout::Forfeit);
+        table.capture(state);
+        CHECK_FALSE(state.active[0]);
+        CHECK_EQ(state.current, 1);
+        table.expire(TurnFlow::Timeout::Forfeit);
+        table.capture(state);
+        CHECK(state.phase == ServerPhase::GameOver);
+        CHECK_EQ(state.winner, 2);
+    }
+
+    TEST_CASE("Timer wheels expire every timer at its tick") {
+        TimerWheel wheel(100);
+        std::vector<uint64_t> delays = {0, 1, 63, 64, 65, 4095, 4096, 4097, 262143, 262145, 300000};
+        std::map<uint64_t, uint64_t> due; // Payload -> expiry tick
+        for (uint64_t delay : delays) {
+            wheel.schedule(delay, delay);
+            due[delay] = 100 + std::max<uint64_t>(delay, 1);
+        }
+        TimerWheel::Handle cancelled = wheel.schedule(10, 999);
+        CHECK(wheel.cancel(cancelled));
+        CHECK_FALSE(wheel.cancel(cancelled)); // Already stopped
+        CHECK_FALSE(wheel.cancel(0));
+        CHECK_EQ(wheel.size(), delays.size());
+
+        std::vector<uint64_t> expired;
+        for (uint64_t tick = 101; tick <= 100 + 5000; ++tick) { // Tick by tick across two levels
+            wheel.advance(tick, expired);
+            for (uint64_t payload : expired) {
+                CHECK_EQ(due[payload], tick);
+            }
+            expired.clear();
+        }
+        CHECK_EQ(wheel.size(), 3u);
+        TimerWheel::Handle reused = wheel.schedule(5, 7); // Takes the node of an expired timer
+        CHECK_FALSE(wheel.cancel(cancelled));
+        wheel.advance(400000, expired); // One jump: in order of expiry
+        CHECK(expired == std::vector<uint64_t>({7, 262143, 262145, 300000}));
+        CHECK_FALSE(wheel.cancel(reused));
+        CHECK_EQ(wheel.size(), 0u);
+
+        // Beyond the span of the wheel, a timer waits and is placed again
+        uint64_t far = (uint64_t(1) << (TimerWheel::SLOT_BITS * TimerWheel::LEVELS)) + 1000;
+        expired.clear();
+        wheel.schedule(far, 1);
+        wheel.schedule(3, 2);
+        wheel.advance(400000 + far - 1, expired);
+        CHECK(expired == std::vector<uint64_t>({2}));
+        wheel.advance(400000 + far, expired);
+        CHECK(expired == std::vector<uint64_t>({2, 1}));
+        wheel.advance(500000 + far * 2, expired); // Empty, jumps at once
+        CHECK_EQ(wheel.now(), 500000 + far * 2);
+    }
+
+    TEST_CASE("The server plays a game over a Unix socket") {
+        std::string path = "/tmp/coup_test_server_" + std::to_string(getpid()) + ".sock";
+        GameServer server;
+        server.listenUnix(path);
+        std::thread loop([&server] { server.run(); });
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        REQUIRE(fd >= 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::copy(path.begin(), path.end(), address.sun_path);
+        REQUIRE(connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+
+        std::string input;
+        std::string output;
+        auto exchange = [&](Request& request, TableState* state = nullptr) {
+            output.clear();
+            encodeRequest(request, output);
+            REQUIRE(write(fd, output.data(), output.size()) == static_cast<ssize_t>(output.size()));
+            return readReply(fd, input, state);
+        };
+
+        Request request;
+        request.type = MessageType::CreateTable;
+        request.seq = 1;
+        Reply reply = exchange(request);
+        CHECK(reply.type == MessageType::Created);
+        CHECK_EQ(reply.seq, 1u);
+        request.table = reply.table;
+
+        request.type = MessageType::AddPlayer;
+        request.seq = 2;
+        request.role = Role::Governor;
+        request.name = "Alice";
+        CHECK(exchange(request).type == MessageType::Ok);
+        request.seq = 3;
+        request.name = "Alice"; // Duplicate names are refused by the game
+        reply = exchange(request);
+        CHECK(reply.type == MessageType::Error);
+        CHECK_FALSE(reply.error.empty());
+        request.seq = 4;
+        request.role = Role::Merchant;
+        request.name = "Bob";
+        CHECK(exchange(request).type == MessageType::Ok);
+
+        TableState state;
+        request.type = MessageType::Subscribe;
+        request.seq = 5;
+        CHECK(exchange(request, &state).type == MessageType::Ok);
+        CHECK(state.phase == ServerPhase::Seating);
+        CHECK_EQ(state.playerCount, 2);
+
+        request.type = MessageType::StartGame;
+        request.seq = 6;
+        CHECK(exchange(request, &state).type == MessageType::Ok);
+        CHECK(state.phase == ServerPhase::Turn); // Pushed before the reply
+
+        request.type = MessageType::Act;
+        request.seq = 7;
+        request.seat = 0;
+        request.action = ActionType::Tax;
+        request.target = -1;
+        CHECK(exchange(request, &state).type == MessageType::Ok);
+        CHECK_EQ(state.coins[0], 3); // A Governor's tax
+        CHECK_EQ(state.current, 1);
+
+        request.seq = 8; // Alice again, but it is Bob's turn
+        reply = exchange(request, &state);
+        CHECK(reply.type == MessageType::Error);
+        CHECK_EQ(reply.seq, 8u);
+
+        request.type = MessageType::StartGame;
+        request.seq = 9;
+        request.table = 999;
+        reply = exchange(request);
+        CHECK(reply.type == MessageType::Error);
+        CHECK_EQ(reply.error, "Unknown table");
+
+        close(fd);
+        server.stop();
+        loop.join();
+        CHECK_EQ(server.requests(), 9u);
+        CHECK_EQ(server.tablesCreated(), 1u);
+    }
+
+    TEST_CASE("Pipelined requests to a table are published as one delta") {
+        std::string path = "/tmp/coup_test_deltas_" + std::to_string(getpid()) + ".sock";
+        GameServer server;
+        server.listenUnix(path);
+        std::thread loop([&server] { server.run(); });
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        REQUIRE(fd >= 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::copy(path.begin(), path.end(), address.sun_path);
+        REQUIRE(connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+
+        std::string input;
+        std::string output;
+        Request request;
+        request.type = MessageType::CreateTable;
+        encodeRequest(request, output);
+        REQUIRE(write(fd, output.data(), output.size()) == static_cast<ssize_t>(output.size()));
+        request.table = readReply(fd, input).table;
+        // Seat, subscribe and start in one write
+        output.clear();
+        request.type = MessageType::AddPlayer;
+        request.role = Role::Governor;
+        request.name = "Alice";
+        encodeRequest(request, output);
+        request.role = Role::Spy;
+        request.name = "Bob";
+        encodeRequest(request, output);
+        request.type = MessageType::Subscribe;
+        encodeRequest(request, output);
+        request.type = MessageType::StartGame;
+        encodeRequest(request, output);
+        REQUIRE(write(fd, output.data(), output.size()) == static_cast<ssize_t>(output.size()));
+        TableState state;
+        for (int reply = 0; reply < 4; ++reply) {
+            CHECK(readReply(fd, input, &state).type == MessageType::Ok);
+        }
+        REQUIRE(state.phase == ServerPhase::Turn);
+        uint32_t version = state.version;
+
+        // Alice gathers, Bob gathers, Alice gathers: three requests read in one go
+        output.clear();
+        request.type = MessageType::Act;
+        request.action = ActionType::Gather;
+        for (int seat : {0, 1, 0}) {
+            request.seat = seat;
+            encodeRequest(request, output);
+        }
+        REQUIRE(write(fd, output.data(), output.size()) == static_cast<ssize_t>(output.size()));
+        char buffer[4096];
+        int deltas = 0;
+        int replies = 0;
+        while (replies < 3) {
+            const char* body;
+            size_t size;
+            size_t frame = nextFrame(input.data(), input.size(), body, size);
+            if (frame == 0) {
+                ssize_t received = read(fd, buffer, sizeof(buffer));
+                REQUIRE(received > 0);
+                input.append(buffer, static_cast<size_t>(received));
+                continue;
+            }
+            if (frameType(body) == MessageType::Delta) {
+                CHECK_EQ(replies, 0); // The states come before the replies
+                StateDelta delta;
+                decodeDelta(body, size, delta);
+                applyDelta(delta, state);
+                ++deltas;
+            } else {
+                Reply reply;
+                decodeReply(body, size, reply);
+                CHECK(reply.type == MessageType::Ok);
+                ++replies;
+            }
+            input.erase(0, frame);
+        }
+        CHECK_EQ(deltas, 1); // Read together, published together
+        CHECK_EQ(state.version, version + 3);
+        CHECK_EQ(state.coins[0], 2);
+        CHECK_EQ(state.coins[1], 1);
+        CHECK_EQ(state.current, 1);
+
+        close(fd);
+        server.stop();
+        loop.join();
+    }
+
+    TEST_CASE("A half closed connection gets every reply before it is closed") {
+        std::string path = "/tmp/coup_test_halfclose_" + std::to_string(getpid()) + ".sock";
+        GameServer server;
+        server.listenUnix(path);
+        std::thread loop([&server] { server.run(); });
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        REQUIRE(fd >= 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::copy(path.begin(), path.end(), address.sun_path);
+        REQUIRE(connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+
+        std::string input;
+        std::string output;
+        Request request;
+        request.type = MessageType::CreateTable;
+        encodeRequest(request, output);
+        REQUIRE(write(fd, output.data(), output.size()) == static_cast<ssize_t>(output.size()));
+        request.table = readReply(fd, input).table;
+        // Seat two players and stop sending in the same breath
+        output.clear();
+        request.type = MessageType::AddPlayer;
+        request.role = Role::Governor;
+        request.name = "Alice";
+        encodeRequest(request, output);
+        request.role = Role::Spy;
+        request.name = "Bob";
+        encodeRequest(request, output);
+        REQUIRE(write(fd, output.data(), output.size()) == static_cast<ssize_t>(output.size()));
+        REQUIRE(shutdown(fd, SHUT_WR) == 0);
+        CHECK(readReply(fd, input).type == MessageType::Ok);
+        CHECK(readReply(fd, input).type == MessageType::Ok);
+        char buffer[64];
+        CHECK(input.empty());
+        CHECK_EQ(read(fd, buffer, sizeof(buffer)), 0); // Closed once answered
+
+        close(fd);
+        server.stop();
+        loop.join();
+    }
+
+    TEST_CASE("The server expires turns and cancel windows on time") {
+        std::string path = "/tmp/coup_test_timers_" + std::to_string(getpid()) + ".sock";
+        GameServer server;
+        server.setTurnLimits(std::chrono::milliseconds(30), std::chrono::milliseconds(20), TurnFlow::Timeout::Gather);
+        server.listenUnix(path);
+        std::thread loop([&server] { server.run(); });
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        REQUIRE(fd >= 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::copy(path.begin(), path.end(), address.sun_path);
+        REQUIRE(connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+
+        std::string input;
+        std::string output;
+        Request request;
+        request.type = MessageType::CreateTable;
+        encodeRequest(request, output);
+        REQUIRE(write(fd, output.data(), output.size()) == static_cast<ssize_t>(output.size()));
+        request.table = readReply(fd, input).table;
+        output.clear();
+        request.type = MessageType::AddPlayer;
+        request.role = Role::Spy;
+        request.name = "Alice";
+        encodeRequest(request, output);
+        request.role = Role::Governor;
+        request.name = "Bob";
+        encodeRequest(request, output);
+        request.type = MessageType::Subscribe;
+        encodeRequest(request, output);
+        request.type = MessageType::StartGame;
+        encodeRequest(request, output);
+        request.type = MessageType::Act; // Alice taxes, then nobody says a word
+        request.seat = 0;
+        request.action = ActionType::Tax;
+        request.target = -1;
+        encodeRequest(request, output);
+        REQUIRE(write(fd, output.data(), output.size()) == static_cast<ssize_t>(output.size()));
+        TableState state;
+        for (int reply = 0; reply < 5; ++reply) {
+            CHECK(readReply(fd, input, &state).type == MessageType::Ok);
+        }
+        auto asked = std::chrono::steady_clock::now();
+        REQUIRE(state.phase == ServerPhase::CancelWindow);
+        CHECK_EQ(state.asked, 1);
+
+        // Bob lets the cancel window run out, then his turn: he gathers
+        std::vector<TableState> seen;
+        char buffer[4096];
+        while (seen.size() < 2) {
+            const char* body;
+            size_t size;
+            size_t frame = nextFrame(input.data(), input.size(), body, size);
+            if (frame == 0) {
+                ssize_t received = read(fd, buffer, sizeof(buffer));
+                REQUIRE(received > 0);
+                input.append(buffer, static_cast<size_t>(received));
+                continue;
+            }
+            REQUIRE(frameType(body) == MessageType::Delta);
+            StateDelta delta;
+            decodeDelta(body, size, delta);
+            applyDelta(delta, state);
+            seen.push_back(state);
+            input.erase(0, frame);
+        }
+        CHECK(std::chrono::steady_clock::now() - asked >= std::chrono::milliseconds(45));
+        CHECK(seen[0].phase == ServerPhase::Turn);
+        CHECK_EQ(seen[0].current, 1);
+        CHECK_EQ(seen[0].coins[0], 2); // The tax went through
+        CHECK(seen[1].phase == ServerPhase::Turn);
+        CHECK_EQ(seen[1].current, 0);
+        CHECK_EQ(seen[1].coins[1], 1);
+
+        close(fd);
+        server.stop();
+        loop.join();
+    }
+
+    TEST_CASE("Tables migrate between shards while their games go on") {
+        std::string path = "/tmp/coup_test_shards_" + std::to_string(getpid()) + ".sock";
+        GameServer server(3);
+        server.setBalancing(std::chrono::milliseconds(1), 1); // Anything busier than the rest moves
+        server.listenUnix(path);
+        std::thread loop([&server] { server.run(); });
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        REQUIRE(fd >= 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::copy(path.begin(), path.end(), address.sun_path);
+        REQUIRE(connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+
+        // Every table is created by the one connection, so they all start on its shard
+        const int TABLES = 60;
+        std::map<uint32_t, TableState> states;
+        std::string input;
+        std::string output;
+        uint32_t seq = 0;
+        uint64_t sent = 0;
+        int errors = 0;
+        // Reads until the given number of replies arrived, applying the states and deltas
+        auto awaitReplies = [&](size_t expected) {
+            Reply reply;
+            char buffer[4096];
+            while (expected > 0) {
+                const char* body;
+                size_t size;
+                size_t frame = nextFrame(input.data(), input.size(), body, size);
+                if (frame == 0) {
+                    ssize_t received = read(fd, buffer, sizeof(buffer));
+                    REQUIRE(received > 0);
+                    input.append(buffer, static_cast<size_t>(received));
+                    continue;
+                }
+                if (frameType(body) == MessageType::State) {
+                    TableState state;
+                    decodeState(body, size, state);
+                    states[state.table] = state;
+                } else if (frameType(body) == MessageType::Delta) {
+                    StateDelta delta;
+                    decodeDelta(body, size, delta);
+                    REQUIRE(states.count(delta.table) == 1);
+                    CHECK(delta.step > 0);
+                    applyDelta(delta, states[delta.table]);
+                } else {
+                    decodeReply(body, size, reply);
+                    errors += reply.type == MessageType::Error;
+                    --expected;
+                }
+                input.erase(0, frame);
+            }
+            return reply;
+        };
+        auto exchange = [&](Request& request) {
+            request.seq = ++seq;
+            output.clear();
+            encodeRequest(request, output);
+            REQUIRE(write(fd, output.data(), output.size()) == static_cast<ssize_t>(output.size()));
+            ++sent;
+            return awaitReplies(1);
+        };
+        for (int t = 0; t < TABLES; ++t) {
+            Request request;
+            request.type = MessageType::CreateTable;
+            Reply reply = exchange(request);
+            REQUIRE(reply.type == MessageType::Created);
+            request.table = reply.table;
+            request.type = MessageType::AddPlayer;
+            request.role = Role::Governor;
+            request.name = "Alice";
+            REQUIRE(exchange(request).type == MessageType::Ok);
+            request.role = Role::Merchant;
+            request.name = "Bob";
+            REQUIRE(exchange(request).type == MessageType::Ok);
+            request.type = MessageType::Subscribe;
+            REQUIRE(exchange(request).type == MessageType::Ok);
+            request.type = MessageType::StartGame;
+            REQUIRE(exchange(request).type == MessageType::Ok);
+        }
+        REQUIRE_EQ(states.size(), static_cast<size_t>(TABLES));
+
+        // Rounds of one request per running table, sent in one write; replies of tables owned by
+        // different shards may come in any order, but every table keeps its own in order
+        for (int round = 0; round < 500; ++round) {
+            output.clear();
+            size_t expected = 0;
+            for (const auto& entry : states) {
+                const TableState& state = entry.second;
+                if (state.phase == ServerPhase::GameOver) {
+                    continue;
+                }
+                Request request;
+                request.table = state.table;
+                request.seq = ++seq;
+                if (state.phase == ServerPhase::CancelWindow) {
+                    request.type = MessageType::Answer;
+                    request.seat = state.asked;
+                    request.cancel = false;
+                } else {
+                    request.type = MessageType::Act;
+                    request.seat = state.current;
+                    request.action = state.coins[state.current] >= 7 ? ActionType::Coup : ActionType::Tax;
+                    request.target = 1 - state.current;
+                }
+                encodeRequest(request, output);
+                ++expected;
+            }
+            if (expected == 0) {
+                break;
+            }
+            REQUIRE(write(fd, output.data(), output.size()) == static_cast<ssize_t>(output.size()));
+            sent += expected;
+            awaitReplies(expected);
+        }
+
+        close(fd);
+        server.stop();
+        loop.join();
+        CHECK_EQ(errors, 0);
+        for (const auto& entry : states) {
+            CHECK(entry.second.phase == ServerPhase::GameOver);
+            CHECK(entry.second.winner >= 0);
+        }
+        std::vector<ShardMetrics> metrics = server.metrics();
+        REQUIRE_EQ(metrics.size(), 3u);
+        uint64_t requests = 0;
+        uint64_t migrated = 0;
+        for (const ShardMetrics& shard : metrics) {
+            requests += shard.requests;
+            migrated += shard.migratedOut;
+        }
+        CHECK_EQ(requests, sent);
+        CHECK(migrated > 0);
+        CHECK(metrics[1].requests + metrics[2].requests > 0); // The other shards took over tables
+    }
+
+    TEST_CASE("Latency histograms report bucket bounds") {
+        LatencyHistogram histogram;
+        CHECK_EQ(histogram.percentile(0.5), 0.0);
+        for (int i = 0; i < 99; ++i) {
+            histogram.record(1000); // 1 us
+        }
+        histogram.record(1000000); // 1 ms
+        double median = histogram.percentile(0.5);
+        CHECK(median >= 1.0);
+        CHECK(median < 1.25);
+        CHECK(histogram.percentile(0.99) < 1.25);
+        double top = histogram.percentile(1.0);
+        CHECK(top >= 1000.0);
+        CHECK(top < 1250.0);
+    }
+}
@@ -0,0 +1,1218 @@
+// idocohen963@gmail.com
+#include "doctest.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include "GAME/game.hpp"
+#include "SIM/simulator.hpp"
+#include "SIM/campaign.hpp"
+#include "SIM/statistics.hpp"
+#include "SIM/exporter.hpp"
+#include "SIM/archive.hpp"
+#include "SIM/spectator.hpp"
+#include "SIM/timeline.hpp"
+#include "SIM/turnflow.hpp"
+#include "SIM/search.hpp"
+#include "SIM/evaluator.hpp"
+#include "SIM/tournament.hpp"
+#include "SIM/belief.hpp"
+#include "SIM/openingbook.hpp"
+
+using namespace coup;
+
+/**
+ * Test suite for the headless simulator and the parallel campaign runner
+ */
+
+extern void resetGame();
+
+TEST_SUITE("Simulation Tests") {
+
+    TEST_CASE("Legal moves never throw when applied") {
+        RandomPolicy policy(0.5);
+        Simulator simulator(policy);
+        Rng rng(7);
+        Lineup lineup = {Role::Governor, Role::Spy, Role::Baron, Role::General, Role::Judge, Role::Merchant};
+
+        // Every move listed by legalMoves goes through the real Player actions, which throw on illegal moves
+        for (int i = 0; i < 300; ++i) {
+            GameResult result = simulator.playGame(lineup, rng);
+            CHECK(result.actions > 0);
+            CHECK(result.winner < static_cast<int>(lineup.size()));
+        }
+        resetGame();
+    }
+
+    TEST_CASE("Legal moves respect the forced coup rule") {
+        resetGame();
+        Game& game = Game::getInstance();
+        game.setVerbose(false);
+        Player* alice = game.addPlayer("Alice", "Governor");
+        game.addPlayer("Bob", "Spy");
+        game.startGame();
+        alice->setCoins(10);
+
+        std::vector<Move> moves;
+        Simulator::legalMoves(game, moves);
+        REQUIRE_EQ(moves.size(), 1);
+        CHECK_EQ(moves[0].action, ActionType::Coup);
+        CHECK_EQ(moves[0].target, 1);
+        game.setVerbose(true);
+        resetGame();
+    }
+
+    TEST_CASE("Sanctioned player without coins passes the turn") {
+        resetGame();
+        Game& game = Game::getInstance();
+        game.setVerbose(false);
+        Player* alice = game.addPlayer("Alice", "Governor");
+        game.addPlayer("Bob", "Spy");
+        game.startGame();
+        alice->setSanctioned(true);
+
+        std::vector<Move> moves;
+        Simulator::legalMoves(game, moves);
+        CHECK(moves.empty());
+
+        Simulator::passTurn(game);
+        CHECK_EQ(game.getCurrentPlayerIndex(), 1);
+        CHECK_FALSE(alice->isSanctioned());
+        game.setVerbose(true);
+        resetGame();
+    }
+
+    TEST_CASE("Each thread has its own game instance") {
+        Game* mainGame = &Game::getInstance();
+        Game* workerGame = nullptr;
+        std::thread worker([&] { workerGame = &Game::getInstance(); });
+        worker.join();
+        CHECK(workerGame != nullptr);
+        CHECK(workerGame != mainGame);
+    }
+
+    TEST_CASE("Campaign results do not depend on the number of threads") {
+        resetGame();
+        Game::getInstance().addPlayer("Alice", "Judge");
+
+        CampaignConfig config;
+        config.games = 600;
+        config.shardSize = 50;
+        config.lineups = {{Role::Baron, Role::Spy}, {Role::Governor, Role::Judge, Role::General, Role::Merchant}};
+        PolicyFactory factory = [] { return std::make_unique<RandomPolicy>(0.3); };
+
+        WorkStealingPool single(1);
+        WorkStealingPool several(4);
+        CampaignTotals a = runCampaign(config, factory, single);
+        CampaignTotals b = runCampaign(config, factory, several);
+
+        CHECK_EQ(a.games, 600);
+        CHECK_EQ(b.games, 600);
+        CHECK_EQ(a.actions, b.actions);
+        CHECK_EQ(a.draws, b.draws);
+        CHECK(a.wins == b.wins);
+        CHECK_EQ(a.seats[static_cast<int>(Role::Baron)], 300);
+
+        // The caller's game is untouched by the workers
+        CHECK_EQ(Game::getInstance().getNumPlayers(), 1);
+        resetGame();
+    }
+
+    TEST_CASE("Campaign totals merge by summing") {
+        CampaignTotals a;
+        CampaignTotals b;
+        a.add({Role::Spy, Role::Baron}, GameResult{1, 10});
+        b.add({Role::Spy, Role::Baron}, GameResult{-1, 1000});
+        a.merge(b);
+        CHECK_EQ(a.games, 2);
+        CHECK_EQ(a.draws, 1);
+        CHECK_EQ(a.actions, 1010);
+        CHECK_EQ(a.wins[static_cast<int>(Role::Baron)], 1);
+        CHECK_EQ(a.winRate(Role::Baron), doctest::Approx(0.5));
+    }
+
+    TEST_CASE("Pool rethrows task failures") {
+        WorkStealingPool pool(2);
+        CHECK_THROWS_AS(pool.run(10, [](unsigned, uint64_t task) {
+            if (task == 3) throw std::runtime_error("task failed");
+        }), std::runtime_error);
+    }
+}
+
+TEST_SUITE("Statistics Tests") {
+
+    TEST_CASE("Aggregator counts match the campaign totals") {
+        CampaignConfig config;
+        config.games = 400;
+        config.shardSize = 40;
+        config.lineups = {{Role::Governor, Role::Judge, Role::General}, {Role::Baron, Role::Spy, Role::Merchant}};
+
+        WorkStealingPool pool(3);
+        std::vector<StatisticsAggregator> partials(pool.size());
+        CampaignTotals totals = runCampaign(config, [] { return std::make_unique<RandomPolicy>(0.5); }, pool,
+                                            [&partials](unsigned worker) { return &partials[worker]; });
+        StatisticsAggregator stats;
+        for (const StatisticsAggregator& partial : partials) {
+            stats.merge(partial);
+        }
+
+        CHECK_EQ(stats.games(), totals.games);
+        CHECK_EQ(stats.draws(), totals.draws);
+        CHECK_EQ(stats.lengths().sum, doctest::Approx(static_cast<double>(totals.actions)));
+        for (int r = 0; r < ROLE_COUNT; ++r) {
+            CHECK_EQ(stats.seats(static_cast<Role>(r)), totals.seats[r]);
+            CHECK_EQ(stats.wins(static_cast<Role>(r)), totals.wins[r]);
+        }
+
+        // Only Judge, Governor and General can cancel, and a cancel never fails more often than it is tried
+        CHECK(stats.cancels(Role::Governor).offered > 0);
+        CHECK_EQ(stats.cancels(Role::Spy).offered, 0);
+        CHECK(stats.cancels(Role::Judge).succeeded <= stats.cancels(Role::Judge).attempted);
+        CHECK_EQ(stats.actionCount(Role::Spy, ActionType::Invest), 0);
+        CHECK(stats.actionCount(Role::Baron, ActionType::Invest) > 0);
+    }
+
+    TEST_CASE("Wilson interval contains the win rate") {
+        StatisticsAggregator stats;
+        Lineup lineup = {Role::Spy, Role::Baron};
+        for (int i = 0; i < 100; ++i) {
+            stats.onGameStart(i, lineup);
+            stats.onGameEnd(lineup, GameResult{i % 4 == 0 ? 0 : 1, 20});
+        }
+        CHECK_EQ(stats.winRate(Role::Spy), doctest::Approx(0.25));
+        Interval ci = stats.winRateInterval(Role::Spy);
+        CHECK(ci.low < 0.25);
+        CHECK(ci.high > 0.25);
+        CHECK(ci.low > 0.15);
+        CHECK(ci.high < 0.35);
+
+        Interval unknown = stats.winRateInterval(Role::Judge);
+        CHECK_EQ(unknown.low, 0.0);
+        CHECK_EQ(unknown.high, 1.0);
+    }
+
+    TEST_CASE("Late turns and long games fall into the overflow buckets") {
+        StatisticsAggregator stats;
+        stats.onAction(ActionEvent{100000, 0, Role::Spy, ActionType::Gather, -1, 0, 1, 0, 0, -1});
+        CHECK_EQ(stats.actionCount(Role::Spy, StatisticsAggregator::TURN_BUCKETS - 1, ActionType::Gather), 1);
+        CHECK_EQ(stats.coins(Role::Spy, StatisticsAggregator::TURN_BUCKETS - 1).mean(), doctest::Approx(1.0));
+
+        Lineup lineup = {Role::Spy, Role::Baron};
+        stats.onGameEnd(lineup, GameResult{-1, 1000000});
+        CHECK_EQ(stats.lengthCount(StatisticsAggregator::LENGTH_BUCKETS - 1), 1);
+        CHECK_EQ(stats.lengthQuantile(1.0), StatisticsAggregator::LENGTH_BUCKETS * StatisticsAggregator::LENGTH_BUCKET_WIDTH);
+    }
+}
+
+/**
+ * Records every event, to compare the exported rows against
+ */
+class RecordingObserver : public GameObserver {
+public:
+    std::vector<ActionEvent> actions;
+    std::vector<GameResult> results;
+
+    void onAction(const ActionEvent& event) override { actions.push_back(event); }
+    void onGameEnd(const Lineup&, const GameResult& result) override { results.push_back(result); }
+};
+
+/**
+ * Forwards the events to two observers
+ */
+class PairObserver : public GameObserver {
+public:
+    PairObserver(GameObserver& first, GameObserver& second) : _first(first), _second(second) {}
+    void onGameStart(uint64_t id, const Lineup& l) override { _first.onGameStart(id, l); _second.onGameStart(id, l); }
+    void onAction(const ActionEvent& e) override { _first.onAction(e); _second.onAction(e); }
+    void onGameEnd(const Lineup& l, const GameResult& r) override { _first.onGameEnd(l, r); _second.onGameEnd(l, r); }
+
+private:
+    GameObserver& _first;
+    GameObserver& _second;
+};
+
+TEST_SUITE("Export Tests") {
+
+    TEST_CASE("Columnar export round trips through the reader") {
+        std::ostringstream file(std::ios::binary);
+        RecordingObserver recorded;
+        Lineup lineup = {Role::Baron, Role::Judge, Role::Governor, Role::General};
+        {
+            // Small blocks, so the games and actions span several blocks of each table
+            ColumnarExporter exporter(file, 100);
+            PairObserver both(exporter, recorded);
+            RandomPolicy policy(0.5);
+            Simulator simulator(policy);
+            simulator.setObserver(&both);
+            Rng rng(11);
+            for (uint64_t id = 0; id < 20; ++id) {
+                simulator.playGame(lineup, rng, 1000 + id * 3);
+            }
+            exporter.finish();
+            CHECK_EQ(exporter.bytesWritten(), file.str().size());
+        }
+        resetGame();
+
+        std::istringstream in(file.str(), std::ios::binary);
+        std::vector<GameRecord> games;
+        std::vector<ActionRecord> actions;
+        readColumnar(in, games, actions);
+
+        REQUIRE_EQ(games.size(), 20);
+        for (size_t g = 0; g < games.size(); ++g) {
+            CHECK_EQ(games[g].gameId, 1000 + g * 3);
+            CHECK(games[g].lineup == lineup);
+            CHECK_EQ(games[g].winner, recorded.results[g].winner);
+            CHECK_EQ(games[g].actions, recorded.results[g].actions);
+        }
+        REQUIRE_EQ(actions.size(), recorded.actions.size());
+        for (size_t i = 0; i < actions.size(); ++i) {
+            const ActionEvent& event = recorded.actions[i];
+            CHECK_EQ(actions[i].turn, event.index);
+            CHECK_EQ(actions[i].actor, event.actor);
+            CHECK_EQ(actions[i].actorRole, event.actorRole);
+            CHECK_EQ(actions[i].action, event.action);
+            CHECK_EQ(actions[i].target, event.target);
+            CHECK_EQ(actions[i].actorDelta, event.actorCoinsAfter - event.actorCoinsBefore);
+            CHECK_EQ(actions[i].targetDelta, event.targetCoinsAfter - event.targetCoinsBefore);
+            CHECK_EQ(actions[i].canceller, event.canceller);
+        }
+    }
+
+    TEST_CASE("Columnar reader rejects foreign and truncated files") {
+        std::vector<GameRecord> games;
+        std::vector<ActionRecord> actions;
+        std::istringstream foreign("game_id,players\n");
+        CHECK_THROWS_AS(readColumnar(foreign, games, actions), std::runtime_error);
+
+        std::ostringstream file(std::ios::binary);
+        {
+            ColumnarExporter exporter(file);
+            exporter.onGameStart(5, {Role::Spy, Role::Baron});
+            exporter.onGameEnd({Role::Spy, Role::Baron}, GameResult{1, 12});
+        }
+        std::string bytes = file.str();
+        std::istringstream truncated(bytes.substr(0, bytes.size() - 2), std::ios::binary);
+        CHECK_THROWS_AS(readColumnar(truncated, games, actions), std::runtime_error);
+
+        // A game block claiming 2^40 rows in a 4 byte payload fails before anything is sized from it
+        std::ostringstream empty(std::ios::binary);
+        {
+            ColumnarExporter exporter(empty);
+            exporter.finish();
+        }
+        std::string rows = empty.str() + "G" + std::string(5, '\x80') + "\x20" + "\x04" + std::string(4, '\0');
+        std::istringstream oversized(rows, std::ios::binary);
+        games.clear();
+        CHECK_THROWS_WITH_AS(readColumnar(oversized, games, actions), "Truncated block", std::runtime_error);
+        CHECK(games.empty());
+    }
+
+    TEST_CASE("CSV export writes a header and one line per row") {
+        std::ostringstream gamesFile;
+        std::ostringstream actionsFile;
+        {
+            CsvExporter exporter(gamesFile, actionsFile, 64);
+            Lineup lineup = {Role::Spy, Role::Baron};
+            exporter.onGameStart(7, lineup);
+            exporter.onAction(ActionEvent{0, 0, Role::Spy, ActionType::Gather, -1, 0, 1, 0, 0, -1});
+            exporter.onAction(ActionEvent{1, 1, Role::Baron, ActionType::Tax, -1, 0, 2, 0, 0, -1});
+            exporter.onAction(ActionEvent{2, 0, Role::Spy, ActionType::Arrest, 1, 1, 2, 2, 1, -1});
+            exporter.onGameEnd(lineup, GameResult{1, 3});
+        }
+        CHECK_EQ(gamesFile.str(), "game_id,players,roles,winner,winner_role,actions\n"
+                                  "7,2,Spy;Baron,1,Baron,3\n");
+        std::string actions = actionsFile.str();
+        CHECK_EQ(std::count(actions.begin(), actions.end(), '\n'), 4);
+        CHECK(actions.find("7,2,0,Spy,Arrest,1,1,-1,\n") != std::string::npos);
+    }
+}
+
+TEST_SUITE("Replay Archive Tests") {
+
+    TEST_CASE("Archived games replay to the same result") {
+        std::stringstream file(std::ios::in | std::ios::out | std::ios::binary);
+        std::vector<GameResult> results;
+        {
+            ReplayArchiveWriter writer(file, 7);
+            RandomPolicy policy(0.4);
+            Simulator simulator(policy);
+            simulator.setObserver(&writer);
+            Rng rng(21);
+            Lineup lineups[] = {{Role::Spy, Role::Baron, Role::General}, {Role::Judge, Role::Governor, Role::Merchant, Role::Spy}};
+            for (uint64_t id = 0; id < 30; ++id) {
+                results.push_back(simulator.playGame(lineups[id % 2], rng, 500 + id));
+            }
+            writer.finish();
+        }
+
+        ReplayArchiveReader reader(file);
+        CHECK_EQ(reader.games(), 30);
+        CHECK_EQ(reader.blocks(), 5);
+        ReplayRecord record;
+        // Read out of order, so blocks are reloaded
+        for (uint64_t position : {29, 0, 13, 6, 7, 28}) {
+            reader.read(position, record);
+            CHECK_EQ(record.gameId, 500 + position);
+            CHECK_EQ(record.winner, results[position].winner);
+            GameResult replayed = replayGame(record);
+            CHECK_EQ(replayed.winner, results[position].winner);
+            if (replayed.winner >= 0) {
+                CHECK_EQ(replayed.actions, results[position].actions);
+            }
+        }
+        resetGame();
+
+        REQUIRE(reader.find(517, record));
+        CHECK_EQ(record.gameId, 517);
+        CHECK_EQ(record.lineup.size(), 4);
+        CHECK_FALSE(reader.find(530, record));
+        CHECK_THROWS_AS(reader.read(30, record), std::out_of_range);
+    }
+
+    TEST_CASE("Replaying a prefix stops in the middle of the game") {
+        ReplayRecord record{1, {Role::Governor, Role::Baron}, -1,
+                            {{ActionType::Tax, -1, -1}, {ActionType::Tax, -1, 0}, {ActionType::Gather, -1, -1}}};
+        replayGame(record, 2);
+        Game& game = Game::getInstance();
+        CHECK_EQ(game.getPlayers()[0]->getCoins(), 3);
+        CHECK_EQ(game.getPlayers()[1]->getCoins(), 0); // The Governor cancelled the Baron's tax
+        CHECK_EQ(game.getCurrentPlayerIndex(), 0);
+
+        replayGame(record);
+        CHECK_EQ(game.getPlayers()[0]->getCoins(), 4);
+        game.setVerbose(true);
+        resetGame();
+    }
+
+    TEST_CASE("Reader rejects files that are not archives") {
+        std::stringstream empty(std::ios::in | std::ios::out | std::ios::binary);
+        CHECK_THROWS_AS(ReplayArchiveReader{empty}, std::runtime_error);
+
+        std::stringstream file(std::ios::in | std::ios::out | std::ios::binary);
+        {
+            ReplayArchiveWriter writer(file);
+            writer.add(ReplayRecord{3, {Role::Spy, Role::Baron}, 0, {{ActionType::Gather, -1, -1}}});
+        }
+        std::string bytes = file.str();
+        bytes[bytes.size() - 1] = 'X';
+        std::stringstream damaged(bytes, std::ios::in | std::ios::binary);
+        CHECK_THROWS_AS(ReplayArchiveReader{damaged}, std::runtime_error);
+    }
+}
+
+TEST_SUITE("Live Table Tests") {
+
+    TEST_CASE("Live tables play whole games and publish every move") {
+        LiveTables tables(6, 2, std::chrono::milliseconds(1), 42);
+        REQUIRE_EQ(tables.size(), 6);
+
+        // Every table finishes at least one game within a generous deadline
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        LiveTableState state;
+        bool allPlayed = false;
+        while (!allPlayed && std::chrono::steady_clock::now() < deadline) {
+            allPlayed = true;
+            for (size_t i = 0; i < tables.size(); ++i) {
+                tables.read(i, state);
+                allPlayed = allPlayed && state.gamesPlayed > 0;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        tables.stop();
+        CHECK(allPlayed);
+
+        for (size_t i = 0; i < tables.size(); ++i) {
+            uint64_t version = tables.read(i, state);
+            CHECK_EQ(version, tables.version(i)); // Nothing moves after stop()
+            CHECK_GT(version, 1);
+            CHECK(state.playerCount >= 2);
+            CHECK(state.playerCount <= MAX_PLAYERS);
+            CHECK(state.current >= 0);
+            CHECK(state.current < state.playerCount);
+            int active = 0;
+            for (int seat = 0; seat < state.playerCount; ++seat) {
+                CHECK(state.coins[seat] >= 0);
+                active += state.active[seat] ? 1 : 0;
+            }
+            if (state.finished && state.winner >= 0) {
+                CHECK_EQ(active, 1);
+                CHECK(state.active[state.winner]);
+            }
+        }
+    }
+
+    TEST_CASE("Live tables leave the game of the calling thread alone") {
+        resetGame();
+        Game::getInstance().addPlayer("Alice", "Governor");
+        {
+            LiveTables tables(3, 3, std::chrono::milliseconds(1), 7);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        CHECK_EQ(Game::getInstance().getPlayers().size(), 1);
+        resetGame();
+        CHECK_THROWS_AS(LiveTables(0, 1, std::chrono::milliseconds(1), 7), std::invalid_argument);
+    }
+}
+
+/**
+ * Records one simulated game through the replay archive
+ */
+static GameRecording recordSimulatedGame(const Lineup& lineup, uint64_t seed) {
+    std::stringstream file(std::ios::in | std::ios::out | std::ios::binary);
+    {
+        ReplayArchiveWriter writer(file);
+        RandomPolicy policy(0.4);
+        Simulator simulator(policy);
+        simulator.setObserver(&writer);
+        Rng rng(seed);
+        simulator.playGame(lineup, rng, 1);
+        writer.finish();
+    }
+    ReplayArchiveReader reader(file);
+    GameRecording recording;
+    reader.read(0, recording.record);
+    const char* names[] = {"Ann", "Ben", "Cat", "Dan", "Eve", "Fay"};
+    recording.names.assign(names, names + lineup.size());
+    return recording;
+}
+
+TEST_SUITE("Replay Timeline Tests") {
+
+    TEST_CASE("Seeking matches a replay from the start and never replays more than an interval") {
+        GameRecording recording = recordSimulatedGame({Role::Baron, Role::Judge, Role::Governor, Role::Spy}, 5);
+        const ReplayRecord& record = recording.record;
+        REQUIRE(record.moves.size() > 20);
+
+        // Reference positions, replayed from the start every time
+        std::vector<GameSnapshot> expected;
+        for (size_t m = 0; m <= record.moves.size(); ++m) {
+            replayGame(record, m);
+            expected.push_back(Game::getInstance().snapshot());
+        }
+
+        ReplayTimeline timeline(recording, 8);
+        CHECK_EQ(timeline.length(), record.moves.size());
+        CHECK_EQ(timeline.checkpoints(), record.moves.size() / 8 + 1);
+        CHECK_EQ(timeline.position(), 0);
+        CHECK_EQ(Game::getInstance().getPlayers()[1]->getName(), "Ben");
+        CHECK_EQ(timeline.actor(0), 0);
+        CHECK_EQ(timeline.actor(1), 1);
+
+        size_t last = record.moves.size();
+        for (size_t position : {last, size_t(0), size_t(13), size_t(14), size_t(9), last - 1, size_t(16), size_t(3)}) {
+            size_t replayed = timeline.seek(position);
+            CHECK(replayed < 8);
+            CHECK_EQ(timeline.position(), position);
+            const GameSnapshot state = Game::getInstance().snapshot();
+            CHECK_EQ(state.currentPlayerIndex, expected[position].currentPlayerIndex);
+            for (int seat = 0; seat < state.playerCount; ++seat) {
+                CHECK_EQ(state.players[seat].coins, expected[position].players[seat].coins);
+                CHECK_EQ(state.players[seat].active, expected[position].players[seat].active);
+            }
+        }
+        CHECK_EQ(timeline.seek(last + 10), 0); // Clamped to the end, where it already is
+        Game::getInstance().setVerbose(true);
+        resetGame();
+    }
+
+    TEST_CASE("Recordings round trip through their text form") {
+        GameRecording recording = recordSimulatedGame({Role::Merchant, Role::General}, 9);
+        recording.names[1] = "Ben Junior";
+        std::stringstream file;
+        saveRecording(recording, file);
+
+        GameRecording loaded = loadRecording(file);
+        CHECK_EQ(loaded.names, recording.names);
+        CHECK_EQ(loaded.record.lineup, recording.record.lineup);
+        CHECK_EQ(loaded.record.winner, recording.record.winner);
+        REQUIRE_EQ(loaded.record.moves.size(), recording.record.moves.size());
+        for (size_t m = 0; m < loaded.record.moves.size(); ++m) {
+            CHECK_EQ(loaded.record.moves[m].action, recording.record.moves[m].action);
+            CHECK_EQ(loaded.record.moves[m].target, recording.record.moves[m].target);
+            CHECK_EQ(loaded.record.moves[m].canceller, recording.record.moves[m].canceller);
+        }
+    }
+
+    TEST_CASE("Malformed recordings are rejected") {
+        std::istringstream oneSeat("player Spy Ann\nmove Gather -1 -1\n");
+        CHECK_THROWS_AS(loadRecording(oneSeat), std::runtime_error);
+        std::istringstream badRole("player Pirate Ann\nplayer Spy Ben\n");
+        CHECK_THROWS_AS(loadRecording(badRole), std::runtime_error);
+        std::istringstream badSeat("player Spy Ann\nplayer Baron Ben\nmove Coup 2 -1\n");
+        CHECK_THROWS_AS(loadRecording(badSeat), std::runtime_error);
+        std::istringstream badAction("player Spy Ann\nplayer Baron Ben\nmove Fly -1 -1\n");
+        CHECK_THROWS_AS(loadRecording(badAction), std::runtime_error);
+        std::istringstream valid("# comment\n\nplayer Spy Ann\nplayer Baron Ben\nmove SpyOn 1 -1\nwinner -1\n");
+        CHECK_EQ(loadRecording(valid).record.moves.size(), 1);
+    }
+}
+
+TEST_SUITE("Turn Flow Tests") {
+
+    TEST_CASE("A turn suspends for the action, then for each player able to cancel it") {
+        std::unique_ptr<Game> game = Game::create();
+        Game::Binding binding(*game);
+        Simulator::seatLineup(*game, {Role::Merchant, Role::Governor, Role::Spy, Role::Governor});
+        TurnFlow flow(*game);
+        CHECK(flow.awaiting() == TurnFlow::Await::Nothing);
+        flow.start();
+        REQUIRE(flow.awaiting() == TurnFlow::Await::Action);
+        CHECK_FALSE(flow.legalMoves().empty());
+        CHECK_THROWS_AS(flow.answer(true), std::runtime_error);
+        CHECK_THROWS_AS(flow.act(Move{ActionType::Coup, 0}), std::runtime_error); // Self target
+        CHECK(flow.awaiting() == TurnFlow::Await::Action);
+
+        flow.act(Move{ActionType::Tax, -1});
+        REQUIRE(flow.awaiting() == TurnFlow::Await::Cancel);
+        CHECK_EQ(flow.actor(), 0);
+        CHECK_EQ(flow.asked(), 1); // Governors cancel a tax, in seat order
+        CHECK_EQ(game->getPlayers()[0]->getCoins(), 2);
+        CHECK_FALSE(flow.answer(false));
+        CHECK_EQ(flow.asked(), 3);
+        CHECK(flow.answer(true));
+        CHECK_EQ(flow.canceller(), 3);
+        CHECK_EQ(game->getPlayers()[0]->getCoins(), 0);
+        CHECK(flow.awaiting() == TurnFlow::Await::Action);
+        CHECK_EQ(game->getCurrentPlayerIndex(), 1);
+    }
+
+    TEST_CASE("Expiring takes the default decision") {
+        std::unique_ptr<Game> game = Game::create();
+        Game::Binding binding(*game);
+        Simulator::seatLineup(*game, {Role::Governor, Role::Governor, Role::Spy});
+        TurnFlow flow(*game);
+        flow.start();
+        flow.expire(); // The first player does nothing, the turn passes
+        REQUIRE(flow.awaiting() == TurnFlow::Await::Action);
+        CHECK_EQ(game->getCurrentPlayerIndex(), 1);
+        CHECK_EQ(game->getPlayers()[0]->getCoins(), 0);
+
+        flow.act(Move{ActionType::Tax, -1});
+        REQUIRE(flow.awaiting() == TurnFlow::Await::Cancel);
+        CHECK_EQ(flow.asked(), 0);
+        flow.expire(); // No answer counts as no
+        CHECK(flow.awaiting() == TurnFlow::Await::Action);
+        CHECK_EQ(flow.canceller(), -1);
+        CHECK_EQ(game->getPlayers()[1]->getCoins(), 3);
+        CHECK_EQ(game->getCurrentPlayerIndex(), 2);
+    }
+
+    TEST_CASE("One thread drives thousands of suspended games") {
+        const int TABLES = 2000;
+        std::vector<std::unique_ptr<Game>> games;
+        std::vector<std::unique_ptr<TurnFlow>> flows;
+        Rng rng(11);
+        for (int t = 0; t < TABLES; ++t) {
+            games.push_back(Game::create());
+            Game::Binding binding(*games.back());
+            Lineup lineup;
+            for (int seat = 0; seat < 2 + t % 5; ++seat) {
+                lineup.push_back(static_cast<Role>(rng() % ROLE_COUNT));
+            }
+            Simulator::seatLineup(*games.back(), lineup);
+            flows.emplace_back(new TurnFlow(*games.back()));
+            flows.back()->start();
+        }
+
+        // Every round resumes each running game with one decision, wherever it is suspended
+        int running = TABLES;
+        int rounds = 0;
+        while (running > 0 && rounds < 10000) {
+            running = 0;
+            for (std::unique_ptr<TurnFlow>& flow : flows) {
+                if (flow->awaiting() == TurnFlow::Await::Action) {
+                    const std::vector<Move>& moves = flow->legalMoves();
+                    flow->act(moves[rng() % moves.size()]);
+                } else if (flow->awaiting() == TurnFlow::Await::Cancel) {
+                    try {
+                        flow->answer(rng() % 4 == 0);
+                    } catch (const std::runtime_error&) {
+                        // The rules refused the cancel, the window moved on
+                    }
+                }
+                running += flow->awaiting() != TurnFlow::Await::Nothing;
+            }
+            ++rounds;
+        }
+        CHECK_EQ(running, 0);
+        int won = 0;
+        for (size_t t = 0; t < flows.size(); ++t) {
+            if (flows[t]->winner() >= 0) {
+                ++won;
+                CHECK(games[t]->getPlayers()[flows[t]->winner()]->isActive());
+            }
+        }
+        CHECK(won > TABLES * 9 / 10);
+    }
+}
+
+TEST_SUITE("Search Bot Tests") {
+
+    TEST_CASE("The search bot wins when it can and cancels what would lose") {
+        std::unique_ptr<Game> game = Game::create();
+        Game::Binding binding(*game);
+        Simulator::seatLineup(*game, {Role::Spy, Role::Governor});
+        const std::vector<Player*>& players = game->getPlayers();
+        SearchPolicy search;
+        Rng rng(1);
+
+        players[0]->setCoins(7);
+        players[1]->setCoins(9);
+        std::vector<Move> moves;
+        Simulator::legalMoves(*game, moves);
+        Move chosen = moves[search.chooseMove(*game, moves, rng)];
+        CHECK(chosen.action == ActionType::Coup);
+        CHECK_EQ(chosen.target, 1);
+
+        // The Spy taxes up to 8 coins: only a cancel saves the Governor from the coup that follows,
+        // since an arrest would still leave the Spy 7 coins
+        players[0]->setCoins(6);
+        players[1]->setCoins(0);
+        Move tax{ActionType::Tax, -1};
+        Simulator::applyMove(*game, tax);
+        REQUIRE_EQ(players[0]->getCoins(), 8);
+        CHECK(search.chooseCancel(*game, *players[1], 0, tax, rng));
+        CHECK_EQ(search.stats().decisions, 2u);
+        CHECK(search.stats().nodes > 0);
+    }
+
+    TEST_CASE("The search is deterministic, keeps to its budget and leaves the game alone") {
+        std::unique_ptr<Game> game = Game::create();
+        Game::Binding binding(*game);
+        Simulator::seatLineup(*game, {Role::Baron, Role::Judge, Role::General, Role::Merchant, Role::Spy});
+        for (Player* player : game->getPlayers()) {
+            player->setCoins(4);
+        }
+        GameSnapshot before = game->snapshot();
+        std::vector<Move> moves;
+        Simulator::legalMoves(*game, moves);
+        Rng rng(1);
+
+        SearchConfig config;
+        config.maxDepth = 6;
+        config.nodeBudget = 500;
+        SearchPolicy first(config);
+        SearchPolicy second(config);
+        size_t chosen = first.chooseMove(*game, moves, rng);
+        CHECK_EQ(second.chooseMove(*game, moves, rng), chosen);
+        CHECK(first.stats().averageDepth() >= 1);
+        CHECK(first.stats().averageDepth() < 6); // The budget stopped the deepening
+        CHECK(first.stats().nodes <= config.nodeBudget * 2);
+
+        config.mode = SearchMode::MaxN;
+        SearchPolicy maxN(config);
+        CHECK(maxN.chooseMove(*game, moves, rng) < moves.size());
+
+        GameSnapshot after = game->snapshot();
+        CHECK_EQ(after.currentPlayerIndex, before.currentPlayerIndex);
+        for (int i = 0; i < before.playerCount; ++i) {
+            CHECK_EQ(after.players[i].coins, before.players[i].coins);
+            CHECK_EQ(after.players[i].active, before.players[i].active);
+        }
+        CHECK_EQ(Game::getInstance().getCurrentPlayerIndex(), before.currentPlayerIndex); // Still bound to game
+    }
+
+    TEST_CASE("Search bots play whole games against random bots") {
+        SearchConfig config;
+        config.maxDepth = 3;
+        config.nodeBudget = 2000;
+        SearchPolicy paranoid(config);
+        config.mode = SearchMode::MaxN;
+        SearchPolicy maxN(config);
+        RandomPolicy random(0.5);
+        SeatPolicies policy({&paranoid, &maxN, &random, &random});
+        Simulator simulator(policy, 400);
+        Rng rng(5);
+        int searchWins = 0;
+        for (int g = 0; g < 20; ++g) {
+            GameResult result = simulator.playGame({Role::Governor, Role::Judge, Role::Baron, Role::General}, rng, g);
+            searchWins += result.winner == 0 || result.winner == 1;
+        }
+        CHECK(searchWins > 10); // Half the seats, more than half the wins
+        CHECK(paranoid.stats().decisions > 0);
+        CHECK(maxN.stats().decisions > 0);
+        resetGame();
+    }
+}
+
+TEST_SUITE("Evaluator Tests") {
+
+    TEST_CASE("Positions are scored from the coins, the coup thresholds and the roles") {
+        std::unique_ptr<Game> game = Game::create();
+        Game::Binding binding(*game);
+        Simulator::seatLineup(*game, {Role::General, Role::Merchant, Role::Baron});
+        const std::vector<Player*>& players = game->getPlayers();
+        players[0]->setCoins(10);
+        players[1]->setCoins(3);
+        players[2]->setCoins(6);
+        GameSnapshot state = game->snapshot();
+
+        float features[FEATURE_COUNT];
+        extractFeatures(state, 0, features);
+        CHECK_EQ(features[static_cast<int>(Feature::CoinLead)], 4);
+        CHECK_EQ(features[static_cast<int>(Feature::CanCoup)], 1);
+        CHECK_EQ(features[static_cast<int>(Feature::MustCoup)], 1);
+        CHECK_EQ(features[static_cast<int>(Feature::General)], 1);
+        CHECK_EQ(features[static_cast<int>(Feature::GeneralGuard)], 1);
+        extractFeatures(state, 2, features);
+        CHECK_EQ(features[static_cast<int>(Feature::NearCoup)], 1);
+        CHECK_EQ(features[static_cast<int>(Feature::Threats)], 1);
+        CHECK_EQ(features[static_cast<int>(Feature::BaronInvest)], 1);
+        CHECK_EQ(features[static_cast<int>(Feature::General)], 0);
+
+        EvalWeights weights = EvalWeights();
+        weights[Feature::Coins] = 1;
+        double values[MAX_PLAYERS];
+        evaluatePosition(state, weights, values);
+        CHECK(values[0] > values[2]);
+        CHECK(values[2] > values[1]);
+        CHECK_EQ(values[0] + values[1] + values[2], doctest::Approx(1.0));
+
+        state.players[1].active = false;
+        state.players[2].active = false;
+        evaluatePosition(state, defaultWeights(), values);
+        CHECK_EQ(values[0], doctest::Approx(1.0));
+        CHECK_EQ(values[1], 0);
+    }
+
+    TEST_CASE("Batches score like single positions and read back written weights") {
+        std::unique_ptr<Game> game = Game::create();
+        Game::Binding binding(*game);
+        RandomPolicy policy(0.5);
+        Simulator simulator(policy, 40);
+        Rng rng(3);
+        std::vector<GameSnapshot> states;
+        std::vector<GameSnapshot> secondStates;
+        PositionBatch batch;
+        PositionBatch second;
+        for (int g = 0; g < 10; ++g) {
+            simulator.playGame({Role::Spy, Role::Judge, Role::Merchant, Role::Governor}, rng, g);
+            GameSnapshot state = game->snapshot();
+            if (Simulator::countActive(*game) > 1) {
+                (g % 2 ? secondStates : states).push_back(state);
+                (g % 2 ? second : batch).add(state);
+            }
+        }
+        GameSnapshot over = states.front();
+        for (int i = 1; i < over.playerCount; ++i) {
+            over.players[i].active = false;
+        }
+        batch.add(over); // Ignored, the game is over
+        states.insert(states.end(), secondStates.begin(), secondStates.end());
+        REQUIRE_EQ(batch.positions() + second.positions(), states.size());
+
+        std::stringstream file;
+        writeWeights(file, defaultWeights());
+        EvalWeights weights = readWeights(file);
+        batch.append(second);
+        std::vector<float> values;
+        batch.evaluate(weights, values);
+        REQUIRE_EQ(values.size(), batch.rows());
+        size_t row = 0;
+        for (const GameSnapshot& state : states) {
+            double expected[MAX_PLAYERS];
+            evaluatePosition(state, weights, expected);
+            for (int i = 0; i < state.playerCount; ++i) {
+                if (state.players[i].active) {
+                    CHECK_EQ(values[row++], doctest::Approx(expected[i]).epsilon(1e-4));
+                }
+            }
+        }
+        CHECK_EQ(row, batch.rows());
+
+        std::stringstream unknown("Coins 1\nLuck 2\n");
+        CHECK_THROWS_AS(readWeights(unknown), std::runtime_error);
+        resetGame();
+    }
+
+    TEST_CASE("Tuning fits the winners the same on any number of threads") {
+        CampaignConfig config;
+        config.games = 300;
+        config.shardSize = 50;
+        config.lineups = {{Role::Governor, Role::Spy, Role::Baron}, {Role::Merchant, Role::Judge, Role::General, Role::Spy}};
+        WorkStealingPool pool(2);
+        std::vector<PositionSampler> samplers(pool.size());
+        runCampaign(config, [] { return std::make_unique<RandomPolicy>(0.5); }, pool,
+                    [&samplers](unsigned worker) { return &samplers[worker]; });
+        PositionBatch batch;
+        for (const PositionSampler& sampler : samplers) {
+            batch.append(sampler.batch());
+        }
+        REQUIRE(batch.positions() > 1000);
+
+        TuneConfig tune;
+        tune.iterations = 40;
+        tune.chunk = 256;
+        EvalWeights start = EvalWeights();
+        TuneResult result = tuneWeights(batch, start, tune, pool);
+        CHECK(result.finalLoss < result.initialLoss);
+        CHECK(batch.accuracy(result.weights) > batch.accuracy(start));
+        CHECK(result.weights[Feature::Governor] > result.weights[Feature::Spy]);
+
+        WorkStealingPool single(1);
+        TuneResult again = tuneWeights(batch, start, tune, single);
+        for (int f = 0; f < FEATURE_COUNT; ++f) {
+            CHECK_EQ(again.weights.weight[f], result.weights.weight[f]);
+        }
+        CHECK_THROWS_AS(tuneWeights(PositionBatch(), start, tune, single), std::invalid_argument);
+        resetGame();
+    }
+}
+
+TEST_SUITE("Tournament Tests") {
+
+    TEST_CASE("The sequential test weighs the results symmetrically") {
+        CHECK_EQ(sprtLlr(50, 10, 50, 20), doctest::Approx(0.0));
+        CHECK_EQ(sprtLlr(60, 10, 40, 20), doctest::Approx(-sprtLlr(40, 10, 60, 20)));
+        CHECK(sprtLlr(60, 10, 40, 20) > 0);
+        CHECK(sprtLlr(600, 100, 400, 20) > sprtLlr(60, 10, 40, 20));
+        CHECK(sprtLlr(3, 0, 0, 20) < std::log(19.0)); // A few wins are not proof yet
+    }
+
+    TEST_CASE("A round robin stops once decided, with the same ratings on any number of threads") {
+        TournamentConfig config;
+        config.maxGames = 4000;
+        config.gamesPerMatch = 16;
+        config.maxSeats = 4;
+        SearchConfig search;
+        search.maxDepth = 1;
+        auto play = [&](unsigned threads) {
+            Tournament tournament(config);
+            tournament.add("random", [] { return std::make_unique<RandomPolicy>(0.5); });
+            tournament.add("search", [search] { return std::make_unique<SearchPolicy>(search); });
+            WorkStealingPool pool(threads);
+            tournament.run(pool);
+            return tournament;
+        };
+        Tournament single = play(1);
+        REQUIRE(single.finished());
+        CHECK(single.decided());
+        CHECK(single.games() < config.maxGames);
+        CHECK_EQ(single.games() % 16, 0u);
+        REQUIRE_EQ(single.pairs().size(), 1u);
+        CHECK_EQ(single.pairs()[0].verdict, -1);
+        CHECK_EQ(single.ranking(), std::vector<int>{1, 0});
+        const Standing& random = single.standings()[0];
+        const Standing& bot = single.standings()[1];
+        CHECK(bot.elo > random.elo);
+        CHECK(bot.mu > random.mu);
+        CHECK_EQ(bot.wins, random.losses);
+        CHECK_EQ(bot.games, single.games());
+        CHECK_EQ(random.elo + bot.elo, doctest::Approx(3000));
+
+        Tournament several = play(3);
+        CHECK_EQ(several.games(), single.games());
+        CHECK_EQ(several.standings()[1].elo, single.standings()[1].elo);
+        CHECK_EQ(several.standings()[1].sigma, single.standings()[1].sigma);
+        resetGame();
+    }
+
+    TEST_CASE("A Swiss tournament pairs neighbours and respects the budget") {
+        TournamentConfig config;
+        config.pairing = Pairing::Swiss;
+        config.maxGames = 301;
+        config.gamesPerMatch = 20;
+        Tournament tournament(config);
+        for (double cancel : {0.0, 0.5, 1.0}) {
+            tournament.add("random", [cancel] { return std::make_unique<RandomPolicy>(cancel); });
+        }
+        WorkStealingPool pool(2);
+        tournament.run(pool);
+        CHECK(tournament.games() <= config.maxGames);
+        CHECK_EQ(tournament.games() % 2, 0u);
+        uint64_t played = 0;
+        for (const Standing& standing : tournament.standings()) {
+            played += standing.games;
+            CHECK_EQ(standing.games, standing.wins + standing.draws + standing.losses);
+        }
+        CHECK_EQ(played, 2 * tournament.games()); // Two entrants a game
+        CHECK_EQ(tournament.ranking().size(), 3u);
+        const std::vector<PairRecord>& pairs = tournament.pairs();
+        CHECK_EQ(tournament.decided(),
+                 std::all_of(pairs.begin(), pairs.end(), [](const PairRecord& pair) { return pair.verdict != 0; }));
+
+        Tournament alone(config);
+        alone.add("random", [] { return std::make_unique<RandomPolicy>(0.5); });
+        CHECK_THROWS_AS(alone.run(pool), std::invalid_argument);
+        config.maxSeats = 7;
+        CHECK_THROWS_AS(Tournament{config}, std::invalid_argument);
+        resetGame();
+    }
+}
+
+/**
+ * Feeds the belief and compares it with the real coins after every action
+ */
+class BeliefCheck : public BeliefObserver {
+public:
+    BeliefCheck(BeliefTracker& tracker, int viewer, int joinAt)
+        : BeliefObserver(tracker, viewer, joinAt), _tracker(tracker) {}
+
+    void onAction(const ActionEvent& event) override {
+        BeliefObserver::onAction(event);
+        if (!tracking()) {
+            return;
+        }
+        const Game& game = Game::getInstance();
+        updates++;
+        if (_tracker.position().currentPlayerIndex != game.getCurrentPlayerIndex()) {
+            publicMismatches++;
+        }
+        for (size_t s = 0; s < game.getPlayers().size(); ++s) {
+            const Player* player = game.getPlayers()[s];
+            if (!player->isActive()) {
+                continue;
+            }
+            int coins = player->getCoins();
+            double error = std::abs(_tracker.expectedCoins(static_cast<int>(s)) - coins);
+            totalError += error;
+            worstError = std::max(worstError, error);
+            seatsChecked++;
+            if (_tracker.probabilityAtLeast(static_cast<int>(s), coins) -
+                    _tracker.probabilityAtLeast(static_cast<int>(s), coins + 1) <= 0) {
+                outsideSupport++;
+            }
+        }
+    }
+
+    int updates = 0;
+    int publicMismatches = 0;
+    int seatsChecked = 0;
+    int outsideSupport = 0;
+    double totalError = 0;
+    double worstError = 0;
+
+private:
+    BeliefTracker& _tracker;
+};
+
+TEST_SUITE("Belief Tests") {
+
+    TEST_CASE("Observations keep the coins of the others hidden") {
+        ActionEvent peek{3, 1, Role::Spy, ActionType::SpyOn, 2, 4, 4, 6, 6, -1};
+        Observation seen = observe(peek, 1, 4);
+        CHECK_EQ(seen.revealed, 6);
+        CHECK_EQ(seen.ownCoins, 4);
+        CHECK_EQ(observe(peek, 0).revealed, -1);
+        CHECK_EQ(observe(peek, 2).revealed, -1); // The target does not see it was looked at
+
+        ActionEvent tax{4, 2, Role::Governor, ActionType::Tax, -1, 6, 9, 0, 0, 0};
+        Observation cancelled = observe(tax, 0);
+        CHECK_EQ(cancelled.actor, 2);
+        CHECK_EQ(cancelled.action, ActionType::Tax);
+        CHECK_EQ(cancelled.canceller, 0);
+        CHECK_EQ(cancelled.revealed, -1);
+        CHECK_THROWS_AS(BeliefTracker(0), std::invalid_argument);
+        CHECK_THROWS_AS(BeliefTracker(BeliefTracker::MAX_PARTICLES + 1), std::invalid_argument);
+    }
+
+    TEST_CASE("A belief from the start of the game follows the coins exactly") {
+        RandomPolicy policy(0.5);
+        Simulator simulator(policy);
+        BeliefTracker tracker(16, 3);
+        BeliefCheck check(tracker, 2, 0);
+        simulator.setObserver(&check);
+        Rng rng(11);
+        Lineup lineup = {Role::Merchant, Role::Governor, Role::Spy, Role::Baron, Role::General, Role::Judge};
+        for (int i = 0; i < 30; ++i) {
+            simulator.playGame(lineup, rng, i);
+        }
+        CHECK(check.updates > 300);
+        CHECK_EQ(check.publicMismatches, 0);
+        CHECK_EQ(check.worstError, 0.0);
+        CHECK_EQ(check.outsideSupport, 0);
+        CHECK_EQ(tracker.redraws(), 0u);
+        resetGame();
+    }
+
+    TEST_CASE("A revealed target is pinned and the coins it implies follow") {
+        auto game = Game::create();
+        Game::Binding binding(*game);
+        Simulator::seatLineup(*game, {Role::Spy, Role::Governor});
+        GameSnapshot state = game->snapshot();
+        state.players[0].coins = 3;
+        state.players[1].coins = 4;
+        game->restore(state);
+
+        BeliefTracker tracker(64, 5);
+        tracker.reset(game->snapshot(), 0, 12);
+        CHECK_EQ(tracker.expectedCoins(0), doctest::Approx(3));
+        CHECK(tracker.probabilityAtLeast(1, 5) > 0);
+        CHECK(tracker.probabilityAtLeast(1, 5) < 1);
+
+        REQUIRE(tracker.update(Observation{0, ActionType::SpyOn, 1, -1, 4, 3}));
+        CHECK_EQ(tracker.expectedCoins(1), doctest::Approx(4));
+        CHECK_EQ(tracker.probabilityAtLeast(1, 5), 0.0);
+        REQUIRE(tracker.update(Observation{1, ActionType::Tax, -1, -1, -1, 3}));
+        CHECK_EQ(tracker.expectedCoins(1), doctest::Approx(7)); // A Governor taxes 3
+        CHECK_EQ(tracker.probabilityAtLeast(1, 7), doctest::Approx(1));
+        CHECK_EQ(tracker.position().currentPlayerIndex, 0);
+
+        Rng rng(1);
+        GameSnapshot drawn;
+        tracker.sample(rng, drawn);
+        CHECK_EQ(drawn.players[1].coins, 7);
+        CHECK_EQ(drawn.currentPlayerIndex, 0);
+        CHECK_EQ(game->getPlayers()[1]->getCoins(), 4); // The tracker plays on a game of its own
+    }
+
+    TEST_CASE("A player joining in the middle of a game narrows the prior") {
+        RandomPolicy policy(0.5);
+        Simulator simulator(policy);
+        BeliefTracker tracker(BeliefTracker::MAX_PARTICLES, 9);
+        BeliefCheck check(tracker, 0, 8);
+        simulator.setObserver(&check);
+        Rng rng(21);
+        Lineup lineup = {Role::Spy, Role::Merchant, Role::Governor};
+        for (int i = 0; i < 40; ++i) {
+            simulator.playGame(lineup, rng, i);
+        }
+        REQUIRE(check.seatsChecked > 0);
+        CHECK_EQ(check.publicMismatches, 0);
+        CHECK(check.totalError / check.seatsChecked < 2.0); // The prior alone is off by 3 or more
+        resetGame();
+    }
+}
+
+TEST_SUITE("Opening Book Tests") {
+
+    TEST_CASE("The book table finds what was inserted and round trips through its file") {
+        OpeningBook book(3);
+        Rng rng(4);
+        std::vector<uint64_t> keys;
+        for (int i = 0; i < 5000; ++i) {
+            keys.push_back(rng() | 1);
+            book.insert(BookEntry{keys.back(), Move{ActionType::Arrest, i % MAX_PLAYERS}, 0.25, 100u + i});
+        }
+        CHECK_EQ(book.size(), 5000u);
+        CHECK(book.slots() >= 2 * book.size());
+        book.insert(BookEntry{keys[0], Move{ActionType::Tax, -1}, 1.0, 70000});
+        CHECK_EQ(book.size(), 5000u); // Replaced, not added
+
+        std::stringstream file;
+        book.write(file);
+        CHECK_EQ(file.str().size(), book.fileSize());
+        OpeningBook read = OpeningBook::read(file);
+        CHECK_EQ(read.size(), book.size());
+        CHECK_EQ(read.plies(), 3);
+        BookEntry entry{};
+        REQUIRE(read.find(keys[0], entry));
+        CHECK_EQ(entry.move.action, ActionType::Tax);
+        CHECK_EQ(entry.move.target, -1);
+        CHECK_EQ(entry.score, doctest::Approx(1.0));
+        CHECK_EQ(entry.visits, 0xFFFFu); // Saturated
+        for (int i = 1; i < 5000; ++i) {
+            REQUIRE(read.find(keys[i], entry));
+            CHECK_EQ(entry.move.target, i % MAX_PLAYERS);
+            CHECK_EQ(entry.visits, 100u + i);
+        }
+        CHECK_EQ(entry.score, doctest::Approx(0.25).epsilon(0.01));
+        CHECK_FALSE(read.find(2, entry));
+
+        std::string bytes = file.str();
+        std::stringstream truncated(bytes.substr(0, bytes.size() - 1));
+        CHECK_THROWS_AS(OpeningBook::read(truncated), std::runtime_error);
+        std::stringstream foreign("CPR1" + bytes.substr(4));
+        CHECK_THROWS_AS(OpeningBook::read(foreign), std::runtime_error);
+        // A header claiming 2^31 slots fails on the missing data, not on the allocation
+        std::string huge = bytes;
+        huge[4] = huge[5] = huge[6] = 0;
+        huge[7] = static_cast<char>(0x80);
+        std::stringstream oversized(huge);
+        CHECK_THROWS_WITH_AS(OpeningBook::read(oversized), "Truncated opening book", std::runtime_error);
+        // Move the entry of keys[1] to an empty slot, where a lookup cannot reach it
+        auto slotOf = [&bytes, &book](uint64_t key) {
+            for (size_t i = 0; i < book.slots(); ++i) {
+                uint64_t stored = 0;
+                std::memcpy(&stored, bytes.data() + 16 + 12 * i, 8);
+                if (stored == key) {
+                    return i;
+                }
+            }
+            return book.slots();
+        };
+        std::string moved = bytes;
+        std::swap_ranges(moved.begin() + 16 + 12 * slotOf(keys[1]), moved.begin() + 28 + 12 * slotOf(keys[1]),
+                         moved.begin() + 16 + 12 * slotOf(0));
+        std::stringstream misplaced(moved);
+        CHECK_THROWS_AS(OpeningBook::read(misplaced), std::runtime_error);
+        CHECK_THROWS_AS(book.insert(BookEntry{0, Move{ActionType::Gather, -1}, 0, 0}), std::invalid_argument);
+    }
+
+    TEST_CASE("Position keys tell positions apart") {
+        auto game = Game::create();
+        Game::Binding binding(*game);
+        Simulator::seatLineup(*game, {Role::Baron, Role::Judge, Role::Spy});
+        GameSnapshot state = game->snapshot();
+        const uint64_t start = positionKey(state);
+        CHECK_NE(start, 0u);
+        CHECK_EQ(positionKey(game->snapshot()), start);
+        GameSnapshot other = state;
+        other.players[1].coins = 1;
+        CHECK_NE(positionKey(other), start);
+        other = state;
+        other.currentPlayerIndex = 1;
+        CHECK_NE(positionKey(other), start);
+        other = state;
+        other.players[2].sanctioned = true;
+        CHECK_NE(positionKey(other), start);
+        other = state;
+        other.roles[2] = Role::Merchant;
+        CHECK_NE(positionKey(other), start);
+    }
+
+    TEST_CASE("Books are built the same on any number of threads and played from the start") {
+        BookConfig config;
+        config.plies = 2;
+        config.gamesPerLineup = 3000;
+        config.minVisits = 16;
+        config.shardSize = 500;
+        std::vector<Lineup> lineups = {{Role::Baron, Role::Governor}, {Role::Merchant, Role::Spy, Role::Judge}};
+        auto build = [&](unsigned threads, BookStats& stats) {
+            WorkStealingPool pool(threads);
+            std::stringstream file;
+            buildOpeningBook(config, lineups, pool, nullptr, &stats).write(file);
+            return file.str();
+        };
+        BookStats single;
+        BookStats several;
+        std::string bytes = build(1, single);
+        CHECK_EQ(build(3, several), bytes);
+        CHECK_EQ(single.games, 6000u);
+        CHECK_EQ(several.positions, single.positions);
+        CHECK(single.entries > 2);
+        CHECK(single.entries <= single.positions);
+
+        std::stringstream file(bytes);
+        auto book = std::make_shared<const OpeningBook>(OpeningBook::read(file));
+        CHECK_EQ(book->plies(), 2);
+        for (const Lineup& lineup : lineups) {
+            auto game = Game::create();
+            Game::Binding binding(*game);
+            Simulator::seatLineup(*game, lineup);
+            Move move{ActionType::Gather, -1};
+            REQUIRE(book->find(game->snapshot(), move));
+            std::vector<Move> moves;
+            Simulator::legalMoves(*game, moves);
+            CHECK(std::any_of(moves.begin(), moves.end(), [&move](const Move& m) {
+                return m.action == move.action && m.target == move.target;
+            }));
+        }
+
+        BookPolicy policy(book, std::make_unique<RandomPolicy>(0.5));
+        Simulator simulator(policy);
+        Rng rng(8);
+        for (int g = 0; g < 20; ++g) {
+            simulator.playGame(lineups[g % 2], rng, g);
+        }
+        CHECK(policy.hits() >= 20); // At least the first move of every game
+        CHECK(policy.misses() > 0);
+        WorkStealingPool pool(1);
+        CHECK_THROWS_AS(buildOpeningBook(config, {}, pool), std::invalid_argument);
+        config.plies = 0;
+        CHECK_THROWS_AS(buildOpeningBook(config, lineups, pool), std::invalid_argument);
+        resetGame();
+    }
+}